@@ -35,13 +35,20 @@ extern "C" {
 /* USER CODE END Includes */
 
 /* USER CODE BEGIN Private defines */
-
+/* F103 上 USART1_TX 和 I2C2_TX 的 DMA 请求都只能走 DMA1 通道4，两边分时使用：
+ * 启动传输前 Acquire，传输完成（或出错）后 Release，再去启动另一方在等的传输
+ */
+#define DMA1_CH4_FREE       0
+#define DMA1_CH4_USART1_TX  1
+#define DMA1_CH4_I2C2_TX    2
+extern volatile uint8_t dma1_ch4_owner;
 /* USER CODE END Private defines */
 
 void MX_DMA_Init(void);
 
 /* USER CODE BEGIN Prototypes */
-
+uint8_t DMA1_Ch4_Acquire(uint8_t owner);
+void DMA1_Ch4_Release(uint8_t owner);
 /* USER CODE END Prototypes */
 
 #ifdef __cplusplus
@@ -35,7 +35,7 @@ extern "C" {
 extern I2C_HandleTypeDef hi2c2;
 
 /* USER CODE BEGIN Private defines */
-
+extern DMA_HandleTypeDef hdma_i2c2_tx;
 /* USER CODE END Private defines */
 
 void MX_I2C2_Init(void);
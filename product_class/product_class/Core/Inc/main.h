@@ -49,17 +49,13 @@ extern "C" {
 extern unsigned char RX_USART_1[64];
 extern uint16_t RX_USART_1_LEN;
 extern uint16_t RX_FLAG;
-
-
-extern uint8_t  myUsbRxData[64];   // յ
-extern uint16_t myUsbRxNum ;
 /* USER CODE END EM */
 
 /* Exported functions prototypes ---------------------------------------------*/
 void Error_Handler(void);
 
 /* USER CODE BEGIN EFP */
-
+void SystemClock_Config(void);    // Stop  PLL ҲҪ
 /* USER CODE END EFP */
 
 /* Private defines -----------------------------------------------------------*/
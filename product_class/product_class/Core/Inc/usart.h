@@ -29,7 +29,7 @@ extern "C" {
 #include "main.h"
 
 /* USER CODE BEGIN Includes */
-
+#include "Connectivity_Protocal.h"
 /* USER CODE END Includes */
 
 extern UART_HandleTypeDef huart1;
@@ -38,16 +38,34 @@ extern UART_HandleTypeDef huart1;
 extern unsigned char RX_USART_1[64];
 extern uint16_t RX_USART_1_LEN;
 extern uint16_t RX_FLAG;
+extern Frame_Parser rx_parser;
+extern Frame_Queue rx_queue;
 
-
-extern uint8_t  myUsbRxData[64];   // յ
-extern uint16_t myUsbRxNum ;
+// ͻأѭһԭ֡ύ
+// DMA һ֡ HAL_UART_TxCpltCallback ŷһ֡
+#define UART1_TX_POOL_SIZE 4      // 2 
+#define UART1_TX_BUF_SIZE  64
+typedef struct
+{
+	uint8_t buf[UART1_TX_POOL_SIZE][UART1_TX_BUF_SIZE];
+	uint16_t len[UART1_TX_POOL_SIZE];
+	volatile uint8_t head;      // һύĻѭ
+	volatile uint8_t tail;      // ڷ͵Ļжϣ
+	volatile uint8_t busy;      // DMA ڷ
+	uint32_t frames;            // ѷ֡
+	uint32_t overflow;          // 벻Ĵ
+	uint8_t high_water;         // Ŷֵ֡
+	uint32_t dma_waits;         // DMA ͨ OLED ռáҪȵĴ
+}Uart_Tx_Pool;
+extern Uart_Tx_Pool tx_pool;
 /* USER CODE END Private defines */
 
 void MX_USART1_UART_Init(void);
 
 /* USER CODE BEGIN Prototypes */
-
+uint8_t *UART1_Tx_Alloc(void);
+void UART1_Tx_Submit(uint16_t len);
+void UART1_Tx_Kick(void);
 /* USER CODE END Prototypes */
 
 #ifdef __cplusplus
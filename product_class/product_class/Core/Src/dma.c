@@ -53,6 +53,25 @@ void MX_DMA_Init(void)
 }
 
 /* USER CODE BEGIN 2 */
+volatile uint8_t dma1_ch4_owner = DMA1_CH4_FREE;
 
+/* 占用通道4，已被另一方占用返回 0；主循环和中断都会调用，要在关中断下执行 */
+uint8_t DMA1_Ch4_Acquire(uint8_t owner)
+{
+  if (dma1_ch4_owner != DMA1_CH4_FREE && dma1_ch4_owner != owner)
+  {
+    return 0;
+  }
+  dma1_ch4_owner = owner;
+  return 1;
+}
+
+void DMA1_Ch4_Release(uint8_t owner)
+{
+  if (dma1_ch4_owner == owner)
+  {
+    dma1_ch4_owner = DMA1_CH4_FREE;
+  }
+}
 /* USER CODE END 2 */
 
@@ -22,6 +22,10 @@
 
 /* USER CODE BEGIN 0 */
 
+/* I2C2_TX 和 USART1_TX 共用 DMA1 通道4，CubeMX 只能把通道分给其中一个，
+ * I2C2_TX 的句柄在这里手动建，分时占用见 dma.h
+ */
+DMA_HandleTypeDef hdma_i2c2_tx;
 /* USER CODE END 0 */
 
 I2C_HandleTypeDef hi2c2;
@@ -38,7 +42,7 @@ void MX_I2C2_Init(void)
 
   /* USER CODE END I2C2_Init 1 */
   hi2c2.Instance = I2C2;
-  hi2c2.Init.ClockSpeed = 100000;
+  hi2c2.Init.ClockSpeed = 400000;
   hi2c2.Init.DutyCycle = I2C_DUTYCYCLE_2;
   hi2c2.Init.OwnAddress1 = 0;
   hi2c2.Init.AddressingMode = I2C_ADDRESSINGMODE_7BIT;
@@ -78,8 +82,34 @@ void HAL_I2C_MspInit(I2C_HandleTypeDef* i2cHandle)
 
     /* I2C2 clock enable */
     __HAL_RCC_I2C2_CLK_ENABLE();
+
+    /* I2C2 interrupt Init */
+    HAL_NVIC_SetPriority(I2C2_EV_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(I2C2_EV_IRQn);
+    HAL_NVIC_SetPriority(I2C2_ER_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(I2C2_ER_IRQn);
   /* USER CODE BEGIN I2C2_MspInit 1 */
 
+    /* I2C2_TX DMA Init，配置和 USART1_TX 一致，只在第一次初始化
+     * 总线恢复时会 DeInit/Init I2C2，这时通道可能正被串口使用，不能再动通道寄存器
+     */
+    if (hdma_i2c2_tx.State == HAL_DMA_STATE_RESET)
+    {
+      hdma_i2c2_tx.Instance = DMA1_Channel4;
+      hdma_i2c2_tx.Init.Direction = DMA_MEMORY_TO_PERIPH;
+      hdma_i2c2_tx.Init.PeriphInc = DMA_PINC_DISABLE;
+      hdma_i2c2_tx.Init.MemInc = DMA_MINC_ENABLE;
+      hdma_i2c2_tx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+      hdma_i2c2_tx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+      hdma_i2c2_tx.Init.Mode = DMA_NORMAL;
+      hdma_i2c2_tx.Init.Priority = DMA_PRIORITY_LOW;
+      if (HAL_DMA_Init(&hdma_i2c2_tx) != HAL_OK)
+      {
+        Error_Handler();
+      }
+    }
+
+    __HAL_LINKDMA(i2cHandle,hdmatx,hdma_i2c2_tx);
   /* USER CODE END I2C2_MspInit 1 */
   }
 }
@@ -103,8 +133,11 @@ void HAL_I2C_MspDeInit(I2C_HandleTypeDef* i2cHandle)
 
     HAL_GPIO_DeInit(GPIOB, GPIO_PIN_11);
 
+    /* I2C2 interrupt Deinit */
+    HAL_NVIC_DisableIRQ(I2C2_EV_IRQn);
+    HAL_NVIC_DisableIRQ(I2C2_ER_IRQn);
   /* USER CODE BEGIN I2C2_MspDeInit 1 */
-
+    /* 通道4 和串口共用，这里不 DeInit */
   /* USER CODE END I2C2_MspDeInit 1 */
   }
 }
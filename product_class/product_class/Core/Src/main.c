@@ -28,6 +28,7 @@
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
 #include "headfile.h"
+#include "usbd_cdc_if.h"
 
 /* USER CODE END Includes */
 
@@ -120,17 +121,17 @@ unsigned char RX_USART_1[64];
 uint16_t RX_USART_1_LEN;
 uint16_t RX_FLAG;
 
-
-uint8_t  myUsbRxData[64] = { 0 };   // յ
-uint16_t myUsbRxNum = 0;
-
-uint8_t  Transmit_Data[64] = { 0 };
 Connectivity_Protocal_Struct Receive_data;
 Connectivity_Protocal_Struct Transmit_data;
 
 uint16_t rubbish_flag = 0;  //תǶflag
-uint16_t fan_flag = 0;      // תflag
 uint16_t oled_flag = 1;     // oled
+Frame_View rx_frame;        // ֱָ֡նУ
+const uint8_t *rx_buf;
+uint16_t rx_len;
+uint8_t frame_version = FRAME_V1;  // ظõ֡汾λ
+uint8_t telemetry_tlv = 0;         // v2 ңⷢ SENSORSTLV COMMONDλ DESCRIBE л
+DHT11_Data_TypeDef DHT11_Data;     // ʪȣDHT11 £
 /* USER CODE END PV */
 
 /* Private function prototypes -----------------------------------------------*/
@@ -141,10 +142,6 @@ void SystemClock_Config(void);
 
 /* Private user code ---------------------------------------------------------*/
 /* USER CODE BEGIN 0 */
-static void Delay(__IO uint32_t nCount)	 //򵥵ʱ
-{
-	for(; nCount != 0; nCount--);
-}
 
 /* USER CODE END 0 */
 
@@ -172,6 +169,7 @@ int main(void)
   SystemClock_Config();
 
   /* USER CODE BEGIN SysInit */
+  Timebase_Init();      // ͳһʱSysTick ms + us ֵʱDWT 
 
   /* USER CODE END SysInit */
 
@@ -185,33 +183,39 @@ int main(void)
   MX_USB_DEVICE_Init();
   /* USER CODE BEGIN 2 */
 
-  //	HAL_TIM_Base_Start_IT(&htim2);   // ʱжϳʼѯ(԰棬ڵλ)
-  HAL_TIM_Base_Start_IT(&htim2);
-  HAL_TIM_IC_Start(&htim2,TIM_CHANNEL_2);
-  HAL_TIM_IC_Start_IT(&htim2, TIM_CHANNEL_2);  // ͨ벶ڳ
+  Ultra_Sound_Init();   // TIM2CH1  TRIGCH2 벶 ECHO
 
   //	HAL_TIM_PWM_Start(&htim3,TIM_CHANNEL_1);
-  SG90_PWM_START(&SG90_TIM, SG90_TIM_CHANNEL);
+  Servo_Init(rubbish_flag);   // ּϵλ֮ TIM3 жﰴ켣ת
 	
-	// ȳʼ
-	TB6612_SET_START(&TB6612_TIM, TB6612_TIM_CHANNEL_A);
-	TB6612_SET_DIRECTION(TB6612_PORT_A, TB6612_UP);
-	TB6612_SET(TB6612_PORT,TB6612_PORT_PIN,TB6612_WORK);
+	// ȳʼã·ͣţ Task_Fan ʪȿ
+	Fan_Init();
 	
   uint16_t recv_degree = 0;
 	
 	
-	// ʪȴ
-	DHT11_Data_TypeDef DHT11_Data;
+	// ʪȴ½ DWT ʱʱ
+#if FIX_BENCH
+	Fix_Bench();    // ͸Աȣ fix_bench 
+#endif
 	DHT11_Init ();
 	
 	//oled
-	Systick_Init();
-	IIC_GPIO_Config();
 	OLED_Init();
-		
-		
-		
+	Task_OLED();    // ϵȻһΣֻ֮ݱ仯ʱػ
+	
+	// ͹ģRTC(LSI) Ӻ EXTI ѣʱɵ Sleep / Stop
+	Power_Init();
+	
+	// ⣺궨ֵڱݼĴҪ Power_Init 򿪱֮
+	Fill_Init();
+	
+	// CPU ʱ׶κͼжϵ DWT ʱλ PROF 
+	Prof_Init();
+	
+	// ȣSysTick 1ms ģ schedule.c
+	OS_Init();
+	
   /* USER CODE END 2 */
 
   /* Infinite loop */
@@ -221,90 +225,7 @@ int main(void)
     /* USER CODE END WHILE */
 
     /* USER CODE BEGIN 3 */
-		Get_distance();
-		
-		Delay(0x1fffff);
-		// ʪȴ
-		if( DHT11_Read_TempAndHumidity ( & DHT11_Data ) == SUCCESS) ;		else ;
-		
-		// oled
-		if(oled_flag){
-			OLED_ShowStr(0, 3, (unsigned char *)"           DUT   ", 1);  // 6*8ַ
-			OLED_ShowStr(0, 4, (unsigned char *)"  class2group7  ", 2); // 8*16ַ
-		}
-		else OLED_Fill(0x00); // ȫ  OLED_Fill(0xFF); // ȫ
-		
-		
-		// 
-		if(ultra_sound.distance < 0.2) beep_on(); else beep_off();
-		
-		
-		// 
-		switch(rubbish_flag){
-			case 0:
-				SG90_PWM_CONTROL(&SG90_TIM, SG90_TIM_CHANNEL, 0);
-				break;
-			case 1:
-				SG90_PWM_CONTROL(&SG90_TIM, SG90_TIM_CHANNEL, 45);
-				break;
-			case 2:
-				SG90_PWM_CONTROL(&SG90_TIM, SG90_TIM_CHANNEL, 90);
-				break;
-			case 3:
-				SG90_PWM_CONTROL(&SG90_TIM, SG90_TIM_CHANNEL, 135);
-				break;
-			case 4:
-				SG90_PWM_CONTROL(&SG90_TIM, SG90_TIM_CHANNEL, 180);
-				break;
-		}
-		
-		// ٶȣ¶ȿƣ
-		if(DHT11_Data.temp_int > 25) fan_flag=1;
-		else fan_flag = 0;
-		if(fan_flag) TB6612_SET_SPEED(&TB6612_TIM, TB6612_TIM_CHANNEL_A, 25);
-		else TB6612_SET_SPEED(&TB6612_TIM, TB6612_TIM_CHANNEL_A, 0);
-		
-		/////
-		Set_Data_Float(&Transmit_data,ultra_sou ,&(ultra_sound.distance) ,1);
-		Set_Data_uint8_t(&Transmit_data,ultra_sou ,&(DHT11_Data.humi_int) ,1,4);
-		Set_Data_uint8_t(&Transmit_data,ultra_sou ,&(DHT11_Data.temp_int) ,1,5);
-		
-		Set_Struct(&Transmit_data,COMMOND);
-		Struct_To_Data(&Transmit_data,Transmit_Data);
-		HAL_UART_Transmit_DMA(&huart1,Transmit_Data,64);
-		
-		Data_To_Struct(&Receive_data,RX_USART_1);
-		if(Receive_data.head[0] == 0xa5 && Receive_data.back == 0xff)
-		{
-			if(Receive_data.data[0] == 0x01)
-			{
-				oled_flag = 1;
-			}
-			else 
-			{
-				oled_flag = 0;
-			}
-			
-			rubbish_flag = Receive_data.data[1];
-//			if(Receive_data.data[1] == 0x01)
-//			{
-//				
-//			}
-//			else 
-//			{
-//				
-//			}	
-
-			
-			
-		}
-			
-			
-		
-//		Set_Data_Float(&Transmit_data,ultra_sou ,&(ultra_sound.distance) ,1);
-//		Set_Struct(&Transmit_data,COMMOND);
-//		Struct_To_Data(&Transmit_data,Transmit_Data);
-//		HAL_UART_Transmit_DMA(&huart1,Transmit_Data,64);
+		PeachOSRun();   // ᷵
   }
   /* USER CODE END 3 */
 }
@@ -357,16 +278,490 @@ void SystemClock_Config(void)
 
 /* USER CODE BEGIN 4 */
 
-// ʱжϻصѯҪ޸һ¶ʱ
-// void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
-//{
+/***************************************************************/
+
+static uint8_t *Link_Tx_Alloc(uint8_t link)
+{
+	return (link == LINK_USB) ? CDC_Tx_Alloc() : UART1_Tx_Alloc();
+}
+
+static void Link_Tx_Submit(uint8_t link, uint16_t len)
+{
+	if(link == LINK_USB) CDC_Tx_Submit(len);
+	else UART1_Tx_Submit(len);
+}
+
+// λɿ֪ͨ v2 λͻ˾͵һңٷ
+static void Sort_Done_Notify(void)
+{
+	static uint32_t done_seq;
+	uint32_t last = done_seq;
+	uint8_t link = active_link;
+	uint8_t *tx_buf, *payload;
+	Servo_Done done;
+
+	if(!Servo_Done_Read(&done_seq, &done) || frame_version != FRAME_V2) return;
+	if((tx_buf = Link_Tx_Alloc(link)) == NULL)
+	{
+		done_seq = last;
+		return;
+	}
+	payload = Frame_V2_Data(tx_buf);
+	payload[0] = done.cls;
+	payload[1] = done.degree;
+	payload[2] = (uint8_t)done_seq;
+	payload[3] = done.move_ms >> 8;
+	payload[4] = done.move_ms & 0xff;
+	Link_Tx_Submit(link, Frame_V2_Encode(tx_buf, SORT_DONE, 5));
+}
+
+// ״̬仯ʱ֪ͨλֻ v2 λգȥ´ٷ
+static void Fill_Notify(void)
+{
+	static uint32_t event_seq;
+	uint32_t last = event_seq;
+	uint8_t link = active_link;
+	uint8_t *tx_buf, *payload;
+	Fill_Event event;
+
+	if(!Fill_Event_Read(&event_seq, &event) || frame_version != FRAME_V2) return;
+	if((tx_buf = Link_Tx_Alloc(link)) == NULL)
+	{
+		event_seq = last;
+		return;
+	}
+	payload = Frame_V2_Data(tx_buf);
+	payload[0] = event.state;
+	payload[1] = event.pct;
+	int2u8Arry(payload + 2, event.distance_mm, 2);
+	payload[4] = (uint8_t)event_seq;
+	Link_Tx_Submit(link, Frame_V2_Encode(tx_buf, FILL_EVENT, 5));
+}
+
+// ķͽȣĸţʷطŴ history  history_end
+typedef struct
+{
+	uint32_t sent;
+	uint32_t history;
+	uint32_t history_end;
+}Sample_Cursor;
+static Sample_Cursor sample_cursor[SAMPLE_NUM];
+
+// v2 Ӧ𣻷ͻ˾ͲأλȲ ACK ԭططİظ
+static void Ack_Send(const Frame_View *frame, uint8_t link, uint8_t status)
+{
+	uint8_t *tx_buf, *payload;
+
+	if((tx_buf = Link_Tx_Alloc(link)) == NULL) return;
+	payload = Frame_V2_Data(tx_buf);
+	payload[0] = frame->seq;
+	payload[1] = frame->cmd;
+	payload[2] = status;
+	Link_Tx_Submit(link, Frame_V2_Encode(tx_buf, ACK, 3));
+}
+
+// ּoled  | ࡣv2 ķ೬Χ NACKĵǰࣻ
+//  ACK_OK ʱѾЧһ Task_Command ǰͿʼ滮
+static uint8_t Sort_Request(const Frame_View *frame)
+{
+	if(frame->length < 2) return ACK_BAD_LEN;
+	if(frame->version == FRAME_V2 && frame->data[1] >= SERVO_CLASS_NUM) return ACK_BAD_ARG;
+	if(frame->data[0] == 0x01)
+	{
+		oled_flag = 1;
+	}
+	else
+	{
+		oled_flag = 0;
+	}
+	rubbish_flag = frame->data[1];
+	return ACK_OK;
+}
+
+// λʷط Task_Telemetry 
+static uint8_t History_Request(const Frame_View *frame)
+{
+	uint8_t mask = (frame->length >= 1) ? frame->data[0] : 0;
+	uint32_t ms = (frame->length >= 3) ? ((uint32_t)frame->data[1] << 8 | frame->data[2]) * 1000 : 0;
+	uint8_t ch;
+
+	for(ch = 0; ch < SAMPLE_NUM; ch++)
+	{
+		if(mask && !(mask & (1 << ch))) continue;
+		sample_cursor[ch].history_end = sample_ring[ch].seq;
+		sample_cursor[ch].history = ms ? Sample_Find(ch, Timebase_Ms() - ms) : Sample_Oldest(ch);
+	}
+	OS_Task_Trigger(TASK_TELEMETRY);
+	return ACK_OK;
+}
+
+// λѯõ͹ģһ֡ͳ
+static uint8_t Power_Request(const Frame_View *frame, uint8_t link)
+{
+	uint8_t *tx_buf;
+
+	if(frame->length != 0 && frame->length < 3) return ACK_BAD_LEN;
+	if(frame->length >= 3)
+	{
+		Power_Config(frame->data[0], ((uint32_t)frame->data[1] << 8 | frame->data[2]) * 1000);
+	}
+	if((tx_buf = Link_Tx_Alloc(link)) == NULL) return ACK_BUSY;
+	Link_Tx_Submit(link, Frame_V2_Encode(tx_buf, POWER, Power_Encode(Frame_V2_Data(tx_buf))));
+	return ACK_OK;
+}
+
+// λѯ궨⣬һ֡״̬
+static uint8_t Fill_Request(const Frame_View *frame, uint8_t link)
+{
+	uint8_t *tx_buf;
+	uint8_t ok = 1;
+
+	switch(frame->length ? frame->data[0] : FILL_QUERY)
+	{
+		case FILL_QUERY:
+			break;
+		case FILL_SET_EMPTY:
+			if(fill.state == FILL_INIT || fill.state == FILL_FAULT) return ACK_BAD_ARG;
+			ok = Fill_Calibrate(fill.distance_mm, fill.full_mm);
+			break;
+		case FILL_SET_FULL:
+			if(fill.state == FILL_INIT || fill.state == FILL_FAULT) return ACK_BAD_ARG;
+			ok = Fill_Calibrate(fill.empty_mm, fill.distance_mm);
+			break;
+		case FILL_SET:
+			if(frame->length < 5) return ACK_BAD_LEN;
+			ok = Fill_Calibrate((uint16_t)frame->data[1] << 8 | frame->data[2], (uint16_t)frame->data[3] << 8 | frame->data[4]);
+			break;
+		default:
+			return ACK_BAD_ARG;
+	}
+	if(!ok) return ACK_BAD_ARG;
+	if((tx_buf = Link_Tx_Alloc(link)) == NULL) return ACK_BUSY;
+	Link_Tx_Submit(link, Frame_V2_Encode(tx_buf, FILL, Fill_Encode(Frame_V2_Data(tx_buf))));
+	return ACK_OK;
+}
+
+// λ Task_Telemetry 
+static uint8_t Prof_Request(const Frame_View *frame)
+{
+	Prof_Dump_Start(frame->length >= 1 && frame->data[0]);
+	OS_Task_Trigger(TASK_TELEMETRY);
+	return ACK_OK;
+}
+
+// λ鴫˳ѡңʽ Task_Telemetry 
+static uint8_t Describe_Request(const Frame_View *frame)
+{
+	if(frame->length >= 1 && frame->data[0] > 1) return ACK_BAD_ARG;
+	telemetry_tlv = frame->length >= 1 ? frame->data[0] : 1;
+	Sensor_Describe_Start();
+	OS_Task_Trigger(TASK_TELEMETRY);
+	return ACK_OK;
+}
+
+static uint16_t Require_Age(uint32_t tick)
+{
+	uint32_t age = Timebase_Since(tick);
+	return age > 0xfffe ? 0xfffe : age;
+}
+
+// ȡظһηĽ
+//  20HzDHT11 ٸ 1sں̨һֱﲻⴥ
+static uint8_t Require_Request(const Frame_View *frame, uint8_t link)
+{
+	uint8_t mask = (frame->length >= 1 && frame->data[0]) ? frame->data[0] : REQUIRE_ALL;
+	uint8_t *tx_buf, *payload;
+	Ultra_Sample sample;
+	DHT11_Data_TypeDef data;
+
+	if(mask & ~REQUIRE_ALL) return ACK_BAD_ARG;
+	if((tx_buf = Link_Tx_Alloc(link)) == NULL) return ACK_BUSY;
+	payload = Frame_V2_Data(tx_buf);
+	memset(payload, 0, 11);
+	payload[0] = mask;
+	int2u8Arry(payload + 3, 0xffff, 2);
+	int2u8Arry(payload + 9, 0xffff, 2);
+	if((mask & REQUIRE_DISTANCE) && Ultra_Sound_Read(&sample))
+	{
+		int2u8Arry(payload + 1, sample.filt_mm, 2);
+		int2u8Arry(payload + 3, Require_Age(sample.tick), 2);
+	}
+	if((mask & REQUIRE_DHT11) && DHT11_Read_TempAndHumidity(&data) == SUCCESS)
+	{
+		int2u8Arry(payload + 5, data.temp_int * 10 + data.temp_deci, 2);
+		int2u8Arry(payload + 7, data.humi_int * 10 + data.humi_deci, 2);
+		int2u8Arry(payload + 9, Require_Age(dht11.data_tick), 2);
+	}
+	Link_Tx_Submit(link, Frame_V2_Encode(tx_buf, REQUIRE, 11));
+	return ACK_OK;
+}
+
+// طȣ֡ţ Task_Telemetry 
+static uint8_t resend_next, resend_end;
+
+// λȱʱҪط֡ | ʼţʡΪ֡
+static uint8_t Resend_Request(const Frame_View *frame)
+{
+	uint8_t count, from, len, i;
+
+	if(frame->length < 1) return ACK_BAD_LEN;
+	count = frame->data[0];
+	if(count == 0 || count > TX_HISTORY_NUM) return ACK_BAD_ARG;
+	from = (frame->length >= 2) ? frame->data[1] : (uint8_t)(Frame_V2_Next_Seq() - count);
+	resend_next = from;
+	resend_end = from + count;
+	OS_Task_Trigger(TASK_TELEMETRY);
+	for(i = 0; i < count; i++)
+	{
+		if(Tx_History_Get(from + i, &len) == NULL) return ACK_GONE;
+	}
+	return ACK_OK;
+}
+
+// ʷ֡ԭطѾǵͻ˾´νŷ
+static void Resend_Send(uint8_t link)
+{
+	const uint8_t *frame;
+	uint8_t *tx_buf;
+	uint8_t len;
+
+	while(resend_next != resend_end)
+	{
+		if((frame = Tx_History_Get(resend_next, &len)) != NULL)
+		{
+			if((tx_buf = Link_Tx_Alloc(link)) == NULL) return;
+			memcpy(tx_buf, frame, len);
+			Link_Tx_Submit(link, len);
+			link_stat[link].tx_resends++;
+		}
+		resend_next++;
+	}
+}
+
+// v2 ȥأִУ ACKACK_BUSY ȥأԭطִһ
+static void Command_Request(const Frame_View *frame, uint8_t link)
+{
+	uint8_t status;
+
+	if(Rx_Dedup_Check(link, frame, &status))
+	{
+		link_stat[link].rx_dups++;
+		Ack_Send(frame, link, status | ACK_DUP);
+		return;
+	}
+	switch(frame->cmd)
+	{
+		case COMMOND: status = Sort_Request(frame); break;
+		case RESEND:  status = Resend_Request(frame); break;
+		case REQUIRE: status = Require_Request(frame, link); break;
+		case HISTORY: status = History_Request(frame); break;
+		case POWER:   status = Power_Request(frame, link); break;
+		case PROF:    status = Prof_Request(frame); break;
+		case DESCRIBE: status = Describe_Request(frame); break;
+		case FILL:    status = Fill_Request(frame, link); break;
+		default:      status = ACK_UNKNOWN; break;
+	}
+	if(status != ACK_BUSY) Rx_Dedup_Save(link, frame, status);
+	if(status != ACK_OK) link_stat[link].rx_nacks++;
+	Ack_Send(frame, link, status);
+}
+
+// ÿ̽һ֡ͻ˾´νŷ
+static void Prof_Dump_Send(uint8_t link)
+{
+	uint8_t *tx_buf;
+
+	while(Prof_Dump_Pending())
+	{
+		if((tx_buf = Link_Tx_Alloc(link)) == NULL) return;
+		Link_Tx_Submit(link, Frame_V2_Encode(tx_buf, PROF, Prof_Dump_Next(Frame_V2_Data(tx_buf))));
+	}
+}
+
+// ÿ֡ SENSOR_DESC_PER_FRAME ͻ˾´νŷ
+static void Sensor_Describe_Send(uint8_t link)
+{
+	uint8_t *tx_buf;
+
+	while(Sensor_Describe_Pending())
+	{
+		if((tx_buf = Link_Tx_Alloc(link)) == NULL) return;
+		Link_Tx_Submit(link, Frame_V2_Encode(tx_buf, DESCRIBE, Sensor_Describe_Next(Frame_V2_Data(tx_buf))));
+	}
+}
+
+// ˳һ·Ͻõֱ֡֡ڶ
+static void Command_Drain(Frame_Queue *queue, uint8_t link)
+{
+	while((rx_buf = Frame_Queue_Peek(queue, &rx_len)) != NULL)
+	{
+		if(Frame_Decode(rx_buf, rx_len, &rx_frame) == 0)
+		{
+			frame_version = rx_frame.version;
+			active_link = link;        // λ·ң
+			link_stat[link].rx_frames++;
+			Power_Activity();          // λߣ RUN
+			if(rx_frame.version == FRAME_V2)
+			{
+				Command_Request(&rx_frame, link);
+			}
+			else
+			{
+				Sort_Request(&rx_frame);   // v1 ֻзּӦ
+			}
+		}
+		Frame_Queue_Release(queue);
+	}
+}
+
+// ڵ֡жѾãUSB յֽ֡һһ
+// յʱɴ / USB жϴλɿʱ TIM3 жϴ
+void Task_Command(void)
+{
+	uint16_t last_oled = oled_flag;
+	uint8_t more;
+
+	Command_Drain(&rx_queue, LINK_UART);
+	do
+	{
+		more = CDC_Rx_Poll();
+		Command_Drain(&usb_rx_queue, LINK_USB);
+	} while(more);
+	if(rubbish_flag < SERVO_CLASS_NUM) Servo_Sort((uint8_t)rubbish_flag);   // ˷¹滮
+	Sort_Done_Notify();
+	if(oled_flag != last_oled) OS_Task_Trigger(TASK_OLED);
+}
+
+//  20HzβжɣѾ½ʱ
+void Task_Ultrasound(void)
+{
+	Ultra_Sample sample;
+
+	Ultra_Sound_Start();
+	if(Ultra_Sound_Read(&sample)) Fill_Update(&sample);
+	if(fill.state == FILL_FULL) beep_on(); else beep_off();
+}
+
+// ʪȴ
+void Task_DHT11(void)
+{
+	// ȡһζȡĽʧܱԭֵٿʼһζȡ SysTick 
+	if( DHT11_Read_TempAndHumidity ( & DHT11_Data ) == SUCCESS) ;		else ;
+	DHT11_Start();
+}
+
+// ȣֻ¶ʪ PI̫ûݽʧЧ
+void Task_Fan(void)
+{
+	Fan_Run();
+}
+
+// ֡Ȱʷܹ꣬һߵȵùٷ
+// ȱൽأ벻ͻ˻ؽȣ´νŷ
+static void Telemetry_Samples(uint8_t link)
+{
+	Sample_Cursor *c;
+	uint8_t payload[FRAME_DATA_MAX];
+	uint8_t *tx_buf;
+	uint8_t ch, flags, len;
+	uint32_t *seq, end, from, tick;
+	int16_t value;
+
+	for(ch = 0; ch < SAMPLE_NUM; ch++)
+	{
+		c = &sample_cursor[ch];
+		for(;;)
+		{
+			if((int32_t)(c->history_end - c->history) > 0)
+			{
+				seq = &c->history;
+				end = c->history_end;
+				flags = SAMPLE_FLAG_HISTORY;
+			}
+			else
+			{
+				seq = &c->sent;
+				end = sample_ring[ch].seq;
+				flags = 0;
+				if((int32_t)(end - c->sent) <= 0) break;
+				if((int32_t)(end - c->sent) < SAMPLE_BATCH && Sample_Get(ch, c->sent, &tick, &value) &&
+				   Timebase_Since(tick) < SAMPLE_BATCH_MS) break;
+			}
+			from = *seq;
+			len = Sample_Encode(ch, seq, end, payload, FRAME_DATA_MAX, flags);
+			if(len == 0) continue;      // ҪȫˣѾȥ
+			if((tx_buf = Link_Tx_Alloc(link)) == NULL)
+			{
+				*seq = from;
+				return;
+			}
+			memcpy(Frame_V2_Data(tx_buf), payload, len);
+			Link_Tx_Submit(link, Frame_V2_Encode(tx_buf, SAMPLES, len));
+		}
+	}
+}
+
+// λ·ĸ汾֡·ĸ汾أͻһ֡Ͳ
+// v2 λ֮֡֡Ĳᶪ
+void Task_Telemetry(void)
+{
+	uint8_t link = active_link;   // жлشڣύҪͬһ
+	uint8_t *tx_buf = Link_Tx_Alloc(link);
+	if(tx_buf != NULL && frame_version == FRAME_V2 && telemetry_tlv)
+	{
+		Link_Tx_Submit(link, Frame_V2_Encode(tx_buf, SENSORS, Sensor_Encode(Frame_V2_Data(tx_buf), FRAME_DATA_MAX)));
+	}
+	else if(tx_buf != NULL && frame_version == FRAME_V2)
+	{
+		uint8_t *payload = Frame_V2_Data(tx_buf);
+		fix2u8Arry(payload, FIX_MM_TO_Q16(ultra_sound.distance_mm));
+		payload[4] = DHT11_Data.humi_int;
+		payload[5] = DHT11_Data.temp_int;
+		// ٰͬλһ飬λٽ float
+		int2u8Arry(payload + 6, ultra_sound.distance_mm, 2);
+		int2u8Arry(payload + 8, DHT11_Data.temp_int * 10 + DHT11_Data.temp_deci, 2);
+		int2u8Arry(payload + 10, DHT11_Data.humi_int * 10 + DHT11_Data.humi_deci, 2);
+		payload[12] = fill.pct;
+		Link_Tx_Submit(link, Frame_V2_Encode(tx_buf,COMMOND,13));
+	}
+	else if(tx_buf != NULL)
+	{
+		// v1 ṹͷͻһ£ֱڻ
+		Connectivity_Protocal_Struct *tx_frame = (Connectivity_Protocal_Struct *)tx_buf;
+		uint8_t distance[4];
+		memset(tx_frame->data, 0, sizeof(tx_frame->data));
+		fix2u8Arry(distance, FIX_MM_TO_Q16(ultra_sound.distance_mm));
+		Set_Data_uint8_t(tx_frame,ultra_sou ,distance ,4,0);
+		Set_Data_uint8_t(tx_frame,ultra_sou ,&(DHT11_Data.humi_int) ,1,4);
+		Set_Data_uint8_t(tx_frame,ultra_sou ,&(DHT11_Data.temp_int) ,1,5);
+		Set_Struct(tx_frame,COMMOND);
+		Link_Tx_Submit(link, FRAME_V1_SIZE);
+	}
+	if(frame_version == FRAME_V2)
+	{
+		Resend_Send(link);
+		Sensor_Describe_Send(link);
+		Telemetry_Samples(link);
+		Prof_Dump_Send(link);
+	}
+	Sort_Done_Notify();
+	Fill_Notify();
+}
+
+// oled ֻʾݱ仯ʱػ
+void Task_OLED(void)
+{
+	if(oled_flag){
+		OLED_ShowStr(0, 3, (unsigned char *)"           DUT   ", 1);  // 6*8ַ
+		OLED_ShowStr(0, 4, (unsigned char *)"  class2group7  ", 2); // 8*16ַ
+	}
+	else OLED_Fill(0x00); // ȫ  OLED_Fill(0xFF); // ȫ
+	PROF_BEGIN(t0);
+	OLED_Refresh();       // ֻԴ˵Ĳд
+	PROF_END(PROF_OLED_FLUSH, t0);
+}
 
-//	if(htim == (&htim2))
-//	{
-////		OS_IT_RUN();
-//	}
-//
-//}
+/***************************************************************/
 
 /* USER CODE END 4 */
 
@@ -22,6 +22,13 @@
 #include "stm32f1xx_it.h"
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
+#include "schedule.h"
+#include "bsp_dht11.h"
+#include "dma.h"
+#include "bsp_oled_debug.h"
+#include "usbd_cdc_if.h"
+#include "power.h"
+#include "cpu_prof.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -57,11 +64,13 @@
 /* External variables --------------------------------------------------------*/
 extern PCD_HandleTypeDef hpcd_USB_FS;
 extern TIM_HandleTypeDef htim2;
+extern TIM_HandleTypeDef htim3;
 extern DMA_HandleTypeDef hdma_usart1_rx;
 extern DMA_HandleTypeDef hdma_usart1_tx;
+extern I2C_HandleTypeDef hi2c2;
 extern UART_HandleTypeDef huart1;
 /* USER CODE BEGIN EV */
-
+extern DMA_HandleTypeDef hdma_i2c2_tx;
 /* USER CODE END EV */
 
 /******************************************************************************/
@@ -187,11 +196,14 @@ void PendSV_Handler(void)
 void SysTick_Handler(void)
 {
   /* USER CODE BEGIN SysTick_IRQn 0 */
-
+  PROF_BEGIN(t0);
   /* USER CODE END SysTick_IRQn 0 */
   HAL_IncTick();
   /* USER CODE BEGIN SysTick_IRQn 1 */
-
+  Timebase_Tick();  // 64 λʱʱDHT11 ȡʱOLED 䳬ʱ
+  OS_IT_RUN();    //  1ms 
+  CDC_Tx_Kick();  // USB һͽŷܺõһ
+  PROF_END(PROF_SYSTICK, t0);
   /* USER CODE END SysTick_IRQn 1 */
 }
 
@@ -208,7 +220,12 @@ void SysTick_Handler(void)
 void DMA1_Channel4_IRQHandler(void)
 {
   /* USER CODE BEGIN DMA1_Channel4_IRQn 0 */
-
+	// ͨ4  I2C2_TX ʱʹãǰռߵľ
+	if(dma1_ch4_owner == DMA1_CH4_I2C2_TX)
+	{
+		HAL_DMA_IRQHandler(&hdma_i2c2_tx);
+		return;
+	}
   /* USER CODE END DMA1_Channel4_IRQn 0 */
   HAL_DMA_IRQHandler(&hdma_usart1_tx);
   /* USER CODE BEGIN DMA1_Channel4_IRQn 1 */
@@ -236,11 +253,11 @@ void DMA1_Channel5_IRQHandler(void)
 void USB_LP_CAN1_RX0_IRQHandler(void)
 {
   /* USER CODE BEGIN USB_LP_CAN1_RX0_IRQn 0 */
-
+  PROF_BEGIN(t0);
   /* USER CODE END USB_LP_CAN1_RX0_IRQn 0 */
   HAL_PCD_IRQHandler(&hpcd_USB_FS);
   /* USER CODE BEGIN USB_LP_CAN1_RX0_IRQn 1 */
-
+  PROF_END(PROF_USB_IRQ, t0);
   /* USER CODE END USB_LP_CAN1_RX0_IRQn 1 */
 }
 
@@ -250,41 +267,100 @@ void USB_LP_CAN1_RX0_IRQHandler(void)
 void TIM2_IRQHandler(void)
 {
   /* USER CODE BEGIN TIM2_IRQn 0 */
-
+  PROF_BEGIN(t0);
   /* USER CODE END TIM2_IRQn 0 */
   HAL_TIM_IRQHandler(&htim2);
   /* USER CODE BEGIN TIM2_IRQn 1 */
-
+  PROF_END(PROF_TIM2_IRQ, t0);
   /* USER CODE END TIM2_IRQn 1 */
 }
 
+/**
+  * @brief This function handles TIM3 global interrupt.
+  */
+void TIM3_IRQHandler(void)
+{
+  /* USER CODE BEGIN TIM3_IRQn 0 */
+
+  /* USER CODE END TIM3_IRQn 0 */
+  HAL_TIM_IRQHandler(&htim3);
+  /* USER CODE BEGIN TIM3_IRQn 1 */
+
+  /* USER CODE END TIM3_IRQn 1 */
+}
+
+/**
+  * @brief This function handles I2C2 event interrupt.
+  */
+void I2C2_EV_IRQHandler(void)
+{
+  /* USER CODE BEGIN I2C2_EV_IRQn 0 */
+
+  /* USER CODE END I2C2_EV_IRQn 0 */
+  HAL_I2C_EV_IRQHandler(&hi2c2);
+  /* USER CODE BEGIN I2C2_EV_IRQn 1 */
+
+  /* USER CODE END I2C2_EV_IRQn 1 */
+}
+
+/**
+  * @brief This function handles I2C2 error interrupt.
+  */
+void I2C2_ER_IRQHandler(void)
+{
+  /* USER CODE BEGIN I2C2_ER_IRQn 0 */
+
+  /* USER CODE END I2C2_ER_IRQn 0 */
+  HAL_I2C_ER_IRQHandler(&hi2c2);
+  /* USER CODE BEGIN I2C2_ER_IRQn 1 */
+
+  /* USER CODE END I2C2_ER_IRQn 1 */
+}
+
 /**
   * @brief This function handles USART1 global interrupt.
   */
 void USART1_IRQHandler(void)
 {
   /* USER CODE BEGIN USART1_IRQn 0 */
-	uint32_t idle_flag_temp;
-	uint16_t len_temp;
+  PROF_BEGIN(t0);
   /* USER CODE END USART1_IRQn 0 */
   HAL_UART_IRQHandler(&huart1);
   /* USER CODE BEGIN USART1_IRQn 1 */
-	idle_flag_temp = __HAL_UART_GET_FLAG(&huart1,UART_FLAG_IDLE);
-	if(idle_flag_temp)
-	{
-		__HAL_UART_CLEAR_FLAG(&huart1,UART_FLAG_IDLE);
-		HAL_UART_DMAStop(&huart1);
-		len_temp = __HAL_DMA_GET_COUNTER(&hdma_usart1_rx);
-		RX_USART_1_LEN = 64 - len_temp;
-		RX_FLAG = 1;
-		//HAL_UART_Transmit_DMA(&huart1,RX_USART_1,RX_USART_1_LEN);
-		__HAL_UART_ENABLE_IT(&huart1,UART_IT_IDLE);
-		HAL_UART_Receive_DMA(&huart1,RX_USART_1,64);
-	}
-
+	// ж HAL ReceiveToIdleDMA ͣ
+  PROF_END(PROF_USART1_IRQ, t0);
   /* USER CODE END USART1_IRQn 1 */
 }
 
 /* USER CODE BEGIN 1 */
 
+/**
+  * @brief This function handles EXTI line[15:10] interrupts.
+  */
+void EXTI15_10_IRQHandler(void)
+{
+  PROF_BEGIN(t0);
+  HAL_GPIO_EXTI_IRQHandler(DHT11_Dout_GPIO_PIN);   // PB12 DHT11 ½
+  __HAL_GPIO_EXTI_CLEAR_IT(POWER_EXTI_UART_RX);    // PA10 ڻѣPower_Idle Ѿ
+  PROF_END(PROF_EXTI15_10_IRQ, t0);
+}
+
+/**
+  * @brief This function handles RTC alarm interrupt through EXTI line 17.
+  */
+void RTC_Alarm_IRQHandler(void)
+{
+  RTC->CRL &= ~RTC_CRL_ALRF;                       // Stop ĶʱѣPower_Idle Ѿ
+  __HAL_GPIO_EXTI_CLEAR_IT(POWER_EXTI_RTC_ALARM);
+}
+
+/**
+  * @brief This function handles USB wake-up interrupt through EXTI line 18.
+  */
+void USBWakeUp_IRQHandler(void)
+{
+  __HAL_GPIO_EXTI_CLEAR_IT(POWER_EXTI_USB_WAKEUP);
+  Power_Activity();
+}
+
 /* USER CODE END 1 */
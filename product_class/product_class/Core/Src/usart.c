@@ -21,6 +21,9 @@
 #include "usart.h"
 
 /* USER CODE BEGIN 0 */
+#include "schedule.h"
+#include "dma.h"
+#include "bsp_oled_debug.h"
 
 /* USER CODE END 0 */
 
@@ -55,11 +58,8 @@ void MX_USART1_UART_Init(void)
   /* USER CODE BEGIN USART1_Init 2 */
 		HAL_NVIC_SetPriority(USART1_IRQn,0 , 0 );
 	HAL_NVIC_EnableIRQ(USART1_IRQn);
-	HAL_UART_DMAStop(&huart1);
-	__HAL_UART_ENABLE_IT(&huart1,UART_IT_RXNE);
-	
-	__HAL_UART_ENABLE_IT(&huart1,UART_IT_IDLE);
-	HAL_UART_Receive_DMA(&huart1,RX_USART_1 , 64);
+	// ѭ DMA ͣգ/ȫ/ʱ HAL_UARTEx_RxEventCallback ֡
+	HAL_UARTEx_ReceiveToIdle_DMA(&huart1,RX_USART_1 , 64);
 	
   /* USER CODE END USART1_Init 2 */
 
@@ -100,7 +100,7 @@ void HAL_UART_MspInit(UART_HandleTypeDef* uartHandle)
     hdma_usart1_rx.Init.MemInc = DMA_MINC_ENABLE;
     hdma_usart1_rx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
     hdma_usart1_rx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
-    hdma_usart1_rx.Init.Mode = DMA_NORMAL;
+    hdma_usart1_rx.Init.Mode = DMA_CIRCULAR;
     hdma_usart1_rx.Init.Priority = DMA_PRIORITY_LOW;
     if (HAL_DMA_Init(&hdma_usart1_rx) != HAL_OK)
     {
@@ -164,5 +164,112 @@ void HAL_UART_MspDeInit(UART_HandleTypeDef* uartHandle)
 }
 
 /* USER CODE BEGIN 1 */
+Frame_Parser rx_parser;
+Frame_Queue rx_queue;
+static uint16_t rx_pos = 0;   // ϴν⵽ RX_USART_1 λ
+
+// Size  DMA ǰдλãϴλõ֮յֽ
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
+{
+	if(huart->Instance != USART1) return;
+	link_stat[LINK_UART].rx_bytes += (Size < rx_pos) ? sizeof(RX_USART_1) - rx_pos + Size : Size - rx_pos;
+	if(Size < rx_pos)
+	{
+		Frame_Parser_Input(&rx_parser, &rx_queue, RX_USART_1 + rx_pos, sizeof(RX_USART_1) - rx_pos);
+		rx_pos = 0;
+	}
+	Frame_Parser_Input(&rx_parser, &rx_queue, RX_USART_1 + rx_pos, Size - rx_pos);
+	rx_pos = (Size >= sizeof(RX_USART_1)) ? 0 : Size;
+	RX_USART_1_LEN = Size;
+	RX_FLAG = 1;
+	if(rx_queue.head != rx_queue.tail) OS_Task_Trigger(TASK_COMMAND);   // ֡ϴ
+}
+
+Uart_Tx_Pool tx_pool;
+
+// ʱһ֡ѭж϶ãҪڹжִ
+// DMA ͨ4  OLED ˢռʱȲOLED ͷͨʱٵ
+void UART1_Tx_Kick(void)
+{
+	if(!tx_pool.busy && tx_pool.tail != tx_pool.head)
+	{
+		uint8_t slot = tx_pool.tail & (UART1_TX_POOL_SIZE - 1);
+		if(!DMA1_Ch4_Acquire(DMA1_CH4_USART1_TX))
+		{
+			tx_pool.dma_waits++;
+			return;
+		}
+		if(HAL_UART_Transmit_DMA(&huart1, tx_pool.buf[slot], tx_pool.len[slot]) == HAL_OK)
+		{
+			tx_pool.busy = 1;
+		}
+		else
+		{
+			DMA1_Ch4_Release(DMA1_CH4_USART1_TX);
+		}
+	}
+}
+
+// һ֡óͨOLED ҳڵȾˢ OLED
+static void UART1_Tx_Done(void)
+{
+	link_stat[LINK_UART].tx_bytes += tx_pool.len[tx_pool.tail & (UART1_TX_POOL_SIZE - 1)];
+	tx_pool.busy = 0;
+	tx_pool.tail++;
+	tx_pool.frames++;
+	DMA1_Ch4_Release(DMA1_CH4_USART1_TX);
+	OLED_Flush_Kick();
+	UART1_Tx_Kick();
+}
 
+// ȡһл֡ NULLȴ
+uint8_t *UART1_Tx_Alloc(void)
+{
+	if((uint8_t)(tx_pool.head - tx_pool.tail) >= UART1_TX_POOL_SIZE)
+	{
+		tx_pool.overflow++;
+		link_stat[LINK_UART].tx_drops++;
+		return NULL;
+	}
+	return tx_pool.buf[tx_pool.head & (UART1_TX_POOL_SIZE - 1)];
+}
+
+// ύ UART1_Tx_Alloc() õĻ
+void UART1_Tx_Submit(uint16_t len)
+{
+	uint32_t primask;
+	uint8_t queued;
+
+	tx_pool.len[tx_pool.head & (UART1_TX_POOL_SIZE - 1)] = len;
+	primask = __get_PRIMASK();
+	__disable_irq();
+	tx_pool.head++;
+	link_stat[LINK_UART].tx_frames++;
+	queued = tx_pool.head - tx_pool.tail;
+	if(queued > tx_pool.high_water) tx_pool.high_water = queued;
+	UART1_Tx_Kick();
+	__set_PRIMASK(primask);
+}
+
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+	if(huart->Instance != USART1) return;
+	UART1_Tx_Done();
+}
+
+// ȴ HAL ͣ DMA գ¿ʼ
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+	if(huart->Instance != USART1) return;
+	if(huart->RxState == HAL_UART_STATE_READY)
+	{
+		rx_pos = 0;
+		HAL_UARTEx_ReceiveToIdle_DMA(&huart1,RX_USART_1 , 64);
+	}
+	// DMA ͳʱ HAL Ѿͣһ֡ŷ
+	if(tx_pool.busy && huart->gState == HAL_UART_STATE_READY)
+	{
+		UART1_Tx_Done();
+	}
+}
 /* USER CODE END 1 */
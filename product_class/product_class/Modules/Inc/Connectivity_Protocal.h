@@ -2,6 +2,7 @@
 #define Connectivity_Protocal_H
 
 #include "main.h"
+#include "fixmath.h"
 
 //֡ͷ2ֽ
 
@@ -16,12 +17,53 @@
 //֡β1ֽ
 
 #define EXP8266_UART	huart1
-#define COMMOND 1
-#define RESEND 2
-#define REQUIRE 3
+#define COMMOND 1     // ң⣨v2 m(float 4) | ʪ % | ¶  |  mm(2) | ¶ 0.1(2) | ʪ 0.1%RH(2) |  %ǰ 6 ֽں v1 һ
+#define RESEND 2      // طλ -> λ֡ | ʼţʡԣʡʱطô֡ʷ v2 ֡ԭط
+#define REQUIRE 3     // ȡ˫򣩣λ 루bit0 룬bit1 ʪȣʡΪȫλ  |
+                      //  mm(2) |  ms(2) | ¶ 0.1(2) | ʪ 0.1%RH(2) | ʪ ms(2)ûʱΪ 65535
+#define SAMPLES 4     // λ -> λʽ sample_ring.h
+#define HISTORY 5     // ʷλ -> λͨ루0 Ϊȫ| (20 Ϊȫ)
+#define SORT_DONE 6   // ּɣλ -> λ | Ƕ |  | λʱ ms(2)λɿ
+#define POWER 7       // ͹ģ˫򣩣λݲѯ  Stop | ʡĿ(20 Ϊ) ã
+                      // λ ģʽ |  Stop | (2) |  ms(4) | Sleep ms(4) | Stop ms(4) | Stop (4) |
+                      // RTC /  / USB Ѵ( 2) | ƽ / ʱ us( 2) | LSI Hz(2)
+#define PROF 8        // CPU ʱ˫򣩣λ (ʡԣ1 Ϊ)λһ֡ܺÿ̽һ֡ʽ cpu_prof.h
+#define ACK 9         // Ӧλ -> λ |  | ״̬ACK_xxxλÿ v2 ֡һ֡
+                      // ظݵPOWERREQUIREȻٻ ACK
+#define SENSORS 10    // ң⣨λ -> λTLVÿݵĴһʽͱż sensor_tlv.h
+#define DESCRIBE 11   // ˫򣩣λ ңʽʡԣ1 Ϊķ SENSORS0 ΪĻ COMMOND
+                      // λȻ ACK֡ʽ sensor_tlv.h
+#define FILL 12       // ⣨˫򣩣λ FILL_xxxʡΪѯ[| Ͱ mm(2) | Ͱ mm(2)]
+                      // λ ״̬ |  % |  mm(2) | Ͱ mm(2) | Ͱ mm(2) |  0.1m/s(2) | Ұֵ(2)ٻ ACK
+#define FILL_EVENT 13 // ״̬仯λ -> λ״̬ |  % |  mm(2) | ¼ţ״̬ fill_level.h
+
+// ACK ״̬ 0  NACKظִУصһε״̬ ACK_DUP
+enum
+{
+	ACK_OK = 0,
+	ACK_BAD_LEN,      // ݳȲ
+	ACK_BAD_ARG,      // Χţ
+	ACK_UNKNOWN,      // ʶ
+	ACK_GONE,         // RESEND Ҫ֡еѾڷʷڵط
+	ACK_BUSY,         // ͻظûȥȥأԭطִ
+};
+#define ACK_DUP 0x80
+
+// REQUIRE Ĵ
+#define REQUIRE_DISTANCE   0x01
+#define REQUIRE_DHT11      0x02
+#define REQUIRE_ALL        (REQUIRE_DISTANCE | REQUIRE_DHT11)
+
+// FILL Ĳõǰ궨ʱûж ACK_BAD_ARG
+enum
+{
+	FILL_QUERY = 0,
+	FILL_SET_EMPTY,   // ǰΪͰ
+	FILL_SET_FULL,    // ǰΪͰ
+	FILL_SET,         // ֱӸͰ / Ͱ
+};
 
-#define USE_SG90 'SG90_USE'// Ϊ8 ÿո
-#define TEMP 'TEMP    '
+// ƣ8 ֽڣÿո sensor_tlv.c  sensor_desc[] Ǽǣv1 ֡һ
 #define ultra_sou (uint8_t*)"ultra_so"
 
 
@@ -36,17 +78,131 @@ typedef struct
 	uint8_t back;
 }Connectivity_Protocal_Struct;
 
+// v2 ֡ʽhead[1] Ϊ汾ţ0 Ϊɵ 64 ֽڶ֡
+// ֡ͷ 0xa5 | 汾 0x02 | ݳ |  |  | ݣ0~56ֽڣ| CRC16ֽǰ| ֡β 0xff
+// CRC16 Ϊ CCITTʽ 0x1021ֵ 0xffffΧӰ汾ŵһֽ
+#define FRAME_HEAD         0xa5
+#define FRAME_BACK         0xff
+#define FRAME_V1           0x00
+#define FRAME_V2           0x02
+#define FRAME_V1_SIZE      64
+#define FRAME_V2_HEAD_SIZE 5
+#define FRAME_V2_OVERHEAD  8
+#define FRAME_DATA_MAX     56
+
+// data ֱָջ
+typedef struct
+{
+	uint8_t version;
+	uint8_t cmd;
+	uint8_t seq;
+	uint8_t length;
+	const uint8_t *data;
+}Frame_View;
+
+// ֡Уждߣѭߣùж
+// ÿ¼Ϊ 1 ֽڳ + ֡¼Խĩβ 0 ʾؿͷ
+#define FRAME_QUEUE_SIZE   1024
+typedef struct
+{
+	uint8_t buf[FRAME_QUEUE_SIZE];
+	volatile uint16_t head;
+	volatile uint16_t tail;
+}Frame_Queue;
+
+// ֽ֡ 0xa5 ֡ͷ汾ȷ֡Уʧܾʹһ 0xa5 ͬ
+typedef struct
+{
+	uint8_t buf[FRAME_V1_SIZE];
+	uint8_t count;
+	uint32_t frames;     // ӵ֡
+	uint32_t resync;     // ֡ͷݲԡ֡ͷĴ
+	uint32_t skipped;    // ͬʱֽ
+	uint32_t dropped;    // ֡
+}Frame_Parser;
+
+// ͨ·USART1  USB CDC ͬһ֡Э飬Խ֡
+// λ·Ч֡ңʹ·
+enum
+{
+	LINK_UART = 0,
+	LINK_USB,
+	LINK_NUM
+};
+
+// ÿ·ͳ
+typedef struct
+{
+	uint32_t rx_bytes;
+	uint32_t rx_frames;   // Ч֡
+	uint32_t rx_dups;     // ظλûյ ACK طģ
+	uint32_t rx_nacks;    //  NACK 
+	uint32_t tx_bytes;    // Ѿϵֽ
+	uint32_t tx_frames;   // ύ͵֡
+	uint32_t tx_drops;    // ͻ֡
+	uint32_t tx_resends;  //  RESEND ط֡
+}Link_Stat;
+
+extern Link_Stat link_stat[LINK_NUM];
+extern volatile uint8_t active_link;
+
+// ʷFrame_V2_Encode õ֡ŴһݣRESEND ԭطŲ䣩
+// ֻѭ֡ùж
+#define TX_HISTORY_NUM     16      // 2 ݣÿ֡֡棬 1KB
+typedef struct
+{
+	uint8_t frame[TX_HISTORY_NUM][FRAME_V2_OVERHEAD + FRAME_DATA_MAX];
+	uint8_t len[TX_HISTORY_NUM];
+}Tx_History;
+
+// ȥأÿ· RX_DEDUP_NUM  v2 šʹ
+// λûȵ ACK ԭطRX_DEDUP_MS ֻͬͬ֡ ACKִ
+// ʱͬŵλŴͷʼ
+#define RX_DEDUP_NUM       8
+#define RX_DEDUP_MS        2000
+typedef struct
+{
+	uint8_t  seq[RX_DEDUP_NUM];
+	uint8_t  cmd[RX_DEDUP_NUM];      // 0 Ϊ
+	uint8_t  status[RX_DEDUP_NUM];
+	uint32_t tick[RX_DEDUP_NUM];
+	uint8_t  next;
+}Rx_Dedup;
+
 
 void Struct_To_Data(Connectivity_Protocal_Struct *the_Connectivity_Protocal_Struct,uint8_t *Target);
 void Data_To_Struct(Connectivity_Protocal_Struct *the_Connectivity_Protocal_Struct,uint8_t *Target);
 
 void Set_Struct(Connectivity_Protocal_Struct *the_Connectivity_Protocal_Struct,uint8_t cd);
 void float2u8Arry(uint8_t *u8Arry, float *floatdata);
+// Q16.16  IEEE754 float ֽ˳ float2u8Arry һֽǰ
+void fix2u8Arry(uint8_t *u8Arry, q16_t fixdata);
+//  n ֽڷֽǰ
+void int2u8Arry(uint8_t *u8Arry, int32_t intdata, uint8_t n);
 //涨ǰ8Ϊ
 void Set_Data_Float(Connectivity_Protocal_Struct *the_Connectivity_Protocal_Struct,uint8_t *waishe ,float *datamath ,uint8_t number);
 
 void Set_Data_uint8_t(Connectivity_Protocal_Struct *the_Connectivity_Protocal_Struct,uint8_t *waishe ,uint8_t *datamath,uint8_t number,uint8_t start);
 
+uint16_t CRC16_Calc(const uint8_t *buf, uint16_t len);
+// ڷͻԭ֡ Frame_V2_Data() дݣٵ Frame_V2_Encode()֡
+uint8_t *Frame_V2_Data(uint8_t *frame);
+uint16_t Frame_V2_Encode(uint8_t *frame, uint8_t cd, uint8_t length);
+// һ v2 ֡
+uint8_t Frame_V2_Next_Seq(void);
+// ȡʷ֡ѾǷ NULL
+const uint8_t *Tx_History_Get(uint8_t seq, uint8_t *len);
+// ظ󷵻 1status ΪһεĴ
+uint8_t Rx_Dedup_Check(uint8_t link, const Frame_View *frame, uint8_t *status);
+void Rx_Dedup_Save(uint8_t link, const Frame_View *frame, uint8_t status);
+// ڽջԭؽ֡v1/v2 ֧֣ɹ 0
+int Frame_Decode(const uint8_t *buf, uint16_t size, Frame_View *view);
+
+void Frame_Parser_Input(Frame_Parser *parser, Frame_Queue *queue, const uint8_t *data, uint16_t len);
+// ȡһ֡ Frame_Queue_Release()пշ NULL
+const uint8_t *Frame_Queue_Peek(Frame_Queue *queue, uint16_t *len);
+void Frame_Queue_Release(Frame_Queue *queue);
+
 
 
 
@@ -12,6 +12,12 @@ void SG90_PWM_START(TIM_HandleTypeDef *htim, uint32_t Channel);
 
 void SG90_PWM_CONTROL(TIM_HandleTypeDef *htim, uint32_t Channel , uint16_t dushu);
 
+// Ƕȵλ 0.01㣬˶滮
+void SG90_PWM_CONTROL_FINE(TIM_HandleTypeDef *htim, uint32_t Channel , uint16_t centidegree);
+
+// ֹͣ壬ɿ
+void SG90_PWM_RELEASE(TIM_HandleTypeDef *htim, uint32_t Channel);
+
 
 
 #endif
@@ -4,6 +4,7 @@
 
 
 #include "stm32f1xx.h"
+#include "timebase.h"
 
 
 /************************** DHT11 Ͷ********************************/
@@ -24,6 +25,9 @@ typedef struct
 
 #define      DHT11_Dout_GPIO_PORT                      GPIOB
 #define      DHT11_Dout_GPIO_PIN                       GPIO_PIN_12  // ޸
+#define      DHT11_Dout_PINSOURCE                      12           // űţӦ EXTI 
+#define      DHT11_Dout_EXTI_PORTSRC                   0x01U        // EXTICR ˿ںţPB
+#define      DHT11_Dout_EXTI_IRQn                      EXTI15_10_IRQn
 
 
 
@@ -35,11 +39,61 @@ typedef struct
 
 
 
+/************************** DHT11 ʱ ********************************/
+#define      DHT11_START_MS               20      // ʱ䣬ֲҪ >=18ms
+#define      DHT11_RESPONSE_MS            2       // ͷߺȴӻӦʱ
+#define      DHT11_FRAME_MS               8       // ͷߵ 40 λʱ䣨Լ 4.2ms
+#define      DHT11_MIN_INTERVAL_MS        1000    // ζȡСϵҲҪô
+#define      DHT11_EDGES                  42      // Ӧ 1  + 40 λ 1  +  1 ½
+
+// ½ؼusӦ 80+80λ 50+26 Ϊ 050+70 Ϊ 1
+#define      DHT11_RESPONSE_MIN_US        120
+#define      DHT11_RESPONSE_MAX_US        220
+#define      DHT11_BIT_MIN_US             60
+#define      DHT11_BIT_ONE_US             100     // СΪ 1
+#define      DHT11_BIT_MAX_US             160
+
+
+
+/************************** DHT11 ״̬ ********************************/
+enum
+{
+	DHT11_IDLE = 0,
+	DHT11_START,          // 
+	DHT11_WAIT,           // ͷţEXTI ¼½ʱ
+	DHT11_DONE,           // ½룬һĽ
+};
+
+typedef struct
+{
+	volatile uint8_t   state;
+	volatile uint8_t   edges;                 // Ѽ¼½
+	Timebase_Timer     timer;                 // ȡʱ͡Ӧ𡢵ꡢ
+	uint32_t           start_tick;            // һοʼȡʱ̣Timebase_Ms
+	uint32_t           edge_ts[DHT11_EDGES];  // ½ʱDWT CYCCNT
+
+	DHT11_Data_TypeDef data;                  // һУͨ
+	uint32_t           data_tick;             // data µʱ
+	volatile uint32_t  seq;                   // Уͨ֡
+
+	// ͳ
+	uint32_t           checksum_errors;       // Уʹ
+	uint32_t           no_response;           // ͷߺûӦ
+	uint32_t           timeouts;              // Ӧ𵫹涨ʱû
+	uint32_t           bit_errors;            // ӦλϷ
+	uint32_t           too_soon;              // һζȡС
+	uint32_t           busy;                  // һζȡû
+} DHT11_Ctrl_TypeDef;
+
+extern DHT11_Ctrl_TypeDef dht11;
+
+
+
 /************************** DHT11  ********************************/
 void                     DHT11_Init                      ( void );
+uint8_t                  DHT11_Start                     ( void );
 uint8_t                  DHT11_Read_TempAndHumidity      ( DHT11_Data_TypeDef * DHT11_Data );
 
-;
 
 #endif /* __DHT11_H */
 
@@ -8,9 +8,7 @@
   * IIC_SCL---->PB10
   * 用户可自定义引脚 详见STM32官方数据手册
   */
-#define IIC_NUM                  I2C2
 #define IIC_GPIO_CLK_ENABLE      __HAL_RCC_GPIOB_CLK_ENABLE
-#define IIC_CLK_ENABLE           __HAL_RCC_I2C2_CLK_ENABLE
 #define IIC_GPIO_PORT            GPIOB
 #define IIC_SDA_GPIO_PIN         GPIO_PIN_11
 #define IIC_SCL_GPIO_PIN         GPIO_PIN_10
@@ -34,7 +32,7 @@
      #define IIC_SCL_0 IIC_GPIO_PORT->BSRR = IIC_SCL_GPIO_PIN << 16u     /* SCL = 0 */
      #define IIC_SCL_1 IIC_GPIO_PORT->BSRR = IIC_SCL_GPIO_PIN            /* SCL = 1 */
     
-     #define IIC_SDA_READ (IIC_GPIO_PORT->IDR & IIC_SDA_GPIO_PIN) >> 11
+     #define IIC_SDA_READ ((IIC_GPIO_PORT->IDR & IIC_SDA_GPIO_PIN) >> 11)
     
  #endif
 
@@ -45,6 +43,7 @@
  uint8_t IIC_Wait_ACK(void);
  void IIC_SendByte(uint8_t byte);
  uint8_t IIC_ReciveByte(void);
+ uint8_t IIC_Bus_Clear(void);
 
  #endif
 
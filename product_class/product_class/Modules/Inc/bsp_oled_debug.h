@@ -3,15 +3,45 @@
 
 #include "stm32f1xx.h"
 
-/* 软件/硬件IIC切换宏 0：软件 1：硬件 */
+/* 上电时的传输方式 0：软件IIC 1：硬件I2C2 + DMA，运行时可用 OLED_Set_Transport 切换 */
 #define IIC_SELECT 1
 
+#define OLED_TRANSPORT_SW     0
+#define OLED_TRANSPORT_HW     1
+
+#define OLED_XFER_TIMEOUT_MS  20   /* 一次传输最长时间，超过按总线卡死处理 */
+#define OLED_HW_MAX_FAILS     3    /* 硬件I2C连续恢复这么多次后改用软件IIC */
+
 #define OLED_ID          0x78
 #define OLED_WR_CMD      0x00
 #define OLED_WR_DATA     0x40
 
+#define OLED_PAGES       8
+#define OLED_COLS        128
+
+/* 刷新统计 */
+typedef struct
+{
+    uint32_t transfers;  /* I2C 传输次数 */
+    uint32_t bytes;      /* 总线上的字节数（含地址和控制字节） */
+    uint32_t pages;      /* 刷新过的页数 */
+    uint32_t flushes;    /* 完成的后台刷新次数 */
+    uint32_t errors;     /* NACK / 总线错误 / 启动失败 */
+    uint32_t timeouts;   /* 传输超时 */
+    uint32_t recoveries; /* 总线恢复次数 */
+    uint32_t fallbacks;  /* 改用软件IIC的次数 */
+    uint32_t dma_waits;  /* DMA 通道被串口占用要等的次数 */
+} OLED_Stat_TypeDef;
+
+extern OLED_Stat_TypeDef oled_stat;
+
 void OLED_Init(void);
 void OLED_SetPos(unsigned char x, unsigned char y);
+void OLED_Refresh(void);
+void OLED_Flush_Kick(void);
+uint8_t OLED_Set_Transport(uint8_t transport);
+uint8_t OLED_Get_Transport(void);
+uint8_t OLED_Busy(void);
 void OLED_Fill(unsigned char fill_data);
 void OLED_CLS(void);
 void OLED_ON(void);
@@ -0,0 +1,78 @@
+#ifndef __CPU_PROF_H_
+#define __CPU_PROF_H_
+
+#include "main.h"
+#include "schedule.h"
+#include "core_delay.h"
+
+// CPU ʱ DWT CYCCNT ׶κͼжϼʱ
+// ÿ̽ڹ̶ıǴС /  / ƽ log2 ֱͼ
+// λ PROF űߣýӵҲܿ 72MHz 
+// ʱڼ䱻ռжϣStop ģʽ CYCCNT ߣֻ̽õ Sleep Ĳ
+#define PROF_ENABLE             1       // 0 ʱ̽ȫɿ
+#define PROF_HIST_BINS          16
+#define PROF_HIST_SHIFT         4       //  0  < 2^5 ڣ i  [2^(i+4), 2^(i+5))һ >= 2^19Լ 7.3ms
+#define PROF_WINDOW_MS          1000    // ʵͳƴ
+#define PROF_SUMMARY_ID         0xff    // ֡ı
+
+// ̽
+enum
+{
+	PROF_TASK = 0,                      // PROF_TASK + TASK_xxx
+	PROF_IDLE = PROF_TASK + TASK_NUM,   // Power_IdleSleep / Stop
+	PROF_SYSTICK,
+	PROF_USART1_IRQ,
+	PROF_TIM2_IRQ,
+	PROF_USB_IRQ,                       // HAL_PCD_IRQHandler
+	PROF_EXTI15_10_IRQ,                 // DHT11 ½
+	PROF_OLED_FLUSH,                    // OLED_Refresh DMA ˢ£ IIC ʱд꣩
+	PROF_DHT11_DECODE,                  //  DHT11_EDGES ½أӦ40 λ
+	PROF_NUM
+};
+
+typedef struct
+{
+	uint32_t count;
+	uint32_t min;
+	uint32_t max;
+	uint64_t sum;
+	uint32_t hist[PROF_HIST_BINS];
+	uint32_t since_tick;          // ʼͳƵʱ̣ռ CPU ı
+}Prof_Probe;
+
+typedef struct
+{
+	Prof_Probe probe[PROF_NUM];
+	uint32_t reset_tick;          // ͳ㣨ϵϴ㣩
+	uint32_t window_tick;         // ʴ
+	uint32_t window_cyc;
+	uint32_t window_idle;         // е
+	uint16_t idle_x100;           // һڵĿʣ0.01%
+	uint16_t idle_min_x100;       // æһ
+	uint8_t  dump_next;           // ĽȣPROF_NUM + 1 ʾûڶ
+	uint8_t  dump_reset;          // һ̽
+}Prof_Table;
+
+extern Prof_Table prof;
+
+#if PROF_ENABLE
+#define PROF_BEGIN(t0)          uint32_t t0 = CPU_TS_TmrRd()
+#define PROF_END(id, t0)        Prof_Record((id), CPU_TS_TmrRd() - (t0))
+#else
+#define PROF_BEGIN(t0)
+#define PROF_END(id, t0)        ((void)0)
+#endif
+
+void Prof_Init(void);
+// һΣжҲܵãͬһֻ̽һطʱ
+void Prof_Record(uint8_t id, uint32_t cycles);
+
+// PROF ֡ PROFȷһ֡ܣÿ̽һֽ֡ڸλǰ
+// ܣ0xff | ̽ | ϸڿ(2) | ʹڿ(2) | ͳʱ ms(4) | CPU MHz | ֱͼ PROF_HIST_SHIFT
+// ̽룺 | (4) | С(4) | (4) | ƽ(4) | ռ CPU 0.01%(2) | ֱͼ PROF_HIST_BINS ( 2 65535  65535)
+void Prof_Dump_Start(uint8_t reset);
+uint8_t Prof_Dump_Pending(void);
+// һ֡ݣس
+uint8_t Prof_Dump_Next(uint8_t *payload);
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef __FAN_CTRL_H_
+#define __FAN_CTRL_H_
+
+#include "main.h"
+
+// ȱջƣTB6612TIM3 CH3 / CH4
+// ÿյһ֡µ DHT11 ݣ¶ȡʪȸ˲ PIȡǸ
+// ·趨ֵزҲռձȲͣ趨ֵӻزſ
+// 󳬹һ·ȵ 100% ʱڶ·ſÿ 100ms бʱƽĿ꣬
+// תֱӴռձȿʼתͣתֱͣ
+// ʪȳʱûи½ʧЧзȰ̶ռձת
+#define FAN_NUM                 2       // ˼·ȣB ·ûӸĳ 1
+#define FAN_MIN_DUTY            20      // ռձ %ֹת
+#define FAN_FAILSAFE_DUTY       60      // ʧЧռձ %
+#define FAN_RAMP_STEP           2       // ÿ 100ms 仯 %
+#define FAN_SENSOR_TIMEOUT_MS   10000   // DHT11 ÿ 2s һΣ 5 û
+#define FAN_FILTER_SHIFT        2       // ʪ EMA ϵ 1/2^n
+
+// ¶ȣ0.1 棩ʪȣ0.1 %RHζĴָ꣩
+enum
+{
+	FAN_TEMP = 0,
+	FAN_HUMI,
+	FAN_PV_NUM
+};
+
+// ״̬
+enum
+{
+	FAN_OFF = 0,
+	FAN_ON,
+	FAN_FAILSAFE,
+};
+
+// ÿ趨ֵ PI λű0.1
+typedef struct
+{
+	int16_t setpoint;
+	int16_t hyst;             // ز
+	int16_t kp;               // 0.01% / 0.1 λ
+	int16_t ki;               // 0.01% / 0.1 λ / 
+}Fan_Loop;
+
+typedef struct
+{
+	uint32_t channel;         // TIM3 ͨ
+	GPIO_TypeDef *port;       // TB6612_SET_DIRECTION ˿ A / B ·
+	uint8_t  duty;            // ǰ %
+	uint8_t  target;          // Ŀ %
+	uint32_t starts;          // ת
+	uint32_t duty_sum;        // ÿ 100ms ۼһΣƽռձ
+}Fan_Channel;
+
+typedef struct
+{
+	uint8_t  state;
+	uint8_t  filt_init;
+	int32_t  pv_q4[FAN_PV_NUM];   // ˲ʪȣλ 1/16 x 0.1
+	int16_t  pv[FAN_PV_NUM];
+	int32_t  integ[FAN_PV_NUM];   // 0.0001%
+	uint16_t demand;              // PI 0.01% 100% x FAN_NUM
+	uint32_t seq;                 // ù DHT11 ֡
+	uint32_t sample_tick;         // һõݵʱ
+
+	Fan_Channel ch[FAN_NUM];
+	uint32_t ticks;               // Fan_Run 
+	uint32_t updates;             // PI 
+	uint32_t failsafes;           // ʧЧĴ
+}Fan_Ctrl;
+
+extern const Fan_Loop fan_loop[FAN_PV_NUM];
+extern Fan_Ctrl fan;
+
+void Fan_Init(void);
+// 100ms һ
+void Fan_Run(void);
+
+#endif
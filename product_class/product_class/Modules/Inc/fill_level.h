@@ -0,0 +1,80 @@
+#ifndef __FILL_LEVEL_H_
+#define __FILL_LEVEL_H_
+
+#include "main.h"
+#include "ultra_sound.h"
+
+// ⣺⵽Ǵľ룬ͰĿͰ / Ͱ뻻ٷֱ
+// 1. ٰ DHT11 ¶331.3 + 0.606 x T m/sultra_sound ﰴ 343 m/s ľٳһ
+// 2. ûлزҪ͵ǰ̫ȵҰֵ֡ζΪͰı
+// 3. 籨زȥٷֱ FILL_DEBOUNCE  FILL_FULL_PCT ű FILL_CLEAR_PCT Ž
+// ״̬仯ʱһ¼ Task_Telemetry λFILL_EVENTλԼж
+// 궨ֵڱݼĴPower_Init ˱򣩣 VBAT ʱλ
+#define FILL_EMPTY_MM           600     // ĬϿͰ루Ͱף
+#define FILL_FULL_MM            150     // ĬͰ
+#define FILL_MIN_SPAN_MM        50      // ͰͰٲô
+#define FILL_FULL_PCT           90      // 
+#define FILL_CLEAR_PCT          75      // ز
+#define FILL_DEBOUNCE           20      // ȥ20Hz ʱԼ 1s
+#define FILL_JUMP_MM            80      // ͵ǰôҰֵ
+#define FILL_JUMP_CONFIRM       5       // ôҰֵ˵Ͱıˣ / գ
+#define FILL_FAULT_COUNT        40      // ôûлز
+#define FILL_EMA_SHIFT          2       //  EMA ϵ 1/2^n
+#define FILL_DEFAULT_TEMP       200     // û¶ʱ 20.0 
+#define FILL_BKP_MAGIC          0xf11a  // ݼĴб궨ֵı
+
+// ״̬
+enum
+{
+	FILL_INIT = 0,          // ûЧ
+	FILL_NORMAL,
+	FILL_FULL,
+	FILL_FAULT,             // ûлزˡסͰߣ
+};
+
+// ״̬仯¼
+typedef struct
+{
+	uint8_t  state;
+	uint8_t  pct;
+	uint16_t distance_mm;
+	uint32_t tick;
+}Fill_Event;
+
+typedef struct
+{
+	// 궨 Fill_Calibrate
+	uint16_t empty_mm;
+	uint16_t full_mm;
+
+	uint8_t  state;
+	uint8_t  pct;                 // ǰٷֱ
+	uint16_t distance_mm;         // ˲ľ
+	uint16_t speed_dm;            // ǰ 0.1 m/s
+	int16_t  temp;                // õ¶ 0.1
+	uint32_t speed_k;             // 343 m/s ľ -> ľ룬Q16
+	int32_t  dist_q4;             // EMA ״̬1/16 mm
+	uint32_t last_tick;           // һ
+	uint8_t  debounce;            // Ҫı䱨״̬
+	uint8_t  jumps;               // Ұֵ
+	uint8_t  misses;              // ûлز
+
+	uint32_t outliers;            // Ұֵ
+	Fill_Event event;
+	uint32_t event_seq;
+}Fill_Ctrl;
+
+extern Fill_Ctrl fill;
+
+// ݼĴı궨ֵҪ Power_Init ֮
+void Fill_Init(void);
+// һͬһֻһΣTask_Ultrasound 
+void Fill_Update(const Ultra_Sample *sample);
+// ñ궨ֵ浽ݼĴ 0
+uint8_t Fill_Calibrate(uint16_t empty_mm, uint16_t full_mm);
+//  seq ֮״̬仯¼ûз 0ֻһ
+uint8_t Fill_Event_Read(uint32_t *seq, Fill_Event *event);
+// FILL Ļظݣʽ Connectivity_Protocal.hس
+uint8_t Fill_Encode(uint8_t *payload);
+
+#endif
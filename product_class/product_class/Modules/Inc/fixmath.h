@@ -0,0 +1,67 @@
+#ifndef __FIXMATH_H_
+#define __FIXMATH_H_
+
+#include "main.h"
+#include "ultra_sound.h"
+#include "SG90.h"
+#include "TB6612.h"
+
+// 㣺F103 û FPUfloat ȫ⺯ģ⣬·ֻ
+// Q16.16  int32_t 16 λС˳ɳһ㵹λ
+typedef int32_t q16_t;
+
+#define Q16_SHIFT              16
+#define Q16_ONE                ((q16_t)1 << Q16_SHIFT)
+#define Q16_FROM_INT(x)        ((q16_t)(x) << Q16_SHIFT)
+#define Q16_RATIO(n, d)        ((q16_t)((((int64_t)(n) << Q16_SHIFT) + (d) / 2) / (d)))   //  n/dֻڱ
+#define Q16_MUL(a, b)          ((q16_t)(((int64_t)(a) * (b)) >> Q16_SHIFT))                // һ SMULL
+
+// زʱ us ->  mm ULTRA_SOUND_SPEED m/sϵ Q18us  65535
+#define FIX_MM_PER_US_K        ((uint32_t)((((uint32_t)ULTRA_SOUND_SPEED << 18) + 1000) / 2000))
+#define FIX_US_TO_MM(us)       (((uint32_t)(us) * FIX_MM_PER_US_K + (1UL << 17)) >> 18)
+//  mm -> ףQ16.16Э float ãmm  65535
+#define FIX_MM_TO_Q16(mm)      ((q16_t)((((uint32_t)(mm) << Q16_SHIFT) + 500) / 1000))
+
+// 0.01 -> Ƚֵ0.5ms~2.5ms Ӧ 0~180㣬Ƚֵ = (0.01 + 4500) *  / 180000
+// ϵ Q2022500 x ϵ 32 λ
+#define FIX_SG90_K             ((uint32_t)((((uint64_t)SG90_TIM_COUNTER_PERIOD << 20) + 90000) / 180000))
+#define FIX_SG90_CMP(cdeg)     ((((uint32_t)(cdeg) + 4500) * FIX_SG90_K + (1UL << 19)) >> 20)
+#define FIX_SG90_DEG_MAX       180
+
+// ռձ % -> Ƚֵ
+#define FIX_DUTY_CMP(duty)     (((uint32_t)(duty) * TB6612_TIM_COUNTER_PERIOD + 50) / 100)
+#define FIX_DUTY_MAX           100
+
+// ɵĲ PWM ±뼴
+extern const uint16_t fix_sg90_cmp[FIX_SG90_DEG_MAX + 1];   // Ƕ
+extern const uint16_t fix_duty_cmp[FIX_DUTY_MAX + 1];       // ռձ
+
+// Q16.16 ת IEEE754 ȵλģʽЭﻹҪ float ĵطã
+uint32_t Fix_Q16_To_Float_Bits(q16_t x);
+
+// ¾·Աȣ 1 ϵһΣҪ CPU_TS_TmrInit fix_bench õ
+#ifndef FIX_BENCH
+#define FIX_BENCH              0
+#endif
+
+#if FIX_BENCH
+enum
+{
+	FIX_BENCH_DISTANCE = 0,   // زʱ -> 
+	FIX_BENCH_ANGLE,          // Ƕ -> Ƚֵ
+	FIX_BENCH_DUTY,           // ռձ -> Ƚֵ
+	FIX_BENCH_FLOAT,          //  -> Э float ֽ
+	FIX_BENCH_NUM
+};
+
+typedef struct
+{
+	uint32_t old_cycles[FIX_BENCH_NUM];   // ƽÿεѿ۵ѭ
+	uint32_t new_cycles[FIX_BENCH_NUM];
+}Fix_Bench_Result;
+
+extern Fix_Bench_Result fix_bench;
+void Fix_Bench(void);
+#endif
+
+#endif
@@ -1,7 +1,9 @@
 #ifndef __HEADFILE_H_
 #define __HEADFILE_H_
 
+#include "timebase.h"
 #include "ultra_sound.h"
+#include "sample_ring.h"
 #include "schedule.h"
 #include "beep.h"
 #include "bsp_dht11.h"
@@ -11,10 +13,16 @@
 #include "bsp_iic_debug.h"
 #include "bsp_oled_debug.h"
 //#include "bsp_oled_codetab.h"
-#include "bsp_systick.h"
 
 #include "SG90.h"
+#include "servo_motion.h"
 #include "TB6612.h"
+#include "fan_ctrl.h"
+#include "power.h"
+#include "cpu_prof.h"
+#include "sensor_tlv.h"
+#include "fill_level.h"
+#include "fixmath.h"
 
 #include "gpio.h"
 #include "tim.h"
@@ -22,7 +30,6 @@
 #include "i2c.h"
 #include "Connectivity_Protocal.h"
 #include "string.h"
-extern uint8_t  Transmit_Data[64];
 extern Connectivity_Protocal_Struct Receive_data;
 extern Connectivity_Protocal_Struct Transmit_data;
 
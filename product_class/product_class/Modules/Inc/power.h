@@ -0,0 +1,97 @@
+#ifndef __POWER_H_
+#define __POWER_H_
+
+#include "main.h"
+
+// ͹Ĺ
+// ûоʱ Power_Idle
+//   RUN  ģʽλͨţֻ SleepWFIκж϶ܻѣӳٲ
+//   SAVE ģʽ save_delay_ms ûյλ֡񻻳ʡڣ schedule.c
+//        һ硢趼ʱ Stopʱȫͣ RTC ӣEXTI17
+//         RX ʼλPA10EXTI10 USB ѣEXTI18
+// ж PLLSystemClock_Configٰ RTC ߹ʱ䲹 SysTick ʱ
+// жϴʱ USART ʺ USB 48MHz ʱӶѾָ
+// ڻѵǸֽڻᶪPLL ǰʲԣλȷһֽڣȼ ms ٷ
+// RTC  LSI 40kHzɴ 50%ʱ SysTick У׼У׼ǰ Stop
+#define POWER_SAVE_DELAY_MS     30000   // ûλ֡ SAVE0 ʾһֱ RUN
+#define POWER_STOP_MIN_MS       20      // һٻôòŽ Stop
+#define POWER_WAKE_MARGIN_MS    3       // RTC ǰ HSE  + PLL 
+#define POWER_CAL_MS            2000    // LSI У׼
+#define POWER_RTC_TIMEOUT_MS    10      // LSI RTC ͬ / дôãʱֻ Sleep
+#define POWER_LSI_HZ            40000   // LSI Ƶ
+#define POWER_LSI_MIN_HZ        30000   // У׼Χ
+#define POWER_LSI_MAX_HZ        60000
+
+// õ EXTI 
+#define POWER_EXTI_UART_RX      (1UL << 10)   // PA10
+#define POWER_EXTI_RTC_ALARM    (1UL << 17)
+#define POWER_EXTI_USB_WAKEUP   (1UL << 18)
+#define POWER_EXTI_WAKE         (POWER_EXTI_UART_RX | POWER_EXTI_RTC_ALARM | POWER_EXTI_USB_WAKEUP)
+
+// ģʽ
+enum
+{
+	POWER_RUN = 0,
+	POWER_SAVE,
+};
+
+// Stop ĻԴ
+enum
+{
+	POWER_WAKE_RTC = 0,
+	POWER_WAKE_UART,
+	POWER_WAKE_USB,
+	POWER_WAKE_OTHER,         //  Stop ǰѾжϹ
+	POWER_WAKE_NUM
+};
+
+// ʱû Stop ԭ
+enum
+{
+	POWER_BLOCK_MODE = 0,     // RUN ģʽ߹ Stop
+	POWER_BLOCK_CAL,          // LSI ûУ׼
+	POWER_BLOCK_DUE,          // һʱ̫
+	POWER_BLOCK_USB,          // USB Ѿö٣ͣʱΪ豸
+	POWER_BLOCK_BUSY,         // 軹ڹ͡ࡢDHT11OLEDȣ
+	POWER_BLOCK_NUM
+};
+
+typedef struct
+{
+	uint8_t  mode;
+	uint8_t  stop_enable;         // 0 ֻ Sleep
+	uint8_t  rtc_fail;            // LSI  RTC ȳʱ֮һֱֻ Sleep
+	uint8_t  cal_valid;
+	uint32_t save_delay_ms;
+	volatile uint32_t activity_tick;  // һλ
+	uint32_t start_tick;          // Power_Init ʱ
+	uint32_t rtc_hz;              // У׼ LSI Ƶ
+	uint32_t cal_tick;            // У׼㣬Stop ֮¿ʼ
+	uint32_t cal_cnt;
+	uint32_t tick_rem;            // RTC  ms 
+
+	uint64_t sleep_cycles;        // WFI  CPU ڣSleep ʱ HCLK ͣCYCCNT ճߣ
+	uint64_t stop_ticks;          // Stop  RTC 
+	uint32_t sleeps;
+	uint32_t stops;
+	uint32_t saves;               //  SAVE Ĵ
+	uint32_t wakes[POWER_WAKE_NUM];
+	uint32_t blocked[POWER_BLOCK_NUM];
+	uint64_t wake_us_sum;         // Stop ʱӻָʱ
+	uint32_t wake_us_max;
+}Power_Ctrl;
+
+extern Power_Ctrl power;
+
+void Power_Init(void);
+// ʱãǰѾжϣʱȻ
+void Power_Idle(void);
+// λлյ֡ / USB ѡUSB ָص RUNж
+void Power_Activity(void);
+void Power_Config(uint8_t stop_enable, uint32_t save_delay_ms);
+//  / Sleep / Stop Եۼʱ䣨ms
+void Power_Residency(uint32_t *run_ms, uint32_t *sleep_ms, uint32_t *stop_ms);
+// ͳƱ POWER ֡ݣس
+uint8_t Power_Encode(uint8_t *payload);
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef __SAMPLE_RING_H_
+#define __SAMPLE_RING_H_
+
+#include "main.h"
+
+// ʱĲλÿͨһ
+// ждÿֻͨһдĵطѭһֱ
+// Լסĸţ˾ʹӻɵŶ
+enum
+{
+	SAMPLE_DISTANCE = 0,      // ˲ľ룬mm
+	SAMPLE_TEMP,              // DHT11 ¶ȣ0.1 
+	SAMPLE_HUMI,              // DHT11 ʪȣ0.1 %RH
+	SAMPLE_NUM
+};
+
+#define SAMPLE_DISTANCE_DEPTH  256    // 2 ݣ20Hz Լ 12.8s
+#define SAMPLE_DHT11_DEPTH     64     // 2 ݣ0.5Hz Լ 128s
+
+// ܹͣ SAMPLE_BATCH ɵһ SAMPLE_BATCH_MS ͷһ֡
+#define SAMPLE_BATCH           16
+#define SAMPLE_BATCH_MS        500
+
+// ֡ݲ֣v2 ֡ SAMPLES
+// ͨbit7 Ϊʷطţ|  | һ(4) | ʱ ms(4) | ֵ(2)ֽڸλǰ
+// ֮ÿһʱmsֵzigzag varintÿֽڵ 7 λbit7 ʾ滹У
+#define SAMPLE_HEAD_SIZE       12
+#define SAMPLE_FLAG_HISTORY    0x80
+
+typedef struct
+{
+	uint32_t *tick;
+	int16_t *value;
+	uint16_t mask;              //  - 1
+	volatile uint32_t seq;      // дһ
+}Sample_Ring;
+
+extern Sample_Ring sample_ring[SAMPLE_NUM];
+
+void Sample_Push(uint8_t ch, uint32_t tick, int16_t value);
+// Ϊ seq Ѿǻ߻ûд뷵 0
+uint8_t Sample_Get(uint8_t ch, uint32_t seq, uint32_t *tick, int16_t *value);
+// ɵġܶ
+uint32_t Sample_Oldest(uint8_t ch);
+// һʱ䲻 tick ţûз sample_ring[ch].seq
+uint32_t Sample_Find(uint8_t ch, uint32_t tick);
+//  *seq ʼ endһ֡ݳȣû 0*seq ǰһûȥ
+uint8_t Sample_Encode(uint8_t ch, uint32_t *seq, uint32_t end, uint8_t *buf, uint8_t size, uint8_t flags);
+
+#endif
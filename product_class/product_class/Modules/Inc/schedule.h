@@ -8,21 +8,49 @@
 struct TaskStruct
 {
 	uint16_t	TaskTickNow;      //ڼʱ
-	uint16_t	TaskTickMax;      //üʱʱ
-	uint8_t	TaskStatus;       //б־λ
+	uint16_t	TaskTickMax;      //üʱʱ䣨ms0 ʾֻ OS_Task_Trigger 
+	uint16_t	TaskPhase;        //һξǰʱms
+	uint16_t	TaskTickSave;     //ʡģʽµڣms0 ʾ
+	volatile uint8_t	TaskStatus;       //б־λ
 	void (*FC)();         //ָ
+	uint32_t	ReleaseTick;      //һξʱ̣Timebase_Ms
+	uint32_t	RunCount;         //д
+	uint32_t	MissCount;        //ʱһλûУֹʱ䣩Ĵ
+	uint32_t	MaxLatency;       //ʼеӳ٣ms
+	uint16_t	TaskTickRun;      //ڣOS_Init ʱ TaskTickMax 
+};
+
+// ţ TaskST[] ˳һ£ǰ
+enum
+{
+	TASK_COMMAND = 0,
+	TASK_ULTRASOUND,
+	TASK_DHT11,
+	TASK_FAN,
+	TASK_TELEMETRY,
+	TASK_OLED,
+	TASK_NUM
 };
 
 extern struct TaskStruct TaskST[];	//Ϊṹݣʱ
 
 //ĺ
+void OS_Init(void);
 void PeachOSRun(void);
 void OS_IT_RUN(void);
-
-
-//ʾ
-void RED_Led(void);
-void GREEN_Led(void);
+void OS_Task_Trigger(uint8_t id);
+void OS_Set_Power_Save(uint8_t on);
+uint16_t OS_Next_Due(void);
+void OS_Advance(uint32_t ms);
+
+
+// main.c ʵ֣
+void Task_Command(void);
+void Task_Ultrasound(void);
+void Task_DHT11(void);
+void Task_Fan(void);
+void Task_Telemetry(void);
+void Task_OLED(void);
 
 
 #endif
@@ -0,0 +1,79 @@
+#ifndef __SENSOR_TLV_H_
+#define __SENSOR_TLV_H_
+
+#include "main.h"
+
+// ע TLV 
+// ÿһ¼ |  | ֵֽǰֽڸ 4 λ͡ 4 λֵֽ
+// ʶıŰСһ֡мż뵽 56 ֽڣûݵĴš
+// λСλں 8 ֲֽݷλ DESCRIBE һΣ Connectivity_Protocal.h
+// Ӵ sensor_desc[] ĩβһУŲҪãдһλøġ
+
+// ţֻ
+enum
+{
+	SENSOR_UPTIME = 1,        // ϵʱ msһ֡ݴʱ
+	SENSOR_DISTANCE,          // ࣨ˲
+	SENSOR_TEMP,              // DHT11 ¶
+	SENSOR_HUMI,              // DHT11 ʪ
+	SENSOR_SERVO,             // ּǰǶ
+	SENSOR_CLASS,             // ǰ
+	SENSOR_FAN_A,             //  A ·ռձ
+	SENSOR_FAN_B,             //  B ·ռձ
+	SENSOR_FILL,              // ٷֱȣfill_level.h
+};
+
+// ֽͣڵĸ 4 λ
+enum
+{
+	SENSOR_U8 = 0,
+	SENSOR_I8,
+	SENSOR_U16,
+	SENSOR_I16,
+	SENSOR_U32,
+	SENSOR_I32,
+};
+
+// λ
+enum
+{
+	SENSOR_UNIT_NONE = 0,
+	SENSOR_UNIT_MS,
+	SENSOR_UNIT_MM,
+	SENSOR_UNIT_CELSIUS,
+	SENSOR_UNIT_RH,           // %RH
+	SENSOR_UNIT_DEGREE,
+	SENSOR_UNIT_PERCENT,
+};
+
+#define SENSOR_TLV_HEAD         2       //  + 
+#define SENSOR_DESC_SIZE        14      // һĳ
+#define SENSOR_DESC_PER_FRAME   3
+#define SENSOR_NAME_LEN         8
+
+typedef struct
+{
+	uint8_t  id;
+	uint8_t  type;
+	uint8_t  unit;
+	int8_t   scale;               // ֵ x 10^scale Ϊʵֵ
+	uint8_t  task;                // ȡĵǰڣTASK_NUM ʾ period_ms
+	uint16_t period_ms;           // 0 ʾ¼
+	char     name[SENSOR_NAME_LEN];   // ֣ 8 ո
+	uint8_t  (*read)(int32_t *value); // ûݷ 0
+}Sensor_Desc;
+
+extern const Sensor_Desc sensor_desc[];
+extern const uint8_t sensor_num;
+
+// ݵĴ TLVŲ max Ķģس
+uint8_t Sensor_Encode(uint8_t *payload, uint8_t max);
+
+// ֡DESCRIBE Ļظ | ֡һ± | ÿһ
+//  |  | λ | Сλ scale(з) |  ms(2) | (8)
+void Sensor_Describe_Start(void);
+uint8_t Sensor_Describe_Pending(void);
+// һ֡ݣس
+uint8_t Sensor_Describe_Next(uint8_t *payload);
+
+#endif
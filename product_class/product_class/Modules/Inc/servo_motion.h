@@ -0,0 +1,83 @@
+#ifndef __SERVO_MOTION_H_
+#define __SERVO_MOTION_H_
+
+#include "main.h"
+
+// ּ˶滮
+//  TIM3 жƽͶ PWM ͬΪ 50HzȽֵһЧλ S 
+// һһڵظĽǶȣ󱣳 SERVO_SETTLE_TICKS ڣͣöɿ
+// λõλ 0.01㣬ʱ䵥λһ PWM ڣ20ms
+#define SERVO_TICK_MS        20
+#define SERVO_CLASS_NUM      5       // rubbish_flag 0~4
+#define SERVO_VMAX           1000    // ٶȣ0.01/ڣ500/s
+#define SERVO_AMAX           320     // Ǽٶȣ0.01/^28000/s^2
+#define SERVO_SETTLE_TICKS   10      // 󱣳 200ms ɿ
+#define SERVO_HOME_TICKS     40      // ϵλδֱ֪ӸǶȣ 800ms ɿ
+
+// 켣
+enum
+{
+	SERVO_TRAPEZOID = 0,      // ٶȣٶ޷
+	SERVO_SCURVE,             // ζʽٶͣûг
+};
+
+// ״̬
+enum
+{
+	SERVO_RELEASED = 0,       // û壬жϹر
+	SERVO_MOVING,
+	SERVO_SETTLING,           // λ
+};
+
+// ÿĿǶȺ͹켣
+typedef struct
+{
+	uint8_t degree;
+	uint8_t profile;
+}Servo_Target;
+
+// ּ¼λɿ󷢲
+typedef struct
+{
+	uint8_t  cls;
+	uint8_t  degree;
+	uint16_t move_ms;         // ʼ˶λ֣
+	uint32_t tick;            // ɿʱ
+}Servo_Done;
+
+typedef struct
+{
+	volatile uint8_t state;
+	uint8_t  cls;             // ǰĿ
+	uint8_t  profile;
+	uint8_t  notify;          // λ󷢲¼ϵλ
+	int32_t  pos;             // ǰĽǶ
+	int32_t  start;           // ˶
+	int32_t  distance;        // ˶룬з
+	uint16_t k;               // Ѿ˼
+	uint16_t n;               // 
+	uint16_t ta;              // Σ / 
+	uint16_t tc;              // Σ
+	uint16_t settle;
+	uint32_t start_tick;
+
+	Servo_Done done;
+	volatile uint32_t done_seq;  // ѷ¼
+	uint32_t moves;
+	uint32_t retargets;       // ˶;лĿ
+	uint32_t releases;
+}Servo_Motion;
+
+extern const Servo_Target servo_target[SERVO_CLASS_NUM];
+extern Servo_Motion servo;
+
+// ϵλ cls ĽǶȣ TIM3 ж
+void Servo_Init(uint8_t cls);
+// ת cls ĽǶȣЧѾ෵ 0
+uint8_t Servo_Sort(uint8_t cls);
+// TIM3 ж
+void Servo_Tick(void);
+// б *seq µ¼ 1*seq Ϊµ¼
+uint8_t Servo_Done_Read(uint32_t *seq, Servo_Done *done);
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef __TIMEBASE_H_
+#define __TIMEBASE_H_
+
+#include "main.h"
+
+// ͳһʱ񶼴ȡʱ
+//   msHAL  uwTickSysTick 1ms 32 λڻʱ 164 λ
+//   usms  SysTick ǰĲ 1ms Ĳ֣ж϶֤
+// Stop ڼ SysTick ͣţ Power_Stop  Timebase_Advance  RTC ϣ
+// ʱڲʱһڡ
+// ʮ us ڵDHT11 λȻֱ CPU_TS_TmrRd 
+//
+// ʱʱ֣ʱ̣msĵλֲۣSysTick ÿֻһۡ
+// ص SysTick жִУҪ̣ص / ֹͣʱ
+// ʱṹʹ߾̬䣬ǰóʼ
+#define TIMEBASE_WHEEL_SLOTS    32      // 2 
+
+typedef struct Timebase_Timer
+{
+	struct Timebase_Timer *next;
+	uint32_t expire;              // ʱ̣ms
+	uint32_t period;              // 0 Ϊ
+	void (*fn)(void);
+	volatile uint8_t active;
+}Timebase_Timer;
+
+typedef struct
+{
+	uint32_t epoch;               // uwTick ƴ64 λ ms ĸ 32 λ
+	uint64_t last_us;             // һζ usֹ
+	uint32_t fired;               // ִеĻص
+	uint32_t late;                // Stop ʱʱŵڵĻص
+	Timebase_Timer *wheel[TIMEBASE_WHEEL_SLOTS];
+}Timebase_Ctrl;
+
+extern Timebase_Ctrl timebase;
+
+//  DWT main ȵ
+void Timebase_Init(void);
+//  SysTick_Handler УHAL_IncTick ֮
+void Timebase_Tick(void);
+// Stop ûߵ msֱӸ uwTickʱж
+void Timebase_Advance(uint32_t ms);
+
+uint32_t Timebase_Ms(void);
+uint64_t Timebase_Ms64(void);
+uint64_t Timebase_Us(void);
+
+// ĳʱжϣ32 λ ms Ҳԣ 24 죩
+uint32_t Timebase_Deadline(uint32_t ms);
+uint8_t  Timebase_Expired(uint32_t deadline);
+uint32_t Timebase_Since(uint32_t tick);
+uint64_t Timebase_Deadline_Us(uint32_t us);
+uint8_t  Timebase_Expired_Us(uint64_t deadline);
+
+// delay_ms ִ fnٵһģperiod_ms Ϊ 0 ʱ֮ظ
+// ѾߵĶʱ¼ʱжҲܵ
+void Timebase_Timer_Start(Timebase_Timer *t, uint32_t delay_ms, uint32_t period_ms, void (*fn)(void));
+void Timebase_Timer_Stop(Timebase_Timer *t);
+// һʱж ms ڣûжʱ 0xffffPower_Idle  Stop 
+uint16_t Timebase_Next_Due(void);
+
+#endif
@@ -4,22 +4,74 @@
 #include "main.h"
 
 
-// ????????????
-void CS100A_TRIG_START(void);
+// TIM2  1us
+#define ULTRA_TRIG_US        12      // TRIG ģҪ >=10us
+#define ULTRA_WINDOW_US      30000   // Ȼزʱ䴰ûȵ½㳬ʱ
+#define ULTRA_MAX_MM         4500    // ̣زӦ볬㳬
+#define ULTRA_SOUND_SPEED    343     //  m/s
+#define ULTRA_BURST_MAX      5       // һβ
+#define ULTRA_HISTORY        16      // ȣ2 ݣ
 
-typedef struct 
+// ÿһĽ
+typedef enum
+{
+	ULTRA_OK = 0,
+	ULTRA_TIMEOUT,        // ûлز / زʱ䴰
+	ULTRA_OUT_OF_RANGE,   // лز
+	ULTRA_BUSY,           // һβ໹û
+	ULTRA_STATUS_NUM
+} Ultra_Status;
+
+// ״̬
+enum
+{
+	ULTRA_IDLE = 0,
+	ULTRA_TRIG,           // ģʽ TRIG
+	ULTRA_WAIT_RISE,      // Ȼز
+	ULTRA_WAIT_FALL,      // Ȼز½
+};
+
+// һβࣨһ
+typedef struct
+{
+	uint32_t tick;        // ʱ̣Timebase_Ms
+	uint16_t raw_mm;      // ЧزֵûЧزʱΪ 0
+	uint16_t filt_mm;     // EMA ˲ľ
+	uint8_t  status;      // ЧزΪ ULTRA_OKΪһĽ
+	uint8_t  valid;       // Чز
+} Ultra_Sample;
+
+typedef struct
 {
 	uint32_t start_time;
 	uint32_t end_time;
-	float pulse_width;
-	float distance ;
+	uint32_t pulse_us;    // һĻز
+	uint16_t distance_mm; // ˲ľ룬ͨЭ
+
+	// ãUltra_Sound_Init ǰԸ
+	uint8_t  burst;       // ÿβȡֵ
+	uint8_t  ema_shift;   // EMA ϵ 1/2^n
+
+	volatile uint8_t state;
+	uint8_t  shot;
+	uint8_t  valid;
+	uint8_t  filt_init;
+	uint16_t shot_mm[ULTRA_BURST_MAX];
+	int32_t  filt_q4;     // EMA ״̬λ 1/16 mm
+
+	Ultra_Sample history[ULTRA_HISTORY];
+	volatile uint32_t seq;                       // ѷ
+	uint32_t hist[ULTRA_STATUS_NUM];             // ÿһĽͳ
+	uint32_t valid_hist[ULTRA_BURST_MAX + 1];    // ÿЧزķֲ
 }ultra_sound_struct;
 
 extern ultra_sound_struct ultra_sound;
 
-void Get_distance(void);
+void Ultra_Sound_Init(void);
+uint8_t Ultra_Sound_Start(void);
+uint8_t Ultra_Sound_Read(Ultra_Sample *sample);
+void Ultra_Sound_Update_IT(void);
 
 
 
 #endif
-
@@ -60,21 +60,10 @@ void Set_Struct(Connectivity_Protocal_Struct *the_Connectivity_Protocal_Struct,u
 	the_Connectivity_Protocal_Struct->length[1] = '0';//ʱ
 	
 	the_Connectivity_Protocal_Struct->cmd = cd;// COMMOND RESEND REQUIRE
-	uint8_t judege0=0 , judege1=0;
-	for(int i = 0 ; i < 56 ; i ++)
-	{
-		judege0 = (judege0 + the_Connectivity_Protocal_Struct->data[i]%2)%2;
-	}
-	for(int i = 0 ; i < 56 ; i ++)
-	{
-		judege0 = (judege0 + the_Connectivity_Protocal_Struct->data[i]%2)%2;
-	}
-	for(int i = 0 ; i < 56 ; i ++)
-	{
-		judege1 = (judege1 + the_Connectivity_Protocal_Struct->data[i]%3)%3;
-	}
-	the_Connectivity_Protocal_Struct->judgement[0] = judege0 ;
-	the_Connectivity_Protocal_Struct->judgement[1] = judege1 ;
+	// ṹȫ uint8_tڴ沼ֺһ£ֱӶǰ 61 ֽ CRC16
+	uint16_t crc = CRC16_Calc((const uint8_t *)the_Connectivity_Protocal_Struct, 5 + 56);
+	the_Connectivity_Protocal_Struct->judgement[0] = crc >> 8 ;
+	the_Connectivity_Protocal_Struct->judgement[1] = crc & 0xff ;
 	the_Connectivity_Protocal_Struct->back = 'o';
 }
 
@@ -97,6 +86,20 @@ void float2u8Arry(uint8_t *u8Arry, float *floatdata)
         u8Arry[3] = farray[3];
     }
 }
+void fix2u8Arry(uint8_t *u8Arry, q16_t fixdata)
+{
+	int2u8Arry(u8Arry, (int32_t)Fix_Q16_To_Float_Bits(fixdata), 4);
+}
+
+void int2u8Arry(uint8_t *u8Arry, int32_t intdata, uint8_t n)
+{
+	while(n--)
+	{
+		u8Arry[n] = (uint8_t)intdata;
+		intdata >>= 8;
+	}
+}
+
 //涨ǰ8Ϊ
 void Set_Data_Float(Connectivity_Protocal_Struct *the_Connectivity_Protocal_Struct,uint8_t *waishe ,float *datamath ,uint8_t number)
 {
@@ -128,20 +131,286 @@ void Set_Data_uint8_t(Connectivity_Protocal_Struct *the_Connectivity_Protocal_St
 	
 }
 
+// CRC16-CCITT ʽ 0x1021
+static const uint16_t crc16_table[256] =
+{
+	0x0000,0x1021,0x2042,0x3063,0x4084,0x50a5,0x60c6,0x70e7,
+	0x8108,0x9129,0xa14a,0xb16b,0xc18c,0xd1ad,0xe1ce,0xf1ef,
+	0x1231,0x0210,0x3273,0x2252,0x52b5,0x4294,0x72f7,0x62d6,
+	0x9339,0x8318,0xb37b,0xa35a,0xd3bd,0xc39c,0xf3ff,0xe3de,
+	0x2462,0x3443,0x0420,0x1401,0x64e6,0x74c7,0x44a4,0x5485,
+	0xa56a,0xb54b,0x8528,0x9509,0xe5ee,0xf5cf,0xc5ac,0xd58d,
+	0x3653,0x2672,0x1611,0x0630,0x76d7,0x66f6,0x5695,0x46b4,
+	0xb75b,0xa77a,0x9719,0x8738,0xf7df,0xe7fe,0xd79d,0xc7bc,
+	0x48c4,0x58e5,0x6886,0x78a7,0x0840,0x1861,0x2802,0x3823,
+	0xc9cc,0xd9ed,0xe98e,0xf9af,0x8948,0x9969,0xa90a,0xb92b,
+	0x5af5,0x4ad4,0x7ab7,0x6a96,0x1a71,0x0a50,0x3a33,0x2a12,
+	0xdbfd,0xcbdc,0xfbbf,0xeb9e,0x9b79,0x8b58,0xbb3b,0xab1a,
+	0x6ca6,0x7c87,0x4ce4,0x5cc5,0x2c22,0x3c03,0x0c60,0x1c41,
+	0xedae,0xfd8f,0xcdec,0xddcd,0xad2a,0xbd0b,0x8d68,0x9d49,
+	0x7e97,0x6eb6,0x5ed5,0x4ef4,0x3e13,0x2e32,0x1e51,0x0e70,
+	0xff9f,0xefbe,0xdfdd,0xcffc,0xbf1b,0xaf3a,0x9f59,0x8f78,
+	0x9188,0x81a9,0xb1ca,0xa1eb,0xd10c,0xc12d,0xf14e,0xe16f,
+	0x1080,0x00a1,0x30c2,0x20e3,0x5004,0x4025,0x7046,0x6067,
+	0x83b9,0x9398,0xa3fb,0xb3da,0xc33d,0xd31c,0xe37f,0xf35e,
+	0x02b1,0x1290,0x22f3,0x32d2,0x4235,0x5214,0x6277,0x7256,
+	0xb5ea,0xa5cb,0x95a8,0x8589,0xf56e,0xe54f,0xd52c,0xc50d,
+	0x34e2,0x24c3,0x14a0,0x0481,0x7466,0x6447,0x5424,0x4405,
+	0xa7db,0xb7fa,0x8799,0x97b8,0xe75f,0xf77e,0xc71d,0xd73c,
+	0x26d3,0x36f2,0x0691,0x16b0,0x6657,0x7676,0x4615,0x5634,
+	0xd94c,0xc96d,0xf90e,0xe92f,0x99c8,0x89e9,0xb98a,0xa9ab,
+	0x5844,0x4865,0x7806,0x6827,0x18c0,0x08e1,0x3882,0x28a3,
+	0xcb7d,0xdb5c,0xeb3f,0xfb1e,0x8bf9,0x9bd8,0xabbb,0xbb9a,
+	0x4a75,0x5a54,0x6a37,0x7a16,0x0af1,0x1ad0,0x2ab3,0x3a92,
+	0xfd2e,0xed0f,0xdd6c,0xcd4d,0xbdaa,0xad8b,0x9de8,0x8dc9,
+	0x7c26,0x6c07,0x5c64,0x4c45,0x3ca2,0x2c83,0x1ce0,0x0cc1,
+	0xef1f,0xff3e,0xcf5d,0xdf7c,0xaf9b,0xbfba,0x8fd9,0x9ff8,
+	0x6e17,0x7e36,0x4e55,0x5e74,0x2e93,0x3eb2,0x0ed1,0x1ef0,
+};
+
+uint16_t CRC16_Calc(const uint8_t *buf, uint16_t len)
+{
+	uint16_t crc = 0xffff;
+	while(len--)
+	{
+		crc = (crc << 8) ^ crc16_table[(uint8_t)(crc >> 8) ^ *buf++];
+	}
+	return crc;
+}
+
+uint8_t *Frame_V2_Data(uint8_t *frame)
+{
+	return frame + FRAME_V2_HEAD_SIZE;
+}
+
+static uint8_t tx_seq;
+static Tx_History tx_history;
+static Rx_Dedup rx_dedup[LINK_NUM];
+
+uint16_t Frame_V2_Encode(uint8_t *frame, uint8_t cd, uint8_t length)
+{
+	uint8_t seq = tx_seq++;
+	uint8_t slot = seq & (TX_HISTORY_NUM - 1);
+	uint16_t crc;
+
+	if(length > FRAME_DATA_MAX) length = FRAME_DATA_MAX;
+	frame[0] = FRAME_HEAD;
+	frame[1] = FRAME_V2;
+	frame[2] = length;
+	frame[3] = seq;
+	frame[4] = cd;
+	crc = CRC16_Calc(frame + 1, FRAME_V2_HEAD_SIZE - 1 + length);
+	frame[FRAME_V2_HEAD_SIZE + length] = crc >> 8;
+	frame[FRAME_V2_HEAD_SIZE + length + 1] = crc & 0xff;
+	frame[FRAME_V2_HEAD_SIZE + length + 2] = FRAME_BACK;
+	memcpy(tx_history.frame[slot], frame, FRAME_V2_OVERHEAD + length);
+	tx_history.len[slot] = FRAME_V2_OVERHEAD + length;
+	return FRAME_V2_OVERHEAD + length;
+}
+
+uint8_t Frame_V2_Next_Seq(void)
+{
+	return tx_seq;
+}
+
+const uint8_t *Tx_History_Get(uint8_t seq, uint8_t *len)
+{
+	uint8_t slot = seq & (TX_HISTORY_NUM - 1);
+
+	//  8 λƣֻ TX_HISTORY_NUM 
+	if(tx_history.len[slot] == 0 || tx_history.frame[slot][3] != seq ||
+	   (uint8_t)(tx_seq - seq - 1) >= TX_HISTORY_NUM) return NULL;
+	*len = tx_history.len[slot];
+	return tx_history.frame[slot];
+}
+
+uint8_t Rx_Dedup_Check(uint8_t link, const Frame_View *frame, uint8_t *status)
+{
+	Rx_Dedup *d = &rx_dedup[link];
+	uint8_t i;
 
+	for(i = 0; i < RX_DEDUP_NUM; i++)
+	{
+		if(d->cmd[i] && d->cmd[i] == frame->cmd && d->seq[i] == frame->seq && Timebase_Since(d->tick[i]) < RX_DEDUP_MS)
+		{
+			*status = d->status[i];
+			return 1;
+		}
+	}
+	return 0;
+}
+
+void Rx_Dedup_Save(uint8_t link, const Frame_View *frame, uint8_t status)
+{
+	Rx_Dedup *d = &rx_dedup[link];
 
+	d->seq[d->next] = frame->seq;
+	d->cmd[d->next] = frame->cmd;
+	d->status[d->next] = status;
+	d->tick[d->next] = Timebase_Ms();
+	d->next = (d->next + 1) % RX_DEDUP_NUM;
+}
 
+int Frame_Decode(const uint8_t *buf, uint16_t size, Frame_View *view)
+{
+	uint8_t length;
+	uint16_t crc;
 
+	if(size < FRAME_V2_OVERHEAD || buf[0] != FRAME_HEAD) return -1;
+	if(buf[1] == FRAME_V1)
+	{
+		// λֻ֤֡ͷ֡βУ
+		if(size < FRAME_V1_SIZE || buf[FRAME_V1_SIZE - 1] != FRAME_BACK) return -1;
+		view->version = FRAME_V1;
+		view->cmd = buf[4];
+		view->seq = 0;
+		view->length = FRAME_DATA_MAX;
+		view->data = buf + 5;
+		return 0;
+	}
+	if(buf[1] != FRAME_V2) return -1;
+	length = buf[2];
+	if(length > FRAME_DATA_MAX || FRAME_V2_OVERHEAD + length > size) return -1;
+	if(buf[FRAME_V2_HEAD_SIZE + length + 2] != FRAME_BACK) return -1;
+	crc = CRC16_Calc(buf + 1, FRAME_V2_HEAD_SIZE - 1 + length);
+	if(buf[FRAME_V2_HEAD_SIZE + length] != (crc >> 8) || buf[FRAME_V2_HEAD_SIZE + length + 1] != (crc & 0xff)) return -1;
+	view->version = FRAME_V2;
+	view->cmd = buf[4];
+	view->seq = buf[3];
+	view->length = length;
+	view->data = buf + FRAME_V2_HEAD_SIZE;
+	return 0;
+}
 
+// ߣдٸ head߿ head ʱһѾд
+static int Frame_Queue_Push(Frame_Queue *queue, const uint8_t *frame, uint8_t len)
+{
+	uint16_t head = queue->head;
+	uint16_t tail = queue->tail;
+	uint16_t need = len + 1;
 
+	if(head >= tail)
+	{
+		if(head + need > FRAME_QUEUE_SIZE || (head + need == FRAME_QUEUE_SIZE && tail == 0))
+		{
+			// ĩβŲ£дתǺͷʼ
+			if(tail <= need) return -1;
+			queue->buf[head] = 0;
+			head = 0;
+		}
+	}
+	else if(head + need >= tail)
+	{
+		return -1;
+	}
+	queue->buf[head] = len;
+	memcpy(queue->buf + head + 1, frame, len);
+	__DMB();
+	head += need;
+	queue->head = (head == FRAME_QUEUE_SIZE) ? 0 : head;
+	return 0;
+}
 
+const uint8_t *Frame_Queue_Peek(Frame_Queue *queue, uint16_t *len)
+{
+	uint16_t tail = queue->tail;
 
+	if(tail == queue->head) return NULL;
+	if(queue->buf[tail] == 0)
+	{
+		queue->tail = tail = 0;
+		if(tail == queue->head) return NULL;
+	}
+	__DMB();
+	*len = queue->buf[tail];
+	return queue->buf + tail + 1;
+}
 
+void Frame_Queue_Release(Frame_Queue *queue)
+{
+	uint16_t tail = queue->tail;
 
+	tail += queue->buf[tail] + 1;
+	__DMB();
+	queue->tail = (tail == FRAME_QUEUE_SIZE) ? 0 : tail;
+}
 
+static void Frame_Parser_Shift(Frame_Parser *parser, uint8_t n)
+{
+	parser->count -= n;
+	memmove(parser->buf, parser->buf + n, parser->count);
+}
 
+// еֽڣܳ֡ͳ֡˾͵ȸֽ
+static void Frame_Parser_Scan(Frame_Parser *parser, Frame_Queue *queue)
+{
+	Frame_View view;
+	uint8_t need;
 
+	for(;;)
+	{
+		uint8_t k = 0;
+		while(k < parser->count && parser->buf[k] != FRAME_HEAD) k++;
+		if(k)
+		{
+			parser->skipped += k;
+			Frame_Parser_Shift(parser, k);
+		}
+		if(parser->count < 2) return;
 
+		if(parser->buf[1] == FRAME_V1)
+		{
+			need = FRAME_V1_SIZE;
+		}
+		else if(parser->buf[1] == FRAME_V2)
+		{
+			if(parser->count < 3) return;
+			need = parser->buf[2] <= FRAME_DATA_MAX ? FRAME_V2_OVERHEAD + parser->buf[2] : 0;
+		}
+		else
+		{
+			need = 0;
+		}
+		if(need == 0)
+		{
+			parser->resync++;
+			parser->skipped++;
+			Frame_Parser_Shift(parser, 1);
+			continue;
+		}
+		if(parser->count < need) return;
 
+		if(Frame_Decode(parser->buf, need, &view) == 0)
+		{
+			if(Frame_Queue_Push(queue, parser->buf, need) == 0) parser->frames++;
+			else parser->dropped++;
+			Frame_Parser_Shift(parser, need);
+		}
+		else
+		{
+			// 0xa5 ܳһ 0xa5 
+			parser->resync++;
+			parser->skipped++;
+			Frame_Parser_Shift(parser, 1);
+		}
+	}
+}
 
+Link_Stat link_stat[LINK_NUM];
+volatile uint8_t active_link = LINK_UART;
 
+void Frame_Parser_Input(Frame_Parser *parser, Frame_Queue *queue, const uint8_t *data, uint16_t len)
+{
+	while(len--)
+	{
+		uint8_t b = *data++;
+		// ֱֽ֡
+		if(parser->count == 0 && b != FRAME_HEAD)
+		{
+			parser->skipped++;
+			continue;
+		}
+		parser->buf[parser->count++] = b;
+		Frame_Parser_Scan(parser, queue);
+	}
+}
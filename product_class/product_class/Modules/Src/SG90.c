@@ -6,7 +6,21 @@ void SG90_PWM_START(TIM_HandleTypeDef *htim, uint32_t Channel)
 	HAL_TIM_PWM_Start(htim, Channel);
 }
 
+// ǶֱӲ
 void SG90_PWM_CONTROL(TIM_HandleTypeDef *htim, uint32_t Channel , uint16_t degree)
 {
-	__HAL_TIM_SetCompare(htim,Channel,(uint16_t)(((float)degree/1800.0 +0.025)*SG90_TIM_COUNTER_PERIOD));
+	if(degree > FIX_SG90_DEG_MAX) degree = FIX_SG90_DEG_MAX;
+	__HAL_TIM_SetCompare(htim,Channel,fix_sg90_cmp[degree]);
+}
+
+// 0.5ms~2.5ms Ӧ 0~180㣺ռձ = 0.01 / 180000 + 0.025˶ϵ fixmath.h
+void SG90_PWM_CONTROL_FINE(TIM_HandleTypeDef *htim, uint32_t Channel , uint16_t centidegree)
+{
+	__HAL_TIM_SetCompare(htim,Channel,FIX_SG90_CMP(centidegree));
+}
+
+// ȽֵΪ 0 ʱ PWM1 һֱ͵ƽղͲٳ
+void SG90_PWM_RELEASE(TIM_HandleTypeDef *htim, uint32_t Channel)
+{
+	__HAL_TIM_SetCompare(htim,Channel,0);
 }
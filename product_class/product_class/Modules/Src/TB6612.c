@@ -50,9 +50,11 @@ void TB6612_SET_START(TIM_HandleTypeDef *htim, uint32_t Channel)
 	HAL_TIM_PWM_Start(htim, Channel);
 }
 
+// ռձ % ɱȽֵ
 void TB6612_SET_SPEED(TIM_HandleTypeDef *htim, uint32_t Channel , uint16_t degree)
 {
-	__HAL_TIM_SetCompare(htim,Channel,(uint16_t)(((float)degree/100)*TB6612_TIM_COUNTER_PERIOD));
+	if(degree > FIX_DUTY_MAX) degree = FIX_DUTY_MAX;
+	__HAL_TIM_SetCompare(htim,Channel,fix_duty_cmp[degree]);
 }
 	
 
@@ -22,15 +22,24 @@
 
 
 
-static void                           DHT11_GPIO_Config                       ( void );
-static void                           DHT11_Mode_IPU                          ( void );
-static void                           DHT11_Mode_Out_PP                       ( void );
-static uint8_t                        DHT11_ReadByte                          ( void );
-
-/* ĺ궨аѺʱ滻SysTickʱǸͻǸ */
+/* ȡ
+ *   1. DHT11_Start ߣ START
+ *   2. ζʱ DHT11_START_MS ͷߣ EXTI ½жϣ
+ *      ٰ DHT11_RESPONSE_MS / DHT11_FRAME_MS ûӦû
+ *   3. EXTI жֻ½ص DWT ʱ DHT11_EDGES жϣʱĳһĽ
+ *   4. ʱصSysTick ж½ؼ롢У󷢲
+ * һֱǿ©ͷ߾д 1ȡڼ䲻лģʽ
+ */
+DHT11_Ctrl_TypeDef dht11;
 
-#define DHT11_DELAY_US(us)  CPU_TS_Tmr_Delay_US(us)
-#define DHT11_DELAY_MS(ms)  CPU_TS_Tmr_Delay_MS(ms)
+static void                           DHT11_GPIO_Config                       ( void );
+static void                           DHT11_EXTI_Config                       ( void );
+static void                           DHT11_Finish                            ( void );
+static void                           DHT11_Decode                            ( void );
+static void                           DHT11_Release                           ( void );
+static void                           DHT11_Response_Timeout                  ( void );
+static void                           DHT11_Frame_Timeout                     ( void );
+static void                           DHT11_Done                              ( void );
 
  /**
   * @brief  DHT11 ʼ
@@ -41,7 +50,12 @@ void DHT11_Init ( void )
 {
 	DHT11_GPIO_Config ();
 	
-	DHT11_Dout_1;               // GPIOB0
+	DHT11_Dout_1;               // ͷ
+
+	DHT11_EXTI_Config ();
+
+	dht11.state = DHT11_IDLE;
+	dht11.start_tick = Timebase_Ms ();   // ϵҲҪС
 }
 
 
@@ -63,8 +77,10 @@ static void DHT11_GPIO_Config ( void )
 	/*ѡҪƵDHT11_Dout_GPIO_PORT*/															   
   	GPIO_InitStructure.Pin = DHT11_Dout_GPIO_PIN;	
 
-	/*ģʽΪͨ*/
-  	GPIO_InitStructure.Mode = GPIO_MODE_OUTPUT_PP;   
+	/*ģʽΪ©ģϵߣ 1 ʱֱӶ*/
+  	GPIO_InitStructure.Mode = GPIO_MODE_OUTPUT_OD;   
+
+	GPIO_InitStructure.Pull = GPIO_NOPULL;
 
 	/*Ϊ50MHz */   
   	GPIO_InitStructure.Speed = GPIO_SPEED_FREQ_HIGH; 
@@ -76,148 +92,189 @@ static void DHT11_GPIO_Config ( void )
 
 
 /*
- * DHT11_Mode_IPU
- *   ʹDHT11-DATAűΪģʽ
+ * DHT11_EXTI_Config
+ *   űģʽEXTI ֱӰĴΪ½ش
+ *         жλֻڵȴʱ
  *   
  *   
  */
-static void DHT11_Mode_IPU(void)
+static void DHT11_EXTI_Config ( void )
 {
-    GPIO_InitTypeDef GPIO_InitStructure;
-    
-    /*ѡҪƵDHT11_Dout_GPIO_PORT*/	
-    GPIO_InitStructure.Pin = DHT11_Dout_GPIO_PIN;
-    
-    /*ģʽΪģʽ*/ 
-    GPIO_InitStructure.Mode = GPIO_MODE_INPUT ;
-
-    /*Ϊģʽ*/
-    GPIO_InitStructure.Pull  = GPIO_PULLUP;    
-
-    /*ÿ⺯ʼDHT11_Dout_GPIO_PORT*/
-    HAL_GPIO_Init(DHT11_Dout_GPIO_PORT, &GPIO_InitStructure);	 
-	
+	__HAL_RCC_AFIO_CLK_ENABLE();
+
+	AFIO->EXTICR[DHT11_Dout_PINSOURCE >> 2] =
+		( AFIO->EXTICR[DHT11_Dout_PINSOURCE >> 2] & ~( 0x0FUL << ( 4 * ( DHT11_Dout_PINSOURCE & 0x03 ) ) ) )
+		| ( DHT11_Dout_EXTI_PORTSRC << ( 4 * ( DHT11_Dout_PINSOURCE & 0x03 ) ) );
+	EXTI->IMR  &= ~DHT11_Dout_GPIO_PIN;
+	EXTI->EMR  &= ~DHT11_Dout_GPIO_PIN;
+	EXTI->RTSR &= ~DHT11_Dout_GPIO_PIN;
+	EXTI->FTSR |=  DHT11_Dout_GPIO_PIN;
+
+	HAL_NVIC_SetPriority ( DHT11_Dout_EXTI_IRQn, 0, 0 );
+	HAL_NVIC_EnableIRQ ( DHT11_Dout_EXTI_IRQn );
 }
 
 
 /*
- * DHT11_Mode_Out_PP
- *   ʹDHT11-DATAűΪģʽ
- *   
- *   
+ * ʼһζȡ 1 ʾѿʼһβ DHT11_MIN_INTERVAL_MS
+ * һλû 0 DHT11_Read_TempAndHumidity ȡ
  */
-static void DHT11_Mode_Out_PP(void)
+uint8_t DHT11_Start ( void )
 {
- 	GPIO_InitTypeDef GPIO_InitStructure;
-
-	 	/*ѡҪƵDHT11_Dout_GPIO_PORT*/															   
-  	GPIO_InitStructure.Pin = DHT11_Dout_GPIO_PIN;	
-
-	/*ģʽΪͨ*/
-  	GPIO_InitStructure.Mode = GPIO_MODE_OUTPUT_PP;   
+	if ( dht11.state != DHT11_IDLE )
+	{
+		dht11.busy++;
+		return 0;
+	}
+	if ( Timebase_Since ( dht11.start_tick ) < DHT11_MIN_INTERVAL_MS )
+	{
+		dht11.too_soon++;
+		return 0;
+	}
+	dht11.start_tick = Timebase_Ms ();
+	dht11.state = DHT11_START;
+	/**/
+	DHT11_Dout_0;
+	Timebase_Timer_Start ( &dht11.timer, DHT11_START_MS, 0, DHT11_Release );
+	return 1;
+}
 
-	/*Ϊ50MHz */   
-  	GPIO_InitStructure.Speed = GPIO_SPEED_FREQ_HIGH;
 
-	/*ÿ⺯ʼDHT11_Dout_GPIO_PORT*/
-  	HAL_GPIO_Init(DHT11_Dout_GPIO_PORT, &GPIO_InitStructure);	 	 
-	
+/* ȡжϣͷ */
+static void DHT11_Finish ( void )
+{
+	EXTI->IMR &= ~DHT11_Dout_GPIO_PIN;
+	DHT11_Dout_1;
+	dht11.state = DHT11_IDLE;
 }
 
 
-/* 
- * DHT11ȡһֽڣMSB
+/*
+ * һݴΪ40bitλȳ
+ * 8bit ʪ + 8bit ʪС + 8bit ¶ + 8bit ¶С + 8bit У 
+ *  i λĿǵ i+1 ͵ i+2 ½صļ
  */
-static uint8_t DHT11_ReadByte ( void )
+static void DHT11_Decode ( void )
 {
-	uint8_t i, temp=0;
-	
-
-	for(i=0;i<8;i++)    
-	{	 
-		/*ÿbit50us͵ƽÿʼѯֱӻ 50us ͵ƽ */  
-		while(DHT11_Dout_IN()==GPIO_PIN_RESET);
-
-		/*DHT11 26~28usĸߵƽʾ070usߵƽʾ1
-		 *ͨ x usĵƽ״ x ʱ 
-		 */
-		DHT11_DELAY_US(40); //ʱx us ʱҪ0ʱ伴	   	  
+	uint8_t  buf[5] = {0};
+	uint32_t cycles_per_us = SystemCoreClock / 1000000U;
+	uint32_t us;
+	uint8_t  i;
 
-		if(DHT11_Dout_IN()==GPIO_PIN_SET)/* x usΪߵƽʾݡ1 */
+	us = ( dht11.edge_ts[1] - dht11.edge_ts[0] ) / cycles_per_us;
+	if ( us < DHT11_RESPONSE_MIN_US || us > DHT11_RESPONSE_MAX_US )
+	{
+		dht11.bit_errors++;
+		return;
+	}
+	for ( i = 0; i < 40; i++ )
+	{
+		us = ( dht11.edge_ts[i + 2] - dht11.edge_ts[i + 1] ) / cycles_per_us;
+		if ( us < DHT11_BIT_MIN_US || us > DHT11_BIT_MAX_US )
 		{
-			/* ȴ1ĸߵƽ */
-			while(DHT11_Dout_IN()==GPIO_PIN_SET);
-
-			temp|=(uint8_t)(0x01<<(7-i));  //ѵ7-iλ1MSB 
-		}
-		else	 // x usΪ͵ƽʾݡ0
-		{			   
-			temp&=(uint8_t)~(0x01<<(7-i)); //ѵ7-iλ0MSB
+			dht11.bit_errors++;
+			return;
 		}
+		if ( us >= DHT11_BIT_ONE_US )
+			buf[i / 8] |= (uint8_t)( 0x80 >> ( i % 8 ) );
 	}
-	
-	return temp;
-	
-}
 
+	/*ȡǷȷ*/
+	if ( (uint8_t)( buf[0] + buf[1] + buf[2] + buf[3] ) != buf[4] )
+	{
+		dht11.checksum_errors++;
+		return;
+	}
+	dht11.data.humi_int  = buf[0];
+	dht11.data.humi_deci = buf[1];
+	dht11.data.temp_int  = buf[2];
+	dht11.data.temp_deci = buf[3];
+	dht11.data.check_sum = buf[4];
+	dht11.data_tick = Timebase_Ms ();
+	__DMB();
+	dht11.seq++;
+	Sample_Push ( SAMPLE_TEMP, dht11.data_tick, (int16_t)( buf[2] * 10 + buf[3] ) );
+	Sample_Push ( SAMPLE_HUMI, dht11.data_tick, (int16_t)( buf[0] * 10 + buf[1] ) );
+}
 
-/*
- * һݴΪ40bitλȳ
- * 8bit ʪ + 8bit ʪС + 8bit ¶ + 8bit ¶С + 8bit У 
- */
-uint8_t DHT11_Read_TempAndHumidity(DHT11_Data_TypeDef *DHT11_Data)
-{  
-	/*ģʽ*/
-	DHT11_Mode_Out_PP();
-	/**/
-	DHT11_Dout_0;
-	/*ʱ18ms*/
-	DHT11_DELAY_MS(18);
 
-	/* ʱ30us*/
-	DHT11_Dout_1; 
+/*  dht11.timer Ļص SysTick жִ */
 
-	DHT11_DELAY_US(30);   //ʱ30us
+/* ʱ䵽ͷߣӻӦ½ؿʼ¼ */
+static void DHT11_Release ( void )
+{
+	dht11.edges = 0;
+	dht11.state = DHT11_WAIT;
+	__HAL_GPIO_EXTI_CLEAR_IT ( DHT11_Dout_GPIO_PIN );   // ʱµĹλ
+	EXTI->IMR |= DHT11_Dout_GPIO_PIN;
+	DHT11_Dout_1;
+	Timebase_Timer_Start ( &dht11.timer, DHT11_RESPONSE_MS, 0, DHT11_Response_Timeout );
+}
 
-	/*Ϊ жϴӻӦź*/ 
-	DHT11_Mode_IPU();
 
-	/*жϴӻǷе͵ƽӦź 粻ӦӦ*/   
-	if(DHT11_Dout_IN()==GPIO_PIN_RESET)     
+static void DHT11_Response_Timeout ( void )
+{
+	if ( dht11.edges == 0 )
 	{
-		/*ѯֱӻ 80us ͵ƽ ӦźŽ*/  
-		while(DHT11_Dout_IN()==GPIO_PIN_RESET);
-
-		/*ѯֱӻ 80us ߵƽ źŽ*/
-		while(DHT11_Dout_IN()==GPIO_PIN_SET);
+		dht11.no_response++;
+		DHT11_Finish ();
+		return;
+	}
+	/*Ӧ𣬵ꣻEXTI 벢˶ʱжж*/
+	__disable_irq ();
+	if ( dht11.state == DHT11_WAIT )
+		Timebase_Timer_Start ( &dht11.timer, DHT11_FRAME_MS - DHT11_RESPONSE_MS, 0, DHT11_Frame_Timeout );
+	__enable_irq ();
+}
 
-		/*ʼ*/   
-		DHT11_Data->humi_int= DHT11_ReadByte();
 
-		DHT11_Data->humi_deci= DHT11_ReadByte();
+static void DHT11_Frame_Timeout ( void )
+{
+	dht11.timeouts++;
+	DHT11_Finish ();
+}
 
-		DHT11_Data->temp_int= DHT11_ReadByte();
 
-		DHT11_Data->temp_deci= DHT11_ReadByte();
+static void DHT11_Done ( void )
+{
+	PROF_BEGIN ( t0 );
+	DHT11_Decode ();
+	PROF_END ( PROF_DHT11_DECODE, t0 );
+	DHT11_Finish ();
+}
 
-		DHT11_Data->check_sum= DHT11_ReadByte();
 
+/* EXTI ½أֻʱжϣʱĳһĽ */
+void HAL_GPIO_EXTI_Callback ( uint16_t GPIO_Pin )
+{
+	if ( GPIO_Pin != DHT11_Dout_GPIO_PIN || dht11.state != DHT11_WAIT )
+		return;
+	dht11.edge_ts[dht11.edges++] = CPU_TS_TmrRd ();
+	if ( dht11.edges >= DHT11_EDGES )
+	{
+		EXTI->IMR &= ~DHT11_Dout_GPIO_PIN;
+		dht11.state = DHT11_DONE;
+		Timebase_Timer_Start ( &dht11.timer, 0, 0, DHT11_Done );
+	}
+}
 
-		/*ȡŸΪģʽ*/
-		DHT11_Mode_Out_PP();
-		/**/
-		DHT11_Dout_1;
 
-		/*ȡǷȷ*/
-		if(DHT11_Data->check_sum == DHT11_Data->humi_int + DHT11_Data->humi_deci + DHT11_Data->temp_int+ DHT11_Data->temp_deci)
-			return SUCCESS;
-		else 
+/*
+ * ȡһУͨݣûж ERROR
+ *  SysTick жĹб¾ض
+ */
+uint8_t DHT11_Read_TempAndHumidity(DHT11_Data_TypeDef *DHT11_Data)
+{  
+	uint32_t seq;
+	do
+	{
+		seq = dht11.seq;
+		if ( seq == 0 )
 			return ERROR;
-	}
-	
-	else
-		return ERROR;
-	
+		*DHT11_Data = dht11.data;
+		__DMB();
+	} while ( seq != dht11.seq );
+	return SUCCESS;
 }
 
 	  
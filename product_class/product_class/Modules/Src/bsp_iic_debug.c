@@ -17,38 +17,11 @@
 #include "headfile.h"
 
 GPIO_InitTypeDef gpio_initstruct;
-I2C_HandleTypeDef iic_initstruct;
 
+/* 软件IIC引脚配置，硬件I2C2的配置见 i2c.c（MX_I2C2_Init） */
 void IIC_GPIO_Config(void)
 {
     IIC_GPIO_CLK_ENABLE();
-#if IIC_SELECT
-    /* 使能时钟 */
-    __HAL_RCC_AFIO_CLK_ENABLE();
-    IIC_CLK_ENABLE();
-    gpio_initstruct.Mode = GPIO_MODE_AF_OD;
-    gpio_initstruct.Pin = IIC_SDA_GPIO_PIN | IIC_SCL_GPIO_PIN;
-    gpio_initstruct.Pull = GPIO_PULLUP;
-    gpio_initstruct.Speed = GPIO_SPEED_FREQ_HIGH;
-
-    HAL_GPIO_Init(IIC_GPIO_PORT, &gpio_initstruct);
-
-    iic_initstruct.Mode = HAL_I2C_MODE_MASTER;
-    iic_initstruct.Instance = IIC_NUM;                             /* 选择I2C1 */
-    iic_initstruct.Init.ClockSpeed = 100000;                       /* 时钟频率为100000 */
-    iic_initstruct.Init.DutyCycle = I2C_DUTYCYCLE_2;               /* 时钟占空比为low/high = 2:1 */
-    iic_initstruct.Init.OwnAddress1 = 0;                           /* 设备自身地址1只要和其它地址不一样即可 */
-    iic_initstruct.Init.AddressingMode = I2C_ADDRESSINGMODE_7BIT;  /* 寻址模式为7位 */
-    iic_initstruct.Init.DualAddressMode = I2C_DUALADDRESS_DISABLE; /* 不开启双地址模式 */
-    iic_initstruct.Init.OwnAddress2 = 0;                           /* 设备自身地址2为0 */
-    iic_initstruct.Init.GeneralCallMode = I2C_GENERALCALL_DISABLE; /* 不开启广播模式 */
-    iic_initstruct.Init.NoStretchMode = I2C_NOSTRETCH_DISABLE;     /* 禁止时钟延长，主模式下必须禁止 */
-
-    HAL_I2C_Init(&iic_initstruct);
-
-    /* 使能IIC */
-    __HAL_I2C_ENABLE(&iic_initstruct);
-#else
     /* 配置GPIO引脚
      * 此处配置GPIO为开漏模式 强下拉 弱上拉
      * 禁止所有设备输出强上拉的高电平的同时兼顾SDA输入输出
@@ -59,7 +32,6 @@ void IIC_GPIO_Config(void)
     gpio_initstruct.Speed = GPIO_SPEED_FREQ_HIGH;
 
     HAL_GPIO_Init(IIC_GPIO_PORT, &gpio_initstruct);
-#endif
 }
 
 static void IIC_Delay(void)
@@ -189,3 +161,25 @@ uint8_t IIC_Wait_ACK(void)
 
     return ack;
 }
+
+/* 总线恢复：从机在发送中途被打断会一直拉低SDA
+ * 最多给9个SCL时钟让它把这个字节送完，SDA释放后补一个停止信号
+ * 引脚要先配成开漏输出（IIC_GPIO_Config），返回 0:SDA已释放 1:仍被拉低
+ */
+uint8_t IIC_Bus_Clear(void)
+{
+    uint8_t i;
+
+    IIC_SDA_1;
+    IIC_Delay();
+    for (i = 0; i < 9 && !IIC_SDA_READ; i++)
+    {
+        IIC_SCL_0;
+        IIC_Delay();
+        IIC_SCL_1;
+        IIC_Delay();
+    }
+    IIC_Stop();
+
+    return IIC_SDA_READ ? 0 : 1;
+}
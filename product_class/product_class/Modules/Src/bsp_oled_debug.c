@@ -15,6 +15,8 @@
  ******************************************************************************
  */
 #include "headfile.h"
+#include "dma.h"
+#include "usart.h"
 
 /***************************16*16ĵȡģʽʽ*********/
 unsigned char F16x16[] =
@@ -235,57 +237,306 @@ const unsigned char F8X16[]=
 
 
 
-extern I2C_HandleTypeDef iic_initstruct;
+/* Դ棺OLED_GRAM[ҳ][]ÿֽһϵ 8 
+ * ͼֻԴ沢ÿҳĶзΧOLED_Refresh ٰѸĶĲд
+ */
+static uint8_t OLED_GRAM[OLED_PAGES][OLED_COLS];
+static uint8_t OLED_Dirty_Lo[OLED_PAGES];   /* ÿҳĶзΧLo > Hi ʾûиĶ */
+static uint8_t OLED_Dirty_Hi[OLED_PAGES];
 
+OLED_Stat_TypeDef oled_stat;
 
-/* oledд */
-void Oled_Write_Data(uint8_t data)
+/* ̨ˢ£ӲIICOLED_Refresh ѸҳĸĶΧƵ oled_flush 
+ * ÿҳ DMA  3 ֽڵĵַ DMA һҳĶݣ
+ * һδɺ HAL_I2C_MemTxCpltCallback һΣCPU 
+ * ʱֻǣ߻ָѭOLED_Refresh
+ */
+typedef struct
 {
-#if IIC_SELECT
-    HAL_I2C_Mem_Write(&iic_initstruct, OLED_ID, OLED_WR_DATA, I2C_MEMADD_SIZE_8BIT, &data, 1, 0x100);
-#else
+    volatile uint8_t busy;   /* ˢ½ */
+    volatile uint8_t active; /* һ DMA  */
+    volatile uint8_t failed; /* /ʱѭָ */
+    uint8_t again;           /* ˢڼµĸĶˢٴһ */
+    uint8_t page;            /* ˢҳ */
+    uint8_t step;            /* 0:ַ 1: */
+    uint8_t lo[OLED_PAGES];  /* ҪˢзΧ */
+    uint8_t hi[OLED_PAGES];
+    uint8_t cmd[3];
+    uint8_t fails;           /* ָɹһ */
+    Timebase_Timer timer;    /* ǰĳʱ */
+} OLED_Flush_TypeDef;
+
+static OLED_Flush_TypeDef oled_flush;
+static void OLED_Xfer_Timeout(void);
+static uint8_t oled_transport = OLED_TRANSPORT_HW; /* MX_I2C2_Init ֮ I2C2 Ѿ */
+
+/* IICһΣֽ + n ֽڣûӦʱֹͣź˳ 1 */
+static uint8_t Oled_Write_Burst_SW(uint8_t control, const uint8_t *buf, uint16_t n)
+{
+    uint16_t i;
+    uint8_t nack;
+
     IIC_Start();
     IIC_SendByte(OLED_ID);
-    /* ȴӦ */
-    while (IIC_Wait_ACK())
-        ;
-    IIC_SendByte(OLED_WR_DATA);
-    /* ȴӦ */
-    while (IIC_Wait_ACK())
-        ;
-    IIC_SendByte(data);
-    /* ȴӦ */
-    while (IIC_Wait_ACK())
-        ;
+    nack = IIC_Wait_ACK();
+    if (!nack)
+    {
+        IIC_SendByte(control);
+        nack = IIC_Wait_ACK();
+    }
+    for (i = 0; i < n && !nack; i++)
+    {
+        IIC_SendByte(buf[i]);
+        nack = IIC_Wait_ACK();
+    }
     IIC_Stop();
-#endif
+
+    return nack;
+}
+
+static void OLED_Recover(void);
+
+/* һ䣺ֽ + n ֽڣݹãֻѭã 1
+ * ӲIICȵȺ̨ˢ½ʱָߺطָ̫IIC
+ */
+static uint8_t Oled_Write_Burst(uint8_t control, const uint8_t *buf, uint16_t n)
+{
+    oled_stat.transfers++;
+    oled_stat.bytes += n + 2; /* ϵַͿֽ */
+    while (oled_transport == OLED_TRANSPORT_HW)
+    {
+        /* 俨ʱʱʱˢ */
+        while (oled_flush.busy && !oled_flush.failed)
+            ;
+        if (!oled_flush.failed &&
+            HAL_I2C_Mem_Write(&hi2c2, OLED_ID, control, I2C_MEMADD_SIZE_8BIT, (uint8_t *)buf, n, OLED_XFER_TIMEOUT_MS) == HAL_OK)
+        {
+            oled_flush.fails = 0;
+            return 0;
+        }
+        if (!oled_flush.failed)
+            oled_stat.errors++;
+        OLED_Recover();
+    }
+    if (Oled_Write_Burst_SW(control, buf, n))
+    {
+        oled_stat.errors++;
+        return 1;
+    }
+    return 0;
+}
+
+/* oledд */
+void Oled_Write_Data(uint8_t data)
+{
+    Oled_Write_Burst(OLED_WR_DATA, &data, 1);
 }
 
 /* oledд */
 void Oled_Write_Cmd(uint8_t cmd)
 {
-#if IIC_SELECT
-    HAL_I2C_Mem_Write(&iic_initstruct, OLED_ID, OLED_WR_CMD, I2C_MEMADD_SIZE_8BIT, &cmd, 1, 0x100);
-#else
-    IIC_Start();
-    IIC_SendByte(OLED_ID);
-    /* ȴӦ */
-    while (IIC_Wait_ACK())
-        ;
-    IIC_SendByte(OLED_WR_CMD);
-    /* ȴӦ */
-    while (IIC_Wait_ACK())
-        ;
-    IIC_SendByte(cmd);
-    /* ȴӦ */
-    while (IIC_Wait_ACK())
+    Oled_Write_Burst(OLED_WR_CMD, &cmd, 1);
+}
+
+/**
+ * @brief  л䷽ʽ̨ˢ½вл
+ * @param  transport: OLED_TRANSPORT_SW IIC / OLED_TRANSPORT_HW ӲI2C2 + DMA
+ * @retval 1:л 0:ˢ½
+ */
+uint8_t OLED_Set_Transport(uint8_t transport)
+{
+    if (oled_flush.busy)
+        return 0;
+    if (transport != oled_transport)
+    {
+        if (transport == OLED_TRANSPORT_HW)
+        {
+            HAL_I2C_Init(&hi2c2); /* MspInit лظÿ© */
+        }
+        else
+        {
+            HAL_I2C_DeInit(&hi2c2);
+            IIC_GPIO_Config();
+        }
+        oled_transport = transport;
+    }
+    oled_flush.failed = 0;
+    oled_flush.fails = 0;
+    return 1;
+}
+
+uint8_t OLED_Get_Transport(void)
+{
+    return oled_transport;
+}
+
+/* ̨ˢ»û͹Ĺݴ˾ܲͣʱӣ */
+uint8_t OLED_Busy(void)
+{
+    return oled_flush.busy;
+}
+
+/* һδ䣬ȫҳˢʱˢ£ѭж϶ãҪڹжִ
+ * DMA ͨ4 ռʱȲڷһ֡ٵ
+ */
+void OLED_Flush_Kick(void)
+{
+    uint8_t m, lo, control;
+    uint8_t *buf;
+    uint16_t n;
+
+    if (!oled_flush.busy || oled_flush.active || oled_flush.failed)
+        return;
+    for (m = oled_flush.page; m < OLED_PAGES && oled_flush.lo[m] > oled_flush.hi[m]; m++)
         ;
-    IIC_Stop();
-#endif
+    oled_flush.page = m;
+    if (m >= OLED_PAGES)
+    {
+        oled_flush.busy = 0;
+        oled_stat.flushes++;
+        if (oled_flush.again)
+        {
+            oled_flush.again = 0;
+            OS_Task_Trigger(TASK_OLED);
+        }
+        return;
+    }
+    if (!DMA1_Ch4_Acquire(DMA1_CH4_I2C2_TX))
+    {
+        oled_stat.dma_waits++;
+        return;
+    }
+
+    lo = oled_flush.lo[m];
+    if (oled_flush.step == 0)
+    {
+        oled_flush.cmd[0] = 0xb0 + m;                  // ҳַ
+        oled_flush.cmd[1] = lo & 0x0f;                 // еַ 4 λ
+        oled_flush.cmd[2] = ((lo & 0xf0) >> 4) | 0x10; // еַ 4 λ
+        control = OLED_WR_CMD;
+        buf = oled_flush.cmd;
+        n = 3;
+    }
+    else
+    {
+        control = OLED_WR_DATA;
+        buf = &OLED_GRAM[m][lo];
+        n = oled_flush.hi[m] - lo + 1;
+    }
+    oled_flush.active = 1;
+    Timebase_Timer_Start(&oled_flush.timer, OLED_XFER_TIMEOUT_MS, 0, OLED_Xfer_Timeout);
+    if (HAL_I2C_Mem_Write_DMA(&hi2c2, OLED_ID, control, I2C_MEMADD_SIZE_8BIT, buf, n) != HAL_OK)
+    {
+        Timebase_Timer_Stop(&oled_flush.timer);
+        oled_flush.active = 0;
+        oled_flush.failed = 1;
+        oled_stat.errors++;
+        DMA1_Ch4_Release(DMA1_CH4_I2C2_TX);
+        return;
+    }
+    oled_stat.transfers++;
+    oled_stat.bytes += n + 2;
+}
+
+/* һ DMA ɣֹͣźѷ */
+void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+    if (hi2c->Instance != I2C2 || !oled_flush.active)
+        return;
+    Timebase_Timer_Stop(&oled_flush.timer);
+    oled_flush.active = 0;
+    oled_flush.fails = 0;
+    DMA1_Ch4_Release(DMA1_CH4_I2C2_TX);
+    if (oled_flush.step == 0)
+    {
+        oled_flush.step = 1;
+    }
+    else
+    {
+        oled_flush.step = 0;
+        oled_flush.lo[oled_flush.page] = OLED_COLS;
+        oled_flush.hi[oled_flush.page] = 0;
+        oled_flush.page++;
+        oled_stat.pages++;
+    }
+    UART1_Tx_Kick(); /* ֡ڵȾȷڣͨ */
+    OLED_Flush_Kick();
+}
+
+/* NACK / ߴ / ٲöʧHAL Ѿͣ DMA */
+void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c)
+{
+    if (hi2c->Instance != I2C2 || !oled_flush.active)
+        return;
+    Timebase_Timer_Stop(&oled_flush.timer);
+    oled_flush.active = 0;
+    oled_flush.failed = 1;
+    oled_stat.errors++;
+    DMA1_Ch4_Release(DMA1_CH4_I2C2_TX);
+    UART1_Tx_Kick();
+    OS_Task_Trigger(TASK_OLED);
+}
+
+/* 䳬ʱʱĻص SysTick жִ
+ * һδ䳬ʱûɣSCL/SDA סжϣͣ I2C  DMAóͨ
+ */
+static void OLED_Xfer_Timeout(void)
+{
+    __disable_irq();
+    if (oled_flush.active)
+    {
+        __HAL_I2C_DISABLE(&hi2c2);
+        HAL_DMA_Abort(&hdma_i2c2_tx);
+        oled_flush.active = 0;
+        oled_flush.failed = 1;
+        oled_stat.timeouts++;
+        DMA1_Ch4_Release(DMA1_CH4_I2C2_TX);
+        UART1_Tx_Kick();
+        OS_Task_Trigger(TASK_OLED);
+    }
+    __enable_irq();
+}
+
+/* ߻ָûˢĲַŻظĶΧI2C2 ͣº GPIO ߣ³ʼ
+ * ָ OLED_HW_MAX_FAILS λо͸IIC
+ */
+static void OLED_Recover(void)
+{
+    uint8_t m;
+
+    for (m = 0; m < OLED_PAGES; m++)
+    {
+        if (oled_flush.busy && oled_flush.lo[m] <= oled_flush.hi[m])
+        {
+            if (oled_flush.lo[m] < OLED_Dirty_Lo[m])
+                OLED_Dirty_Lo[m] = oled_flush.lo[m];
+            if (oled_flush.hi[m] > OLED_Dirty_Hi[m])
+                OLED_Dirty_Hi[m] = oled_flush.hi[m];
+        }
+        oled_flush.lo[m] = OLED_COLS;
+        oled_flush.hi[m] = 0;
+    }
+    oled_flush.busy = 0;
+    oled_flush.failed = 0;
+    oled_stat.recoveries++;
+
+    HAL_I2C_DeInit(&hi2c2);
+    IIC_GPIO_Config();
+    IIC_Bus_Clear();
+    if (++oled_flush.fails >= OLED_HW_MAX_FAILS)
+    {
+        oled_stat.fallbacks++;
+        oled_flush.fails = 0;
+        oled_transport = OLED_TRANSPORT_SW;
+        return;
+    }
+    HAL_I2C_Init(&hi2c2); /* Init λ I2C */
 }
 
 void OLED_Init(void)
 {
+    OLED_Set_Transport(IIC_SELECT ? OLED_TRANSPORT_HW : OLED_TRANSPORT_SW);
+
     /* ʾ/ر
      * AE--->ʾ
      * AF--->ʾر(ģʽ)
@@ -402,6 +653,13 @@ void OLED_Init(void)
     Oled_Write_Cmd(0x14);
 
     Oled_Write_Cmd(0xAF);
+
+    /* ϵʱϵ RAM ݲȷԴ㲢ΪĶһˢʱдһ */
+    memset(OLED_GRAM, 0, sizeof(OLED_GRAM));
+    memset(OLED_Dirty_Lo, 0, sizeof(OLED_Dirty_Lo));
+    memset(OLED_Dirty_Hi, OLED_COLS - 1, sizeof(OLED_Dirty_Hi));
+    memset(oled_flush.lo, OLED_COLS, sizeof(oled_flush.lo));
+    memset(oled_flush.hi, 0, sizeof(oled_flush.hi));
 }
 
 /**
@@ -410,7 +668,7 @@ void OLED_Init(void)
  *		   y,yλ
  * @retval 
  */
-void OLED_SetPos(unsigned char x, unsigned char y) // ʼ
+void OLED_SetPos(unsigned char x, unsigned char y) // ʼֱ꣨дԴ棩
 {
     Oled_Write_Cmd(0xb0 + y);
     Oled_Write_Cmd(((x & 0xf0) >> 4) | 0x10);
@@ -418,21 +676,100 @@ void OLED_SetPos(unsigned char x, unsigned char y) // 
 }
 
 /**
- * @brief  Ļ
+ * @brief  дԴһֽڣݱ˲żΪĶ
+ * @param  x:(0~127) y:ҳ(0~7) data:8
+ * @retval 
+ */
+static void OLED_PutByte(unsigned char x, unsigned char y, unsigned char data)
+{
+    if (x >= OLED_COLS || y >= OLED_PAGES || OLED_GRAM[y][x] == data)
+        return;
+    OLED_GRAM[y][x] = data;
+    if (x < OLED_Dirty_Lo[y])
+        OLED_Dirty_Lo[y] = x;
+    if (x > OLED_Dirty_Hi[y])
+        OLED_Dirty_Hi[y] = x;
+}
+
+/**
+ * @brief  ԴĶĲдϣÿҳһõַ + һд
+ *         ӲIICں̨ DMA ˢ£ֻһδͷأ
+ *         һλûˢʱĶţˢٴһ TASK_OLED
+ *         IICֱдꣻûиĶʱռ
+ * @param  
+ * @retval 
+ */
+void OLED_Refresh(void)
+{
+    unsigned char m, lo, hi;
+    uint8_t cmd[3];
+    uint8_t pending = 0;
+    uint32_t primask;
+
+    if (oled_transport == OLED_TRANSPORT_HW && oled_flush.failed && !oled_flush.active)
+        OLED_Recover();
+    if (oled_flush.busy)
+    {
+        oled_flush.again = 1;
+        return;
+    }
+    memset(oled_flush.lo, OLED_COLS, sizeof(oled_flush.lo));
+    memset(oled_flush.hi, 0, sizeof(oled_flush.hi));
+
+    for (m = 0; m < OLED_PAGES; m++)
+    {
+        lo = OLED_Dirty_Lo[m];
+        hi = OLED_Dirty_Hi[m];
+        if (lo > hi)
+            continue;
+        OLED_Dirty_Lo[m] = OLED_COLS;
+        OLED_Dirty_Hi[m] = 0;
+
+        if (oled_transport == OLED_TRANSPORT_HW)
+        {
+            oled_flush.lo[m] = lo;
+            oled_flush.hi[m] = hi;
+            pending = 1;
+            continue;
+        }
+        cmd[0] = 0xb0 + m;                 // ҳַ
+        cmd[1] = lo & 0x0f;                // еַ 4 λ
+        cmd[2] = ((lo & 0xf0) >> 4) | 0x10; // еַ 4 λ
+        if (Oled_Write_Burst(OLED_WR_CMD, cmd, 3) || Oled_Write_Burst(OLED_WR_DATA, &OLED_GRAM[m][lo], hi - lo + 1))
+        {
+            /* ûӦ𣬸Ķ´ */
+            OLED_Dirty_Lo[m] = lo;
+            OLED_Dirty_Hi[m] = hi;
+            break;
+        }
+        oled_stat.pages++;
+    }
+
+    if (pending)
+    {
+        primask = __get_PRIMASK();
+        __disable_irq();
+        oled_flush.page = 0;
+        oled_flush.step = 0;
+        oled_flush.busy = 1;
+        OLED_Flush_Kick();
+        __set_PRIMASK(primask);
+    }
+}
+
+/**
+ * @brief  ĻԴ棩
  * @param  fill_data:Ҫ
  * @retval 
  */
 void OLED_Fill(unsigned char fill_data) // ȫ
 {
     unsigned char m, n;
-    for (m = 0; m < 8; m++)
+    for (m = 0; m < OLED_PAGES; m++)
     {
-        Oled_Write_Cmd(0xb0 + m); // page0-page1
-        Oled_Write_Cmd(0x00);     // low column start address
-        Oled_Write_Cmd(0x10);     // high column start address
-        for (n = 0; n < 128; n++)
+        for (n = 0; n < OLED_COLS; n++)
         {
-            Oled_Write_Data(fill_data);
+            OLED_PutByte(n, m, fill_data);
         }
     }
 }
@@ -493,9 +830,8 @@ void OLED_ShowStr(unsigned char x, unsigned char y, unsigned char ch[], unsigned
                 x = 0;
                 y++;
             }
-            OLED_SetPos(x, y);
             for (i = 0; i < 6; i++)
-                Oled_Write_Data(F6x8[c][i]);
+                OLED_PutByte(x + i, y, F6x8[c][i]);
             x += 6;
             j++;
         }
@@ -511,12 +847,10 @@ void OLED_ShowStr(unsigned char x, unsigned char y, unsigned char ch[], unsigned
                 x = 0;
                 y++;
             }
-            OLED_SetPos(x, y);
             for (i = 0; i < 8; i++)
-                Oled_Write_Data(F8X16[c * 16 + i]);
-            OLED_SetPos(x, y + 1);
+                OLED_PutByte(x + i, y, F8X16[c * 16 + i]);
             for (i = 0; i < 8; i++)
-                Oled_Write_Data(F8X16[c * 16 + i + 8]);
+                OLED_PutByte(x + i, y + 1, F8X16[c * 16 + i + 8]);
             x += 8;
             j++;
         }
@@ -535,16 +869,14 @@ void OLED_ShowCN(unsigned char x, unsigned char y, unsigned char n)
 {
     unsigned char wm = 0;
     unsigned int adder = 32 * n;
-    OLED_SetPos(x, y);
     for (wm = 0; wm < 16; wm++)
     {
-        Oled_Write_Data(F16x16[adder]);
+        OLED_PutByte(x + wm, y, F16x16[adder]);
         adder += 1;
     }
-    OLED_SetPos(x, y + 1);
     for (wm = 0; wm < 16; wm++)
     {
-        Oled_Write_Data(F16x16[adder]);
+        OLED_PutByte(x + wm, y + 1, F16x16[adder]);
         adder += 1;
     }
 }
@@ -569,10 +901,9 @@ void OLED_DrawBMP(unsigned char x0, unsigned char y0, unsigned char x1, unsigned
     }
     for (y = y0; y < y1; y++)
     {
-        OLED_SetPos(x0, y);
         for (x = x0; x < x1; x++)
         {
-            Oled_Write_Data(BMP[j++]);
+            OLED_PutByte(x, y, BMP[j++]);
         }
     }
 }
@@ -0,0 +1,128 @@
+#include "headfile.h"
+
+// CPU ʱ cpu_prof.h
+
+Prof_Table prof;
+
+void Prof_Init(void)
+{
+	uint8_t i;
+
+	memset(&prof, 0, sizeof(prof));
+	prof.reset_tick = Timebase_Ms();
+	for(i = 0; i < PROF_NUM; i++)
+	{
+		prof.probe[i].since_tick = prof.reset_tick;
+	}
+	prof.window_tick = prof.reset_tick;
+	prof.window_cyc = CPU_TS_TmrRd();
+	prof.idle_x100 = 10000;
+	prof.idle_min_x100 = 10000;
+	prof.dump_next = PROF_NUM + 1;
+}
+
+//  = 1 - ǿе / ʱStop ڼ CYCCNT ͣţԴӷǿеĲ
+static void Prof_Window(uint32_t idle)
+{
+	uint32_t now = Timebase_Ms();
+	uint32_t ms = now - prof.window_tick;
+	uint32_t cyc = CPU_TS_TmrRd();
+	uint64_t total, busy;
+
+	prof.window_idle += idle;
+	if(ms < PROF_WINDOW_MS) return;
+	total = (uint64_t)ms * (SystemCoreClock / 1000);
+	busy = (uint32_t)(cyc - prof.window_cyc) - prof.window_idle;
+	prof.idle_x100 = busy < total ? (uint16_t)(10000 - busy * 10000 / total) : 0;
+	if(prof.idle_x100 < prof.idle_min_x100) prof.idle_min_x100 = prof.idle_x100;
+	prof.window_tick = now;
+	prof.window_cyc = cyc;
+	prof.window_idle = 0;
+}
+
+void Prof_Record(uint8_t id, uint32_t cycles)
+{
+	Prof_Probe *p = &prof.probe[id];
+	uint32_t bin = 31 - __CLZ(cycles | 1);
+
+	bin = bin > PROF_HIST_SHIFT ? bin - PROF_HIST_SHIFT : 0;
+	if(bin >= PROF_HIST_BINS) bin = PROF_HIST_BINS - 1;
+	p->count++;
+	p->sum += cycles;
+	if(p->count == 1 || cycles < p->min) p->min = cycles;
+	if(cycles > p->max) p->max = cycles;
+	p->hist[bin]++;
+	// ͿжѭֻƽһֱûпʱҲ㴰
+	if(id <= PROF_IDLE) Prof_Window(id == PROF_IDLE ? cycles : 0);
+}
+
+void Prof_Dump_Start(uint8_t reset)
+{
+	prof.dump_next = 0;
+	prof.dump_reset = reset;
+}
+
+uint8_t Prof_Dump_Pending(void)
+{
+	return prof.dump_next <= PROF_NUM;
+}
+
+// ֡ʱͳʱ
+static uint8_t Prof_Encode_Summary(uint8_t *payload)
+{
+	uint32_t now = Timebase_Ms();
+
+	payload[0] = PROF_SUMMARY_ID;
+	payload[1] = PROF_NUM;
+	int2u8Arry(payload + 2, prof.idle_x100, 2);
+	int2u8Arry(payload + 4, prof.idle_min_x100, 2);
+	int2u8Arry(payload + 6, now - prof.reset_tick, 4);
+	payload[10] = SystemCoreClock / 1000000;
+	payload[11] = PROF_HIST_SHIFT;
+	if(prof.dump_reset)
+	{
+		prof.reset_tick = now;
+		prof.idle_min_x100 = 10000;
+	}
+	return 12;
+}
+
+uint8_t Prof_Dump_Next(uint8_t *payload)
+{
+	Prof_Probe p;
+	uint64_t total;
+	uint32_t now, primask;
+	uint8_t id, i;
+
+	if(prof.dump_next == 0)
+	{
+		prof.dump_next++;
+		return Prof_Encode_Summary(payload);
+	}
+	id = prof.dump_next++ - 1;
+
+	// ж̽ڸ£жϿһ
+	primask = __get_PRIMASK();
+	__disable_irq();
+	now = Timebase_Ms();
+	p = prof.probe[id];
+	if(prof.dump_reset)
+	{
+		memset(&prof.probe[id], 0, sizeof(Prof_Probe));
+		prof.probe[id].since_tick = now;
+	}
+	__set_PRIMASK(primask);
+	total = (uint64_t)(now - p.since_tick) * (SystemCoreClock / 1000);
+
+	payload[0] = id;
+	int2u8Arry(payload + 1, p.count, 4);
+	int2u8Arry(payload + 5, p.min, 4);
+	int2u8Arry(payload + 9, p.max, 4);
+	int2u8Arry(payload + 13, p.count ? (uint32_t)(p.sum / p.count) : 0, 4);
+	int2u8Arry(payload + 17, total ? (uint32_t)(p.sum * 10000 / total) : 0, 2);
+	for(i = 0; i < PROF_HIST_BINS; i++)
+	{
+		int2u8Arry(payload + 19 + i * 2, p.hist[i] > 0xffff ? 0xffff : p.hist[i], 2);
+	}
+	return 19 + PROF_HIST_BINS * 2;
+}
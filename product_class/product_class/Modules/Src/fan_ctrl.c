@@ -0,0 +1,180 @@
+#include "headfile.h"
+
+// ȱջƣ fan_ctrl.h
+
+const Fan_Loop fan_loop[FAN_PV_NUM] =
+{
+	// 趨ֵ   ز   kp10%/桢2%/%RH   ki20%//min4%/%RH/min
+	{  250,      5,    100,                 200 },      // 25.0 
+	{  700,     30,     20,                  40 },      // 70.0 %RH
+};
+
+Fan_Ctrl fan =
+{
+	.ch =
+	{
+		{ TB6612_TIM_CHANNEL_A, TB6612_PORT_A },
+#if FAN_NUM > 1
+		{ TB6612_TIM_CHANNEL_B, TB6612_PORT_B },
+#endif
+	},
+};
+
+void Fan_Init(void)
+{
+	uint8_t i;
+
+	for(i = 0; i < FAN_NUM; i++)
+	{
+		TB6612_SET_DIRECTION(fan.ch[i].port, TB6612_STOP);
+		TB6612_SET_SPEED(&TB6612_TIM, fan.ch[i].channel, 0);
+		TB6612_SET_START(&TB6612_TIM, fan.ch[i].channel);
+	}
+	TB6612_SET(TB6612_PORT, TB6612_PORT_PIN, TB6612_WORK);   // STBY
+	fan.sample_tick = Timebase_Ms();   // ϵһֱʪҲʧЧ
+}
+
+static void Fan_Filter(const DHT11_Data_TypeDef *d)
+{
+	int32_t x[FAN_PV_NUM];
+	uint8_t i;
+
+	x[FAN_TEMP] = d->temp_int * 10 + d->temp_deci;
+	x[FAN_HUMI] = d->humi_int * 10 + d->humi_deci;
+	for(i = 0; i < FAN_PV_NUM; i++)
+	{
+		if(!fan.filt_init) fan.pv_q4[i] = x[i] << 4;
+		else fan.pv_q4[i] += ((x[i] << 4) - fan.pv_q4[i]) >> FAN_FILTER_SHIFT;
+		fan.pv[i] = (int16_t)(fan.pv_q4[i] >> 4);
+	}
+	fan.filt_init = 1;
+}
+
+// ز + PIdt Ϊμļms
+static void Fan_Control(uint32_t dt)
+{
+	const int32_t out_min = FAN_MIN_DUTY * 100, out_max = FAN_NUM * 100 * 100;
+	int32_t e, out, best = 0, start;
+	uint8_t i, over = 0, below = 1;
+
+	for(i = 0; i < FAN_PV_NUM; i++)
+	{
+		e = fan.pv[i] - fan_loop[i].setpoint;
+		if(e > fan_loop[i].hyst) over = 1;
+		if(e > -fan_loop[i].hyst) below = 0;
+	}
+	if(fan.state != FAN_ON)
+	{
+		// ͣŵĵȳزٿռձ𲽣ʧЧָʱʧЧռձȽŵ
+		if(fan.state == FAN_OFF && !over) return;
+		start = (fan.state == FAN_OFF) ? out_min : FAN_FAILSAFE_DUTY * 100 * FAN_NUM;
+		fan.state = FAN_ON;
+		for(i = 0; i < FAN_PV_NUM; i++)
+		{
+			// л趨ֵĻ·ѻԤóֵ
+			e = fan.pv[i] - fan_loop[i].setpoint;
+			out = start - fan_loop[i].kp * e;
+			fan.integ[i] = (e > 0 && out > 0) ? out * 100 : 0;
+		}
+		dt = 0;      // ִһ֡ʼ
+	}
+
+	for(i = 0; i < FAN_PV_NUM; i++)
+	{
+		e = fan.pv[i] - fan_loop[i].setpoint;
+		out = fan_loop[i].kp * e + fan.integ[i] / 100;
+		// ޻޻ڽͲٻ
+		if(!(out >= out_max && e > 0) && !(out <= out_min && e < 0))
+		{
+			fan.integ[i] += e * fan_loop[i].ki * (int32_t)dt / 600;
+			if(fan.integ[i] < 0) fan.integ[i] = 0;
+			if(fan.integ[i] > out_max * 100) fan.integ[i] = out_max * 100;
+			out = fan_loop[i].kp * e + fan.integ[i] / 100;
+		}
+		if(out > best) best = out;
+	}
+
+	if(below && best <= out_min)
+	{
+		fan.state = FAN_OFF;
+		fan.demand = 0;
+		return;
+	}
+	if(best < out_min) best = out_min;
+	if(best > out_max) best = out_max;
+	fan.demand = (uint16_t)best;
+}
+
+// ȸ A · 100% Ĳָ B ·B ·ҪռձȲſ֮󻹳 100% Ͳͣ
+static void Fan_Split(void)
+{
+	int16_t d = (fan.demand + 50) / 100;
+	uint8_t i;
+
+	for(i = 0; i < FAN_NUM; i++)
+	{
+		if(fan.state == FAN_FAILSAFE) fan.ch[i].target = FAN_FAILSAFE_DUTY;
+		else if(fan.state == FAN_OFF || d <= 0) fan.ch[i].target = 0;
+		else if(d >= 100) fan.ch[i].target = 100;
+		else if(d >= FAN_MIN_DUTY || i == 0) fan.ch[i].target = (d < FAN_MIN_DUTY) ? FAN_MIN_DUTY : d;
+		else fan.ch[i].target = fan.ch[i].target ? FAN_MIN_DUTY : 0;
+		d -= 100;
+	}
+}
+
+// бʱƽĿ꣺ͣתֱͣתռձȿʼ
+static void Fan_Output(void)
+{
+	Fan_Channel *c;
+	uint8_t i, duty;
+
+	for(i = 0; i < FAN_NUM; i++)
+	{
+		c = &fan.ch[i];
+		duty = c->duty;
+		if(c->target == 0) duty = 0;
+		else if(duty == 0) duty = FAN_MIN_DUTY;
+		else if(duty + FAN_RAMP_STEP < c->target) duty += FAN_RAMP_STEP;
+		else if(duty > c->target + FAN_RAMP_STEP) duty -= FAN_RAMP_STEP;
+		else duty = c->target;
+
+		if(duty != c->duty)
+		{
+			if(c->duty == 0)
+			{
+				TB6612_SET_DIRECTION(c->port, TB6612_UP);
+				c->starts++;
+			}
+			TB6612_SET_SPEED(&TB6612_TIM, c->channel, duty);
+			if(duty == 0) TB6612_SET_DIRECTION(c->port, TB6612_STOP);
+			c->duty = duty;
+		}
+		c->duty_sum += duty;
+	}
+}
+
+void Fan_Run(void)
+{
+	DHT11_Data_TypeDef d;
+	uint32_t now = Timebase_Ms();
+	uint32_t seq = dht11.seq;
+
+	fan.ticks++;
+	if(seq != fan.seq && DHT11_Read_TempAndHumidity(&d) == SUCCESS)
+	{
+		fan.seq = seq;
+		Fan_Filter(&d);
+		Fan_Control(now - fan.sample_tick);
+		fan.sample_tick = now;
+		fan.updates++;
+	}
+	else if(now - fan.sample_tick > FAN_SENSOR_TIMEOUT_MS && fan.state != FAN_FAILSAFE)
+	{
+		// ʪȲˣ֪Ҫ̶ռձתָ˲¿ʼ
+		fan.state = FAN_FAILSAFE;
+		fan.failsafes++;
+		fan.filt_init = 0;
+	}
+	Fan_Split();
+	Fan_Output();
+}
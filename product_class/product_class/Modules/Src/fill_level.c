@@ -0,0 +1,146 @@
+#include "headfile.h"
+
+// ⣬ fill_level.h
+
+Fill_Ctrl fill =
+{
+	.empty_mm = FILL_EMPTY_MM,
+	.full_mm = FILL_FULL_MM,
+	.temp = FILL_DEFAULT_TEMP - 1,    // õһ Fill_Speed һһ
+};
+
+// ¶ٺϵ¶ûͲ
+static void Fill_Speed(int16_t temp)
+{
+	if(temp == fill.temp) return;
+	fill.temp = temp;
+	fill.speed_dm = (uint16_t)(3313 + temp * 606 / 1000);
+	fill.speed_k = ((uint32_t)fill.speed_dm << 16) / (ULTRA_SOUND_SPEED * 10);
+}
+
+void Fill_Init(void)
+{
+	Fill_Speed(FILL_DEFAULT_TEMP);
+	if(BKP->DR1 == FILL_BKP_MAGIC && BKP->DR2 >= BKP->DR3 + FILL_MIN_SPAN_MM && BKP->DR2 <= ULTRA_MAX_MM)
+	{
+		fill.empty_mm = BKP->DR2;
+		fill.full_mm = BKP->DR3;
+	}
+}
+
+static uint8_t Fill_Pct(uint16_t mm)
+{
+	if(mm >= fill.empty_mm) return 0;
+	if(mm <= fill.full_mm) return 100;
+	return (uint8_t)((uint32_t)(fill.empty_mm - mm) * 100 / (fill.empty_mm - fill.full_mm));
+}
+
+uint8_t Fill_Calibrate(uint16_t empty_mm, uint16_t full_mm)
+{
+	if(empty_mm > ULTRA_MAX_MM || empty_mm < full_mm + FILL_MIN_SPAN_MM) return 0;
+	fill.empty_mm = empty_mm;
+	fill.full_mm = full_mm;
+	fill.debounce = 0;
+	if(fill.state != FILL_INIT) fill.pct = Fill_Pct(fill.distance_mm);
+	BKP->DR2 = empty_mm;
+	BKP->DR3 = full_mm;
+	BKP->DR1 = FILL_BKP_MAGIC;
+	return 1;
+}
+
+static void Fill_Set_State(uint8_t state)
+{
+	if(state == fill.state) return;
+	fill.state = state;
+	fill.debounce = 0;
+	fill.event.state = state;
+	fill.event.pct = fill.pct;
+	fill.event.distance_mm = fill.distance_mm;
+	fill.event.tick = Timebase_Ms();
+	fill.event_seq++;
+}
+
+// Ұֵޣ͵ǰ̫ȲҪ FILL_JUMP_CONFIRM ξֱ¶
+static uint8_t Fill_Filter(uint16_t mm)
+{
+	int32_t diff;
+
+	if(fill.state == FILL_INIT || fill.state == FILL_FAULT)
+	{
+		fill.dist_q4 = (int32_t)mm << 4;
+		return 1;
+	}
+	diff = ((int32_t)mm << 4) - fill.dist_q4;
+	if(diff > (FILL_JUMP_MM << 4) || diff < -(FILL_JUMP_MM << 4))
+	{
+		if(++fill.jumps < FILL_JUMP_CONFIRM)
+		{
+			fill.outliers++;
+			return 0;
+		}
+		fill.dist_q4 = (int32_t)mm << 4;
+	}
+	else
+	{
+		fill.dist_q4 += diff >> FILL_EMA_SHIFT;
+	}
+	fill.jumps = 0;
+	return 1;
+}
+
+void Fill_Update(const Ultra_Sample *sample)
+{
+	DHT11_Data_TypeDef dht;
+	uint8_t full;
+
+	if(sample->tick == fill.last_tick) return;
+	fill.last_tick = sample->tick;
+	if(DHT11_Read_TempAndHumidity(&dht) == SUCCESS) Fill_Speed(dht.temp_int * 10 + dht.temp_deci);
+
+	if(!sample->valid)
+	{
+		if(fill.misses < FILL_FAULT_COUNT && ++fill.misses == FILL_FAULT_COUNT) Fill_Set_State(FILL_FAULT);
+		return;
+	}
+	fill.misses = 0;
+	// ñֵ ultra_sound  EMAҰֵ
+	if(!Fill_Filter((uint16_t)((sample->raw_mm * fill.speed_k + (1UL << 15)) >> 16))) return;
+	fill.distance_mm = (uint16_t)(fill.dist_q4 >> 4);
+	fill.pct = Fill_Pct(fill.distance_mm);
+
+	// һЧ߹ϻֱָӶ״̬ȥ
+	if(fill.state == FILL_INIT || fill.state == FILL_FAULT)
+	{
+		Fill_Set_State(fill.pct >= FILL_FULL_PCT ? FILL_FULL : FILL_NORMAL);
+		return;
+	}
+	full = fill.state == FILL_FULL;
+	if(full ? fill.pct <= FILL_CLEAR_PCT : fill.pct >= FILL_FULL_PCT)
+	{
+		if(++fill.debounce >= FILL_DEBOUNCE) Fill_Set_State(full ? FILL_NORMAL : FILL_FULL);
+	}
+	else
+	{
+		fill.debounce = 0;
+	}
+}
+
+uint8_t Fill_Event_Read(uint32_t *seq, Fill_Event *event)
+{
+	if(*seq == fill.event_seq) return 0;
+	*event = fill.event;
+	*seq = fill.event_seq;
+	return 1;
+}
+
+uint8_t Fill_Encode(uint8_t *payload)
+{
+	payload[0] = fill.state;
+	payload[1] = fill.pct;
+	int2u8Arry(payload + 2, fill.distance_mm, 2);
+	int2u8Arry(payload + 4, fill.empty_mm, 2);
+	int2u8Arry(payload + 6, fill.full_mm, 2);
+	int2u8Arry(payload + 8, fill.speed_dm, 2);
+	int2u8Arry(payload + 10, fill.outliers > 0xffff ? 0xffff : fill.outliers, 2);
+	return 12;
+}
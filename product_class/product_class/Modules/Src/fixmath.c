@@ -0,0 +1,157 @@
+#include "headfile.h"
+
+// Ͳ fixmath.h
+
+#define FIX_REP10(f, n)   f(n), f(n + 1), f(n + 2), f(n + 3), f(n + 4), f(n + 5), f(n + 6), f(n + 7), f(n + 8), f(n + 9)
+#define FIX_SG90_DEG(d)   FIX_SG90_CMP((d) * 100)
+
+const uint16_t fix_sg90_cmp[FIX_SG90_DEG_MAX + 1] =
+{
+	FIX_REP10(FIX_SG90_DEG,   0), FIX_REP10(FIX_SG90_DEG,  10), FIX_REP10(FIX_SG90_DEG,  20),
+	FIX_REP10(FIX_SG90_DEG,  30), FIX_REP10(FIX_SG90_DEG,  40), FIX_REP10(FIX_SG90_DEG,  50),
+	FIX_REP10(FIX_SG90_DEG,  60), FIX_REP10(FIX_SG90_DEG,  70), FIX_REP10(FIX_SG90_DEG,  80),
+	FIX_REP10(FIX_SG90_DEG,  90), FIX_REP10(FIX_SG90_DEG, 100), FIX_REP10(FIX_SG90_DEG, 110),
+	FIX_REP10(FIX_SG90_DEG, 120), FIX_REP10(FIX_SG90_DEG, 130), FIX_REP10(FIX_SG90_DEG, 140),
+	FIX_REP10(FIX_SG90_DEG, 150), FIX_REP10(FIX_SG90_DEG, 160), FIX_REP10(FIX_SG90_DEG, 170),
+	FIX_SG90_DEG(180),
+};
+
+const uint16_t fix_duty_cmp[FIX_DUTY_MAX + 1] =
+{
+	FIX_REP10(FIX_DUTY_CMP,  0), FIX_REP10(FIX_DUTY_CMP, 10), FIX_REP10(FIX_DUTY_CMP, 20),
+	FIX_REP10(FIX_DUTY_CMP, 30), FIX_REP10(FIX_DUTY_CMP, 40), FIX_REP10(FIX_DUTY_CMP, 50),
+	FIX_REP10(FIX_DUTY_CMP, 60), FIX_REP10(FIX_DUTY_CMP, 70), FIX_REP10(FIX_DUTY_CMP, 80),
+	FIX_REP10(FIX_DUTY_CMP, 90),
+	FIX_DUTY_CMP(100),
+};
+
+// λ뵽 bit23 õ 24 λβƳĲְ IEEE Ĺ루һʱȡż
+// Q16 Сָټ 16
+uint32_t Fix_Q16_To_Float_Bits(q16_t x)
+{
+	uint32_t sign = 0, m, rem, half;
+	int32_t top;
+
+	if(x == 0) return 0;
+	m = (uint32_t)x;
+	if(x < 0)
+	{
+		sign = 0x80000000u;
+		m = 0u - m;
+	}
+	top = 31 - __CLZ(m);            // λλ
+	if(top > 23)
+	{
+		half = 1u << (top - 24);
+		rem = m & ((half << 1) - 1);
+		m >>= top - 23;
+		if(rem > half || (rem == half && (m & 1))) m++;
+		if(m >> 24)                  // λһλ
+		{
+			m >>= 1;
+			top++;
+		}
+	}
+	else
+	{
+		m <<= 23 - top;
+	}
+	return sign | ((uint32_t)(top - Q16_SHIFT + 127) << 23) | (m & 0x7fffffu);
+}
+
+#if FIX_BENCH
+
+#define FIX_BENCH_LOOPS   256
+
+typedef uint32_t (*Fix_Bench_Fn)(uint32_t i);
+
+Fix_Bench_Result fix_bench;
+static volatile uint32_t bench_sink;
+
+static uint32_t Bench_Empty(uint32_t i)
+{
+	return i;
+}
+
+// ·ĳɶ֮ǰд
+static uint32_t Bench_Distance_Old(uint32_t i)
+{
+	float pulse = (float)(i << 7) * 1e-6f;
+	float distance = pulse * (float)ULTRA_SOUND_SPEED / 2.0f;
+	return (uint32_t)(distance * 1000.0f);
+}
+
+static uint32_t Bench_Angle_Old(uint32_t i)
+{
+	uint16_t degree = (uint16_t)(i * 180 >> 8);
+	return (uint16_t)(((float)degree/1800.0 +0.025)*SG90_TIM_COUNTER_PERIOD);
+}
+
+static uint32_t Bench_Duty_Old(uint32_t i)
+{
+	uint16_t degree = (uint16_t)(i * 100 >> 8);
+	return (uint16_t)(((float)degree/100)*TB6612_TIM_COUNTER_PERIOD);
+}
+
+static uint32_t Bench_Float_Old(uint32_t i)
+{
+	uint8_t buf[4];
+	float distance = (float)(i << 4) * 0.001f;
+	float2u8Arry(buf, &distance);
+	return buf[0];
+}
+
+// ·
+static uint32_t Bench_Distance_New(uint32_t i)
+{
+	return FIX_US_TO_MM(i << 7);
+}
+
+static uint32_t Bench_Angle_New(uint32_t i)
+{
+	return fix_sg90_cmp[i * 180 >> 8];
+}
+
+static uint32_t Bench_Duty_New(uint32_t i)
+{
+	return fix_duty_cmp[i * 100 >> 8];
+}
+
+static uint32_t Bench_Float_New(uint32_t i)
+{
+	uint8_t buf[4];
+	fix2u8Arry(buf, FIX_MM_TO_Q16(i << 4));
+	return buf[0];
+}
+
+// ƽÿε۵ѭ empty
+static uint32_t Fix_Bench_Run(Fix_Bench_Fn fn, uint32_t empty)
+{
+	uint32_t i, t, sum = 0;
+
+	t = CPU_TS_TmrRd();
+	for(i = 0; i < FIX_BENCH_LOOPS; i++) sum += fn(i);
+	t = CPU_TS_TmrRd() - t;
+	bench_sink = sum;
+	return (t > empty) ? (t - empty) / FIX_BENCH_LOOPS : 0;
+}
+
+void Fix_Bench(void)
+{
+	static const Fix_Bench_Fn old_fn[FIX_BENCH_NUM] = { Bench_Distance_Old, Bench_Angle_Old, Bench_Duty_Old, Bench_Float_Old };
+	static const Fix_Bench_Fn new_fn[FIX_BENCH_NUM] = { Bench_Distance_New, Bench_Angle_New, Bench_Duty_New, Bench_Float_New };
+	uint32_t empty, primask;
+	uint8_t k;
+
+	primask = __get_PRIMASK();
+	__disable_irq();             // жȥ
+	empty = Fix_Bench_Run(Bench_Empty, 0) * FIX_BENCH_LOOPS;
+	for(k = 0; k < FIX_BENCH_NUM; k++)
+	{
+		fix_bench.old_cycles[k] = Fix_Bench_Run(old_fn[k], empty);
+		fix_bench.new_cycles[k] = Fix_Bench_Run(new_fn[k], empty);
+	}
+	__set_PRIMASK(primask);
+}
+
+#endif
@@ -0,0 +1,310 @@
+#include "headfile.h"
+#include "usart.h"
+#include "usbd_cdc_if.h"
+
+// ͹Ĺ power.h
+
+extern USBD_HandleTypeDef hUsbDeviceFS;
+
+Power_Ctrl power =
+{
+	.stop_enable = 1,
+	.save_delay_ms = POWER_SAVE_DELAY_MS,
+	.rtc_hz = POWER_LSI_HZ,
+};
+
+// LSI  RTC ⣺ٽ StopλҲ򲻿
+static void Power_RTC_Fail(void)
+{
+	power.rtc_fail = 1;
+	power.stop_enable = 0;
+}
+
+//  RTC->CRL ı־λʱ 0Stop ʱ SysTick ͣţ CYCCNT ʱ
+static uint8_t Power_RTC_Wait(uint32_t flag)
+{
+	uint32_t t0 = CPU_TS_TmrRd();
+
+	while(!(RTC->CRL & flag))
+	{
+		if(CPU_TS_TmrRd() - t0 > POWER_RTC_TIMEOUT_MS * (SystemCoreClock / 1000))
+		{
+			Power_RTC_Fail();
+			return 0;
+		}
+	}
+	return 1;
+}
+
+// RTC Ĵд꣨RTOFFд
+static uint8_t Power_RTC_Wait_Write(void)
+{
+	return Power_RTC_Wait(RTC_CRL_RTOFF);
+}
+
+// APB1 ʱͣλStop֮󣬵 RTC Ĵ APB1 ͬܶ
+static uint8_t Power_RTC_Sync(void)
+{
+	RTC->CRL &= ~RTC_CRL_RSF;
+	return Power_RTC_Wait(RTC_CRL_RSF);
+}
+
+// ָߵ룬Ĺнλض
+static uint32_t Power_RTC_Count(void)
+{
+	uint16_t h, l;
+	do
+	{
+		h = RTC->CNTH;
+		l = RTC->CNTL;
+	} while(h != RTC->CNTH);
+	return (uint32_t)h << 16 | l;
+}
+
+static uint8_t Power_RTC_Set_Alarm(uint32_t cnt)
+{
+	if(!Power_RTC_Wait_Write()) return 0;
+	RTC->CRL |= RTC_CRL_CNF;
+	RTC->ALRH = cnt >> 16;
+	RTC->ALRL = cnt & 0xffff;
+	RTC->CRL &= ~RTC_CRL_CNF;
+	return Power_RTC_Wait_Write();
+}
+
+// RTC ʱѡ LSIƵ1 Լ 25usһֱߣֻ
+void Power_Init(void)
+{
+	uint32_t tick = Timebase_Ms();
+
+	power.start_tick = tick;
+	power.activity_tick = tick;
+	__HAL_RCC_PWR_CLK_ENABLE();
+	__HAL_RCC_BKP_CLK_ENABLE();
+	HAL_PWR_EnableBkUpAccess();
+	RCC->CSR |= RCC_CSR_LSION;
+	while(!(RCC->CSR & RCC_CSR_LSIRDY))
+	{
+		if(Timebase_Since(tick) > POWER_RTC_TIMEOUT_MS)
+		{
+			Power_RTC_Fail();          // LSI ֻ Sleep
+			return;
+		}
+	}
+	if((RCC->BDCR & RCC_BDCR_RTCSEL) != RCC_BDCR_RTCSEL_LSI)
+	{
+		// RTC ʱԴѡֻܿλ
+		RCC->BDCR |= RCC_BDCR_BDRST;
+		RCC->BDCR &= ~RCC_BDCR_BDRST;
+		RCC->BDCR |= RCC_BDCR_RTCSEL_LSI;
+	}
+	RCC->BDCR |= RCC_BDCR_RTCEN;
+	if(!Power_RTC_Sync() || !Power_RTC_Wait_Write()) return;
+	RTC->CRL |= RTC_CRL_CNF;
+	RTC->PRLH = 0;
+	RTC->PRLL = 0;
+	RTC->ALRH = 0xffff;
+	RTC->ALRL = 0xffff;
+	RTC->CRL &= ~RTC_CRL_CNF;
+	if(!Power_RTC_Wait_Write()) return;
+	RTC->CRL &= ~RTC_CRL_ALRF;
+	RTC->CRH |= RTC_CRH_ALRIE;
+
+	// Ӻ USB أ RX ƽʱÿֽڶ½أ Stop ǰŴ
+	EXTI->RTSR |= POWER_EXTI_RTC_ALARM | POWER_EXTI_USB_WAKEUP;
+	HAL_NVIC_SetPriority(RTC_Alarm_IRQn, 0, 0);
+	HAL_NVIC_EnableIRQ(RTC_Alarm_IRQn);
+	HAL_NVIC_SetPriority(USBWakeUp_IRQn, 0, 0);
+	HAL_NVIC_EnableIRQ(USBWakeUp_IRQn);
+
+	power.cal_tick = Timebase_Ms();
+	power.cal_cnt = Power_RTC_Count();
+}
+
+void Power_Activity(void)
+{
+	power.activity_tick = Timebase_Ms();
+	if(power.mode != POWER_RUN)
+	{
+		power.mode = POWER_RUN;
+		OS_Set_Power_Save(0);
+	}
+}
+
+void Power_Config(uint8_t stop_enable, uint32_t save_delay_ms)
+{
+	power.stop_enable = stop_enable && !power.rtc_fail;
+	power.save_delay_ms = save_delay_ms;
+	Power_Activity();
+}
+
+// LSI  SysTick У׼û Stop߶ʵʵ߹ʱ
+static void Power_Calibrate(uint32_t now)
+{
+	uint32_t cnt, hz;
+
+	if(now - power.cal_tick < POWER_CAL_MS) return;
+	cnt = Power_RTC_Count();
+	hz = (uint32_t)((uint64_t)(cnt - power.cal_cnt) * 1000 / (now - power.cal_tick));
+	if(hz >= POWER_LSI_MIN_HZ && hz <= POWER_LSI_MAX_HZ)
+	{
+		power.rtc_hz = power.cal_valid ? (power.rtc_hz * 3 + hz) / 4 : hz;
+		power.cal_valid = 1;
+	}
+	power.cal_tick = now;
+	power.cal_cnt = cnt;
+}
+
+// 軹ڹͲͣʱ
+static uint8_t Power_Busy(void)
+{
+	uint8_t i;
+
+	if(tx_pool.busy || tx_pool.head != tx_pool.tail) return 1;
+	if(ultra_sound.state != ULTRA_IDLE || dht11.state != DHT11_IDLE) return 1;
+	if(OLED_Busy() || servo.state != SERVO_RELEASED) return 1;
+	for(i = 0; i < FAN_NUM; i++)
+	{
+		if(fan.ch[i].duty) return 1;
+	}
+	return 0;
+}
+
+static uint8_t Power_Stop_Block(uint16_t due)
+{
+	if(power.mode != POWER_SAVE || !power.stop_enable) return POWER_BLOCK_MODE;
+	if(!power.cal_valid) return POWER_BLOCK_CAL;
+	if(due < POWER_STOP_MIN_MS) return POWER_BLOCK_DUE;
+	if(hUsbDeviceFS.dev_state == USBD_STATE_CONFIGURED || hUsbDeviceFS.dev_state == USBD_STATE_ADDRESSED)
+		return POWER_BLOCK_USB;
+	if(Power_Busy()) return POWER_BLOCK_BUSY;
+	return POWER_BLOCK_NUM;
+}
+
+static void Power_Sleep(void)
+{
+	uint32_t t0 = CPU_TS_TmrRd();
+
+	__WFI();
+	power.sleep_cycles += CPU_TS_TmrRd() - t0;
+	power.sleeps++;
+}
+
+static void Power_Stop(uint16_t due)
+{
+	uint32_t cnt0, cnt_wake, cnt_clk, pr, ms, us;
+	uint64_t ticks;
+	uint8_t synced;
+
+	// SysTick ֮ͣʱȫ RTC 㣻֮ͣǰѾĽĻ Stop Ϸ
+	HAL_SuspendTick();
+	cnt0 = Power_RTC_Count();
+	if(!Power_RTC_Set_Alarm(cnt0 + (uint32_t)((uint64_t)(due - POWER_WAKE_MARGIN_MS) * power.rtc_hz / 1000)))
+	{
+		// 費ϣ Stop Ѳ˻ Sleep
+		HAL_ResumeTick();
+		Power_Sleep();
+		return;
+	}
+	RTC->CRL &= ~RTC_CRL_ALRF;
+	AFIO->EXTICR[2] &= ~AFIO_EXTICR3_EXTI10;      // EXTI10  PA10
+	EXTI->FTSR |= POWER_EXTI_UART_RX;
+	__HAL_GPIO_EXTI_CLEAR_IT(POWER_EXTI_WAKE);
+	EXTI->IMR |= POWER_EXTI_WAKE;
+
+	HAL_PWR_EnterSTOPMode(PWR_LOWPOWERREGULATOR_ON, PWR_STOPENTRY_WFI);
+
+	// ʱ SYSCLK  HSIжϰ HSE  PLL ϣʱȫָŴж
+	synced = Power_RTC_Sync();
+	cnt_wake = Power_RTC_Count();
+	SystemClock_Config();
+	HAL_ResumeTick();
+	cnt_clk = Power_RTC_Count();
+	if(!synced) cnt_wake = cnt_clk = cnt0;    // ׼Stop ڼʱ䲹
+
+	pr = EXTI->PR & POWER_EXTI_WAKE;
+	EXTI->IMR &= ~POWER_EXTI_WAKE;
+	EXTI->FTSR &= ~POWER_EXTI_UART_RX;
+	__HAL_GPIO_EXTI_CLEAR_IT(POWER_EXTI_WAKE);
+	RTC->CRL &= ~RTC_CRL_ALRF;
+
+	//  Stop ڼûߵʱͬڵʱʱһ
+	ticks = (uint64_t)(cnt_clk - cnt0) * 1000 + power.tick_rem;
+	ms = (uint32_t)(ticks / power.rtc_hz);
+	power.tick_rem = (uint32_t)(ticks % power.rtc_hz);
+	Timebase_Advance(ms);
+	OS_Advance(ms);
+
+	power.stops++;
+	power.stop_ticks += cnt_clk - cnt0;
+	us = (uint32_t)((uint64_t)(cnt_clk - cnt_wake) * 1000000 / power.rtc_hz);
+	power.wake_us_sum += us;
+	if(us > power.wake_us_max) power.wake_us_max = us;
+	power.cal_tick = Timebase_Ms();
+	power.cal_cnt = cnt_clk;
+
+	if(pr & POWER_EXTI_UART_RX) power.wakes[POWER_WAKE_UART]++;
+	else if(pr & POWER_EXTI_USB_WAKEUP) power.wakes[POWER_WAKE_USB]++;
+	else if(pr & POWER_EXTI_RTC_ALARM) power.wakes[POWER_WAKE_RTC]++;
+	else power.wakes[POWER_WAKE_OTHER]++;
+	if(pr & (POWER_EXTI_UART_RX | POWER_EXTI_USB_WAKEUP)) Power_Activity();
+}
+
+void Power_Idle(void)
+{
+	uint32_t now = Timebase_Ms();
+	uint16_t due;
+	uint8_t block;
+
+	Power_Calibrate(now);
+	if(power.mode == POWER_RUN && power.save_delay_ms && now - power.activity_tick >= power.save_delay_ms)
+	{
+		power.mode = POWER_SAVE;
+		power.saves++;
+		OS_Set_Power_Save(1);
+	}
+	due = OS_Next_Due();
+	if(Timebase_Next_Due() < due) due = Timebase_Next_Due();
+	block = Power_Stop_Block(due);
+	if(block < POWER_BLOCK_NUM)
+	{
+		power.blocked[block]++;
+		Power_Sleep();
+	}
+	else
+	{
+		Power_Stop(due);
+	}
+}
+
+// Sleep  CYCCNT 㣬Stop  RTC 㣬ʣµУжϣ
+void Power_Residency(uint32_t *run_ms, uint32_t *sleep_ms, uint32_t *stop_ms)
+{
+	uint32_t total = Timebase_Since(power.start_tick);
+	uint32_t sleep = (uint32_t)(power.sleep_cycles / (SystemCoreClock / 1000));
+	uint32_t stop = (uint32_t)(power.stop_ticks * 1000 / power.rtc_hz);
+
+	*sleep_ms = sleep;
+	*stop_ms = stop;
+	*run_ms = (total > sleep + stop) ? total - sleep - stop : 0;
+}
+
+uint8_t Power_Encode(uint8_t *payload)
+{
+	uint32_t run, sleep, stop;
+
+	Power_Residency(&run, &sleep, &stop);
+	payload[0] = power.mode;
+	payload[1] = power.stop_enable;
+	int2u8Arry(payload + 2, power.save_delay_ms / 1000, 2);
+	int2u8Arry(payload + 4, run, 4);
+	int2u8Arry(payload + 8, sleep, 4);
+	int2u8Arry(payload + 12, stop, 4);
+	int2u8Arry(payload + 16, power.stops, 4);
+	int2u8Arry(payload + 20, power.wakes[POWER_WAKE_RTC], 2);
+	int2u8Arry(payload + 22, power.wakes[POWER_WAKE_UART], 2);
+	int2u8Arry(payload + 24, power.wakes[POWER_WAKE_USB], 2);
+	int2u8Arry(payload + 26, power.stops ? (uint32_t)(power.wake_us_sum / power.stops) : 0, 2);
+	int2u8Arry(payload + 28, power.wake_us_max, 2);
+	int2u8Arry(payload + 30, power.rtc_hz, 2);
+	return 32;
+}
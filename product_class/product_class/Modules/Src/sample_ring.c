@@ -0,0 +1,136 @@
+#include "headfile.h"
+
+static uint32_t distance_tick[SAMPLE_DISTANCE_DEPTH];
+static int16_t  distance_value[SAMPLE_DISTANCE_DEPTH];
+static uint32_t temp_tick[SAMPLE_DHT11_DEPTH];
+static int16_t  temp_value[SAMPLE_DHT11_DEPTH];
+static uint32_t humi_tick[SAMPLE_DHT11_DEPTH];
+static int16_t  humi_value[SAMPLE_DHT11_DEPTH];
+
+Sample_Ring sample_ring[SAMPLE_NUM] =
+{
+	{ distance_tick, distance_value, SAMPLE_DISTANCE_DEPTH - 1, 0 },
+	{ temp_tick,     temp_value,     SAMPLE_DHT11_DEPTH - 1,    0 },
+	{ humi_tick,     humi_value,     SAMPLE_DHT11_DEPTH - 1,    0 },
+};
+
+// дټţ˿ʱѾд
+void Sample_Push(uint8_t ch, uint32_t tick, int16_t value)
+{
+	Sample_Ring *ring = &sample_ring[ch];
+	uint32_t seq = ring->seq;
+
+	ring->tick[seq & ring->mask] = tick;
+	ring->value[seq & ring->mask] = value;
+	__DMB();
+	ring->seq = seq + 1;
+}
+
+// һҪдλþɵǸдĹпܱģܶ
+uint32_t Sample_Oldest(uint8_t ch)
+{
+	uint32_t seq = sample_ring[ch].seq;
+	return (seq > sample_ring[ch].mask) ? seq - sample_ring[ch].mask : 0;
+}
+
+// ټһΣĹбǾʧ
+uint8_t Sample_Get(uint8_t ch, uint32_t seq, uint32_t *tick, int16_t *value)
+{
+	Sample_Ring *ring = &sample_ring[ch];
+
+	if((int32_t)(seq - Sample_Oldest(ch)) < 0 || (int32_t)(ring->seq - seq) <= 0) return 0;
+	__DMB();
+	*tick = ring->tick[seq & ring->mask];
+	*value = ring->value[seq & ring->mask];
+	__DMB();
+	return (int32_t)(seq - Sample_Oldest(ch)) >= 0;
+}
+
+// ʱ˳д룬ֲ
+uint32_t Sample_Find(uint8_t ch, uint32_t tick)
+{
+	uint32_t lo = Sample_Oldest(ch);
+	uint32_t hi = sample_ring[ch].seq;
+	uint32_t mid, t;
+	int16_t v;
+
+	while(lo != hi)
+	{
+		mid = lo + (hi - lo) / 2;
+		if(!Sample_Get(ch, mid, &t, &v))
+		{
+			lo = Sample_Oldest(ch);   // ҹбǣµ
+			if((int32_t)(hi - lo) < 0) lo = hi;
+			continue;
+		}
+		if((int32_t)(t - tick) < 0) lo = mid + 1;
+		else hi = mid;
+	}
+	return lo;
+}
+
+static uint8_t Varint_Put(uint8_t *buf, uint32_t v)
+{
+	uint8_t n = 0;
+	while(v >= 0x80)
+	{
+		buf[n++] = (uint8_t)(v | 0x80);
+		v >>= 7;
+	}
+	buf[n++] = (uint8_t)v;
+	return n;
+}
+
+static void Put_U32(uint8_t *buf, uint32_t v)
+{
+	buf[0] = (uint8_t)(v >> 24);
+	buf[1] = (uint8_t)(v >> 16);
+	buf[2] = (uint8_t)(v >> 8);
+	buf[3] = (uint8_t)v;
+}
+
+uint8_t Sample_Encode(uint8_t ch, uint32_t *seq, uint32_t end, uint8_t *buf, uint8_t size, uint8_t flags)
+{
+	uint32_t s = *seq;
+	uint32_t tick, last_tick = 0;
+	int16_t value, last_value = 0;
+	int32_t dv;
+	uint8_t n = 0, len = 0, k;
+	uint8_t tmp[10];
+
+	while((int32_t)(end - s) > 0 && n < 255)
+	{
+		if(!Sample_Get(ch, s, &tick, &value))
+		{
+			if(n) break;                 // ൽһıˣȷѾõ
+			s = Sample_Oldest(ch);       // ûͱˣɵĽŷ
+			continue;
+		}
+		if(n == 0)
+		{
+			buf[0] = ch | flags;
+			Put_U32(buf + 2, s);
+			Put_U32(buf + 6, tick);
+			buf[10] = (uint8_t)((uint16_t)value >> 8);
+			buf[11] = (uint8_t)value;
+			len = SAMPLE_HEAD_SIZE;
+		}
+		else
+		{
+			dv = (int32_t)value - last_value;
+			k = Varint_Put(tmp, tick - last_tick);
+			k += Varint_Put(tmp + k, (uint32_t)((dv << 1) ^ (dv >> 31)));
+			if(len + k > size) break;
+			memcpy(buf + len, tmp, k);
+			len += k;
+		}
+		last_tick = tick;
+		last_value = value;
+		n++;
+		s++;
+	}
+	*seq = s;
+	if(n == 0) return 0;
+	buf[1] = n;
+	return len;
+}
@@ -3,65 +3,170 @@
 
 struct TaskStruct TaskST[]=
 {
- //  ???   ????ms???????    ?????????    ?????????
-	{ 0,       500,              0,           RED_Led},
-	{ 0,       100,              0,		   GREEN_Led},
+ //  ʱ  ڣms  λms  ʡڣms  ־  
+	{ 0,       0,          0,           0,          0,     Task_Command},     // յʱɴ / USB жϴ
+	{ 0,      50,          0,         500,          0,     Task_Ultrasound},  // 20Hz 
+	{ 0,    2000,       1010,        5000,          0,     Task_DHT11},       // DHT11 ϵ 1s ܶζȡټ 1sʡʱҲҪȷʧЧ 10s 
+	{ 0,     100,         75,        1000,          0,     Task_Fan},         // ȱջµʪȵ˲¼㣬бʱ仯
+	{ 0,     100,         25,        1000,          0,     Task_Telemetry},   // ࣬µĽ
+	{ 0,       0,          0,           0,          0,     Task_OLED},        // ʾݱ仯ʱ
 };
 
 
-/*******************************??????????????????********************************/
+/***************************************************************/
 
-//???????????
-uint8_t TaskCount=	sizeof(TaskST)/sizeof(TaskST[0]);	
+//
+uint8_t TaskCount=	sizeof(TaskST)/sizeof(TaskST[0]);
 
-//?????TIM2_IRQHandler?????????????????
+//λõһξʱ̣ PeachOSRun ǰ
+void OS_Init(void)
+{
+	uint8_t i;
+	__disable_irq();
+	for(i=0;i<TaskCount;i++)
+	{
+		TaskST[i].TaskTickRun = TaskST[i].TaskTickMax;
+		if(TaskST[i].TaskTickMax)
+		{
+			// ʼڼ SysTick Ѿڼʱ¿ʼ
+			TaskST[i].TaskTickNow = TaskST[i].TaskPhase < TaskST[i].TaskTickMax ?
+			                        TaskST[i].TaskTickMax - TaskST[i].TaskPhase : 0;
+			TaskST[i].TaskStatus = 0;
+			TaskST[i].MissCount = 0;
+		}
+		TaskST[i].ReleaseTick = Timebase_Ms();
+	}
+	__enable_irq();
+}
+
+// SysTick_Handler У1ms һ
+//δʱճʱڲΪƯƣʱһλûоͼһδ
 void OS_IT_RUN(void)
 {
 	uint8_t i;
-	for(i=0;i<TaskCount;i++)//???????????
-	{	
-		if(!TaskST[i].TaskStatus)
-		{		
-			if(++TaskST[i].TaskTickNow >= TaskST[i].TaskTickMax)//?????????????????
-			{	
-				TaskST[i].TaskTickNow = 0;
+	for(i=0;i<TaskCount;i++)
+	{
+		if(!TaskST[i].TaskTickMax)
+			continue;
+		if(++TaskST[i].TaskTickNow >= TaskST[i].TaskTickMax)
+		{
+			TaskST[i].TaskTickNow = 0;
+			if(TaskST[i].TaskStatus)
+			{
+				TaskST[i].MissCount++;
+			}
+			else
+			{
+				TaskST[i].ReleaseTick = Timebase_Ms();
 				TaskST[i].TaskStatus = 1;
 			}
 		}
 	}
 }
 
-//????main?????????????????????????????????
-		void PeachOSRun(void)
+//¼񣨿жеãѾĲظʱ
+void OS_Task_Trigger(uint8_t id)
 {
-	uint8_t j=0;
-	while(1)
+	if(id >= TaskCount || TaskST[id].TaskStatus)
+		return;
+	TaskST[id].ReleaseTick = Timebase_Ms();
+	TaskST[id].TaskStatus = 1;
+}
+
+//л / ʡڣжеãʱѾƹͷһľ
+void OS_Set_Power_Save(uint8_t on)
+{
+	uint8_t i;
+	uint16_t max;
+	uint32_t primask = __get_PRIMASK();
+	__disable_irq();
+	for(i=0;i<TaskCount;i++)
 	{
-		if(TaskST[j].TaskStatus)//???????????????
-		{		
-			TaskST[j].FC();				//?????????
-			TaskST[j].TaskStatus=0;		//?????????????
-		}
-		if(++j>=TaskCount)//??????????????????????
-			j=0;		
+		if(!TaskST[i].TaskTickMax)
+			continue;
+		max = (on && TaskST[i].TaskTickSave) ? TaskST[i].TaskTickSave : TaskST[i].TaskTickRun;
+		TaskST[i].TaskTickMax = max;
+		if(TaskST[i].TaskTickNow >= max)
+			TaskST[i].TaskTickNow = max - 1;
 	}
+	__set_PRIMASK(primask);
 }
-/*******************************??????????????????********************************/
-
 
-/*************************???????????*****************************/
-void RED_Led(void)
+//ж ms Ѿ 0жϵ
+uint16_t OS_Next_Due(void)
 {
-	//printf("RED_Led \n");//?????????????????uart???????????????
-	HAL_GPIO_TogglePin(GPIOA,LED_RED_Pin);
-	
+	uint8_t i;
+	uint16_t due = 0xFFFF;
+	for(i=0;i<TaskCount;i++)
+	{
+		if(TaskST[i].TaskStatus)
+			return 0;
+		if(TaskST[i].TaskTickMax && TaskST[i].TaskTickMax - TaskST[i].TaskTickNow < due)
+			due = TaskST[i].TaskTickMax - TaskST[i].TaskTickNow;
+	}
+	return due;
 }
-	
-void GREEN_Led(void)
+
+//Stop ڼ SysTick ͣˣ RTC ߹ʱ䲹ϼʱжϵ
+//Stop ӣ߹ͷ߹ͷҲֻһΣǴ
+void OS_Advance(uint32_t ms)
 {
-	//printf("GREEN_Led \n");//??????
-	HAL_GPIO_TogglePin(GPIOA,LED_GREEN_Pin);
+	uint8_t i;
+	uint32_t t;
+	for(i=0;i<TaskCount;i++)
+	{
+		if(!TaskST[i].TaskTickMax)
+			continue;
+		t = TaskST[i].TaskTickNow + ms;
+		if(t >= TaskST[i].TaskTickMax)
+		{
+			TaskST[i].TaskTickNow = (t - TaskST[i].TaskTickMax) % TaskST[i].TaskTickMax;
+			if(!TaskST[i].TaskStatus)
+			{
+				TaskST[i].ReleaseTick = Timebase_Ms();
+				TaskST[i].TaskStatus = 1;
+			}
+		}
+		else
+		{
+			TaskST[i].TaskTickNow = t;
+		}
+	}
 }
 
-/*************************???????????*****************************/
-	
+// main ᷵
+//ÿδӱͷҵһУûоʱ Power_Idle ˯ߣSleep  Stopж
+void PeachOSRun(void)
+{
+	uint8_t j;
+	uint32_t latency;
+	while(1)
+	{
+		// жϼ飬˯֮жȻܰں˻
+		__disable_irq();
+		for(j=0;j<TaskCount;j++)
+		{
+			if(TaskST[j].TaskStatus)
+				break;
+		}
+		if(j >= TaskCount)
+		{
+			PROF_BEGIN(t0);
+			Power_Idle();
+			PROF_END(PROF_IDLE, t0);
+		}
+		__enable_irq();
+		if(j >= TaskCount)
+			continue;
+
+		latency = Timebase_Since(TaskST[j].ReleaseTick);
+		if(latency > TaskST[j].MaxLatency)
+			TaskST[j].MaxLatency = latency;
+		TaskST[j].TaskStatus = 0;		//־ڼٴξᶪ
+		PROF_BEGIN(t0);
+		TaskST[j].FC();
+		PROF_END(PROF_TASK + j, t0);
+		TaskST[j].RunCount++;
+	}
+}
+/***************************************************************/
@@ -0,0 +1,141 @@
+#include "headfile.h"
+
+// ע TLV 룬 sensor_tlv.h
+
+#define SENSOR_TYPE(t, n)       ((uint8_t)((t) << 4 | (n)))
+
+static uint8_t Sensor_Read_Uptime(int32_t *value)
+{
+	*value = (int32_t)Timebase_Ms();
+	return 1;
+}
+
+static uint8_t Sensor_Read_Distance(int32_t *value)
+{
+	Ultra_Sample sample;
+
+	if(!Ultra_Sound_Read(&sample)) return 0;
+	*value = sample.filt_mm;
+	return 1;
+}
+
+static uint8_t Sensor_Read_Temp(int32_t *value)
+{
+	DHT11_Data_TypeDef data;
+
+	if(DHT11_Read_TempAndHumidity(&data) != SUCCESS) return 0;
+	*value = data.temp_int * 10 + data.temp_deci;
+	return 1;
+}
+
+static uint8_t Sensor_Read_Humi(int32_t *value)
+{
+	DHT11_Data_TypeDef data;
+
+	if(DHT11_Read_TempAndHumidity(&data) != SUCCESS) return 0;
+	*value = data.humi_int * 10 + data.humi_deci;
+	return 1;
+}
+
+static uint8_t Sensor_Read_Servo(int32_t *value)
+{
+	*value = servo.pos;
+	return 1;
+}
+
+static uint8_t Sensor_Read_Class(int32_t *value)
+{
+	*value = servo.cls;
+	return 1;
+}
+
+static uint8_t Sensor_Read_Fan_A(int32_t *value)
+{
+	*value = fan.ch[0].duty;
+	return 1;
+}
+
+static uint8_t Sensor_Read_Fan_B(int32_t *value)
+{
+	if(FAN_NUM < 2) return 0;
+	*value = fan.ch[FAN_NUM - 1].duty;
+	return 1;
+}
+
+static uint8_t Sensor_Read_Fill(int32_t *value)
+{
+	if(fill.state == FILL_INIT || fill.state == FILL_FAULT) return 0;
+	*value = fill.pct;
+	return 1;
+}
+
+const Sensor_Desc sensor_desc[] =
+{
+ //                                         λ                 scale            ms            
+	{SENSOR_UPTIME,   SENSOR_TYPE(SENSOR_U32, 4),   SENSOR_UNIT_MS,       0,    TASK_TELEMETRY,  0,       "TICK    ",  Sensor_Read_Uptime},
+	{SENSOR_DISTANCE, SENSOR_TYPE(SENSOR_U16, 2),   SENSOR_UNIT_MM,       0,    TASK_ULTRASOUND, 0,       "ultra_so",  Sensor_Read_Distance},
+	{SENSOR_TEMP,     SENSOR_TYPE(SENSOR_I16, 2),   SENSOR_UNIT_CELSIUS, -1,    TASK_DHT11,      0,       "TEMP    ",  Sensor_Read_Temp},
+	{SENSOR_HUMI,     SENSOR_TYPE(SENSOR_U16, 2),   SENSOR_UNIT_RH,      -1,    TASK_DHT11,      0,       "HUMI    ",  Sensor_Read_Humi},
+	{SENSOR_SERVO,    SENSOR_TYPE(SENSOR_U16, 2),   SENSOR_UNIT_DEGREE,  -2,    TASK_NUM,        SERVO_TICK_MS, "SG90_USE", Sensor_Read_Servo},
+	{SENSOR_CLASS,    SENSOR_TYPE(SENSOR_U8, 1),    SENSOR_UNIT_NONE,     0,    TASK_NUM,        0,       "CLASS   ",  Sensor_Read_Class},
+	{SENSOR_FAN_A,    SENSOR_TYPE(SENSOR_U8, 1),    SENSOR_UNIT_PERCENT,  0,    TASK_FAN,        0,       "FAN_A   ",  Sensor_Read_Fan_A},
+	{SENSOR_FAN_B,    SENSOR_TYPE(SENSOR_U8, 1),    SENSOR_UNIT_PERCENT,  0,    TASK_FAN,        0,       "FAN_B   ",  Sensor_Read_Fan_B},
+	{SENSOR_FILL,     SENSOR_TYPE(SENSOR_U8, 1),    SENSOR_UNIT_PERCENT,  0,    TASK_ULTRASOUND, 0,       "FILL    ",  Sensor_Read_Fill},
+};
+
+const uint8_t sensor_num = sizeof(sensor_desc) / sizeof(sensor_desc[0]);
+
+static uint8_t describe_next = 0xff;    // ڼ0xff ʾûڷ
+
+uint8_t Sensor_Encode(uint8_t *payload, uint8_t max)
+{
+	const Sensor_Desc *d;
+	uint8_t i, n, len = 0;
+	int32_t value;
+
+	for(i = 0; i < sensor_num; i++)
+	{
+		d = &sensor_desc[i];
+		n = d->type & 0x0f;
+		if(len + SENSOR_TLV_HEAD + n > max) break;
+		if(!d->read(&value)) continue;
+		payload[len] = d->id;
+		payload[len + 1] = d->type;
+		int2u8Arry(payload + len + SENSOR_TLV_HEAD, value, n);
+		len += SENSOR_TLV_HEAD + n;
+	}
+	return len;
+}
+
+void Sensor_Describe_Start(void)
+{
+	describe_next = 0;
+}
+
+uint8_t Sensor_Describe_Pending(void)
+{
+	return describe_next < sensor_num;
+}
+
+uint8_t Sensor_Describe_Next(uint8_t *payload)
+{
+	const Sensor_Desc *d;
+	uint8_t *p = payload + 2;
+	uint8_t k;
+
+	payload[0] = sensor_num;
+	payload[1] = describe_next;
+	for(k = 0; k < SENSOR_DESC_PER_FRAME && describe_next < sensor_num; k++, describe_next++)
+	{
+		d = &sensor_desc[describe_next];
+		p[0] = d->id;
+		p[1] = d->type;
+		p[2] = d->unit;
+		p[3] = (uint8_t)d->scale;
+		// ʡģʽڻ䣬ǰķ
+		int2u8Arry(p + 4, d->task < TASK_NUM ? TaskST[d->task].TaskTickMax : d->period_ms, 2);
+		memcpy(p + 6, d->name, SENSOR_NAME_LEN);
+		p += SENSOR_DESC_SIZE;
+	}
+	return (uint8_t)(p - payload);
+}
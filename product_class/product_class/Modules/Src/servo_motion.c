@@ -0,0 +1,170 @@
+#include "headfile.h"
+
+// ּ˶滮 servo_motion.h
+
+// ÿĿǶȣԭ switch(rubbish_flag) һ
+const Servo_Target servo_target[SERVO_CLASS_NUM] =
+{
+	{   0, SERVO_TRAPEZOID },
+	{  45, SERVO_TRAPEZOID },
+	{  90, SERVO_TRAPEZOID },
+	{ 135, SERVO_TRAPEZOID },
+	{ 180, SERVO_TRAPEZOID },
+};
+
+Servo_Motion servo;
+
+static uint16_t Servo_Sqrt_Ceil(uint32_t x)
+{
+	uint16_t r = 0;
+	while((uint32_t)r * r < x) r++;
+	return r;
+}
+
+//  d0.01㣩ҪڣٶȺͼٶȶ޷
+static void Servo_Plan(uint32_t d)
+{
+	uint32_t n;
+
+	if(servo.profile == SERVO_SCURVE)
+	{
+		// s(u) = 10u^3 - 15u^4 + 6u^5ֵٶ 1.875d/nֵٶ 5.774d/n^2
+		n = (15 * d + 8 * SERVO_VMAX - 1) / (8 * SERVO_VMAX);
+		servo.ta = Servo_Sqrt_Ceil((5774 * d + 1000 * SERVO_AMAX - 1) / (1000 * SERVO_AMAX));
+		if(n < servo.ta) n = servo.ta;
+		servo.tc = 0;
+	}
+	else
+	{
+		//  ta tc ta ڣֵٶ d/(ta+tc)ٶ d/(ta(ta+tc))
+		servo.ta = (SERVO_VMAX + SERVO_AMAX - 1) / SERVO_AMAX;
+		n = (d + SERVO_VMAX - 1) / SERVO_VMAX;
+		if(n > servo.ta)
+		{
+			servo.tc = n - servo.ta;
+		}
+		else
+		{
+			// ̣ٶȾҪ
+			servo.ta = Servo_Sqrt_Ceil((d + SERVO_AMAX - 1) / SERVO_AMAX);
+			servo.tc = 0;
+		}
+		if(servo.ta == 0) servo.ta = 1;
+		n = 2 * servo.ta + servo.tc;
+	}
+	servo.n = (n == 0) ? 1 : n;
+}
+
+//  k ߹ľ
+static int32_t Servo_Profile_Pos(uint16_t k)
+{
+	int64_t num, den;
+	int64_t n = servo.n, ta = servo.ta, tc = servo.tc, j;
+
+	if(k >= servo.n) return servo.distance;
+	if(servo.profile == SERVO_SCURVE)
+	{
+		num = (int64_t)k * k * k * (10 * n * n - 15 * k * n + 6 * (int64_t)k * k);
+		den = n * n * n * n * n;
+	}
+	else
+	{
+		// ٶ k^2ٶб 2taٶκͼٶζԳ
+		den = 2 * ta * (ta + tc);
+		if(k <= ta) num = (int64_t)k * k;
+		else if(k <= ta + tc) num = ta * ta + 2 * ta * (k - ta);
+		else
+		{
+			j = n - k;
+			num = den - j * j;
+		}
+	}
+	return (int32_t)(servo.distance * num / den);
+}
+
+void Servo_Init(uint8_t cls)
+{
+	if(cls >= SERVO_CLASS_NUM) cls = 0;
+	servo.cls = cls;
+	servo.pos = servo_target[cls].degree * 100;
+	servo.notify = 0;
+	SG90_PWM_CONTROL_FINE(&SG90_TIM, SG90_TIM_CHANNEL, (uint16_t)servo.pos);
+	SG90_PWM_START(&SG90_TIM, SG90_TIM_CHANNEL);
+
+	servo.settle = SERVO_HOME_TICKS;
+	servo.state = SERVO_SETTLING;
+	__HAL_TIM_CLEAR_FLAG(&SG90_TIM, TIM_FLAG_UPDATE);
+	__HAL_TIM_ENABLE_IT(&SG90_TIM, TIM_IT_UPDATE);
+}
+
+// ӵǰĽǶ¹滮˶;лĿҲһֻ TIM3 жϣӰж
+uint8_t Servo_Sort(uint8_t cls)
+{
+	int32_t target;
+
+	if(cls >= SERVO_CLASS_NUM || cls == servo.cls) return 0;
+	target = servo_target[cls].degree * 100;
+
+	__HAL_TIM_DISABLE_IT(&SG90_TIM, TIM_IT_UPDATE);
+	if(servo.state == SERVO_MOVING) servo.retargets++;
+	servo.cls = cls;
+	servo.profile = servo_target[cls].profile;
+	servo.start = servo.pos;
+	servo.distance = target - servo.pos;
+	Servo_Plan(servo.distance < 0 ? -servo.distance : servo.distance);
+	servo.k = 0;
+	servo.notify = 1;
+	servo.start_tick = Timebase_Ms();
+	servo.moves++;
+	servo.state = SERVO_MOVING;
+	__HAL_TIM_ENABLE_IT(&SG90_TIM, TIM_IT_UPDATE);
+	return 1;
+}
+
+void Servo_Tick(void)
+{
+	if(servo.state == SERVO_MOVING)
+	{
+		servo.pos = servo.start + Servo_Profile_Pos(++servo.k);
+		SG90_PWM_CONTROL_FINE(&SG90_TIM, SG90_TIM_CHANNEL, (uint16_t)servo.pos);
+		if(servo.k >= servo.n)
+		{
+			servo.done.move_ms = Timebase_Since(servo.start_tick);
+			servo.settle = SERVO_SETTLE_TICKS;
+			servo.state = SERVO_SETTLING;
+		}
+	}
+	else if(servo.state == SERVO_SETTLING)
+	{
+		if(--servo.settle) return;
+		// λˣɿû˶ʱٽж
+		SG90_PWM_RELEASE(&SG90_TIM, SG90_TIM_CHANNEL);
+		__HAL_TIM_DISABLE_IT(&SG90_TIM, TIM_IT_UPDATE);
+		servo.state = SERVO_RELEASED;
+		servo.releases++;
+		if(servo.notify)
+		{
+			servo.done.cls = servo.cls;
+			servo.done.degree = servo_target[servo.cls].degree;
+			servo.done.tick = Timebase_Ms();
+			__DMB();
+			servo.done_seq++;
+			OS_Task_Trigger(TASK_COMMAND);
+		}
+	}
+}
+
+// жĹб¾ض
+uint8_t Servo_Done_Read(uint32_t *seq, Servo_Done *done)
+{
+	uint32_t s;
+	do
+	{
+		s = servo.done_seq;
+		if(s == *seq) return 0;
+		*done = servo.done;
+		__DMB();
+	} while(s != servo.done_seq);
+	*seq = s;
+	return 1;
+}
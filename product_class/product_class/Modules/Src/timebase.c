@@ -0,0 +1,205 @@
+#include "headfile.h"
+
+// ͳһʱʱ timebase.h
+
+#define TIMEBASE_SLOT(ms)       ((ms) & (TIMEBASE_WHEEL_SLOTS - 1))
+
+Timebase_Ctrl timebase;
+
+void Timebase_Init(void)
+{
+	CPU_TS_TmrInit();
+}
+
+uint32_t Timebase_Ms(void)
+{
+	return uwTick;
+}
+
+uint64_t Timebase_Ms64(void)
+{
+	uint32_t primask = __get_PRIMASK();
+	uint64_t ms;
+
+	__disable_irq();
+	ms = (uint64_t)timebase.epoch << 32 | uwTick;
+	__set_PRIMASK(primask);
+	return ms;
+}
+
+// SysTick ¼װʱ PENDSTSETжʱĿѾ߹ uwTick ûӣ
+// ֵǰ˵ǸװģҪ 1ms
+uint64_t Timebase_Us(void)
+{
+	uint32_t primask = __get_PRIMASK();
+	uint32_t load, val, ms, hi;
+	uint64_t us;
+
+	__disable_irq();
+	hi = timebase.epoch;
+	ms = uwTick;
+	load = SysTick->LOAD;
+	val = SysTick->VAL;
+	if((SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) && val > load / 2)
+	{
+		if(++ms == 0) hi++;
+	}
+	us = ((uint64_t)hi << 32 | ms) * 1000 + (load - val) / ((load + 1) / 1000);
+	if(us < timebase.last_us) us = timebase.last_us;
+	timebase.last_us = us;
+	__set_PRIMASK(primask);
+	return us;
+}
+
+uint32_t Timebase_Deadline(uint32_t ms)
+{
+	return uwTick + ms;
+}
+
+uint8_t Timebase_Expired(uint32_t deadline)
+{
+	return (int32_t)(uwTick - deadline) >= 0;
+}
+
+uint32_t Timebase_Since(uint32_t tick)
+{
+	return uwTick - tick;
+}
+
+uint64_t Timebase_Deadline_Us(uint32_t us)
+{
+	return Timebase_Us() + us;
+}
+
+uint8_t Timebase_Expired_Us(uint64_t deadline)
+{
+	return Timebase_Us() >= deadline;
+}
+
+// ڹжʱ
+static void Timebase_Insert(Timebase_Timer *t)
+{
+	Timebase_Timer **slot = &timebase.wheel[TIMEBASE_SLOT(t->expire)];
+
+	t->next = *slot;
+	*slot = t;
+}
+
+static void Timebase_Unlink(Timebase_Timer *t)
+{
+	Timebase_Timer **pp = &timebase.wheel[TIMEBASE_SLOT(t->expire)];
+
+	while(*pp && *pp != t) pp = &(*pp)->next;
+	if(*pp) *pp = t->next;
+}
+
+// ִһﵽ now ΪֹڵĶʱÿֻժһصڿԭж״̬ʱִУ
+// صĶʱڱ
+static void Timebase_Run(uint32_t slot, uint32_t now)
+{
+	Timebase_Timer **pp, *t;
+	void (*fn)(void);
+	uint32_t primask;
+
+	for(;;)
+	{
+		fn = 0;
+		primask = __get_PRIMASK();
+		__disable_irq();
+		for(pp = &timebase.wheel[slot]; (t = *pp) != 0; pp = &t->next)
+		{
+			if((int32_t)(now - t->expire) < 0) continue;   // ҪתȦ
+			*pp = t->next;
+			fn = t->fn;
+			if(t->period)
+			{
+				t->expire += t->period;
+				if((int32_t)(now - t->expire) >= 0) t->expire = now + t->period;   // һϾͲ׷
+				Timebase_Insert(t);
+			}
+			else
+			{
+				t->active = 0;
+			}
+			break;
+		}
+		__set_PRIMASK(primask);
+		if(!fn) break;
+		timebase.fired++;
+		fn();
+	}
+}
+
+void Timebase_Tick(void)
+{
+	uint32_t now = uwTick;
+
+	if(now == 0) timebase.epoch++;
+	Timebase_Run(TIMEBASE_SLOT(now), now);
+}
+
+void Timebase_Advance(uint32_t ms)
+{
+	uint32_t old = uwTick, now = old + ms, fired = timebase.fired, i;
+
+	if(ms == 0) return;
+	uwTick = now;
+	if(now < old) timebase.epoch++;
+	if(ms >= TIMEBASE_WHEEL_SLOTS)
+	{
+		for(i = 0; i < TIMEBASE_WHEEL_SLOTS; i++) Timebase_Run(i, now);
+	}
+	else
+	{
+		for(i = 1; i <= ms; i++) Timebase_Run(TIMEBASE_SLOT(old + i), old + i);
+	}
+	timebase.late += timebase.fired - fired;
+}
+
+void Timebase_Timer_Start(Timebase_Timer *t, uint32_t delay_ms, uint32_t period_ms, void (*fn)(void))
+{
+	uint32_t primask = __get_PRIMASK();
+
+	__disable_irq();
+	if(t->active) Timebase_Unlink(t);
+	t->expire = uwTick + (delay_ms ? delay_ms : 1);
+	t->period = period_ms;
+	t->fn = fn;
+	t->active = 1;
+	Timebase_Insert(t);
+	__set_PRIMASK(primask);
+}
+
+void Timebase_Timer_Stop(Timebase_Timer *t)
+{
+	uint32_t primask = __get_PRIMASK();
+
+	__disable_irq();
+	if(t->active)
+	{
+		Timebase_Unlink(t);
+		t->active = 0;
+	}
+	__set_PRIMASK(primask);
+}
+
+uint16_t Timebase_Next_Due(void)
+{
+	uint32_t primask = __get_PRIMASK();
+	uint32_t now = uwTick, due = 0xffff, i;
+	int32_t left;
+	Timebase_Timer *t;
+
+	__disable_irq();
+	for(i = 0; i < TIMEBASE_WHEEL_SLOTS; i++)
+	{
+		for(t = timebase.wheel[i]; t; t = t->next)
+		{
+			left = (int32_t)(t->expire - now);
+			if(left <= 0) due = 0;
+			else if((uint32_t)left < due) due = left;
+		}
+	}
+	__set_PRIMASK(primask);
+	return due;
+}
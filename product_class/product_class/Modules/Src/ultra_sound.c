@@ -1,38 +1,173 @@
 #include "headfile.h"
 
 // ģ
-ultra_sound_struct ultra_sound = {0,0,0,0};
+// TIM2 ģʽ1us 
+//   1. CH1(PA15) PWM2  TRIG ARR ºԶֹͣTRIG ص͵ƽ
+//   2. ж CH1 ǿΪͣARR Ϊزʱ䴰CH2(PB3) Ȳٲ½
+//   3. ʱ䴰ûȵ½أжϼʱ
+// жɣ
+ultra_sound_struct ultra_sound = {0,0,0,0, 3, 2};
 
 
-
-// ͸ߵƽ
-void CS100A_TRIG_START(void)
+static void Ultra_Set_OC1(uint32_t mode)
 {
-	HAL_GPIO_WritePin(GPIOA, TRIG_Pin, GPIO_PIN_SET);
-	// ʱ72MHz72ָΪ1΢룬һforѭΪ8ָ Դ10΢Ҫ90ѭ
-	for(uint16_t i = 0; i < 100 ; i++);
-	HAL_GPIO_WritePin(GPIOA, TRIG_Pin, GPIO_PIN_RESET);
+	htim2.Instance->CCMR1 = (htim2.Instance->CCMR1 & ~TIM_CCMR1_OC1M) | mode;
 }
 
-void Get_distance()
+static void Ultra_Timer_Run(uint32_t period)
 {
-	// 
+	__HAL_TIM_SET_AUTORELOAD(&htim2, period);
 	__HAL_TIM_SET_COUNTER(&htim2, 0);
-	HAL_TIM_IC_Start(&htim2, TIM_CHANNEL_1);    // Ӳ½
-	HAL_TIM_IC_Start(&htim2, TIM_CHANNEL_2);    // ֱӲ
-	CS100A_TRIG_START();
-	// ȴز
-	while(__HAL_TIM_GET_FLAG(&htim2, TIM_FLAG_CC2) == RESET);
-	// ر־λ
-	__HAL_TIM_CLEAR_FLAG(&htim2, TIM_FLAG_CC2);
-	ultra_sound.start_time = HAL_TIM_ReadCapturedValue(&htim2, TIM_CHANNEL_2);
-	// ȴ½ز
-	while(__HAL_TIM_GET_FLAG(&htim2, TIM_FLAG_CC1) == RESET);
-	// ر־λ
-	__HAL_TIM_CLEAR_FLAG(&htim2, TIM_FLAG_CC1);
-	ultra_sound.end_time = HAL_TIM_ReadCapturedValue(&htim2, TIM_CHANNEL_1);
-	// 
-	uint32_t delte = ultra_sound.end_time - ultra_sound.start_time;
-	ultra_sound.pulse_width = (float)delte * 1e-6 ;  // λ룩
-	ultra_sound.distance = ultra_sound.pulse_width * 340.0 / 2.0f;
+	__HAL_TIM_CLEAR_FLAG(&htim2, TIM_FLAG_UPDATE | TIM_FLAG_CC2 | TIM_FLAG_CC2OF);
+	__HAL_TIM_ENABLE(&htim2);
+}
+
+// һ TRIG
+static void Ultra_Shot(void)
+{
+	ultra_sound.state = ULTRA_TRIG;
+	__HAL_TIM_SET_CAPTUREPOLARITY(&htim2, TIM_CHANNEL_2, TIM_INPUTCHANNELPOLARITY_RISING);
+	Ultra_Set_OC1(TIM_OCMODE_PWM2);       // CNT>=CCR1(=1) ʱΪߣºص
+	Ultra_Timer_Run(ULTRA_TRIG_US);
+}
+
+// ֵn  ULTRA_BURST_MAX
+static uint16_t Ultra_Median(uint16_t *v, uint8_t n)
+{
+	uint8_t i, j;
+	uint16_t x;
+	for(i = 1; i < n; i++)
+	{
+		x = v[i];
+		for(j = i; j > 0 && v[j - 1] > x; j--) v[j] = v[j - 1];
+		v[j] = x;
+	}
+	return v[n / 2];
+}
+
+// һ˲д빲
+static void Ultra_Publish(uint8_t status)
+{
+	Ultra_Sample *s = &ultra_sound.history[ultra_sound.seq & (ULTRA_HISTORY - 1)];
+
+	s->tick = Timebase_Ms();
+	s->valid = ultra_sound.valid;
+	s->raw_mm = 0;
+	s->status = status;
+	if(ultra_sound.valid)
+	{
+		s->raw_mm = Ultra_Median(ultra_sound.shot_mm, ultra_sound.valid);
+		s->status = ULTRA_OK;
+		if(!ultra_sound.filt_init)
+		{
+			ultra_sound.filt_q4 = (int32_t)s->raw_mm << 4;
+			ultra_sound.filt_init = 1;
+		}
+		else
+		{
+			ultra_sound.filt_q4 += (((int32_t)s->raw_mm << 4) - ultra_sound.filt_q4) >> ultra_sound.ema_shift;
+		}
+		ultra_sound.distance_mm = (uint16_t)(ultra_sound.filt_q4 >> 4);
+	}
+	s->filt_mm = (uint16_t)(ultra_sound.filt_q4 >> 4);
+	Sample_Push(SAMPLE_DISTANCE, s->tick, (int16_t)s->filt_mm);
+	ultra_sound.valid_hist[ultra_sound.valid]++;
+	__DMB();
+	ultra_sound.seq++;
+	ultra_sound.state = ULTRA_IDLE;
+}
+
+// һЧͽŷһʱ˵ģܻزֱӽ
+static void Ultra_Shot_Done(uint8_t status, uint16_t mm)
+{
+	htim2.Instance->CR1 &= ~TIM_CR1_CEN;
+	ultra_sound.hist[status]++;
+	if(status == ULTRA_OK)
+	{
+		ultra_sound.shot_mm[ultra_sound.valid++] = mm;
+	}
+	if(++ultra_sound.shot < ultra_sound.burst && status != ULTRA_TIMEOUT)
+	{
+		Ultra_Shot();
+		return;
+	}
+	Ultra_Publish(status);
+}
+
+void Ultra_Sound_Init(void)
+{
+	if(ultra_sound.burst == 0 || ultra_sound.burst > ULTRA_BURST_MAX) ultra_sound.burst = ULTRA_BURST_MAX;
+	ultra_sound.filt_q4 = (int32_t)ULTRA_MAX_MM << 4;   // û⵽֮ǰǰûж
+
+	Ultra_Set_OC1(TIM_OCMODE_FORCED_INACTIVE);
+	HAL_TIM_PWM_Start(&htim2, TIM_CHANNEL_1);          // CH1(PA15)  TRIG
+	HAL_TIM_IC_Start_IT(&htim2, TIM_CHANNEL_2);        // CH2(PB3)  ECHO
+	htim2.Instance->CR1 &= ~TIM_CR1_CEN;               //  Ultra_Sound_Start ٿʼ
+	__HAL_TIM_CLEAR_FLAG(&htim2, TIM_FLAG_UPDATE);
+	__HAL_TIM_ENABLE_IT(&htim2, TIM_IT_UPDATE);
+}
+
+// ʼһβࣨһһλû 0 Ultra_Sound_Read ȡ
+uint8_t Ultra_Sound_Start(void)
+{
+	if(ultra_sound.state != ULTRA_IDLE)
+	{
+		ultra_sound.hist[ULTRA_BUSY]++;
+		return 0;
+	}
+	ultra_sound.shot = 0;
+	ultra_sound.valid = 0;
+	Ultra_Shot();
+	return 1;
+}
+
+// µû 0жĹб¾ض
+uint8_t Ultra_Sound_Read(Ultra_Sample *sample)
+{
+	uint32_t seq;
+	do
+	{
+		seq = ultra_sound.seq;
+		if(seq == 0) return 0;
+		*sample = ultra_sound.history[(seq - 1) & (ULTRA_HISTORY - 1)];
+		__DMB();
+	} while(seq != ultra_sound.seq);
+	return 1;
+}
+
+// TIM2 ж
+void Ultra_Sound_Update_IT(void)
+{
+	if(ultra_sound.state == ULTRA_TRIG)
+	{
+		// TRIG ѾʼȻز
+		Ultra_Set_OC1(TIM_OCMODE_FORCED_INACTIVE);
+		ultra_sound.state = ULTRA_WAIT_RISE;
+		Ultra_Timer_Run(ULTRA_WINDOW_US - 1);
+	}
+	else if(ultra_sound.state != ULTRA_IDLE)
+	{
+		Ultra_Shot_Done(ULTRA_TIMEOUT, 0);
+	}
+}
+
+void HAL_TIM_IC_CaptureCallback(TIM_HandleTypeDef *htim)
+{
+	uint32_t mm;
+	if(htim->Instance != TIM2 || htim->Channel != HAL_TIM_ACTIVE_CHANNEL_2) return;
+	if(ultra_sound.state == ULTRA_WAIT_RISE)
+	{
+		ultra_sound.start_time = HAL_TIM_ReadCapturedValue(&htim2, TIM_CHANNEL_2);
+		__HAL_TIM_SET_CAPTUREPOLARITY(&htim2, TIM_CHANNEL_2, TIM_INPUTCHANNELPOLARITY_FALLING);
+		ultra_sound.state = ULTRA_WAIT_FALL;
+	}
+	else if(ultra_sound.state == ULTRA_WAIT_FALL)
+	{
+		ultra_sound.end_time = HAL_TIM_ReadCapturedValue(&htim2, TIM_CHANNEL_2);
+		ultra_sound.pulse_us = ultra_sound.end_time - ultra_sound.start_time;
+		// ʱ任 mmus * 343 / 2000˶ϵus ʱ䴰ʱе
+		mm = FIX_US_TO_MM(ultra_sound.pulse_us);
+		if(ultra_sound.pulse_us > ULTRA_WINDOW_US || mm > ULTRA_MAX_MM) Ultra_Shot_Done(ULTRA_OUT_OF_RANGE, 0);
+		else Ultra_Shot_Done(ULTRA_OK, (uint16_t)mm);
+	}
 }
@@ -0,0 +1,163 @@
+/**
+ ******************************************************************************
+ * @file    sim.h
+ * @brief   主机仿真内部接口
+ ******************************************************************************
+ * @attention
+ *
+ * 时间模型：虚拟时间（72MHz 内核周期）只由固件的执行推进，和主机快慢无关，
+ * 同一个 --seed 每次跑出来的结果都一样：每进一个插桩函数记 SIM_CALL_CYCLES，
+ * 每次 HAL 访问记 SIM_HAL_CYCLES，忙等（总线传输、HSE 起振）、WFI 和 Stop
+ * 直接跳到下一个事件。每过 tick_us 虚拟微秒在固件线程上轮询一次外设模型，
+ * 有中断要处理就用 SIGUSR1 投给自己，在信号处理函数里按优先级调用 xxx_IRQHandler。
+ * PRIMASK 对应屏蔽 SIGUSR1，所有仿真状态都在 sim_lock() 保护下修改。
+ * 固件在不调用函数的循环里空转等标志（比如等中断改的变量）时时钟推不动，
+ * 内核线程发现固件只占 CPU 不前进，就用 SIGUSR2 让它往前推到下一个中断。
+ * --realtime（接 PTY 时默认打开）让虚拟时间不跑在主机时间 x time_scale 前面。
+ *
+ ******************************************************************************
+ */
+#ifndef __SIM_H
+#define __SIM_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "stm32f1xx_hal.h"
+
+#define SIM_CORE_CLOCK_HZ     72000000U
+#define SIM_CYCLES_PER_US     (SIM_CORE_CLOCK_HZ / 1000000U)
+#define SIM_US(us)            ((uint64_t)(us) * SIM_CYCLES_PER_US)
+#define SIM_MS(ms)            ((uint64_t)(ms) * SIM_CYCLES_PER_US * 1000U)
+#define SIM_CALL_CYCLES       24U      /* 一次函数调用（含函数体）记的周期数 */
+#define SIM_HAL_CYCLES        8U       /* 一次 HAL 读写外设记的周期数 */
+#define SIM_IRQ_ENTRY_CYCLES  12U      /* 异常进入（压栈、取向量） */
+
+/* 中断号偏移后作为数组下标：SysTick(-1) -> 15 */
+#define SIM_IRQ_INDEX(irqn)   ((int)(irqn) + 16)
+#define SIM_IRQ_COUNT         (16 + 43)
+
+/******************************* 运行参数 *************************************/
+typedef struct
+{
+  double      time_scale;        /* --realtime 时虚拟时间相对主机时间的倍率 */
+  uint32_t    tick_us;           /* 外设模型轮询间隔（虚拟时间） */
+  int         realtime;          /* 按主机时间节拍推进，和 PTY 另一端的程序对得上 */
+  uint32_t    duration_ms;       /* 运行时长（虚拟时间），0 表示一直运行 */
+  const char *pty_link;          /* USART1 PTY 的软链接路径 */
+  const char *usb_pty_link;      /* USB CDC PTY 的软链接路径 */
+  const char *report_path;       /* JSON 报告输出路径 */
+  const char *oled_dump_path;    /* 退出时导出 OLED 显存 */
+  double      distance_m;        /* 超声波模型：目标距离 */
+  double      distance_noise_m;  /* 超声波模型：距离噪声（标准差） */
+  int         temp_c;            /* DHT11 模型：温度 */
+  int         humi_pct;          /* DHT11 模型：湿度 */
+  double      heat_c;            /* 桶内模型：风扇不转时比环境高多少度 */
+  double      humi_rise_pct;     /* 桶内模型：风扇不转时比环境高多少 %RH */
+  uint32_t    i2c_nack_every;    /* I2C 故障注入：每 N 次传输地址不应答，0 表示不注入 */
+  uint32_t    lsi_hz;            /* LSI 实际频率（RTC 时钟） */
+  int         no_usb;            /* USB 线没插：设备一直停在默认状态 */
+  uint32_t    seed;
+  int         quiet;
+} sim_options_t;
+
+extern sim_options_t sim_opt;
+
+/******************************* 时钟与锁 *************************************/
+uint64_t sim_now(void);                     /* 当前虚拟周期数 */
+uint64_t sim_host_ns(void);                 /* 启动以来的主机纳秒数 */
+void     sim_advance(uint32_t cycles);      /* 固件执行了 cycles 个周期，只在固件线程上调用 */
+void     sim_spin_until(uint64_t cycles);   /* 忙等到指定虚拟时刻，期间可响应中断 */
+void     sim_lock(void);
+void     sim_unlock(void);
+int      sim_in_handler(void);
+uint64_t sim_wfi_cycles(void);              /* 固件在 WFI 里睡眠的总周期数 */
+uint64_t sim_wfi_count(void);
+uint64_t sim_core_stall_steps(void);        /* 空转时内核线程催促推进的次数 */
+uint32_t sim_rand(void);
+double   sim_rand_gauss(void);
+
+/******************************* 中断 *****************************************/
+/* 电平型中断源：返回非零表示外设仍在请求中断 */
+typedef int (*sim_irq_level_fn)(void);
+
+void sim_irq_set_level_source(IRQn_Type irqn, sim_irq_level_fn fn);
+void sim_irq_pend(IRQn_Type irqn);
+void sim_irq_kick(void);                    /* 有待处理中断时通知固件线程 */
+
+/******************************* 轮询钩子 *************************************/
+void sim_core_init(void);
+void sim_core_start(void);
+void sim_core_poll(uint64_t now);
+
+void sim_gpio_init(void);
+void sim_gpio_poll(uint64_t now);
+void sim_tim_init(void);
+void sim_tim_poll(uint64_t now);
+void sim_uart_init(void);
+void sim_uart_poll(uint64_t now);
+void sim_i2c_init(void);
+void sim_i2c_poll(uint64_t now);
+void sim_usb_init(void);
+void sim_usb_poll(uint64_t now);
+void sim_pwr_init(void);
+void sim_pwr_poll(uint64_t now);
+
+/******************************* 外设间接口 ***********************************/
+/* 外部模型驱动的输入引脚电平变化（用于 EXTI 边沿检测） */
+void     sim_gpio_input_edge(GPIO_TypeDef *port, uint16_t pin, int level, uint64_t t);
+int      sim_gpio_is_output(GPIO_TypeDef *port, uint16_t pin);
+void     sim_gpio_af_output(GPIO_TypeDef *port, uint16_t pin, int level, uint64_t t);
+
+/* TIM 输入通道 TI1/TI2 的电平变化（按时间顺序） */
+void     sim_tim_input_edge(TIM_TypeDef *tim, int ti, int level, uint64_t t);
+
+/* DMA1 通道：外设模型按字节请求传输，传输计数和 HT/TC 标志由 DMA 模型维护 */
+typedef struct
+{
+  uint8_t  *mem;         /* 主机侧内存地址（CMAR 只存得下低 32 位） */
+  uint16_t  size;
+  uint32_t  bytes;       /* 累计传输字节数 */
+} sim_dma_chan_t;
+
+#define SIM_DMA_CHANNELS  7
+
+extern sim_dma_chan_t sim_dma_chan[SIM_DMA_CHANNELS];
+void     sim_dma_init(void);
+int      sim_dma_index(DMA_Channel_TypeDef *ch);
+void     sim_dma_start(DMA_HandleTypeDef *hdma, uint8_t *mem, uint16_t size);
+int      sim_dma_request_read(int idx, uint8_t *data);   /* 存储器 -> 外设，无请求返回 0 */
+int      sim_dma_request_write(int idx, uint8_t data);   /* 外设 -> 存储器，无请求返回 0 */
+
+/* 环境模型：超声波与 DHT11 */
+void     sim_env_init(void);
+void     sim_env_poll(uint64_t now);
+void     sim_env_trig_edge(int level, uint64_t t);
+int      sim_env_echo_level(uint64_t t);
+int      sim_env_dht_level(uint64_t t, int polled);
+void     sim_env_dht_host_drive(int level, uint64_t t);
+
+/* PWR/RCC：Stop 期间时钟停止，HAL_RCC_OscConfig/ClockConfig 里恢复 */
+int      sim_pwr_clock_stopped(void);
+void     sim_pwr_osc_config(const RCC_OscInitTypeDef *osc);
+void     sim_pwr_clock_restored(void);
+
+/******************************* 统计与报告 ***********************************/
+void     sim_prof_irq_enter(int idx);
+void     sim_prof_irq_exit(int idx, uint64_t cycles);
+uint64_t sim_prof_irq_cycles(void);
+void     sim_report_write(void);
+void     sim_report_gpio(FILE *f);
+void     sim_report_tim(FILE *f);
+void     sim_report_uart(FILE *f);
+void     sim_report_i2c(FILE *f);
+void     sim_report_usb(FILE *f);
+void     sim_report_env(FILE *f);
+void     sim_report_pwr(FILE *f);
+void     sim_report_irq(FILE *f);
+void     sim_report_summary(FILE *f);
+const char *sim_prof_current_function(void);
+void     sim_i2c_dump_oled(const char *path);
+
+void     sim_exit(int code);
+
+#endif /* __SIM_H */
@@ -0,0 +1,498 @@
+/**
+ ******************************************************************************
+ * @file    stm32f1xx.h
+ * @brief   仿真用器件头文件（替代 CMSIS/Device 下的 stm32f1xx.h）
+ ******************************************************************************
+ * @attention
+ *
+ * 只在 Simulation 主机构建中使用，提供固件代码用到的寄存器结构、外设实例、
+ * 中断号和内核指令。外设寄存器是普通内存，由仿真内核维护；
+ * DWT/SysTick/SCB 等内核寄存器映射在真实地址上（见 sim_core.c），
+ * 这样 core_delay.c 里直接写地址的代码也能原样编译运行。
+ *
+ ******************************************************************************
+ */
+#ifndef __STM32F1xx_H
+#define __STM32F1xx_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if !defined(STM32F103xB)
+#define STM32F103xB
+#endif
+
+#define __IO volatile
+#define __I  volatile const
+#define __O  volatile
+
+#define __STATIC_INLINE static inline
+
+typedef enum
+{
+  RESET = 0,
+  SET = !RESET
+} FlagStatus, ITStatus;
+
+typedef enum
+{
+  DISABLE = 0,
+  ENABLE = !DISABLE
+} FunctionalState;
+
+typedef enum
+{
+  SUCCESS = 0U,
+  ERROR = !SUCCESS
+} ErrorStatus;
+
+/* 中断号，与 stm32f103xb.h 保持一致 */
+typedef enum
+{
+  NonMaskableInt_IRQn         = -14,
+  HardFault_IRQn              = -13,
+  MemoryManagement_IRQn       = -12,
+  BusFault_IRQn               = -11,
+  UsageFault_IRQn             = -10,
+  SVCall_IRQn                 = -5,
+  DebugMonitor_IRQn           = -4,
+  PendSV_IRQn                 = -2,
+  SysTick_IRQn                = -1,
+  WWDG_IRQn                   = 0,
+  PVD_IRQn                    = 1,
+  TAMPER_IRQn                 = 2,
+  RTC_IRQn                    = 3,
+  FLASH_IRQn                  = 4,
+  RCC_IRQn                    = 5,
+  EXTI0_IRQn                  = 6,
+  EXTI1_IRQn                  = 7,
+  EXTI2_IRQn                  = 8,
+  EXTI3_IRQn                  = 9,
+  EXTI4_IRQn                  = 10,
+  DMA1_Channel1_IRQn          = 11,
+  DMA1_Channel2_IRQn          = 12,
+  DMA1_Channel3_IRQn          = 13,
+  DMA1_Channel4_IRQn          = 14,
+  DMA1_Channel5_IRQn          = 15,
+  DMA1_Channel6_IRQn          = 16,
+  DMA1_Channel7_IRQn          = 17,
+  ADC1_2_IRQn                 = 18,
+  USB_HP_CAN1_TX_IRQn         = 19,
+  USB_LP_CAN1_RX0_IRQn        = 20,
+  CAN1_RX1_IRQn               = 21,
+  CAN1_SCE_IRQn               = 22,
+  EXTI9_5_IRQn                = 23,
+  TIM1_BRK_IRQn               = 24,
+  TIM1_UP_IRQn                = 25,
+  TIM1_TRG_COM_IRQn           = 26,
+  TIM1_CC_IRQn                = 27,
+  TIM2_IRQn                   = 28,
+  TIM3_IRQn                   = 29,
+  TIM4_IRQn                   = 30,
+  I2C1_EV_IRQn                = 31,
+  I2C1_ER_IRQn                = 32,
+  I2C2_EV_IRQn                = 33,
+  I2C2_ER_IRQn                = 34,
+  SPI1_IRQn                   = 35,
+  SPI2_IRQn                   = 36,
+  USART1_IRQn                 = 37,
+  USART2_IRQn                 = 38,
+  USART3_IRQn                 = 39,
+  EXTI15_10_IRQn              = 40,
+  RTC_Alarm_IRQn              = 41,
+  USBWakeUp_IRQn              = 42,
+} IRQn_Type;
+
+/******************************* 外设寄存器 ***********************************/
+typedef struct
+{
+  __IO uint32_t CRL;
+  __IO uint32_t CRH;
+  __IO uint32_t IDR;
+  __IO uint32_t ODR;
+  __IO uint32_t BSRR;
+  __IO uint32_t BRR;
+  __IO uint32_t LCKR;
+} GPIO_TypeDef;
+
+typedef struct
+{
+  __IO uint32_t CR1;
+  __IO uint32_t CR2;
+  __IO uint32_t SMCR;
+  __IO uint32_t DIER;
+  __IO uint32_t SR;
+  __IO uint32_t EGR;
+  __IO uint32_t CCMR1;
+  __IO uint32_t CCMR2;
+  __IO uint32_t CCER;
+  __IO uint32_t CNT;
+  __IO uint32_t PSC;
+  __IO uint32_t ARR;
+  __IO uint32_t RCR;
+  __IO uint32_t CCR1;
+  __IO uint32_t CCR2;
+  __IO uint32_t CCR3;
+  __IO uint32_t CCR4;
+  __IO uint32_t BDTR;
+  __IO uint32_t DCR;
+  __IO uint32_t DMAR;
+  __IO uint32_t OR;
+} TIM_TypeDef;
+
+typedef struct
+{
+  __IO uint32_t SR;
+  __IO uint32_t DR;
+  __IO uint32_t BRR;
+  __IO uint32_t CR1;
+  __IO uint32_t CR2;
+  __IO uint32_t CR3;
+  __IO uint32_t GTPR;
+} USART_TypeDef;
+
+typedef struct
+{
+  __IO uint32_t CR1;
+  __IO uint32_t CR2;
+  __IO uint32_t OAR1;
+  __IO uint32_t OAR2;
+  __IO uint32_t DR;
+  __IO uint32_t SR1;
+  __IO uint32_t SR2;
+  __IO uint32_t CCR;
+  __IO uint32_t TRISE;
+} I2C_TypeDef;
+
+typedef struct
+{
+  __IO uint32_t CCR;
+  __IO uint32_t CNDTR;
+  __IO uint32_t CPAR;
+  __IO uint32_t CMAR;
+} DMA_Channel_TypeDef;
+
+typedef struct
+{
+  __IO uint32_t ISR;
+  __IO uint32_t IFCR;
+} DMA_TypeDef;
+
+typedef struct
+{
+  __IO uint32_t IMR;
+  __IO uint32_t EMR;
+  __IO uint32_t RTSR;
+  __IO uint32_t FTSR;
+  __IO uint32_t SWIER;
+  __IO uint32_t PR;
+} EXTI_TypeDef;
+
+typedef struct
+{
+  __IO uint32_t EVCR;
+  __IO uint32_t MAPR;
+  __IO uint32_t EXTICR[4];
+  uint32_t RESERVED0;
+  __IO uint32_t MAPR2;
+} AFIO_TypeDef;
+
+typedef struct
+{
+  __IO uint32_t CR;
+  __IO uint32_t CFGR;
+  __IO uint32_t CIR;
+  __IO uint32_t APB2RSTR;
+  __IO uint32_t APB1RSTR;
+  __IO uint32_t AHBENR;
+  __IO uint32_t APB2ENR;
+  __IO uint32_t APB1ENR;
+  __IO uint32_t BDCR;
+  __IO uint32_t CSR;
+} RCC_TypeDef;
+
+typedef struct
+{
+  __IO uint32_t CR;
+  __IO uint32_t CSR;
+} PWR_TypeDef;
+
+typedef struct
+{
+  __IO uint32_t CRH;
+  __IO uint32_t CRL;
+  __IO uint32_t PRLH;
+  __IO uint32_t PRLL;
+  __IO uint32_t DIVH;
+  __IO uint32_t DIVL;
+  __IO uint32_t CNTH;
+  __IO uint32_t CNTL;
+  __IO uint32_t ALRH;
+  __IO uint32_t ALRL;
+} RTC_TypeDef;
+
+typedef struct
+{
+  uint32_t      RESERVED0;
+  __IO uint32_t DR1;
+  __IO uint32_t DR2;
+  __IO uint32_t DR3;
+  __IO uint32_t DR4;
+  __IO uint32_t DR5;
+  __IO uint32_t DR6;
+  __IO uint32_t DR7;
+  __IO uint32_t DR8;
+  __IO uint32_t DR9;
+  __IO uint32_t DR10;
+  __IO uint32_t RTCCR;
+  __IO uint32_t CR;
+  __IO uint32_t CSR;
+} BKP_TypeDef;
+
+/* 外设实例在 sim_hal.c 中定义 */
+extern GPIO_TypeDef        sim_GPIOA, sim_GPIOB, sim_GPIOC, sim_GPIOD;
+extern TIM_TypeDef         sim_TIM2, sim_TIM3;
+extern USART_TypeDef       sim_USART1;
+extern I2C_TypeDef         sim_I2C2;
+extern DMA_TypeDef         sim_DMA1;
+extern DMA_Channel_TypeDef sim_DMA1_Channel[7];
+extern EXTI_TypeDef        sim_EXTI;
+extern AFIO_TypeDef        sim_AFIO;
+extern RCC_TypeDef         sim_RCC;
+extern PWR_TypeDef         sim_PWR;
+extern RTC_TypeDef         sim_RTC;
+extern BKP_TypeDef         sim_BKP;
+
+#define GPIOA               (&sim_GPIOA)
+#define GPIOB               (&sim_GPIOB)
+#define GPIOC               (&sim_GPIOC)
+#define GPIOD               (&sim_GPIOD)
+#define TIM2                (&sim_TIM2)
+#define TIM3                (&sim_TIM3)
+#define USART1              (&sim_USART1)
+#define I2C2                (&sim_I2C2)
+#define DMA1                (&sim_DMA1)
+#define DMA1_Channel1       (&sim_DMA1_Channel[0])
+#define DMA1_Channel2       (&sim_DMA1_Channel[1])
+#define DMA1_Channel3       (&sim_DMA1_Channel[2])
+#define DMA1_Channel4       (&sim_DMA1_Channel[3])
+#define DMA1_Channel5       (&sim_DMA1_Channel[4])
+#define DMA1_Channel6       (&sim_DMA1_Channel[5])
+#define DMA1_Channel7       (&sim_DMA1_Channel[6])
+#define EXTI                (&sim_EXTI)
+#define AFIO                (&sim_AFIO)
+#define RCC                 (&sim_RCC)
+#define PWR                 (&sim_PWR)
+#define RTC                 (&sim_RTC)
+#define BKP                 (&sim_BKP)
+
+/******************************* 内核寄存器 ***********************************/
+typedef struct
+{
+  __IO uint32_t CTRL;
+  __IO uint32_t LOAD;
+  __IO uint32_t VAL;
+  __I  uint32_t CALIB;
+} SysTick_Type;
+
+typedef struct
+{
+  __I  uint32_t CPUID;
+  __IO uint32_t ICSR;
+  __IO uint32_t VTOR;
+  __IO uint32_t AIRCR;
+  __IO uint32_t SCR;
+  __IO uint32_t CCR;
+  __IO uint8_t  SHP[12U];
+  __IO uint32_t SHCSR;
+} SCB_Type;
+
+typedef struct
+{
+  __IO uint32_t CTRL;
+  __IO uint32_t CYCCNT;
+  __IO uint32_t CPICNT;
+  __IO uint32_t EXCCNT;
+  __IO uint32_t SLEEPCNT;
+  __IO uint32_t LSUCNT;
+  __IO uint32_t FOLDCNT;
+} DWT_Type;
+
+typedef struct
+{
+  __IO uint32_t DHCSR;
+  __O  uint32_t DCRSR;
+  __IO uint32_t DCRDR;
+  __IO uint32_t DEMCR;
+} CoreDebug_Type;
+
+#define SCS_BASE            (0xE000E000UL)
+#define DWT_BASE            (0xE0001000UL)
+#define CoreDebug_BASE      (0xE000EDF0UL)
+#define SysTick_BASE        (SCS_BASE +  0x0010UL)
+#define SCB_BASE            (SCS_BASE +  0x0D00UL)
+
+#define SysTick             ((SysTick_Type   *)     SysTick_BASE  )
+#define SCB                 ((SCB_Type       *)     SCB_BASE      )
+#define DWT                 ((DWT_Type       *)     DWT_BASE      )
+#define CoreDebug           ((CoreDebug_Type *)     CoreDebug_BASE)
+
+#define __NVIC_PRIO_BITS    4U
+
+/******************************* 位定义 ***************************************/
+#define SysTick_CTRL_COUNTFLAG_Msk   (1UL << 16U)
+#define SysTick_CTRL_CLKSOURCE_Msk   (1UL << 2U)
+#define SysTick_CTRL_TICKINT_Msk     (1UL << 1U)
+#define SysTick_CTRL_ENABLE_Msk      (1UL)
+#define SysTick_LOAD_RELOAD_Msk      (0xFFFFFFUL)
+
+#define SCB_ICSR_PENDSTSET_Pos       26U
+#define SCB_ICSR_PENDSTSET_Msk       (1UL << SCB_ICSR_PENDSTSET_Pos)
+
+#define SCB_SCR_SLEEPDEEP_Msk        (1UL << 2U)
+#define SCB_SCR_SLEEPONEXIT_Msk      (1UL << 1U)
+
+#define DWT_CTRL_CYCCNTENA_Msk       (1UL)
+#define CoreDebug_DEMCR_TRCENA_Msk   (1UL << 24U)
+
+#define USART_SR_PE                  (1UL << 0U)
+#define USART_SR_FE                  (1UL << 1U)
+#define USART_SR_NE                  (1UL << 2U)
+#define USART_SR_ORE                 (1UL << 3U)
+#define USART_SR_IDLE                (1UL << 4U)
+#define USART_SR_RXNE                (1UL << 5U)
+#define USART_SR_TC                  (1UL << 6U)
+#define USART_SR_TXE                 (1UL << 7U)
+#define USART_CR1_RE                 (1UL << 2U)
+#define USART_CR1_TE                 (1UL << 3U)
+#define USART_CR1_IDLEIE             (1UL << 4U)
+#define USART_CR1_RXNEIE             (1UL << 5U)
+#define USART_CR1_TCIE               (1UL << 6U)
+#define USART_CR1_TXEIE              (1UL << 7U)
+#define USART_CR1_PEIE               (1UL << 8U)
+#define USART_CR1_UE                 (1UL << 13U)
+#define USART_CR3_EIE                (1UL << 0U)
+#define USART_CR3_DMAR               (1UL << 6U)
+#define USART_CR3_DMAT               (1UL << 7U)
+
+#define TIM_CR1_CEN                  (1UL << 0U)
+#define TIM_CR1_UDIS                 (1UL << 1U)
+#define TIM_CR1_URS                  (1UL << 2U)
+#define TIM_CR1_OPM                  (1UL << 3U)
+#define TIM_CR1_ARPE                 (1UL << 7U)
+#define TIM_SR_UIF                   (1UL << 0U)
+#define TIM_SR_CC1IF                 (1UL << 1U)
+#define TIM_SR_CC2IF                 (1UL << 2U)
+#define TIM_SR_CC3IF                 (1UL << 3U)
+#define TIM_SR_CC4IF                 (1UL << 4U)
+#define TIM_SR_TIF                   (1UL << 6U)
+#define TIM_SR_CC1OF                 (1UL << 9U)
+#define TIM_SR_CC2OF                 (1UL << 10U)
+#define TIM_SR_CC3OF                 (1UL << 11U)
+#define TIM_SR_CC4OF                 (1UL << 12U)
+#define TIM_DIER_UIE                 (1UL << 0U)
+#define TIM_DIER_CC1IE               (1UL << 1U)
+#define TIM_DIER_CC2IE               (1UL << 2U)
+#define TIM_DIER_CC3IE               (1UL << 3U)
+#define TIM_DIER_CC4IE               (1UL << 4U)
+#define TIM_DIER_TIE                 (1UL << 6U)
+#define TIM_EGR_UG                   (1UL << 0U)
+#define TIM_CCMR1_OC1M               (7UL << 4U)
+#define TIM_CCMR1_OC2M               (7UL << 12U)
+#define TIM_CCER_CC1E                (1UL << 0U)
+#define TIM_CCER_CC1P                (1UL << 1U)
+#define TIM_CCER_CC1NP               (1UL << 3U)
+#define TIM_CCER_CC2E                (1UL << 4U)
+#define TIM_CCER_CC2P                (1UL << 5U)
+#define TIM_CCER_CC3E                (1UL << 8U)
+#define TIM_CCER_CC3P                (1UL << 9U)
+#define TIM_CCER_CC4E                (1UL << 12U)
+#define TIM_CCER_CC4P                (1UL << 13U)
+
+#define I2C_CR1_PE                   (1UL << 0U)
+#define I2C_CR1_START                (1UL << 8U)
+#define I2C_CR1_STOP                 (1UL << 9U)
+#define I2C_CR1_SWRST                (1UL << 15U)
+#define I2C_CR2_ITERREN              (1UL << 8U)
+#define I2C_CR2_ITEVTEN              (1UL << 9U)
+#define I2C_CR2_ITBUFEN              (1UL << 10U)
+#define I2C_CR2_DMAEN                (1UL << 11U)
+#define I2C_SR1_SB                   (1UL << 0U)
+#define I2C_SR1_ADDR                 (1UL << 1U)
+#define I2C_SR1_BTF                  (1UL << 2U)
+#define I2C_SR1_TXE                  (1UL << 7U)
+#define I2C_SR1_BERR                 (1UL << 8U)
+#define I2C_SR1_ARLO                 (1UL << 9U)
+#define I2C_SR1_AF                   (1UL << 10U)
+
+#define AFIO_EXTICR3_EXTI10          (0x0FUL << 8U)
+
+#define RCC_CSR_LSION                (1UL << 0U)
+#define RCC_CSR_LSIRDY               (1UL << 1U)
+#define RCC_BDCR_RTCSEL              (3UL << 8U)
+#define RCC_BDCR_RTCSEL_LSE          (1UL << 8U)
+#define RCC_BDCR_RTCSEL_LSI          (2UL << 8U)
+#define RCC_BDCR_RTCSEL_HSE          (3UL << 8U)
+#define RCC_BDCR_RTCEN               (1UL << 15U)
+#define RCC_BDCR_BDRST               (1UL << 16U)
+
+#define PWR_CR_LPDS                  (1UL << 0U)
+#define PWR_CR_PDDS                  (1UL << 1U)
+#define PWR_CR_CWUF                  (1UL << 2U)
+#define PWR_CR_DBP                   (1UL << 8U)
+
+#define RTC_CRH_SECIE                (1UL << 0U)
+#define RTC_CRH_ALRIE                (1UL << 1U)
+#define RTC_CRH_OWIE                 (1UL << 2U)
+#define RTC_CRL_SECF                 (1UL << 0U)
+#define RTC_CRL_ALRF                 (1UL << 1U)
+#define RTC_CRL_OWF                  (1UL << 2U)
+#define RTC_CRL_RSF                  (1UL << 3U)
+#define RTC_CRL_CNF                  (1UL << 4U)
+#define RTC_CRL_RTOFF                (1UL << 5U)
+
+#define DMA_CCR_EN                   (1UL << 0U)
+#define DMA_CCR_TCIE                 (1UL << 1U)
+#define DMA_CCR_HTIE                 (1UL << 2U)
+#define DMA_CCR_TEIE                 (1UL << 3U)
+#define DMA_CCR_CIRC                 (1UL << 5U)
+
+/******************************* 内核指令 *************************************/
+/* 由 sim_core.c 实现：PRIMASK 对应屏蔽仿真中断信号，WFI 挂起到下一个中断 */
+void     sim_disable_irq(void);
+void     sim_enable_irq(void);
+uint32_t sim_get_primask(void);
+void     sim_set_primask(uint32_t primask);
+void     sim_wfi(void);
+void     sim_system_reset(void);
+
+#define __disable_irq()        sim_disable_irq()
+#define __enable_irq()         sim_enable_irq()
+#define __get_PRIMASK()        sim_get_primask()
+#define __set_PRIMASK(x)       sim_set_primask(x)
+#define __WFI()                sim_wfi()
+#define __WFE()                sim_wfi()
+#define __SEV()                ((void)0)
+#define __NOP()                __asm__ volatile ("nop")
+#define __DSB()                __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define __ISB()                __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define __DMB()                __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define __CLZ(x)               ((uint8_t)((x) ? __builtin_clz(x) : 32U))
+#define NVIC_SystemReset()     sim_system_reset()
+
+extern uint32_t SystemCoreClock;
+extern const uint8_t AHBPrescTable[16U];
+extern const uint8_t APBPrescTable[8U];
+
+void SystemInit(void);
+void SystemCoreClockUpdate(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __STM32F1xx_H */
@@ -0,0 +1,827 @@
+/**
+ ******************************************************************************
+ * @file    stm32f1xx_hal.h
+ * @brief   仿真用 HAL 头文件（替代 STM32F1xx_HAL_Driver）
+ ******************************************************************************
+ * @attention
+ *
+ * 只声明固件实际用到的 HAL 类型、常量、宏和函数，数值与官方 HAL 一致。
+ * 读写状态寄存器的宏改为调用仿真函数，以便和外设模型同步；
+ * 函数实现位于 Simulation/Src/sim_*.c。
+ *
+ ******************************************************************************
+ */
+#ifndef __STM32F1xx_HAL_H
+#define __STM32F1xx_HAL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32f1xx.h"
+
+/******************************* 通用定义 *************************************/
+typedef enum
+{
+  HAL_OK       = 0x00U,
+  HAL_ERROR    = 0x01U,
+  HAL_BUSY     = 0x02U,
+  HAL_TIMEOUT  = 0x03U
+} HAL_StatusTypeDef;
+
+typedef enum
+{
+  HAL_UNLOCKED = 0x00U,
+  HAL_LOCKED   = 0x01U
+} HAL_LockTypeDef;
+
+#define HAL_MAX_DELAY      0xFFFFFFFFU
+#define UNUSED(X)          (void)X
+#define __HAL_LOCK(__HANDLE__)                                           \
+                                do{                                        \
+                                    if((__HANDLE__)->Lock == HAL_LOCKED)   \
+                                    {                                      \
+                                       return HAL_BUSY;                    \
+                                    }                                      \
+                                    else                                   \
+                                    {                                      \
+                                       (__HANDLE__)->Lock = HAL_LOCKED;    \
+                                    }                                      \
+                                  }while (0U)
+#define __HAL_UNLOCK(__HANDLE__)                                          \
+                                  do{                                       \
+                                      (__HANDLE__)->Lock = HAL_UNLOCKED;    \
+                                    }while (0U)
+#ifndef __weak
+#define __weak             __attribute__((weak))
+#endif
+#ifndef __packed
+#define __packed           __attribute__((__packed__))
+#endif
+#ifndef __ALIGN_BEGIN
+#define __ALIGN_BEGIN
+#define __ALIGN_END        __attribute__ ((aligned (4)))
+#endif
+
+#define HAL_GPIO_MODULE_ENABLED
+#define HAL_DMA_MODULE_ENABLED
+#define HAL_TIM_MODULE_ENABLED
+#define HAL_UART_MODULE_ENABLED
+#define HAL_I2C_MODULE_ENABLED
+#define HAL_RCC_MODULE_ENABLED
+#define HAL_PWR_MODULE_ENABLED
+#define HAL_CORTEX_MODULE_ENABLED
+#define HAL_FLASH_MODULE_ENABLED
+#define HAL_EXTI_MODULE_ENABLED
+#define HAL_PCD_MODULE_ENABLED
+
+#define TICK_INT_PRIORITY  15U
+
+/******************************* HAL 核心 *************************************/
+typedef enum
+{
+  HAL_TICK_FREQ_10HZ   = 100U,
+  HAL_TICK_FREQ_100HZ  = 10U,
+  HAL_TICK_FREQ_1KHZ   = 1U,
+  HAL_TICK_FREQ_DEFAULT = HAL_TICK_FREQ_1KHZ
+} HAL_TickFreqTypeDef;
+
+extern __IO uint32_t uwTick;
+extern uint32_t uwTickPrio;
+extern HAL_TickFreqTypeDef uwTickFreq;
+
+HAL_StatusTypeDef HAL_Init(void);
+HAL_StatusTypeDef HAL_DeInit(void);
+void              HAL_MspInit(void);
+void              HAL_MspDeInit(void);
+HAL_StatusTypeDef HAL_InitTick(uint32_t TickPriority);
+void              HAL_IncTick(void);
+void              HAL_Delay(uint32_t Delay);
+uint32_t          HAL_GetTick(void);
+uint32_t          HAL_GetTickPrio(void);
+void              HAL_SuspendTick(void);
+void              HAL_ResumeTick(void);
+uint32_t          HAL_GetUIDw0(void);
+uint32_t          HAL_GetUIDw1(void);
+uint32_t          HAL_GetUIDw2(void);
+
+/******************************* CORTEX ***************************************/
+#define NVIC_PRIORITYGROUP_0         0x00000007U
+#define NVIC_PRIORITYGROUP_1         0x00000006U
+#define NVIC_PRIORITYGROUP_2         0x00000005U
+#define NVIC_PRIORITYGROUP_3         0x00000004U
+#define NVIC_PRIORITYGROUP_4         0x00000003U
+#define SYSTICK_CLKSOURCE_HCLK_DIV8  0x00000000U
+#define SYSTICK_CLKSOURCE_HCLK       0x00000004U
+
+void     HAL_NVIC_SetPriorityGrouping(uint32_t PriorityGroup);
+void     HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority);
+void     HAL_NVIC_EnableIRQ(IRQn_Type IRQn);
+void     HAL_NVIC_DisableIRQ(IRQn_Type IRQn);
+void     HAL_NVIC_SystemReset(void);
+uint32_t HAL_NVIC_GetPendingIRQ(IRQn_Type IRQn);
+void     HAL_NVIC_SetPendingIRQ(IRQn_Type IRQn);
+void     HAL_NVIC_ClearPendingIRQ(IRQn_Type IRQn);
+uint32_t HAL_SYSTICK_Config(uint32_t TicksNumb);
+void     HAL_SYSTICK_CLKSourceConfig(uint32_t CLKSource);
+void     HAL_SYSTICK_IRQHandler(void);
+void     HAL_SYSTICK_Callback(void);
+
+/******************************* RCC ******************************************/
+typedef struct
+{
+  uint32_t PLLState;
+  uint32_t PLLSource;
+  uint32_t PLLMUL;
+} RCC_PLLInitTypeDef;
+
+typedef struct
+{
+  uint32_t OscillatorType;
+  uint32_t HSEState;
+  uint32_t HSEPredivValue;
+  uint32_t LSEState;
+  uint32_t HSIState;
+  uint32_t HSICalibrationValue;
+  uint32_t LSIState;
+  RCC_PLLInitTypeDef PLL;
+} RCC_OscInitTypeDef;
+
+typedef struct
+{
+  uint32_t ClockType;
+  uint32_t SYSCLKSource;
+  uint32_t AHBCLKDivider;
+  uint32_t APB1CLKDivider;
+  uint32_t APB2CLKDivider;
+} RCC_ClkInitTypeDef;
+
+typedef struct
+{
+  uint32_t PeriphClockSelection;
+  uint32_t RTCClockSelection;
+  uint32_t AdcClockSelection;
+  uint32_t UsbClockSelection;
+} RCC_PeriphCLKInitTypeDef;
+
+#define RCC_OSCILLATORTYPE_NONE      0x00000000U
+#define RCC_OSCILLATORTYPE_HSE       0x00000001U
+#define RCC_OSCILLATORTYPE_HSI       0x00000002U
+#define RCC_OSCILLATORTYPE_LSE       0x00000004U
+#define RCC_OSCILLATORTYPE_LSI       0x00000008U
+#define RCC_HSE_OFF                  0x00000000U
+#define RCC_HSE_ON                   0x00010000U
+#define RCC_HSE_PREDIV_DIV1          0x00000000U
+#define RCC_HSI_OFF                  0x00000000U
+#define RCC_HSI_ON                   0x00000001U
+#define RCC_LSI_OFF                  0x00000000U
+#define RCC_LSI_ON                   0x00000001U
+#define RCC_PLL_NONE                 0x00000000U
+#define RCC_PLL_OFF                  0x00000001U
+#define RCC_PLL_ON                   0x00000002U
+#define RCC_PLLSOURCE_HSI_DIV2       0x00000000U
+#define RCC_PLLSOURCE_HSE            0x00010000U
+#define RCC_PLL_MUL9                 0x001C0000U
+#define RCC_CLOCKTYPE_SYSCLK         0x00000001U
+#define RCC_CLOCKTYPE_HCLK           0x00000002U
+#define RCC_CLOCKTYPE_PCLK1          0x00000004U
+#define RCC_CLOCKTYPE_PCLK2          0x00000008U
+#define RCC_SYSCLKSOURCE_HSI         0x00000000U
+#define RCC_SYSCLKSOURCE_HSE         0x00000001U
+#define RCC_SYSCLKSOURCE_PLLCLK      0x00000002U
+#define RCC_SYSCLK_DIV1              0x00000000U
+#define RCC_HCLK_DIV1                0x00000000U
+#define RCC_HCLK_DIV2                0x00000400U
+#define RCC_PERIPHCLK_RTC            0x00000001U
+#define RCC_PERIPHCLK_ADC            0x00000002U
+#define RCC_PERIPHCLK_USB            0x00000010U
+#define RCC_USBCLKSOURCE_PLL         0x00400000U
+#define RCC_USBCLKSOURCE_PLL_DIV1_5  0x00000000U
+#define FLASH_LATENCY_0              0x00000000U
+#define FLASH_LATENCY_1              0x00000001U
+#define FLASH_LATENCY_2              0x00000002U
+
+HAL_StatusTypeDef HAL_RCC_OscConfig(RCC_OscInitTypeDef *RCC_OscInitStruct);
+HAL_StatusTypeDef HAL_RCC_ClockConfig(RCC_ClkInitTypeDef *RCC_ClkInitStruct, uint32_t FLatency);
+HAL_StatusTypeDef HAL_RCCEx_PeriphCLKConfig(RCC_PeriphCLKInitTypeDef *PeriphClkInit);
+uint32_t          HAL_RCC_GetSysClockFreq(void);
+uint32_t          HAL_RCC_GetHCLKFreq(void);
+uint32_t          HAL_RCC_GetPCLK1Freq(void);
+uint32_t          HAL_RCC_GetPCLK2Freq(void);
+
+/* 仿真中外设时钟始终可用，时钟开关与重映射宏均为空操作 */
+#define __HAL_RCC_NOP()                   do { } while (0U)
+#define __HAL_RCC_GPIOA_CLK_ENABLE()      __HAL_RCC_NOP()
+#define __HAL_RCC_GPIOB_CLK_ENABLE()      __HAL_RCC_NOP()
+#define __HAL_RCC_GPIOC_CLK_ENABLE()      __HAL_RCC_NOP()
+#define __HAL_RCC_GPIOD_CLK_ENABLE()      __HAL_RCC_NOP()
+#define __HAL_RCC_AFIO_CLK_ENABLE()       __HAL_RCC_NOP()
+#define __HAL_RCC_PWR_CLK_ENABLE()        __HAL_RCC_NOP()
+#define __HAL_RCC_BKP_CLK_ENABLE()        __HAL_RCC_NOP()
+#define __HAL_RCC_DMA1_CLK_ENABLE()       __HAL_RCC_NOP()
+#define __HAL_RCC_TIM2_CLK_ENABLE()       __HAL_RCC_NOP()
+#define __HAL_RCC_TIM2_CLK_DISABLE()      __HAL_RCC_NOP()
+#define __HAL_RCC_TIM3_CLK_ENABLE()       __HAL_RCC_NOP()
+#define __HAL_RCC_TIM3_CLK_DISABLE()      __HAL_RCC_NOP()
+#define __HAL_RCC_USART1_CLK_ENABLE()     __HAL_RCC_NOP()
+#define __HAL_RCC_USART1_CLK_DISABLE()    __HAL_RCC_NOP()
+#define __HAL_RCC_I2C2_CLK_ENABLE()       __HAL_RCC_NOP()
+#define __HAL_RCC_I2C2_CLK_DISABLE()      __HAL_RCC_NOP()
+#define __HAL_RCC_I2C2_FORCE_RESET()      __HAL_RCC_NOP()
+#define __HAL_RCC_I2C2_RELEASE_RESET()    __HAL_RCC_NOP()
+#define __HAL_RCC_USB_CLK_ENABLE()        __HAL_RCC_NOP()
+#define __HAL_RCC_USB_CLK_DISABLE()       __HAL_RCC_NOP()
+#define __HAL_AFIO_REMAP_SWJ_NOJTAG()     __HAL_RCC_NOP()
+#define __HAL_AFIO_REMAP_TIM2_PARTIAL_1() __HAL_RCC_NOP()
+
+/******************************* PWR ******************************************/
+#define PWR_MAINREGULATOR_ON         0x00000000U
+#define PWR_LOWPOWERREGULATOR_ON     PWR_CR_LPDS
+#define PWR_STOPENTRY_WFI            ((uint8_t)0x01)
+#define PWR_STOPENTRY_WFE            ((uint8_t)0x02)
+
+/* 实现在 sim_pwr.c：Stop 挂起到有唤醒的 EXTI 线挂起，醒来时钟停在 HSI，
+ * 要重新调用 SystemClock_Config() */
+void HAL_PWR_EnableBkUpAccess(void);
+void HAL_PWR_DisableBkUpAccess(void);
+void HAL_PWR_EnterSTOPMode(uint32_t Regulator, uint8_t STOPEntry);
+
+/******************************* GPIO *****************************************/
+typedef struct
+{
+  uint32_t Pin;
+  uint32_t Mode;
+  uint32_t Pull;
+  uint32_t Speed;
+} GPIO_InitTypeDef;
+
+typedef enum
+{
+  GPIO_PIN_RESET = 0u,
+  GPIO_PIN_SET
+} GPIO_PinState;
+
+#define GPIO_PIN_0                 ((uint16_t)0x0001)
+#define GPIO_PIN_1                 ((uint16_t)0x0002)
+#define GPIO_PIN_2                 ((uint16_t)0x0004)
+#define GPIO_PIN_3                 ((uint16_t)0x0008)
+#define GPIO_PIN_4                 ((uint16_t)0x0010)
+#define GPIO_PIN_5                 ((uint16_t)0x0020)
+#define GPIO_PIN_6                 ((uint16_t)0x0040)
+#define GPIO_PIN_7                 ((uint16_t)0x0080)
+#define GPIO_PIN_8                 ((uint16_t)0x0100)
+#define GPIO_PIN_9                 ((uint16_t)0x0200)
+#define GPIO_PIN_10                ((uint16_t)0x0400)
+#define GPIO_PIN_11                ((uint16_t)0x0800)
+#define GPIO_PIN_12                ((uint16_t)0x1000)
+#define GPIO_PIN_13                ((uint16_t)0x2000)
+#define GPIO_PIN_14                ((uint16_t)0x4000)
+#define GPIO_PIN_15                ((uint16_t)0x8000)
+#define GPIO_PIN_All               ((uint16_t)0xFFFF)
+
+#define GPIO_MODE_INPUT                  0x00000000u
+#define GPIO_MODE_OUTPUT_PP              0x00000001u
+#define GPIO_MODE_OUTPUT_OD              0x00000011u
+#define GPIO_MODE_AF_PP                  0x00000002u
+#define GPIO_MODE_AF_OD                  0x00000012u
+#define GPIO_MODE_AF_INPUT               GPIO_MODE_INPUT
+#define GPIO_MODE_ANALOG                 0x00000003u
+#define GPIO_MODE_IT_RISING              0x10110000u
+#define GPIO_MODE_IT_FALLING             0x10210000u
+#define GPIO_MODE_IT_RISING_FALLING      0x10310000u
+#define GPIO_MODE_EVT_RISING             0x10120000u
+#define GPIO_MODE_EVT_FALLING            0x10220000u
+#define GPIO_MODE_EVT_RISING_FALLING     0x10320000u
+#define GPIO_SPEED_FREQ_LOW              0x00000002u
+#define GPIO_SPEED_FREQ_MEDIUM           0x00000001u
+#define GPIO_SPEED_FREQ_HIGH             0x00000003u
+#define GPIO_NOPULL                      0x00000000u
+#define GPIO_PULLUP                      0x00000001u
+#define GPIO_PULLDOWN                    0x00000002u
+
+#define __HAL_GPIO_EXTI_GET_IT(__EXTI_LINE__)   (EXTI->PR & (__EXTI_LINE__))
+#define __HAL_GPIO_EXTI_GET_FLAG(__EXTI_LINE__) (EXTI->PR & (__EXTI_LINE__))
+#define __HAL_GPIO_EXTI_CLEAR_IT(__EXTI_LINE__) sim_exti_clear(__EXTI_LINE__)
+#define __HAL_GPIO_EXTI_CLEAR_FLAG(__EXTI_LINE__) sim_exti_clear(__EXTI_LINE__)
+
+void          HAL_GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init);
+void          HAL_GPIO_DeInit(GPIO_TypeDef *GPIOx, uint32_t GPIO_Pin);
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin);
+void          HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState);
+void          HAL_GPIO_TogglePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin);
+void          HAL_GPIO_EXTI_IRQHandler(uint16_t GPIO_Pin);
+void          HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin);
+void          sim_exti_clear(uint32_t line);
+
+/******************************* DMA ******************************************/
+typedef struct
+{
+  uint32_t Direction;
+  uint32_t PeriphInc;
+  uint32_t MemInc;
+  uint32_t PeriphDataAlignment;
+  uint32_t MemDataAlignment;
+  uint32_t Mode;
+  uint32_t Priority;
+} DMA_InitTypeDef;
+
+typedef enum
+{
+  HAL_DMA_STATE_RESET   = 0x00U,
+  HAL_DMA_STATE_READY   = 0x01U,
+  HAL_DMA_STATE_BUSY    = 0x02U,
+  HAL_DMA_STATE_TIMEOUT = 0x03U
+} HAL_DMA_StateTypeDef;
+
+typedef struct __DMA_HandleTypeDef
+{
+  DMA_Channel_TypeDef  *Instance;
+  DMA_InitTypeDef       Init;
+  HAL_LockTypeDef       Lock;
+  HAL_DMA_StateTypeDef  State;
+  void                 *Parent;
+  void (* XferCpltCallback)(struct __DMA_HandleTypeDef *hdma);
+  void (* XferHalfCpltCallback)(struct __DMA_HandleTypeDef *hdma);
+  void (* XferErrorCallback)(struct __DMA_HandleTypeDef *hdma);
+  void (* XferAbortCallback)(struct __DMA_HandleTypeDef *hdma);
+  __IO uint32_t         ErrorCode;
+  DMA_TypeDef          *DmaBaseAddress;
+  uint32_t              ChannelIndex;
+} DMA_HandleTypeDef;
+
+#define DMA_PERIPH_TO_MEMORY         0x00000000U
+#define DMA_MEMORY_TO_PERIPH         0x00000010U
+#define DMA_MEMORY_TO_MEMORY         0x00004000U
+#define DMA_PINC_ENABLE              0x00000040U
+#define DMA_PINC_DISABLE             0x00000000U
+#define DMA_MINC_ENABLE              0x00000080U
+#define DMA_MINC_DISABLE             0x00000000U
+#define DMA_PDATAALIGN_BYTE          0x00000000U
+#define DMA_MDATAALIGN_BYTE          0x00000000U
+#define DMA_NORMAL                   0x00000000U
+#define DMA_CIRCULAR                 0x00000020U
+#define DMA_PRIORITY_LOW             0x00000000U
+#define DMA_PRIORITY_MEDIUM          0x00001000U
+#define DMA_PRIORITY_HIGH            0x00002000U
+#define DMA_PRIORITY_VERY_HIGH       0x00003000U
+#define DMA_IT_TC                    DMA_CCR_TCIE
+#define DMA_IT_HT                    DMA_CCR_HTIE
+#define DMA_IT_TE                    DMA_CCR_TEIE
+#define HAL_DMA_ERROR_NONE           0x00000000U
+#define HAL_DMA_ERROR_TE             0x00000001U
+
+#define __HAL_LINKDMA(__HANDLE__, __PPP_DMA_FIELD__, __DMA_HANDLE__)               \
+                        do{                                                      \
+                              (__HANDLE__)->__PPP_DMA_FIELD__ = &(__DMA_HANDLE__); \
+                              (__DMA_HANDLE__).Parent = (__HANDLE__);             \
+                          } while(0U)
+
+#define __HAL_DMA_GET_COUNTER(__HANDLE__)        ((__HANDLE__)->Instance->CNDTR)
+#define __HAL_DMA_ENABLE_IT(__HANDLE__, __IT__)  ((__HANDLE__)->Instance->CCR |= (__IT__))
+#define __HAL_DMA_DISABLE_IT(__HANDLE__, __IT__) ((__HANDLE__)->Instance->CCR &= ~(__IT__))
+
+HAL_StatusTypeDef HAL_DMA_Init(DMA_HandleTypeDef *hdma);
+HAL_StatusTypeDef HAL_DMA_DeInit(DMA_HandleTypeDef *hdma);
+HAL_StatusTypeDef HAL_DMA_Abort(DMA_HandleTypeDef *hdma);
+HAL_StatusTypeDef HAL_DMA_Abort_IT(DMA_HandleTypeDef *hdma);
+void              HAL_DMA_IRQHandler(DMA_HandleTypeDef *hdma);
+HAL_DMA_StateTypeDef HAL_DMA_GetState(DMA_HandleTypeDef *hdma);
+
+/******************************* TIM ******************************************/
+typedef struct
+{
+  uint32_t Prescaler;
+  uint32_t CounterMode;
+  uint32_t Period;
+  uint32_t ClockDivision;
+  uint32_t RepetitionCounter;
+  uint32_t AutoReloadPreload;
+} TIM_Base_InitTypeDef;
+
+typedef struct
+{
+  uint32_t OCMode;
+  uint32_t Pulse;
+  uint32_t OCPolarity;
+  uint32_t OCNPolarity;
+  uint32_t OCFastMode;
+  uint32_t OCIdleState;
+  uint32_t OCNIdleState;
+} TIM_OC_InitTypeDef;
+
+typedef struct
+{
+  uint32_t ICPolarity;
+  uint32_t ICSelection;
+  uint32_t ICPrescaler;
+  uint32_t ICFilter;
+} TIM_IC_InitTypeDef;
+
+typedef struct
+{
+  uint32_t ClockSource;
+  uint32_t ClockPolarity;
+  uint32_t ClockPrescaler;
+  uint32_t ClockFilter;
+} TIM_ClockConfigTypeDef;
+
+typedef struct
+{
+  uint32_t MasterOutputTrigger;
+  uint32_t MasterSlaveMode;
+} TIM_MasterConfigTypeDef;
+
+typedef enum
+{
+  HAL_TIM_ACTIVE_CHANNEL_1       = 0x01U,
+  HAL_TIM_ACTIVE_CHANNEL_2       = 0x02U,
+  HAL_TIM_ACTIVE_CHANNEL_3       = 0x04U,
+  HAL_TIM_ACTIVE_CHANNEL_4       = 0x08U,
+  HAL_TIM_ACTIVE_CHANNEL_CLEARED = 0x00U
+} HAL_TIM_ActiveChannel;
+
+typedef enum
+{
+  HAL_TIM_STATE_RESET   = 0x00U,
+  HAL_TIM_STATE_READY   = 0x01U,
+  HAL_TIM_STATE_BUSY    = 0x02U,
+  HAL_TIM_STATE_TIMEOUT = 0x03U,
+  HAL_TIM_STATE_ERROR   = 0x04U
+} HAL_TIM_StateTypeDef;
+
+typedef enum
+{
+  HAL_TIM_CHANNEL_STATE_RESET = 0x00U,
+  HAL_TIM_CHANNEL_STATE_READY = 0x01U,
+  HAL_TIM_CHANNEL_STATE_BUSY  = 0x02U,
+} HAL_TIM_ChannelStateTypeDef;
+
+typedef struct __TIM_HandleTypeDef
+{
+  TIM_TypeDef                 *Instance;
+  TIM_Base_InitTypeDef         Init;
+  HAL_TIM_ActiveChannel        Channel;
+  DMA_HandleTypeDef           *hdma[7];
+  HAL_LockTypeDef              Lock;
+  __IO HAL_TIM_StateTypeDef    State;
+  __IO HAL_TIM_ChannelStateTypeDef ChannelState[4];
+  __IO HAL_TIM_ChannelStateTypeDef ChannelNState[4];
+} TIM_HandleTypeDef;
+
+#define TIM_CHANNEL_1                      0x00000000U
+#define TIM_CHANNEL_2                      0x00000004U
+#define TIM_CHANNEL_3                      0x00000008U
+#define TIM_CHANNEL_4                      0x0000000CU
+#define TIM_CHANNEL_ALL                    0x0000003CU
+#define TIM_COUNTERMODE_UP                 0x00000000U
+#define TIM_CLOCKDIVISION_DIV1             0x00000000U
+#define TIM_AUTORELOAD_PRELOAD_DISABLE     0x00000000U
+#define TIM_AUTORELOAD_PRELOAD_ENABLE      TIM_CR1_ARPE
+#define TIM_CLOCKSOURCE_INTERNAL           0x00001000U
+#define TIM_TRGO_RESET                     0x00000000U
+#define TIM_TRGO_UPDATE                    0x00000020U
+#define TIM_MASTERSLAVEMODE_DISABLE        0x00000000U
+#define TIM_MASTERSLAVEMODE_ENABLE         0x00000080U
+#define TIM_INPUTCHANNELPOLARITY_RISING    0x00000000U
+#define TIM_INPUTCHANNELPOLARITY_FALLING   TIM_CCER_CC1P
+#define TIM_INPUTCHANNELPOLARITY_BOTHEDGE  (TIM_CCER_CC1P | (1UL << 3U))
+#define TIM_ICPOLARITY_RISING              TIM_INPUTCHANNELPOLARITY_RISING
+#define TIM_ICPOLARITY_FALLING             TIM_INPUTCHANNELPOLARITY_FALLING
+#define TIM_ICSELECTION_DIRECTTI           0x00000001U
+#define TIM_ICSELECTION_INDIRECTTI         0x00000002U
+#define TIM_ICSELECTION_TRC                0x00000003U
+#define TIM_ICPSC_DIV1                     0x00000000U
+#define TIM_OCMODE_TIMING                  0x00000000U
+#define TIM_OCMODE_ACTIVE                  0x00000010U
+#define TIM_OCMODE_INACTIVE                0x00000020U
+#define TIM_OCMODE_TOGGLE                  0x00000030U
+#define TIM_OCMODE_FORCED_INACTIVE         0x00000040U
+#define TIM_OCMODE_FORCED_ACTIVE           0x00000050U
+#define TIM_OCMODE_PWM1                    0x00000060U
+#define TIM_OCMODE_PWM2                    0x00000070U
+#define TIM_OCPOLARITY_HIGH                0x00000000U
+#define TIM_OCPOLARITY_LOW                 TIM_CCER_CC1P
+#define TIM_OCFAST_DISABLE                 0x00000000U
+#define TIM_OCFAST_ENABLE                  0x00000004U
+#define TIM_OPMODE_SINGLE                  TIM_CR1_OPM
+#define TIM_OPMODE_REPETITIVE              0x00000000U
+
+#define TIM_FLAG_UPDATE                    TIM_SR_UIF
+#define TIM_FLAG_CC1                       TIM_SR_CC1IF
+#define TIM_FLAG_CC2                       TIM_SR_CC2IF
+#define TIM_FLAG_CC3                       TIM_SR_CC3IF
+#define TIM_FLAG_CC4                       TIM_SR_CC4IF
+#define TIM_FLAG_CC1OF                     TIM_SR_CC1OF
+#define TIM_FLAG_CC2OF                     TIM_SR_CC2OF
+#define TIM_FLAG_CC3OF                     TIM_SR_CC3OF
+#define TIM_FLAG_CC4OF                     TIM_SR_CC4OF
+#define TIM_IT_UPDATE                      TIM_DIER_UIE
+#define TIM_IT_CC1                         TIM_DIER_CC1IE
+#define TIM_IT_CC2                         TIM_DIER_CC2IE
+#define TIM_IT_CC3                         TIM_DIER_CC3IE
+#define TIM_IT_CC4                         TIM_DIER_CC4IE
+
+/* 计数器/状态寄存器由仿真内核按虚拟时钟推进，读写都经过仿真函数 */
+uint32_t sim_tim_get_counter(TIM_TypeDef *TIMx);
+void     sim_tim_set_counter(TIM_TypeDef *TIMx, uint32_t value);
+uint32_t sim_tim_get_flag(TIM_TypeDef *TIMx, uint32_t flag);
+void     sim_tim_clear_flag(TIM_TypeDef *TIMx, uint32_t flag);
+
+#define __HAL_TIM_ENABLE(__HANDLE__)                 ((__HANDLE__)->Instance->CR1 |= (TIM_CR1_CEN))
+#define __HAL_TIM_DISABLE(__HANDLE__)                ((__HANDLE__)->Instance->CR1 &= ~(TIM_CR1_CEN))
+#define __HAL_TIM_ENABLE_IT(__HANDLE__, __IT__)      ((__HANDLE__)->Instance->DIER |= (__IT__))
+#define __HAL_TIM_DISABLE_IT(__HANDLE__, __IT__)     ((__HANDLE__)->Instance->DIER &= ~(__IT__))
+#define __HAL_TIM_GET_IT_SOURCE(__HANDLE__, __IT__)  ((((__HANDLE__)->Instance->DIER & (__IT__)) == (__IT__)) ? SET : RESET)
+#define __HAL_TIM_GET_FLAG(__HANDLE__, __FLAG__)     ((sim_tim_get_flag((__HANDLE__)->Instance, (__FLAG__)) == (__FLAG__)) ? SET : RESET)
+#define __HAL_TIM_CLEAR_FLAG(__HANDLE__, __FLAG__)   sim_tim_clear_flag((__HANDLE__)->Instance, (__FLAG__))
+#define __HAL_TIM_CLEAR_IT(__HANDLE__, __IT__)       sim_tim_clear_flag((__HANDLE__)->Instance, (__IT__))
+#define __HAL_TIM_SET_COUNTER(__HANDLE__, __COUNTER__) sim_tim_set_counter((__HANDLE__)->Instance, (__COUNTER__))
+#define __HAL_TIM_GET_COUNTER(__HANDLE__)            sim_tim_get_counter((__HANDLE__)->Instance)
+#define __HAL_TIM_SET_AUTORELOAD(__HANDLE__, __AUTORELOAD__) \
+  do { (__HANDLE__)->Instance->ARR = (__AUTORELOAD__); (__HANDLE__)->Init.Period = (__AUTORELOAD__); } while(0)
+#define __HAL_TIM_GET_AUTORELOAD(__HANDLE__)         ((__HANDLE__)->Instance->ARR)
+#define __HAL_TIM_SET_PRESCALER(__HANDLE__, __PRESC__) ((__HANDLE__)->Instance->PSC = (__PRESC__))
+#define __HAL_TIM_SET_COMPARE(__HANDLE__, __CHANNEL__, __COMPARE__) \
+  (*(&((__HANDLE__)->Instance->CCR1) + ((__CHANNEL__) >> 2U)) = (__COMPARE__))
+#define __HAL_TIM_GET_COMPARE(__HANDLE__, __CHANNEL__) \
+  (*(&((__HANDLE__)->Instance->CCR1) + ((__CHANNEL__) >> 2U)))
+#define __HAL_TIM_SET_CAPTUREPOLARITY(__HANDLE__, __CHANNEL__, __POLARITY__) \
+  ((__HANDLE__)->Instance->CCER = ((__HANDLE__)->Instance->CCER & ~((TIM_CCER_CC1P | TIM_CCER_CC1NP) << (__CHANNEL__))) | \
+                                  ((__POLARITY__) << (__CHANNEL__)))
+#define __HAL_TIM_SetCompare                         __HAL_TIM_SET_COMPARE
+#define __HAL_TIM_GetCompare                         __HAL_TIM_GET_COMPARE
+#define __HAL_TIM_SetCounter                         __HAL_TIM_SET_COUNTER
+#define __HAL_TIM_GetCounter                         __HAL_TIM_GET_COUNTER
+
+HAL_StatusTypeDef HAL_TIM_Base_Init(TIM_HandleTypeDef *htim);
+HAL_StatusTypeDef HAL_TIM_Base_DeInit(TIM_HandleTypeDef *htim);
+void              HAL_TIM_Base_MspInit(TIM_HandleTypeDef *htim);
+void              HAL_TIM_Base_MspDeInit(TIM_HandleTypeDef *htim);
+HAL_StatusTypeDef HAL_TIM_Base_Start(TIM_HandleTypeDef *htim);
+HAL_StatusTypeDef HAL_TIM_Base_Stop(TIM_HandleTypeDef *htim);
+HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef *htim);
+HAL_StatusTypeDef HAL_TIM_Base_Stop_IT(TIM_HandleTypeDef *htim);
+HAL_StatusTypeDef HAL_TIM_ConfigClockSource(TIM_HandleTypeDef *htim, TIM_ClockConfigTypeDef *sClockSourceConfig);
+HAL_StatusTypeDef HAL_TIM_IC_Init(TIM_HandleTypeDef *htim);
+void              HAL_TIM_IC_MspInit(TIM_HandleTypeDef *htim);
+void              HAL_TIM_OC_MspInit(TIM_HandleTypeDef *htim);
+void              HAL_TIM_PWM_MspInit(TIM_HandleTypeDef *htim);
+void              HAL_TIM_OnePulse_MspInit(TIM_HandleTypeDef *htim);
+HAL_StatusTypeDef HAL_TIM_IC_ConfigChannel(TIM_HandleTypeDef *htim, TIM_IC_InitTypeDef *sConfig, uint32_t Channel);
+HAL_StatusTypeDef HAL_TIM_IC_Start(TIM_HandleTypeDef *htim, uint32_t Channel);
+HAL_StatusTypeDef HAL_TIM_IC_Stop(TIM_HandleTypeDef *htim, uint32_t Channel);
+HAL_StatusTypeDef HAL_TIM_IC_Start_IT(TIM_HandleTypeDef *htim, uint32_t Channel);
+HAL_StatusTypeDef HAL_TIM_IC_Stop_IT(TIM_HandleTypeDef *htim, uint32_t Channel);
+HAL_StatusTypeDef HAL_TIM_OC_Init(TIM_HandleTypeDef *htim);
+HAL_StatusTypeDef HAL_TIM_OC_ConfigChannel(TIM_HandleTypeDef *htim, TIM_OC_InitTypeDef *sConfig, uint32_t Channel);
+HAL_StatusTypeDef HAL_TIM_OC_Start_IT(TIM_HandleTypeDef *htim, uint32_t Channel);
+HAL_StatusTypeDef HAL_TIM_OC_Stop_IT(TIM_HandleTypeDef *htim, uint32_t Channel);
+HAL_StatusTypeDef HAL_TIM_PWM_Init(TIM_HandleTypeDef *htim);
+HAL_StatusTypeDef HAL_TIM_PWM_ConfigChannel(TIM_HandleTypeDef *htim, TIM_OC_InitTypeDef *sConfig, uint32_t Channel);
+HAL_StatusTypeDef HAL_TIM_PWM_Start(TIM_HandleTypeDef *htim, uint32_t Channel);
+HAL_StatusTypeDef HAL_TIM_PWM_Stop(TIM_HandleTypeDef *htim, uint32_t Channel);
+HAL_StatusTypeDef HAL_TIM_OnePulse_Init(TIM_HandleTypeDef *htim, uint32_t OnePulseMode);
+HAL_StatusTypeDef HAL_TIMEx_MasterConfigSynchronization(TIM_HandleTypeDef *htim, TIM_MasterConfigTypeDef *sMasterConfig);
+uint32_t          HAL_TIM_ReadCapturedValue(TIM_HandleTypeDef *htim, uint32_t Channel);
+HAL_TIM_ActiveChannel HAL_TIM_GetActiveChannel(TIM_HandleTypeDef *htim);
+void              HAL_TIM_IRQHandler(TIM_HandleTypeDef *htim);
+void              HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim);
+void              HAL_TIM_IC_CaptureCallback(TIM_HandleTypeDef *htim);
+void              HAL_TIM_OC_DelayElapsedCallback(TIM_HandleTypeDef *htim);
+void              HAL_TIM_PWM_PulseFinishedCallback(TIM_HandleTypeDef *htim);
+
+/******************************* UART *****************************************/
+typedef struct
+{
+  uint32_t BaudRate;
+  uint32_t WordLength;
+  uint32_t StopBits;
+  uint32_t Parity;
+  uint32_t Mode;
+  uint32_t HwFlowCtl;
+  uint32_t OverSampling;
+} UART_InitTypeDef;
+
+typedef enum
+{
+  HAL_UART_STATE_RESET      = 0x00U,
+  HAL_UART_STATE_READY      = 0x20U,
+  HAL_UART_STATE_BUSY       = 0x24U,
+  HAL_UART_STATE_BUSY_TX    = 0x21U,
+  HAL_UART_STATE_BUSY_RX    = 0x22U,
+  HAL_UART_STATE_BUSY_TX_RX = 0x23U,
+  HAL_UART_STATE_TIMEOUT    = 0xA0U,
+  HAL_UART_STATE_ERROR      = 0xE0U
+} HAL_UART_StateTypeDef;
+
+typedef uint32_t HAL_UART_RxTypeTypeDef;
+typedef uint32_t HAL_UART_RxEventTypeTypeDef;
+
+typedef struct __UART_HandleTypeDef
+{
+  USART_TypeDef                 *Instance;
+  UART_InitTypeDef               Init;
+  const uint8_t                 *pTxBuffPtr;
+  uint16_t                       TxXferSize;
+  __IO uint16_t                  TxXferCount;
+  uint8_t                       *pRxBuffPtr;
+  uint16_t                       RxXferSize;
+  __IO uint16_t                  RxXferCount;
+  __IO HAL_UART_RxTypeTypeDef    ReceptionType;
+  __IO HAL_UART_RxEventTypeTypeDef RxEventType;
+  DMA_HandleTypeDef             *hdmatx;
+  DMA_HandleTypeDef             *hdmarx;
+  HAL_LockTypeDef                Lock;
+  __IO HAL_UART_StateTypeDef     gState;
+  __IO HAL_UART_StateTypeDef     RxState;
+  __IO uint32_t                  ErrorCode;
+} UART_HandleTypeDef;
+
+#define UART_WORDLENGTH_8B                  0x00000000U
+#define UART_STOPBITS_1                     0x00000000U
+#define UART_PARITY_NONE                    0x00000000U
+#define UART_HWCONTROL_NONE                 0x00000000U
+#define UART_MODE_RX                        USART_CR1_RE
+#define UART_MODE_TX                        USART_CR1_TE
+#define UART_MODE_TX_RX                     (USART_CR1_TE | USART_CR1_RE)
+#define UART_OVERSAMPLING_16                0x00000000U
+
+#define HAL_UART_ERROR_NONE                 0x00000000U
+#define HAL_UART_ERROR_PE                   0x00000001U
+#define HAL_UART_ERROR_NE                   0x00000002U
+#define HAL_UART_ERROR_FE                   0x00000004U
+#define HAL_UART_ERROR_ORE                  0x00000008U
+#define HAL_UART_ERROR_DMA                  0x00000010U
+
+#define HAL_UART_RECEPTION_STANDARD         (0x00000000U)
+#define HAL_UART_RECEPTION_TOIDLE           (0x00000001U)
+#define HAL_UART_RXEVENT_TC                 (0x00000000U)
+#define HAL_UART_RXEVENT_HT                 (0x00000001U)
+#define HAL_UART_RXEVENT_IDLE               (0x00000002U)
+
+#define UART_FLAG_TXE                       USART_SR_TXE
+#define UART_FLAG_TC                        USART_SR_TC
+#define UART_FLAG_RXNE                      USART_SR_RXNE
+#define UART_FLAG_IDLE                      USART_SR_IDLE
+#define UART_FLAG_ORE                       USART_SR_ORE
+#define UART_FLAG_NE                        USART_SR_NE
+#define UART_FLAG_FE                        USART_SR_FE
+#define UART_FLAG_PE                        USART_SR_PE
+
+#define UART_CR1_REG_INDEX                  1U
+#define UART_CR2_REG_INDEX                  2U
+#define UART_CR3_REG_INDEX                  3U
+#define UART_IT_MASK                        0x0000FFFFU
+#define UART_IT_PE                          ((uint32_t)(UART_CR1_REG_INDEX << 28U | USART_CR1_PEIE))
+#define UART_IT_TXE                         ((uint32_t)(UART_CR1_REG_INDEX << 28U | USART_CR1_TXEIE))
+#define UART_IT_TC                          ((uint32_t)(UART_CR1_REG_INDEX << 28U | USART_CR1_TCIE))
+#define UART_IT_RXNE                        ((uint32_t)(UART_CR1_REG_INDEX << 28U | USART_CR1_RXNEIE))
+#define UART_IT_IDLE                        ((uint32_t)(UART_CR1_REG_INDEX << 28U | USART_CR1_IDLEIE))
+#define UART_IT_ERR                         ((uint32_t)(UART_CR3_REG_INDEX << 28U | USART_CR3_EIE))
+
+/* SR 由仿真内核置位：写 SR 只能清 rc_w0 位（RXNE/TC），
+ * PE/FE/NE/ORE/IDLE 需要"读 SR 再读 DR"才能清掉，同时会读走 DR 里的数据 */
+void sim_uart_clear_flag(USART_TypeDef *USARTx, uint32_t flag);
+void sim_uart_clear_peflag(USART_TypeDef *USARTx);
+
+#define __HAL_UART_GET_FLAG(__HANDLE__, __FLAG__)   (((__HANDLE__)->Instance->SR & (__FLAG__)) == (__FLAG__))
+#define __HAL_UART_CLEAR_FLAG(__HANDLE__, __FLAG__) sim_uart_clear_flag((__HANDLE__)->Instance, (__FLAG__))
+#define __HAL_UART_CLEAR_PEFLAG(__HANDLE__)         sim_uart_clear_peflag((__HANDLE__)->Instance)
+#define __HAL_UART_CLEAR_FEFLAG(__HANDLE__)         __HAL_UART_CLEAR_PEFLAG(__HANDLE__)
+#define __HAL_UART_CLEAR_NEFLAG(__HANDLE__)         __HAL_UART_CLEAR_PEFLAG(__HANDLE__)
+#define __HAL_UART_CLEAR_OREFLAG(__HANDLE__)        __HAL_UART_CLEAR_PEFLAG(__HANDLE__)
+#define __HAL_UART_CLEAR_IDLEFLAG(__HANDLE__)       __HAL_UART_CLEAR_PEFLAG(__HANDLE__)
+#define __HAL_UART_ENABLE_IT(__HANDLE__, __INTERRUPT__)                                                   \
+  ((((__INTERRUPT__) >> 28U) == UART_CR1_REG_INDEX) ? ((__HANDLE__)->Instance->CR1 |= ((__INTERRUPT__) & UART_IT_MASK)) : \
+   ((__HANDLE__)->Instance->CR3 |= ((__INTERRUPT__) & UART_IT_MASK)))
+#define __HAL_UART_DISABLE_IT(__HANDLE__, __INTERRUPT__)                                                  \
+  ((((__INTERRUPT__) >> 28U) == UART_CR1_REG_INDEX) ? ((__HANDLE__)->Instance->CR1 &= ~((__INTERRUPT__) & UART_IT_MASK)) : \
+   ((__HANDLE__)->Instance->CR3 &= ~((__INTERRUPT__) & UART_IT_MASK)))
+#define __HAL_UART_GET_IT_SOURCE(__HANDLE__, __IT__)                                                      \
+  (((((__IT__) >> 28U) == UART_CR1_REG_INDEX) ? (__HANDLE__)->Instance->CR1 : (__HANDLE__)->Instance->CR3) & \
+   (((uint32_t)(__IT__)) & UART_IT_MASK))
+
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *huart);
+HAL_StatusTypeDef HAL_UART_DeInit(UART_HandleTypeDef *huart);
+void              HAL_UART_MspInit(UART_HandleTypeDef *huart);
+void              HAL_UART_MspDeInit(UART_HandleTypeDef *huart);
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_UART_Receive_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_UART_DMAStop(UART_HandleTypeDef *huart);
+HAL_StatusTypeDef HAL_UART_AbortReceive(UART_HandleTypeDef *huart);
+HAL_StatusTypeDef HAL_UART_AbortTransmit(UART_HandleTypeDef *huart);
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size);
+HAL_UART_RxEventTypeTypeDef HAL_UARTEx_GetRxEventType(UART_HandleTypeDef *huart);
+HAL_UART_StateTypeDef HAL_UART_GetState(UART_HandleTypeDef *huart);
+uint32_t          HAL_UART_GetError(UART_HandleTypeDef *huart);
+void              HAL_UART_IRQHandler(UART_HandleTypeDef *huart);
+void              HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart);
+void              HAL_UART_TxHalfCpltCallback(UART_HandleTypeDef *huart);
+void              HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart);
+void              HAL_UART_RxHalfCpltCallback(UART_HandleTypeDef *huart);
+void              HAL_UART_ErrorCallback(UART_HandleTypeDef *huart);
+void              HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size);
+
+/******************************* I2C ******************************************/
+typedef struct
+{
+  uint32_t ClockSpeed;
+  uint32_t DutyCycle;
+  uint32_t OwnAddress1;
+  uint32_t AddressingMode;
+  uint32_t DualAddressMode;
+  uint32_t OwnAddress2;
+  uint32_t GeneralCallMode;
+  uint32_t NoStretchMode;
+} I2C_InitTypeDef;
+
+typedef enum
+{
+  HAL_I2C_STATE_RESET     = 0x00U,
+  HAL_I2C_STATE_READY     = 0x20U,
+  HAL_I2C_STATE_BUSY      = 0x24U,
+  HAL_I2C_STATE_BUSY_TX   = 0x21U,
+  HAL_I2C_STATE_BUSY_RX   = 0x22U,
+  HAL_I2C_STATE_ABORT     = 0x60U,
+  HAL_I2C_STATE_TIMEOUT   = 0xA0U,
+  HAL_I2C_STATE_ERROR     = 0xE0U
+} HAL_I2C_StateTypeDef;
+
+typedef enum
+{
+  HAL_I2C_MODE_NONE   = 0x00U,
+  HAL_I2C_MODE_MASTER = 0x10U,
+  HAL_I2C_MODE_SLAVE  = 0x20U,
+  HAL_I2C_MODE_MEM    = 0x40U
+} HAL_I2C_ModeTypeDef;
+
+typedef struct __I2C_HandleTypeDef
+{
+  I2C_TypeDef                *Instance;
+  I2C_InitTypeDef             Init;
+  uint8_t                    *pBuffPtr;
+  uint16_t                    XferSize;
+  __IO uint16_t               XferCount;
+  __IO uint32_t               XferOptions;
+  __IO uint32_t               PreviousState;
+  DMA_HandleTypeDef          *hdmatx;
+  DMA_HandleTypeDef          *hdmarx;
+  HAL_LockTypeDef             Lock;
+  __IO HAL_I2C_StateTypeDef   State;
+  __IO HAL_I2C_ModeTypeDef    Mode;
+  __IO uint32_t               ErrorCode;
+  __IO uint32_t               Devaddress;
+  __IO uint32_t               Memaddress;
+  __IO uint32_t               MemaddSize;
+} I2C_HandleTypeDef;
+
+#define I2C_DUTYCYCLE_2                 0x00000000U
+#define I2C_DUTYCYCLE_16_9              0x00004000U
+#define I2C_ADDRESSINGMODE_7BIT         0x00004000U
+#define I2C_DUALADDRESS_DISABLE         0x00000000U
+#define I2C_GENERALCALL_DISABLE         0x00000000U
+#define I2C_NOSTRETCH_DISABLE           0x00000000U
+#define I2C_MEMADD_SIZE_8BIT            0x00000001U
+#define I2C_MEMADD_SIZE_16BIT           0x00000010U
+#define HAL_I2C_ERROR_NONE              0x00000000U
+#define HAL_I2C_ERROR_BERR              0x00000001U
+#define HAL_I2C_ERROR_ARLO              0x00000002U
+#define HAL_I2C_ERROR_AF                0x00000004U
+#define HAL_I2C_ERROR_OVR               0x00000008U
+#define HAL_I2C_ERROR_DMA               0x00000010U
+#define HAL_I2C_ERROR_TIMEOUT           0x00000020U
+
+#define __HAL_I2C_ENABLE(__HANDLE__)    ((__HANDLE__)->Instance->CR1 |= I2C_CR1_PE)
+#define __HAL_I2C_DISABLE(__HANDLE__)   ((__HANDLE__)->Instance->CR1 &= ~I2C_CR1_PE)
+
+HAL_StatusTypeDef HAL_I2C_Init(I2C_HandleTypeDef *hi2c);
+HAL_StatusTypeDef HAL_I2C_DeInit(I2C_HandleTypeDef *hi2c);
+void              HAL_I2C_MspInit(I2C_HandleTypeDef *hi2c);
+void              HAL_I2C_MspDeInit(I2C_HandleTypeDef *hi2c);
+HAL_StatusTypeDef HAL_I2C_Master_Transmit(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_I2C_Mem_Write(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t *pData, uint16_t Size, uint32_t Timeout);
+HAL_StatusTypeDef HAL_I2C_Mem_Write_DMA(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_I2C_IsDeviceReady(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint32_t Trials, uint32_t Timeout);
+HAL_I2C_StateTypeDef HAL_I2C_GetState(I2C_HandleTypeDef *hi2c);
+uint32_t          HAL_I2C_GetError(I2C_HandleTypeDef *hi2c);
+void              HAL_I2C_EV_IRQHandler(I2C_HandleTypeDef *hi2c);
+void              HAL_I2C_ER_IRQHandler(I2C_HandleTypeDef *hi2c);
+void              HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef *hi2c);
+void              HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c);
+
+/******************************* PCD (USB) ************************************/
+typedef struct
+{
+  void    *Instance;
+  __IO uint32_t State;
+  void    *pData;
+} PCD_HandleTypeDef;
+
+void HAL_PCD_IRQHandler(PCD_HandleTypeDef *hpcd);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __STM32F1xx_HAL_H */
@@ -0,0 +1,22 @@
+/**
+ ******************************************************************************
+ * @file    usb_device.h
+ * @brief   仿真用 usb_device.h（替代 USB_DEVICE/App/usb_device.h）
+ ******************************************************************************
+ */
+#ifndef __USB_DEVICE__H__
+#define __USB_DEVICE__H__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32f1xx_hal.h"
+
+void MX_USB_DEVICE_Init(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __USB_DEVICE__H__ */
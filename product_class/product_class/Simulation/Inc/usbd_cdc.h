@@ -0,0 +1,96 @@
+/**
+ ******************************************************************************
+ * @file    usbd_cdc.h
+ * @brief   仿真用 usbd_cdc.h（替代 Middlewares 下的 USB 设备库）
+ ******************************************************************************
+ * @attention
+ *
+ * 只保留 usbd_cdc_if.c 用到的类型和函数，结构体成员是官方库的子集，
+ * 名字保持一致。实现在 sim_usb.c。
+ *
+ ******************************************************************************
+ */
+#ifndef __USB_CDC_H
+#define __USB_CDC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#include "stm32f1xx_hal.h"
+
+#define CDC_DATA_FS_MAX_PACKET_SIZE     64U
+
+#define CDC_SEND_ENCAPSULATED_COMMAND   0x00U
+#define CDC_GET_ENCAPSULATED_RESPONSE   0x01U
+#define CDC_SET_COMM_FEATURE            0x02U
+#define CDC_GET_COMM_FEATURE            0x03U
+#define CDC_CLEAR_COMM_FEATURE          0x04U
+#define CDC_SET_LINE_CODING             0x20U
+#define CDC_GET_LINE_CODING             0x21U
+#define CDC_SET_CONTROL_LINE_STATE      0x22U
+#define CDC_SEND_BREAK                  0x23U
+
+#define USBD_STATE_DEFAULT              0x01U
+#define USBD_STATE_ADDRESSED            0x02U
+#define USBD_STATE_CONFIGURED           0x03U
+#define USBD_STATE_SUSPENDED            0x04U
+
+typedef enum
+{
+  USBD_OK = 0U,
+  USBD_BUSY,
+  USBD_FAIL,
+} USBD_StatusTypeDef;
+
+typedef struct usb_setup_req
+{
+  uint8_t  bmRequest;
+  uint8_t  bRequest;
+  uint16_t wValue;
+  uint16_t wIndex;
+  uint16_t wLength;
+} USBD_SetupReqTypedef;
+
+typedef struct _USBD_HandleTypeDef
+{
+  uint8_t       id;
+  uint32_t      dev_config;
+  __IO uint8_t  dev_state;
+  void         *pClassData;
+  void         *pUserData;
+  void         *pData;
+} USBD_HandleTypeDef;
+
+typedef struct _USBD_CDC_Itf
+{
+  int8_t (* Init)(void);
+  int8_t (* DeInit)(void);
+  int8_t (* Control)(uint8_t cmd, uint8_t *pbuf, uint16_t length);
+  int8_t (* Receive)(uint8_t *Buf, uint32_t *Len);
+} USBD_CDC_ItfTypeDef;
+
+typedef struct
+{
+  uint32_t data[CDC_DATA_FS_MAX_PACKET_SIZE / 4U];
+  uint8_t  CmdOpCode;
+  uint8_t  CmdLength;
+  uint8_t  *RxBuffer;
+  uint8_t  *TxBuffer;
+  uint32_t RxLength;
+  uint32_t TxLength;
+
+  __IO uint32_t TxState;
+  __IO uint32_t RxState;
+} USBD_CDC_HandleTypeDef;
+
+uint8_t USBD_CDC_SetTxBuffer(USBD_HandleTypeDef *pdev, uint8_t *pbuff, uint16_t length);
+uint8_t USBD_CDC_SetRxBuffer(USBD_HandleTypeDef *pdev, uint8_t *pbuff);
+uint8_t USBD_CDC_ReceivePacket(USBD_HandleTypeDef *pdev);
+uint8_t USBD_CDC_TransmitPacket(USBD_HandleTypeDef *pdev);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __USB_CDC_H */
@@ -0,0 +1,862 @@
+/**
+ ******************************************************************************
+ * @file    sim_core.c
+ * @brief   仿真内核：虚拟时钟、临界区、NVIC 中断投递、内核寄存器镜像
+ ******************************************************************************
+ * @attention
+ *
+ * DWT/SysTick/SCB/CoreDebug 映射在 0xE0000000 起的真实地址上，
+ * 固件直接读写这些地址（core_delay.c 就是这么用的）。时钟每次推进都刷新
+ * CYCCNT，每次轮询刷新 SysTick->VAL；如果固件改写了它们（比如 CYCCNT 清零），
+ * 用 CAS 发现后以固件写入的值为新起点继续计数。
+ *
+ ******************************************************************************
+ */
+#define _GNU_SOURCE
+#include <errno.h>
+#include <math.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include "sim.h"
+
+#define SIM_CORE_BASE        0xE0000000UL
+#define SIM_CORE_SIZE        0x00100000UL
+#define SIM_IRQ_SIGNAL       SIGUSR1
+#define SIM_STEP_SIGNAL      SIGUSR2
+#define SIM_SYSTICK_BACKLOG  1000
+#define SIM_STALL_CHECK_US   100U      /* 内核线程多久看一次固件有没有在空转 */
+#define SIM_STALL_CPU_US     500U      /* 固件占了这么多 CPU 却没推进时钟算空转 */
+#define SIM_STALL_TICKS      10U       /* 空转时一次最多推进的轮询周期数，有中断就停 */
+#define SIM_PACE_SLACK_NS    1000000U  /* --realtime 时超前主机时间这么多才睡 */
+
+sim_options_t sim_opt =
+{
+  .time_scale       = 1.0,
+  .tick_us          = 10,
+  .realtime         = 0,
+  .duration_ms      = 0,
+  .pty_link         = NULL,
+  .report_path      = NULL,
+  .oled_dump_path   = NULL,
+  .distance_m       = 0.50,
+  .distance_noise_m = 0.0,
+  .temp_c           = 24,
+  .humi_pct         = 55,
+  .lsi_hz           = 40000,
+  .seed             = 1,
+  .quiet            = 0,
+};
+
+/******************************* 虚拟时钟 *************************************/
+static struct timespec sim_t0;
+static double          sim_pace_cycles_per_ns;  /* --realtime */
+
+/* 只在固件线程上（包括它的信号处理函数里）推进，别的线程只读 */
+static volatile uint64_t sim_cycles;
+static uint64_t          sim_tick_cycles;
+static uint64_t          sim_next_tick;         /* 下一次轮询外设模型的时刻 */
+static volatile uint64_t sim_progress;          /* 推进时钟和出锁的次数，内核线程据此判断固件是否在空转 */
+static volatile uint64_t sim_stall_seen;        /* 内核线程发 SIGUSR2 时看到的 sim_progress */
+static uint64_t          sim_stall_steps;
+static uint64_t          sim_irq_handled;       /* 执行过的中断处理函数个数 */
+static __thread int      sim_lock_depth;
+
+static void sim_core_poll_dwt(uint64_t now);
+static int  sim_irq_waiting(void);
+
+uint64_t sim_host_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)(ts.tv_sec - sim_t0.tv_sec) * 1000000000ULL + (uint64_t)ts.tv_nsec - (uint64_t)sim_t0.tv_nsec;
+}
+
+uint64_t sim_now(void)
+{
+  return __atomic_load_n(&sim_cycles, __ATOMIC_RELAXED);
+}
+
+/* --realtime：虚拟时间超前主机时间太多就睡一会儿 */
+static void sim_pace(uint64_t now)
+{
+  uint64_t target = (uint64_t)((double)now / sim_pace_cycles_per_ns);
+  uint64_t host = sim_host_ns();
+
+  if (target > host + SIM_PACE_SLACK_NS)
+  {
+    struct timespec ts = { (time_t)((target - host) / 1000000000ULL), (long)((target - host) % 1000000000ULL) };
+    nanosleep(&ts, NULL);
+  }
+}
+
+/* 到了轮询时刻：推进各个外设模型，有中断就投递 */
+static void sim_tick(uint64_t now)
+{
+  sim_next_tick = now - now % sim_tick_cycles + sim_tick_cycles;
+  sim_lock();
+  sim_core_poll(now);
+  sim_gpio_poll(now);
+  sim_tim_poll(now);
+  sim_uart_poll(now);
+  sim_i2c_poll(now);
+  sim_usb_poll(now);
+  sim_env_poll(now);
+  sim_pwr_poll(now);
+  sim_unlock();
+  if (sim_opt.duration_ms != 0U && now >= SIM_MS(sim_opt.duration_ms))
+  {
+    sim_exit(0);
+  }
+  if (sim_opt.realtime)
+  {
+    sim_pace(now);
+  }
+  sim_irq_kick();
+}
+
+static void sim_jump(uint64_t cycles)
+{
+  __atomic_store_n(&sim_cycles, cycles, __ATOMIC_RELAXED);
+  sim_progress++;
+  /* 持锁时（模型里回调到固件）只记时间，轮询留到出锁后的下一次推进 */
+  if (cycles >= sim_next_tick && sim_lock_depth == 0)
+  {
+    sim_tick(cycles);
+  }
+  else
+  {
+    sim_core_poll_dwt(cycles);
+  }
+}
+
+void sim_advance(uint32_t cycles)
+{
+  sim_jump(sim_cycles + cycles);
+}
+
+/* 中间的每个轮询时刻都停一下，期间到期的中断照常执行 */
+void sim_spin_until(uint64_t cycles)
+{
+  while (sim_cycles < cycles)
+  {
+    sim_jump(cycles < sim_next_tick ? cycles : sim_next_tick);
+  }
+}
+
+/* SIGUSR2：固件在空转，往前推到有中断为止（最多 SIM_STALL_TICKS 个轮询周期） */
+static void sim_stall_step(int sig)
+{
+  int saved_errno = errno;
+  uint64_t handled = sim_irq_handled;
+
+  (void)sig;
+  /* 信号被锁挡住、出锁后才送到的，说明固件并没有卡住 */
+  if (sim_progress != sim_stall_seen)
+  {
+    return;
+  }
+  sim_stall_steps++;
+  for (uint32_t i = 0; i < SIM_STALL_TICKS && sim_irq_handled == handled; i++)
+  {
+    sim_jump(sim_next_tick);
+    if (sim_irq_waiting())
+    {
+      break;
+    }
+  }
+  errno = saved_errno;
+}
+
+uint64_t sim_core_stall_steps(void)
+{
+  return sim_stall_steps;
+}
+
+/* xorshift32，结果可由 --seed 复现 */
+static uint32_t sim_rng_state = 1;
+
+uint32_t sim_rand(void)
+{
+  uint32_t x = sim_rng_state;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  sim_rng_state = x;
+  return x;
+}
+
+double sim_rand_gauss(void)
+{
+  double u1 = ((double)sim_rand() + 1.0) / 4294967297.0;
+  double u2 = ((double)sim_rand() + 1.0) / 4294967297.0;
+  return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+/******************************* 临界区 ***************************************/
+static pthread_mutex_t  sim_mutex;
+static pthread_t        sim_fw_thread;
+static pthread_t        sim_kernel_thread;
+static __thread int      sim_is_fw;
+static __thread sigset_t sim_lock_saved;
+
+static volatile sig_atomic_t sim_primask;
+static volatile sig_atomic_t sim_handler_depth;
+static volatile sig_atomic_t sim_kick_sent;
+static uint64_t              sim_wfi_calls;
+static uint64_t              sim_wfi_total;     /* WFI 睡眠的周期数，不含期间的中断 */
+
+static void sim_block_irq_signal(sigset_t *saved)
+{
+  sigset_t set;
+  sigemptyset(&set);
+  sigaddset(&set, SIM_IRQ_SIGNAL);
+  pthread_sigmask(SIG_BLOCK, &set, saved);
+}
+
+/* 持锁期间中断和空转推进都不能进来 */
+static void sim_block_sim_signals(sigset_t *saved)
+{
+  sigset_t set;
+  sigemptyset(&set);
+  sigaddset(&set, SIM_IRQ_SIGNAL);
+  sigaddset(&set, SIM_STEP_SIGNAL);
+  pthread_sigmask(SIG_BLOCK, &set, saved);
+}
+
+static void sim_unblock_irq_signal(void)
+{
+  sigset_t set;
+  sigemptyset(&set);
+  sigaddset(&set, SIM_IRQ_SIGNAL);
+  pthread_sigmask(SIG_UNBLOCK, &set, NULL);
+}
+
+void sim_lock(void)
+{
+  if (sim_lock_depth++ == 0 && sim_is_fw)
+  {
+    sim_block_sim_signals(&sim_lock_saved);
+  }
+  pthread_mutex_lock(&sim_mutex);
+}
+
+void sim_unlock(void)
+{
+  pthread_mutex_unlock(&sim_mutex);
+  if (--sim_lock_depth == 0 && sim_is_fw)
+  {
+    sim_progress++;
+    pthread_sigmask(SIG_SETMASK, &sim_lock_saved, NULL);
+  }
+}
+
+int sim_in_handler(void)
+{
+  return sim_handler_depth != 0;
+}
+
+/******************************* 内核指令 *************************************/
+void sim_disable_irq(void)
+{
+  if (!sim_primask && !sim_handler_depth)
+  {
+    sim_block_irq_signal(NULL);
+  }
+  sim_primask = 1;
+}
+
+void sim_enable_irq(void)
+{
+  sim_primask = 0;
+  if (!sim_handler_depth)
+  {
+    sim_unblock_irq_signal();
+  }
+}
+
+uint32_t sim_get_primask(void)
+{
+  return (uint32_t)sim_primask;
+}
+
+void sim_set_primask(uint32_t primask)
+{
+  if (primask & 1U)
+  {
+    sim_disable_irq();
+  }
+  else
+  {
+    sim_enable_irq();
+  }
+}
+
+void sim_system_reset(void)
+{
+  fprintf(stderr, "sim: NVIC_SystemReset() called\n");
+  sim_exit(3);
+}
+
+/* WFI：一个轮询周期一个轮询周期地往前跳，直到执行过中断。
+ * PRIMASK 置位时中断不执行但仍能唤醒内核 */
+void sim_wfi(void)
+{
+  uint64_t t0, irq0, handled;
+
+  if (sim_handler_depth)
+  {
+    return;
+  }
+  t0 = sim_now();
+  irq0 = sim_prof_irq_cycles();
+  handled = sim_irq_handled;
+  while (sim_irq_handled == handled && !sim_irq_waiting())
+  {
+    sim_jump(sim_next_tick);
+  }
+  sim_wfi_calls++;
+  sim_wfi_total += (sim_now() - t0) - (sim_prof_irq_cycles() - irq0);
+}
+
+uint64_t sim_wfi_cycles(void)
+{
+  return sim_wfi_total;
+}
+
+uint64_t sim_wfi_count(void)
+{
+  return sim_wfi_calls;
+}
+
+/******************************* NVIC *****************************************/
+#define SIM_VECTOR(name) extern void name(void) __attribute__((weak));
+SIM_VECTOR(SysTick_Handler)
+SIM_VECTOR(PendSV_Handler)
+SIM_VECTOR(EXTI0_IRQHandler)
+SIM_VECTOR(EXTI1_IRQHandler)
+SIM_VECTOR(EXTI2_IRQHandler)
+SIM_VECTOR(EXTI3_IRQHandler)
+SIM_VECTOR(EXTI4_IRQHandler)
+SIM_VECTOR(DMA1_Channel1_IRQHandler)
+SIM_VECTOR(DMA1_Channel2_IRQHandler)
+SIM_VECTOR(DMA1_Channel3_IRQHandler)
+SIM_VECTOR(DMA1_Channel4_IRQHandler)
+SIM_VECTOR(DMA1_Channel5_IRQHandler)
+SIM_VECTOR(DMA1_Channel6_IRQHandler)
+SIM_VECTOR(DMA1_Channel7_IRQHandler)
+SIM_VECTOR(USB_LP_CAN1_RX0_IRQHandler)
+SIM_VECTOR(EXTI9_5_IRQHandler)
+SIM_VECTOR(TIM2_IRQHandler)
+SIM_VECTOR(TIM3_IRQHandler)
+SIM_VECTOR(I2C2_EV_IRQHandler)
+SIM_VECTOR(I2C2_ER_IRQHandler)
+SIM_VECTOR(USART1_IRQHandler)
+SIM_VECTOR(EXTI15_10_IRQHandler)
+SIM_VECTOR(RTC_Alarm_IRQHandler)
+SIM_VECTOR(USBWakeUp_IRQHandler)
+
+typedef void (*sim_vector_t)(void);
+
+static sim_vector_t sim_vector(int idx)
+{
+  switch (idx - 16)
+  {
+    case SysTick_IRQn:          return SysTick_Handler;
+    case PendSV_IRQn:           return PendSV_Handler;
+    case EXTI0_IRQn:            return EXTI0_IRQHandler;
+    case EXTI1_IRQn:            return EXTI1_IRQHandler;
+    case EXTI2_IRQn:            return EXTI2_IRQHandler;
+    case EXTI3_IRQn:            return EXTI3_IRQHandler;
+    case EXTI4_IRQn:            return EXTI4_IRQHandler;
+    case DMA1_Channel1_IRQn:    return DMA1_Channel1_IRQHandler;
+    case DMA1_Channel2_IRQn:    return DMA1_Channel2_IRQHandler;
+    case DMA1_Channel3_IRQn:    return DMA1_Channel3_IRQHandler;
+    case DMA1_Channel4_IRQn:    return DMA1_Channel4_IRQHandler;
+    case DMA1_Channel5_IRQn:    return DMA1_Channel5_IRQHandler;
+    case DMA1_Channel6_IRQn:    return DMA1_Channel6_IRQHandler;
+    case DMA1_Channel7_IRQn:    return DMA1_Channel7_IRQHandler;
+    case USB_LP_CAN1_RX0_IRQn:  return USB_LP_CAN1_RX0_IRQHandler;
+    case EXTI9_5_IRQn:          return EXTI9_5_IRQHandler;
+    case TIM2_IRQn:             return TIM2_IRQHandler;
+    case TIM3_IRQn:             return TIM3_IRQHandler;
+    case I2C2_EV_IRQn:          return I2C2_EV_IRQHandler;
+    case I2C2_ER_IRQn:          return I2C2_ER_IRQHandler;
+    case USART1_IRQn:           return USART1_IRQHandler;
+    case EXTI15_10_IRQn:        return EXTI15_10_IRQHandler;
+    case RTC_Alarm_IRQn:        return RTC_Alarm_IRQHandler;
+    case USBWakeUp_IRQn:        return USBWakeUp_IRQHandler;
+    default:                    return NULL;
+  }
+}
+
+static uint8_t          sim_nvic_enabled[SIM_IRQ_COUNT];
+static uint8_t          sim_nvic_prio[SIM_IRQ_COUNT];
+static uint32_t         sim_nvic_pending[SIM_IRQ_COUNT];
+static sim_irq_level_fn sim_nvic_level[SIM_IRQ_COUNT];
+static uint32_t         sim_nvic_group = NVIC_PRIORITYGROUP_4;
+static uint32_t         sim_systick_backlog_max;
+
+void sim_irq_set_level_source(IRQn_Type irqn, sim_irq_level_fn fn)
+{
+  sim_nvic_level[SIM_IRQ_INDEX(irqn)] = fn;
+}
+
+/* SCB->ICSR 的 PENDSTSET 跟着 SysTick 的挂起计数走，调用者持锁 */
+static void sim_systick_icsr_sync(void)
+{
+  if (sim_nvic_pending[SIM_IRQ_INDEX(SysTick_IRQn)] != 0U)
+  {
+    SCB->ICSR |= SCB_ICSR_PENDSTSET_Msk;
+  }
+  else
+  {
+    SCB->ICSR &= ~SCB_ICSR_PENDSTSET_Msk;
+  }
+}
+
+void sim_irq_pend(IRQn_Type irqn)
+{
+  int idx = SIM_IRQ_INDEX(irqn);
+
+  if (irqn == SysTick_IRQn)
+  {
+    if (sim_nvic_pending[idx] < SIM_SYSTICK_BACKLOG)
+    {
+      sim_nvic_pending[idx]++;
+    }
+    if (sim_nvic_pending[idx] > sim_systick_backlog_max)
+    {
+      sim_systick_backlog_max = sim_nvic_pending[idx];
+    }
+    sim_systick_icsr_sync();
+  }
+  else
+  {
+    sim_nvic_pending[idx] = 1;
+  }
+}
+
+static int sim_irq_is_enabled(int idx)
+{
+  if (idx == SIM_IRQ_INDEX(SysTick_IRQn))
+  {
+    return (SysTick->CTRL & SysTick_CTRL_TICKINT_Msk) != 0U;
+  }
+  if (idx < 16)
+  {
+    return 1;
+  }
+  return sim_nvic_enabled[idx];
+}
+
+/* 找出优先级最高的待处理中断，调用者持锁 */
+static int sim_irq_select(void)
+{
+  int best = -1;
+
+  for (int idx = 0; idx < SIM_IRQ_COUNT; idx++)
+  {
+    if (!sim_irq_is_enabled(idx))
+    {
+      continue;
+    }
+    if (sim_nvic_pending[idx] == 0U && !(sim_nvic_level[idx] != NULL && sim_nvic_level[idx]()))
+    {
+      continue;
+    }
+    if (best < 0 || sim_nvic_prio[idx] < sim_nvic_prio[best])
+    {
+      best = idx;
+    }
+  }
+  return best;
+}
+
+static int sim_irq_waiting(void)
+{
+  int pending;
+
+  sim_lock();
+  pending = sim_irq_select() >= 0;
+  sim_unlock();
+  return pending;
+}
+
+/* 只在固件线程上调用：信号发给自己，没屏蔽时返回前就执行完了，屏蔽着就等解除屏蔽的那一刻 */
+void sim_irq_kick(void)
+{
+  if (sim_kick_sent || !sim_irq_waiting())
+  {
+    return;
+  }
+  sim_kick_sent = 1;
+  pthread_kill(sim_fw_thread, SIM_IRQ_SIGNAL);
+}
+
+/* 中断处理在固件线程的信号上下文里执行，不做抢占嵌套：
+ * 一个 handler 跑完后按优先级继续处理剩余的中断（相当于 tail-chaining） */
+static void sim_irq_dispatch(int sig, siginfo_t *info, void *context)
+{
+  ucontext_t *uc = (ucontext_t *)context;
+  int saved_errno = errno;
+
+  (void)sig;
+  (void)info;
+  sim_kick_sent = 0;
+  sim_handler_depth++;
+  while (!sim_primask)
+  {
+    int idx;
+    sim_vector_t handler;
+    uint64_t start;
+
+    sim_lock();
+    idx = sim_irq_select();
+    if (idx >= 0 && sim_nvic_pending[idx] != 0U)
+    {
+      sim_nvic_pending[idx]--;
+      sim_systick_icsr_sync();
+    }
+    sim_unlock();
+    if (idx < 0)
+    {
+      break;
+    }
+    handler = sim_vector(idx);
+    if (handler == NULL)
+    {
+      continue;
+    }
+    sim_prof_irq_enter(idx);
+    start = sim_now();
+    sim_irq_handled++;
+    sim_advance(SIM_IRQ_ENTRY_CYCLES);
+    handler();
+    sim_prof_irq_exit(idx, sim_now() - start);
+  }
+  sim_handler_depth--;
+
+  /* 中断里改了 PRIMASK 要带回线程模式，与 Cortex-M 异常返回行为一致 */
+  if (sim_primask)
+  {
+    sigaddset(&uc->uc_sigmask, SIM_IRQ_SIGNAL);
+  }
+  errno = saved_errno;
+}
+
+void HAL_NVIC_SetPriorityGrouping(uint32_t PriorityGroup)
+{
+  sim_nvic_group = PriorityGroup & 0x07U;
+}
+
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority)
+{
+  uint32_t group = sim_nvic_group;
+  uint32_t preempt_bits = ((7U - group) > __NVIC_PRIO_BITS) ? __NVIC_PRIO_BITS : (7U - group);
+  uint32_t sub_bits = ((group + __NVIC_PRIO_BITS) < 7U) ? 0U : (group - 7U + __NVIC_PRIO_BITS);
+  uint32_t prio = ((PreemptPriority & ((1UL << preempt_bits) - 1UL)) << sub_bits) |
+                  (SubPriority & ((1UL << sub_bits) - 1UL));
+
+  sim_nvic_prio[SIM_IRQ_INDEX(IRQn)] = (uint8_t)prio;
+}
+
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn)
+{
+  sim_lock();
+  sim_nvic_enabled[SIM_IRQ_INDEX(IRQn)] = 1;
+  sim_unlock();
+  sim_irq_kick();
+}
+
+void HAL_NVIC_DisableIRQ(IRQn_Type IRQn)
+{
+  sim_lock();
+  sim_nvic_enabled[SIM_IRQ_INDEX(IRQn)] = 0;
+  sim_unlock();
+}
+
+uint32_t HAL_NVIC_GetPendingIRQ(IRQn_Type IRQn)
+{
+  return sim_nvic_pending[SIM_IRQ_INDEX(IRQn)] != 0U;
+}
+
+void HAL_NVIC_SetPendingIRQ(IRQn_Type IRQn)
+{
+  sim_lock();
+  sim_irq_pend(IRQn);
+  sim_unlock();
+  sim_irq_kick();
+}
+
+void HAL_NVIC_ClearPendingIRQ(IRQn_Type IRQn)
+{
+  sim_lock();
+  sim_nvic_pending[SIM_IRQ_INDEX(IRQn)] = 0;
+  sim_systick_icsr_sync();
+  sim_unlock();
+}
+
+void HAL_NVIC_SystemReset(void)
+{
+  sim_system_reset();
+}
+
+uint32_t sim_core_systick_backlog_max(void)
+{
+  return sim_systick_backlog_max;
+}
+
+/******************************* 内核寄存器镜像 *******************************/
+static uint32_t sim_cyccnt_written;
+static uint64_t sim_cyccnt_base;
+static int      sim_cyccnt_running;
+
+static uint32_t sim_st_ctrl;
+static uint32_t sim_st_load;
+static uint32_t sim_st_val_written;
+static uint64_t sim_st_base;
+static uint64_t sim_st_ticks;
+
+static void sim_core_map(void)
+{
+  void *p = mmap((void *)SIM_CORE_BASE, SIM_CORE_SIZE, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+
+  if (p == MAP_FAILED || p != (void *)SIM_CORE_BASE)
+  {
+    fprintf(stderr, "sim: cannot map core peripherals at 0x%08lX: %s\n", SIM_CORE_BASE, strerror(errno));
+    exit(1);
+  }
+  /* Cortex-M3 r1p1 */
+  *(volatile uint32_t *)&SCB->CPUID = 0x411FC231U;
+  *(volatile uint32_t *)&SysTick->CALIB = SIM_CORE_CLOCK_HZ / 8000U;
+}
+
+static void sim_core_poll_dwt(uint64_t now)
+{
+  uint32_t expect;
+  uint32_t value;
+
+  if (!(CoreDebug->DEMCR & CoreDebug_DEMCR_TRCENA_Msk) || !(DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk))
+  {
+    sim_cyccnt_running = 0;
+    return;
+  }
+  if (!sim_cyccnt_running)
+  {
+    sim_cyccnt_running = 1;
+    sim_cyccnt_written = DWT->CYCCNT;
+    sim_cyccnt_base = now - sim_cyccnt_written;
+  }
+  expect = sim_cyccnt_written;
+  value = (uint32_t)(now - sim_cyccnt_base);
+  if (__atomic_compare_exchange_n((uint32_t *)&DWT->CYCCNT, &expect, value, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+  {
+    sim_cyccnt_written = value;
+  }
+  else
+  {
+    /* 固件改写了 CYCCNT，从写入值继续计数 */
+    sim_cyccnt_base = now - expect;
+    sim_cyccnt_written = expect;
+  }
+}
+
+static void sim_core_poll_systick(uint64_t now)
+{
+  uint32_t ctrl = SysTick->CTRL & (SysTick_CTRL_ENABLE_Msk | SysTick_CTRL_TICKINT_Msk | SysTick_CTRL_CLKSOURCE_Msk);
+  uint32_t load = SysTick->LOAD & SysTick_LOAD_RELOAD_Msk;
+  uint32_t expect = sim_st_val_written;
+  uint64_t div;
+  uint64_t period;
+  uint64_t ticks;
+  uint32_t value;
+
+  if (!(ctrl & SysTick_CTRL_ENABLE_Msk))
+  {
+    sim_st_ctrl = ctrl;
+    return;
+  }
+  if (!(sim_st_ctrl & SysTick_CTRL_ENABLE_Msk) || load != sim_st_load ||
+      SysTick->VAL != expect)
+  {
+    /* 刚使能、改了重装值或固件写了 VAL：重新开始一个周期 */
+    sim_st_base = now;
+    sim_st_ticks = 0;
+    expect = SysTick->VAL;
+  }
+  sim_st_ctrl = ctrl;
+  sim_st_load = load;
+  if (load == 0U)
+  {
+    return;
+  }
+  div = (ctrl & SysTick_CTRL_CLKSOURCE_Msk) ? 1U : 8U;
+  period = ((uint64_t)load + 1U) * div;
+  ticks = (now - sim_st_base) / period;
+  if (ticks > sim_st_ticks)
+  {
+    SysTick->CTRL |= SysTick_CTRL_COUNTFLAG_Msk;
+    if (ctrl & SysTick_CTRL_TICKINT_Msk)
+    {
+      for (uint64_t i = sim_st_ticks; i < ticks; i++)
+      {
+        sim_irq_pend(SysTick_IRQn);
+      }
+    }
+    sim_st_ticks = ticks;
+  }
+  value = load - (uint32_t)(((now - sim_st_base) % period) / div);
+  if (__atomic_compare_exchange_n((uint32_t *)&SysTick->VAL, &expect, value, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+  {
+    sim_st_val_written = value;
+  }
+  else
+  {
+    sim_st_val_written = expect;
+  }
+}
+
+void sim_core_poll(uint64_t now)
+{
+  sim_core_poll_dwt(now);
+  sim_core_poll_systick(now);
+}
+
+/******************************* 内核线程 *************************************/
+/* 收 SIGINT/SIGTERM；固件占着 CPU 却一直没推进时钟（在空循环里等标志）就让它推进一步。
+ * 看的是固件线程的 CPU 时间，主机把它调度走、--realtime 睡着都不算空转 */
+static void *sim_kernel_main(void *arg)
+{
+  sigset_t stop_set;
+  clockid_t fw_clock;
+  uint64_t last_progress = 0;
+  uint64_t last_cpu = 0;
+
+  (void)arg;
+  prctl(PR_SET_NAME, "sim-kernel");
+  prctl(PR_SET_TIMERSLACK, 1UL);
+  sigemptyset(&stop_set);
+  sigaddset(&stop_set, SIGINT);
+  sigaddset(&stop_set, SIGTERM);
+  if (pthread_getcpuclockid(sim_fw_thread, &fw_clock) != 0)
+  {
+    fprintf(stderr, "sim: cannot read firmware thread cpu time\n");
+    exit(1);
+  }
+  for (;;)
+  {
+    struct timespec ts = { 0, (long)SIM_STALL_CHECK_US * 1000L };
+    int sig = sigtimedwait(&stop_set, NULL, &ts);
+    uint64_t progress = sim_progress;
+    uint64_t cpu;
+
+    if (sig == SIGINT || sig == SIGTERM)
+    {
+      sim_exit(0);
+    }
+    clock_gettime(fw_clock, &ts);
+    cpu = (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+    if (progress != last_progress)
+    {
+      last_progress = progress;
+      last_cpu = cpu;
+    }
+    else if (cpu - last_cpu >= SIM_STALL_CPU_US * 1000ULL)
+    {
+      last_cpu = cpu;
+      sim_stall_seen = progress;
+      pthread_kill(sim_fw_thread, SIM_STEP_SIGNAL);
+    }
+  }
+  return NULL;
+}
+
+void sim_core_init(void)
+{
+  pthread_mutexattr_t attr;
+  struct sigaction sa;
+  sigset_t set;
+
+  clock_gettime(CLOCK_MONOTONIC, &sim_t0);
+  sim_pace_cycles_per_ns = (double)SIM_CORE_CLOCK_HZ / 1e9 * sim_opt.time_scale;
+  sim_tick_cycles = SIM_US(sim_opt.tick_us);
+  sim_next_tick = sim_tick_cycles;
+  sim_rng_state = sim_opt.seed ? sim_opt.seed : 1U;
+
+  pthread_mutexattr_init(&attr);
+  pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+  pthread_mutex_init(&sim_mutex, &attr);
+  pthread_mutexattr_destroy(&attr);
+
+  sim_core_map();
+  for (int idx = 0; idx < SIM_IRQ_COUNT; idx++)
+  {
+    sim_nvic_prio[idx] = 0;
+  }
+
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_sigaction = sim_irq_dispatch;
+  sa.sa_flags = SA_SIGINFO | SA_RESTART;
+  sigemptyset(&sa.sa_mask);
+  sigaction(SIM_IRQ_SIGNAL, &sa, NULL);
+
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = sim_stall_step;
+  sa.sa_flags = SA_RESTART;
+  sigemptyset(&sa.sa_mask);
+  sigaction(SIM_STEP_SIGNAL, &sa, NULL);
+
+  /* SIGINT/SIGTERM 只由内核线程收取；复位后 PRIMASK=0，中断信号对固件线程放开 */
+  sigemptyset(&set);
+  sigaddset(&set, SIGINT);
+  sigaddset(&set, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &set, NULL);
+  sigemptyset(&set);
+  sigaddset(&set, SIM_STEP_SIGNAL);
+  pthread_sigmask(SIG_UNBLOCK, &set, NULL);
+  sim_unblock_irq_signal();
+
+  sim_fw_thread = pthread_self();
+  sim_is_fw = 1;
+}
+
+void sim_core_start(void)
+{
+  sigset_t set;
+  sigset_t saved;
+
+  /* 内核线程继承的信号掩码里屏蔽 SIGUSR1/SIGUSR2，只让固件线程处理 */
+  sigemptyset(&set);
+  sigaddset(&set, SIM_IRQ_SIGNAL);
+  sigaddset(&set, SIM_STEP_SIGNAL);
+  pthread_sigmask(SIG_BLOCK, &set, &saved);
+  if (pthread_create(&sim_kernel_thread, NULL, sim_kernel_main, NULL) != 0)
+  {
+    fprintf(stderr, "sim: cannot start kernel thread\n");
+    exit(1);
+  }
+  pthread_sigmask(SIG_SETMASK, &saved, NULL);
+}
+
+void sim_exit(int code)
+{
+  static pthread_mutex_t exit_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+  pthread_mutex_lock(&exit_mutex);
+  sim_lock();
+  sim_report_write();
+  if (code == 0 && strcmp(sim_prof_current_function(), "Error_Handler") == 0)
+  {
+    fprintf(stderr, "sim: firmware is stuck in Error_Handler\n");
+    code = 2;
+  }
+  fflush(NULL);
+  _exit(code);
+}
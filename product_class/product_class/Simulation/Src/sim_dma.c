@@ -0,0 +1,294 @@
+/**
+ ******************************************************************************
+ * @file    sim_dma.c
+ * @brief   仿真 DMA1 与 HAL_DMA 接口
+ ******************************************************************************
+ * @attention
+ *
+ * 通道本身不主动搬运数据：外设模型在产生 DMA 请求时调用
+ * sim_dma_request_read()/sim_dma_request_write()，每次搬一个字节，
+ * 并按 CNDTR 更新半传输/传输完成标志，循环模式自动重装。
+ *
+ ******************************************************************************
+ */
+#include <string.h>
+#include "sim.h"
+
+#define DMA_CCR_DIR     0x00000010U
+#define DMA_ISR_GIF1    0x00000001U
+#define DMA_ISR_TCIF1   0x00000002U
+#define DMA_ISR_HTIF1   0x00000004U
+#define DMA_ISR_TEIF1   0x00000008U
+
+sim_dma_chan_t sim_dma_chan[SIM_DMA_CHANNELS];
+
+int sim_dma_index(DMA_Channel_TypeDef *ch)
+{
+  return (int)(ch - &sim_DMA1_Channel[0]);
+}
+
+/* 调用者持锁 */
+static void sim_dma_set_flags(int idx, uint32_t flags)
+{
+  DMA1->ISR |= (flags | DMA_ISR_GIF1) << (idx * 4);
+}
+
+static void sim_dma_clear_flags(int idx, uint32_t flags)
+{
+  DMA1->ISR &= ~(flags << (idx * 4));
+  if ((DMA1->ISR & ((DMA_ISR_TCIF1 | DMA_ISR_HTIF1 | DMA_ISR_TEIF1) << (idx * 4))) == 0U)
+  {
+    DMA1->ISR &= ~(DMA_ISR_GIF1 << (idx * 4));
+  }
+}
+
+static int sim_dma_ready(int idx, int to_periph)
+{
+  DMA_Channel_TypeDef *ch = &sim_DMA1_Channel[idx];
+
+  return (ch->CCR & DMA_CCR_EN) && ch->CNDTR != 0U && sim_dma_chan[idx].mem != NULL &&
+         (((ch->CCR & DMA_CCR_DIR) != 0U) == (to_periph != 0));
+}
+
+/* 传输一个字节后更新计数与标志 */
+static void sim_dma_count(int idx)
+{
+  DMA_Channel_TypeDef *ch = &sim_DMA1_Channel[idx];
+  sim_dma_chan_t *c = &sim_dma_chan[idx];
+
+  ch->CNDTR--;
+  c->bytes++;
+  if (ch->CNDTR == (uint32_t)(c->size - c->size / 2U))
+  {
+    sim_dma_set_flags(idx, DMA_ISR_HTIF1);
+  }
+  if (ch->CNDTR == 0U)
+  {
+    sim_dma_set_flags(idx, DMA_ISR_TCIF1);
+    if (ch->CCR & DMA_CCR_CIRC)
+    {
+      ch->CNDTR = c->size;
+    }
+  }
+}
+
+int sim_dma_request_read(int idx, uint8_t *data)
+{
+  DMA_Channel_TypeDef *ch = &sim_DMA1_Channel[idx];
+  sim_dma_chan_t *c = &sim_dma_chan[idx];
+
+  if (!sim_dma_ready(idx, 1))
+  {
+    return 0;
+  }
+  *data = c->mem[(ch->CCR & DMA_MINC_ENABLE) ? (uint32_t)c->size - ch->CNDTR : 0U];
+  sim_dma_count(idx);
+  return 1;
+}
+
+int sim_dma_request_write(int idx, uint8_t data)
+{
+  DMA_Channel_TypeDef *ch = &sim_DMA1_Channel[idx];
+  sim_dma_chan_t *c = &sim_dma_chan[idx];
+
+  if (!sim_dma_ready(idx, 0))
+  {
+    return 0;
+  }
+  c->mem[(ch->CCR & DMA_MINC_ENABLE) ? (uint32_t)c->size - ch->CNDTR : 0U] = data;
+  sim_dma_count(idx);
+  return 1;
+}
+
+/******************************* HAL_DMA **************************************/
+HAL_StatusTypeDef HAL_DMA_Init(DMA_HandleTypeDef *hdma)
+{
+  int idx;
+
+  if (hdma == NULL)
+  {
+    return HAL_ERROR;
+  }
+  idx = sim_dma_index(hdma->Instance);
+  hdma->ChannelIndex = (uint32_t)idx * 4U;
+  hdma->DmaBaseAddress = DMA1;
+  hdma->State = HAL_DMA_STATE_BUSY;
+  sim_lock();
+  hdma->Instance->CCR = hdma->Init.Direction | hdma->Init.PeriphInc | hdma->Init.MemInc |
+                        hdma->Init.PeriphDataAlignment | hdma->Init.MemDataAlignment |
+                        hdma->Init.Mode | hdma->Init.Priority;
+  sim_unlock();
+  hdma->ErrorCode = HAL_DMA_ERROR_NONE;
+  hdma->State = HAL_DMA_STATE_READY;
+  hdma->Lock = HAL_UNLOCKED;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_DMA_DeInit(DMA_HandleTypeDef *hdma)
+{
+  int idx;
+
+  if (hdma == NULL)
+  {
+    return HAL_ERROR;
+  }
+  idx = sim_dma_index(hdma->Instance);
+  sim_lock();
+  hdma->Instance->CCR = 0U;
+  hdma->Instance->CNDTR = 0U;
+  sim_dma_clear_flags(idx, DMA_ISR_GIF1 | DMA_ISR_TCIF1 | DMA_ISR_HTIF1 | DMA_ISR_TEIF1);
+  sim_dma_chan[idx].mem = NULL;
+  sim_unlock();
+  hdma->XferCpltCallback = NULL;
+  hdma->XferHalfCpltCallback = NULL;
+  hdma->XferErrorCallback = NULL;
+  hdma->XferAbortCallback = NULL;
+  hdma->ErrorCode = HAL_DMA_ERROR_NONE;
+  hdma->State = HAL_DMA_STATE_RESET;
+  hdma->Lock = HAL_UNLOCKED;
+  return HAL_OK;
+}
+
+/* 相当于 HAL_DMA_Start_IT()，只是存储器地址用主机指针传入 */
+void sim_dma_start(DMA_HandleTypeDef *hdma, uint8_t *mem, uint16_t size)
+{
+  int idx = sim_dma_index(hdma->Instance);
+
+  hdma->State = HAL_DMA_STATE_BUSY;
+  hdma->ErrorCode = HAL_DMA_ERROR_NONE;
+  sim_lock();
+  hdma->Instance->CCR &= ~DMA_CCR_EN;
+  sim_dma_clear_flags(idx, DMA_ISR_GIF1 | DMA_ISR_TCIF1 | DMA_ISR_HTIF1 | DMA_ISR_TEIF1);
+  hdma->Instance->CNDTR = size;
+  hdma->Instance->CMAR = (uint32_t)(uintptr_t)mem;
+  sim_dma_chan[idx].mem = mem;
+  sim_dma_chan[idx].size = size;
+  if (hdma->XferHalfCpltCallback != NULL)
+  {
+    hdma->Instance->CCR |= DMA_IT_TC | DMA_IT_HT | DMA_IT_TE;
+  }
+  else
+  {
+    hdma->Instance->CCR = (hdma->Instance->CCR & ~DMA_IT_HT) | DMA_IT_TC | DMA_IT_TE;
+  }
+  hdma->Instance->CCR |= DMA_CCR_EN;
+  sim_unlock();
+}
+
+HAL_StatusTypeDef HAL_DMA_Abort(DMA_HandleTypeDef *hdma)
+{
+  int idx = sim_dma_index(hdma->Instance);
+
+  if (hdma->State != HAL_DMA_STATE_BUSY)
+  {
+    hdma->ErrorCode = 0x00000004U;  /* HAL_DMA_ERROR_NO_XFER */
+    __HAL_UNLOCK(hdma);
+    return HAL_ERROR;
+  }
+  sim_lock();
+  hdma->Instance->CCR &= ~(DMA_IT_TC | DMA_IT_HT | DMA_IT_TE);
+  hdma->Instance->CCR &= ~DMA_CCR_EN;
+  sim_dma_clear_flags(idx, DMA_ISR_GIF1 | DMA_ISR_TCIF1 | DMA_ISR_HTIF1 | DMA_ISR_TEIF1);
+  sim_unlock();
+  hdma->State = HAL_DMA_STATE_READY;
+  __HAL_UNLOCK(hdma);
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_DMA_Abort_IT(DMA_HandleTypeDef *hdma)
+{
+  if (HAL_DMA_Abort(hdma) != HAL_OK)
+  {
+    return HAL_ERROR;
+  }
+  if (hdma->XferAbortCallback != NULL)
+  {
+    hdma->XferAbortCallback(hdma);
+  }
+  return HAL_OK;
+}
+
+void HAL_DMA_IRQHandler(DMA_HandleTypeDef *hdma)
+{
+  int idx = sim_dma_index(hdma->Instance);
+  uint32_t flag_it = DMA1->ISR >> (idx * 4);
+  uint32_t source_it = hdma->Instance->CCR;
+
+  if ((flag_it & DMA_ISR_HTIF1) && (source_it & DMA_IT_HT))
+  {
+    sim_lock();
+    if ((hdma->Instance->CCR & DMA_CCR_CIRC) == 0U)
+    {
+      hdma->Instance->CCR &= ~DMA_IT_HT;
+    }
+    sim_dma_clear_flags(idx, DMA_ISR_HTIF1);
+    sim_unlock();
+    if (hdma->XferHalfCpltCallback != NULL)
+    {
+      hdma->XferHalfCpltCallback(hdma);
+    }
+  }
+  else if ((flag_it & DMA_ISR_TCIF1) && (source_it & DMA_IT_TC))
+  {
+    sim_lock();
+    if ((hdma->Instance->CCR & DMA_CCR_CIRC) == 0U)
+    {
+      hdma->Instance->CCR &= ~(DMA_IT_TE | DMA_IT_TC);
+      hdma->State = HAL_DMA_STATE_READY;
+    }
+    sim_dma_clear_flags(idx, DMA_ISR_TCIF1);
+    sim_unlock();
+    __HAL_UNLOCK(hdma);
+    if (hdma->XferCpltCallback != NULL)
+    {
+      hdma->XferCpltCallback(hdma);
+    }
+  }
+  else if ((flag_it & DMA_ISR_TEIF1) && (source_it & DMA_IT_TE))
+  {
+    sim_lock();
+    hdma->Instance->CCR &= ~(DMA_IT_TC | DMA_IT_HT | DMA_IT_TE);
+    sim_dma_clear_flags(idx, DMA_ISR_GIF1 | DMA_ISR_TCIF1 | DMA_ISR_HTIF1 | DMA_ISR_TEIF1);
+    sim_unlock();
+    hdma->ErrorCode = HAL_DMA_ERROR_TE;
+    hdma->State = HAL_DMA_STATE_READY;
+    __HAL_UNLOCK(hdma);
+    if (hdma->XferErrorCallback != NULL)
+    {
+      hdma->XferErrorCallback(hdma);
+    }
+  }
+}
+
+HAL_DMA_StateTypeDef HAL_DMA_GetState(DMA_HandleTypeDef *hdma)
+{
+  return hdma->State;
+}
+
+static int sim_dma_level(int idx)
+{
+  uint32_t flags = (DMA1->ISR >> (idx * 4)) & (DMA_ISR_TCIF1 | DMA_ISR_HTIF1 | DMA_ISR_TEIF1);
+
+  /* ISR 的 TCIF/HTIF/TEIF 与 CCR 的 TCIE/HTIE/TEIE 位置相同 */
+  return (flags & sim_DMA1_Channel[idx].CCR) != 0U;
+}
+
+static int sim_dma1_ch1_level(void) { return sim_dma_level(0); }
+static int sim_dma1_ch2_level(void) { return sim_dma_level(1); }
+static int sim_dma1_ch3_level(void) { return sim_dma_level(2); }
+static int sim_dma1_ch4_level(void) { return sim_dma_level(3); }
+static int sim_dma1_ch5_level(void) { return sim_dma_level(4); }
+static int sim_dma1_ch6_level(void) { return sim_dma_level(5); }
+static int sim_dma1_ch7_level(void) { return sim_dma_level(6); }
+
+void sim_dma_init(void)
+{
+  memset(sim_dma_chan, 0, sizeof(sim_dma_chan));
+  sim_irq_set_level_source(DMA1_Channel1_IRQn, sim_dma1_ch1_level);
+  sim_irq_set_level_source(DMA1_Channel2_IRQn, sim_dma1_ch2_level);
+  sim_irq_set_level_source(DMA1_Channel3_IRQn, sim_dma1_ch3_level);
+  sim_irq_set_level_source(DMA1_Channel4_IRQn, sim_dma1_ch4_level);
+  sim_irq_set_level_source(DMA1_Channel5_IRQn, sim_dma1_ch5_level);
+  sim_irq_set_level_source(DMA1_Channel6_IRQn, sim_dma1_ch6_level);
+  sim_irq_set_level_source(DMA1_Channel7_IRQn, sim_dma1_ch7_level);
+}
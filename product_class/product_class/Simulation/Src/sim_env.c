@@ -0,0 +1,509 @@
+/**
+ ******************************************************************************
+ * @file    sim_env.c
+ * @brief   仿真外部环境：CS100A 超声波模块、DHT11、SG90 舵机与桶内温湿度
+ ******************************************************************************
+ * @attention
+ *
+ * 超声波：TRIG(PA15) 下降沿后约 220us 拉高 ECHO(PB3)，高电平宽度为
+ * 声波往返时间 2d/c，c = 331.3 + 0.606T m/s 按桶内温度算，超出量程时输出 38ms。ECHO 边沿按发生时刻送给
+ * TIM2 的 TI2 和 GPIO（EXTI）。
+ *
+ * DHT11：主机拉低 >=18ms 后释放总线，20us 后从机应答 80us 低、80us 高，
+ * 然后是 40 位数据（每位 50us 低 + 26us/70us 高）和 50us 结束低电平。
+ * 每个下降沿/上升沿按标称时刻送给 GPIO（EXTI），供边沿时间戳解码。
+ * 固件用轮询读引脚、两次读之间隔得比一段电平还长时会错过整段电平；
+ * 轮询模式下没被读到过的电平段会被拉长到第一次被读到为止，保证固件不会卡死。
+ *
+ * SG90：信号线接 TIM3_CH1(PA6)，按 CCR1 算脉宽，0.5~2.5ms 对应 0~180°，
+ * 没有脉冲时电机不出力。内部是比例带加死区的位置环，电机按最大加速度
+ * 和空载转速限幅，带动挡板有惯性，大角度阶跃会过冲。电流 = 静态电流 +
+ * |驱动量| x 堵转电流，统计每次运动的到位时间（进入 ±1° 不再出来）、过冲
+ * 和平均电流。
+ *
+ * 桶内温湿度：风扇不转时比环境高 --heat / --humi-rise，风量按 1/(1+k*风量)
+ * 压低温升，一阶惯性。风量是两路 TB6612 输出的占空比之和：STBY(PA7) 为高、
+ * 方向引脚（A 路 PA4/PA5，B 路 PB13/PB14）为正转、TIM3 CH3/CH4 打开才算，
+ * 占空比低于堵转阈值时风扇转不起来。DHT11 按桶内温湿度应答。
+ *
+ ******************************************************************************
+ */
+#include <math.h>
+#include <string.h>
+#include "sim.h"
+
+#define SIM_SOUND_SPEED(t)      (331.3 + 0.606 * (t))
+#define SIM_ECHO_DELAY_US       220U
+#define SIM_ECHO_JITTER_US      30U
+#define SIM_ECHO_MAX_RANGE_M    4.5
+#define SIM_ECHO_TIMEOUT_US     38000U
+#define SIM_TRIG_MIN_US         10U
+
+#define SIM_DHT_START_LOW_US    18000U
+#define SIM_DHT_RESPONSE_US     20U
+#define SIM_DHT_PHASES          (2 + 40 * 2 + 1)
+
+#define SIM_SERVO_STEP_US       100U
+#define SIM_SERVO_VMAX          600.0    /* 空载转速 °/s（0.1s/60°） */
+#define SIM_SERVO_ACCEL         20000.0  /* 带挡板的最大角加速度 °/s^2 */
+#define SIM_SERVO_PBAND         8.0      /* 比例带：误差超过这个驱动饱和 */
+#define SIM_SERVO_DEADBAND      0.5
+#define SIM_SERVO_COAST_TAU     0.02     /* 没有脉冲时靠齿轮摩擦停下的时间常数 */
+#define SIM_SERVO_SETTLE_BAND   1.0
+#define SIM_SERVO_QUIET_MS      100U     /* 在误差带里待这么久算一次运动结束 */
+#define SIM_SERVO_IDLE_MA       8.0      /* 有脉冲：解码和驱动电路 */
+#define SIM_SERVO_SLEEP_MA      2.0      /* 没有脉冲 */
+#define SIM_SERVO_STALL_MA      650.0
+
+#define SIM_BIN_STEP_MS         10U
+#define SIM_BIN_TAU_S           30.0     /* 桶内温湿度的时间常数 */
+#define SIM_FAN_GAIN            3.0      /* 一路风扇全速时温升降到 1/(1+k) */
+#define SIM_FAN_STALL_DUTY      0.15     /* 低于这个占空比风扇转不起来 */
+
+typedef struct
+{
+  /* 超声波 */
+  int      trig_level;
+  uint64_t trig_rise_t;
+  uint64_t echo_rise_t;
+  uint64_t echo_fall_t;
+  int      echo_pending;        /* 0 空闲，1 等上升沿，2 等下降沿 */
+  int      echo_level;
+  uint32_t triggers;
+  uint32_t short_triggers;
+  uint32_t busy_triggers;
+  uint32_t echoes;
+  uint32_t timeouts;
+  double   last_distance_m;
+
+  /* DHT11 */
+  uint64_t dht_low_t;           /* 主机开始拉低的时刻 */
+  int      dht_host_level;
+  int      dht_active;
+  uint64_t dht_phase_t;         /* 当前电平段开始时刻 */
+  int      dht_phase;
+  uint8_t  dht_sampled[SIM_DHT_PHASES];
+  uint16_t dht_dur_us[SIM_DHT_PHASES];
+  int      dht_edge_phase;      /* 下一个要送出的边沿（第几段开始，PHASES 为结束） */
+  uint64_t dht_edge_t;
+  uint32_t dht_starts;
+  uint32_t dht_short_starts;
+  uint32_t dht_frames;
+  uint32_t dht_stretches;
+
+  /* SG90 */
+  uint64_t servo_t;
+  int      servo_powered;
+  double   servo_target;
+  double   servo_angle;
+  double   servo_speed;
+  int      servo_moving;
+  uint64_t servo_move_t;
+  uint64_t servo_busy_t;        /* 最后一次目标变化或者在误差带外的时刻 */
+  double   servo_from;
+  double   servo_min;
+  double   servo_max;
+  uint32_t servo_moves;
+  double   servo_settle_ms;
+  double   servo_settle_max_ms;
+  double   servo_overshoot;
+  double   servo_overshoot_max;
+  double   servo_charge;        /* mA*s */
+  double   servo_peak_ma;
+  uint64_t servo_powered_cycles;
+
+  /* 桶内温湿度 */
+  uint64_t bin_t;
+  double   bin_temp;
+  double   bin_humi;
+  double   fan_duty[2];
+  double   fan_duty_sum[2];
+  uint64_t fan_steps;
+  uint32_t fan_stalled_steps;   /* 有输出但低于堵转阈值 */
+} sim_env_t;
+
+static sim_env_t sim_env;
+
+/******************************* 超声波 ***************************************/
+void sim_env_trig_edge(int level, uint64_t t)
+{
+  if (level == sim_env.trig_level)
+  {
+    return;
+  }
+  sim_env.trig_level = level;
+  if (level)
+  {
+    sim_env.trig_rise_t = t;
+    return;
+  }
+
+  sim_env.triggers++;
+  if (t - sim_env.trig_rise_t < SIM_US(SIM_TRIG_MIN_US))
+  {
+    sim_env.short_triggers++;
+  }
+  if (sim_env.echo_pending)
+  {
+    /* 上一次测距还没结束，模块不响应 */
+    sim_env.busy_triggers++;
+    return;
+  }
+
+  double d = sim_opt.distance_m + sim_opt.distance_noise_m * sim_rand_gauss();
+  uint64_t width;
+
+  if (d <= 0.0 || d >= SIM_ECHO_MAX_RANGE_M)
+  {
+    width = SIM_US(SIM_ECHO_TIMEOUT_US);
+    sim_env.timeouts++;
+  }
+  else
+  {
+    width = (uint64_t)(2.0 * d / SIM_SOUND_SPEED(sim_env.bin_temp) * SIM_CORE_CLOCK_HZ);
+  }
+  sim_env.last_distance_m = d;
+  sim_env.echo_rise_t = t + SIM_US(SIM_ECHO_DELAY_US) + SIM_US(sim_rand() % SIM_ECHO_JITTER_US);
+  sim_env.echo_fall_t = sim_env.echo_rise_t + width;
+  sim_env.echo_pending = 1;
+}
+
+int sim_env_echo_level(uint64_t t)
+{
+  if (sim_env.echo_pending == 0)
+  {
+    return sim_env.echo_level;
+  }
+  return t >= sim_env.echo_rise_t && t < sim_env.echo_fall_t;
+}
+
+static void sim_env_echo_edge(int level, uint64_t t)
+{
+  sim_env.echo_level = level;
+  sim_tim_input_edge(TIM2, 2, level, t);
+  sim_gpio_input_edge(GPIOB, GPIO_PIN_3, level, t);
+}
+
+/******************************* DHT11 ****************************************/
+static void sim_env_dht_frame(void)
+{
+  double h = sim_env.bin_humi + 0.5, t = sim_env.bin_temp + 0.05;
+  uint8_t humi = (uint8_t)(h < 0.0 ? 0.0 : h > 99.0 ? 99.0 : h);
+  uint8_t temp = (uint8_t)(t < 0.0 ? 0.0 : t > 50.0 ? 50.0 : t);
+  uint8_t deci = (uint8_t)(t < 0.0 || t > 50.0 ? 0.0 : (t - temp) * 10.0);   /* 温度有一位小数，湿度没有 */
+  uint8_t data[5] = { humi, 0, temp, deci, (uint8_t)(humi + temp + deci) };
+  int p = 0;
+
+  sim_env.dht_dur_us[p++] = 80;
+  sim_env.dht_dur_us[p++] = 80;
+  for (int i = 0; i < 40; i++)
+  {
+    sim_env.dht_dur_us[p++] = 50;
+    sim_env.dht_dur_us[p++] = ((data[i / 8] >> (7 - i % 8)) & 1U) ? 70 : 26;
+  }
+  sim_env.dht_dur_us[p++] = 50;
+}
+
+void sim_env_dht_host_drive(int level, uint64_t t)
+{
+  if (level == sim_env.dht_host_level)
+  {
+    return;
+  }
+  sim_env.dht_host_level = level;
+  if (level == 0)
+  {
+    /* 主机拉低会打断正在进行的传输 */
+    sim_env.dht_low_t = t;
+    sim_env.dht_active = 0;
+    return;
+  }
+  if (t - sim_env.dht_low_t < SIM_US(SIM_DHT_START_LOW_US))
+  {
+    sim_env.dht_short_starts++;
+    return;
+  }
+  sim_env_dht_frame();
+  memset(sim_env.dht_sampled, 0, sizeof(sim_env.dht_sampled));
+  sim_env.dht_phase = 0;
+  sim_env.dht_phase_t = t + SIM_US(SIM_DHT_RESPONSE_US);
+  sim_env.dht_edge_phase = 0;
+  sim_env.dht_edge_t = sim_env.dht_phase_t;
+  sim_env.dht_active = 1;
+  sim_env.dht_starts++;
+}
+
+/* 偶数段为低电平，奇数段为高电平 */
+int sim_env_dht_level(uint64_t t, int polled)
+{
+  int phase = sim_env.dht_phase;
+  uint64_t start = sim_env.dht_phase_t;
+
+  if (!sim_env.dht_active || t < start)
+  {
+    return 1;
+  }
+  while (phase < SIM_DHT_PHASES && t >= start + SIM_US(sim_env.dht_dur_us[phase]))
+  {
+    if (polled && !sim_env.dht_sampled[phase])
+    {
+      sim_env.dht_stretches++;
+      break;
+    }
+    start += SIM_US(sim_env.dht_dur_us[phase]);
+    phase++;
+  }
+  if (phase >= SIM_DHT_PHASES)
+  {
+    return 1;
+  }
+  if (polled)
+  {
+    if (t >= start + SIM_US(sim_env.dht_dur_us[phase]))
+    {
+      /* 被拉长的段从现在重新计时 */
+      start = t;
+    }
+    if (phase == SIM_DHT_PHASES - 1 && !sim_env.dht_sampled[phase])
+    {
+      sim_env.dht_frames++;
+    }
+    sim_env.dht_phase = phase;
+    sim_env.dht_phase_t = start;
+    sim_env.dht_sampled[phase] = 1;
+  }
+  return (phase & 1) != 0;
+}
+
+/******************************* SG90 *****************************************/
+/* 当前 PWM 对应的目标角度，没有有效脉冲返回 0 */
+static int sim_env_servo_pulse(double *deg)
+{
+  double us;
+
+  if ((TIM3->CR1 & TIM_CR1_CEN) == 0U || (TIM3->CCER & TIM_CCER_CC1E) == 0U || TIM3->CCR1 == 0U)
+  {
+    return 0;
+  }
+  us = (double)TIM3->CCR1 * (double)(TIM3->PSC + 1U) / (double)SIM_CYCLES_PER_US;
+  if (us < 400.0 || us > 2600.0)
+  {
+    return 0;
+  }
+  *deg = (us - 500.0) * 0.09;
+  *deg = *deg < 0.0 ? 0.0 : *deg > 180.0 ? 180.0 : *deg;
+  return 1;
+}
+
+static void sim_env_servo_step(uint64_t t, double dt)
+{
+  double deg = sim_env.servo_target, e, u = 0.0, acc, ma;
+
+  sim_env.servo_powered = sim_env_servo_pulse(&deg);
+  if (sim_env.servo_powered && fabs(deg - sim_env.servo_target) > 0.01)
+  {
+    if (!sim_env.servo_moving)
+    {
+      sim_env.servo_moving = 1;
+      sim_env.servo_move_t = t;
+      sim_env.servo_from = sim_env.servo_angle;
+      sim_env.servo_min = sim_env.servo_max = sim_env.servo_angle;
+    }
+    sim_env.servo_target = deg;
+    sim_env.servo_busy_t = t;
+  }
+
+  e = sim_env.servo_target - sim_env.servo_angle;
+  if (sim_env.servo_powered)
+  {
+    if (fabs(e) > SIM_SERVO_DEADBAND)
+    {
+      u = e / SIM_SERVO_PBAND;
+      u = u > 1.0 ? 1.0 : u < -1.0 ? -1.0 : u;
+    }
+    acc = SIM_SERVO_ACCEL * (u - sim_env.servo_speed / SIM_SERVO_VMAX);
+    ma = SIM_SERVO_IDLE_MA + fabs(u) * SIM_SERVO_STALL_MA;
+    sim_env.servo_powered_cycles += SIM_US(SIM_SERVO_STEP_US);
+  }
+  else
+  {
+    acc = -sim_env.servo_speed / SIM_SERVO_COAST_TAU;
+    ma = SIM_SERVO_SLEEP_MA;
+  }
+  sim_env.servo_speed += acc * dt;
+  sim_env.servo_angle += sim_env.servo_speed * dt;
+  if (sim_env.servo_angle < 0.0 || sim_env.servo_angle > 180.0)
+  {
+    sim_env.servo_angle = sim_env.servo_angle < 0.0 ? 0.0 : 180.0;   /* 机械限位 */
+    sim_env.servo_speed = 0.0;
+  }
+  sim_env.servo_charge += ma * dt;
+  if (ma > sim_env.servo_peak_ma)
+  {
+    sim_env.servo_peak_ma = ma;
+  }
+
+  if (!sim_env.servo_moving)
+  {
+    return;
+  }
+  if (sim_env.servo_angle < sim_env.servo_min) sim_env.servo_min = sim_env.servo_angle;
+  if (sim_env.servo_angle > sim_env.servo_max) sim_env.servo_max = sim_env.servo_angle;
+  if (fabs(sim_env.servo_target - sim_env.servo_angle) > SIM_SERVO_SETTLE_BAND)
+  {
+    sim_env.servo_busy_t = t;
+  }
+  else if (t - sim_env.servo_busy_t >= SIM_MS(SIM_SERVO_QUIET_MS))
+  {
+    /* 运动结束：到位时间从第一次改目标算起，过冲按运动方向算 */
+    sim_env.servo_moving = 0;
+    sim_env.servo_moves++;
+    sim_env.servo_settle_ms = (double)(sim_env.servo_busy_t - sim_env.servo_move_t) / SIM_CYCLES_PER_US / 1000.0;
+    sim_env.servo_overshoot = sim_env.servo_target >= sim_env.servo_from ?
+                              sim_env.servo_max - sim_env.servo_target : sim_env.servo_target - sim_env.servo_min;
+    if (sim_env.servo_overshoot < 0.0)
+    {
+      sim_env.servo_overshoot = 0.0;
+    }
+    if (sim_env.servo_settle_ms > sim_env.servo_settle_max_ms)
+    {
+      sim_env.servo_settle_max_ms = sim_env.servo_settle_ms;
+    }
+    if (sim_env.servo_overshoot > sim_env.servo_overshoot_max)
+    {
+      sim_env.servo_overshoot_max = sim_env.servo_overshoot;
+    }
+  }
+}
+
+/* 按固定步长积分到 now */
+static void sim_env_servo_poll(uint64_t now)
+{
+  while (now >= sim_env.servo_t + SIM_US(SIM_SERVO_STEP_US))
+  {
+    sim_env.servo_t += SIM_US(SIM_SERVO_STEP_US);
+    sim_env_servo_step(sim_env.servo_t, SIM_SERVO_STEP_US * 1e-6);
+  }
+}
+
+/******************************* 桶内温湿度 ***********************************/
+/* 一路风扇的占空比，没有在正转或者 PWM 没开返回 0 */
+static double sim_env_fan_duty(GPIO_TypeDef *port, uint16_t in1, uint16_t in2, uint32_t cc_enable,
+                               volatile uint32_t *ccr)
+{
+  if ((GPIOA->ODR & GPIO_PIN_7) == 0U || (port->ODR & in1) != 0U || (port->ODR & in2) == 0U ||
+      (TIM3->CR1 & TIM_CR1_CEN) == 0U || (TIM3->CCER & cc_enable) == 0U)
+  {
+    return 0.0;
+  }
+  return (double)*ccr / ((double)TIM3->ARR + 1.0);
+}
+
+static void sim_env_bin_poll(uint64_t now)
+{
+  const double dt = SIM_BIN_STEP_MS * 1e-3;
+
+  while (now >= sim_env.bin_t + SIM_MS(SIM_BIN_STEP_MS))
+  {
+    double flow = 0.0, k;
+
+    sim_env.bin_t += SIM_MS(SIM_BIN_STEP_MS);
+    sim_env.fan_duty[0] = sim_env_fan_duty(GPIOA, GPIO_PIN_4, GPIO_PIN_5, TIM_CCER_CC3E, &TIM3->CCR3);
+    sim_env.fan_duty[1] = sim_env_fan_duty(GPIOB, GPIO_PIN_13, GPIO_PIN_14, TIM_CCER_CC4E, &TIM3->CCR4);
+    for (int i = 0; i < 2; i++)
+    {
+      sim_env.fan_duty_sum[i] += sim_env.fan_duty[i];
+      if (sim_env.fan_duty[i] >= SIM_FAN_STALL_DUTY)
+      {
+        flow += sim_env.fan_duty[i];
+      }
+      else if (sim_env.fan_duty[i] > 0.0)
+      {
+        sim_env.fan_stalled_steps++;
+      }
+    }
+    sim_env.fan_steps++;
+    k = 1.0 / (1.0 + SIM_FAN_GAIN * flow);
+    sim_env.bin_temp += (sim_opt.temp_c + sim_opt.heat_c * k - sim_env.bin_temp) * dt / SIM_BIN_TAU_S;
+    sim_env.bin_humi += (sim_opt.humi_pct + sim_opt.humi_rise_pct * k - sim_env.bin_humi) * dt / SIM_BIN_TAU_S;
+  }
+}
+
+/******************************* 仿真内核 *************************************/
+void sim_env_init(void)
+{
+  memset(&sim_env, 0, sizeof(sim_env));
+  sim_env.dht_host_level = 1;
+  sim_env.servo_angle = 90.0;    /* 上电时挡板停在哪里不确定 */
+  sim_env.servo_target = 90.0;
+  sim_env.bin_temp = sim_opt.temp_c + sim_opt.heat_c;     /* 上电时风扇已经停了很久 */
+  sim_env.bin_humi = sim_opt.humi_pct + sim_opt.humi_rise_pct;
+}
+
+/* 按标称时序把到期的 DHT11 边沿送出去，不受轮询拉长的影响 */
+static void sim_env_dht_poll(uint64_t now)
+{
+  while (sim_env.dht_active && sim_env.dht_edge_phase <= SIM_DHT_PHASES && now >= sim_env.dht_edge_t)
+  {
+    int phase = sim_env.dht_edge_phase++;
+
+    if (phase == SIM_DHT_PHASES)
+    {
+      /* 结束低电平后释放总线 */
+      if (!sim_env.dht_sampled[phase - 1])
+      {
+        sim_env.dht_sampled[phase - 1] = 1;
+        sim_env.dht_frames++;
+      }
+      sim_gpio_input_edge(GPIOB, GPIO_PIN_12, 1, sim_env.dht_edge_t);
+      break;
+    }
+    sim_gpio_input_edge(GPIOB, GPIO_PIN_12, phase & 1, sim_env.dht_edge_t);
+    sim_env.dht_edge_t += SIM_US(sim_env.dht_dur_us[phase]);
+  }
+}
+
+/* 把到期的 ECHO、DHT11 边沿送出去，调用者持锁 */
+void sim_env_poll(uint64_t now)
+{
+  sim_env_dht_poll(now);
+  sim_env_servo_poll(now);
+  sim_env_bin_poll(now);
+  if (sim_env.echo_pending == 1 && now >= sim_env.echo_rise_t)
+  {
+    sim_env.echo_pending = 2;
+    sim_env_echo_edge(1, sim_env.echo_rise_t);
+  }
+  if (sim_env.echo_pending == 2 && now >= sim_env.echo_fall_t)
+  {
+    sim_env.echo_pending = 0;
+    sim_env.echoes++;
+    sim_env_echo_edge(0, sim_env.echo_fall_t);
+  }
+}
+
+void sim_report_env(FILE *f)
+{
+  fprintf(f, "  \"env\": {\n");
+  fprintf(f, "    \"ultrasonic\": {\"triggers\": %u, \"short_triggers\": %u, \"busy_triggers\": %u, "
+             "\"echoes\": %u, \"timeouts\": %u, \"last_distance_m\": %.4f},\n",
+          sim_env.triggers, sim_env.short_triggers, sim_env.busy_triggers,
+          sim_env.echoes, sim_env.timeouts, sim_env.last_distance_m);
+  fprintf(f, "    \"dht11\": {\"starts\": %u, \"short_starts\": %u, \"frames\": %u, \"stretched_phases\": %u},\n",
+          sim_env.dht_starts, sim_env.dht_short_starts, sim_env.dht_frames, sim_env.dht_stretches);
+  fprintf(f, "    \"servo\": {\"angle\": %.2f, \"powered\": %d, \"moves\": %u, \"last_settle_ms\": %.1f, "
+             "\"max_settle_ms\": %.1f, \"last_overshoot_deg\": %.2f, \"max_overshoot_deg\": %.2f, "
+             "\"avg_ma\": %.2f, \"peak_ma\": %.1f, \"powered_pct\": %.1f},\n",
+          sim_env.servo_angle, sim_env.servo_powered, sim_env.servo_moves, sim_env.servo_settle_ms,
+          sim_env.servo_settle_max_ms, sim_env.servo_overshoot, sim_env.servo_overshoot_max,
+          sim_env.servo_t ? sim_env.servo_charge / ((double)sim_env.servo_t / SIM_CYCLES_PER_US * 1e-6) : 0.0,
+          sim_env.servo_peak_ma,
+          sim_env.servo_t ? 100.0 * (double)sim_env.servo_powered_cycles / (double)sim_env.servo_t : 0.0);
+  fprintf(f, "    \"bin\": {\"temp\": %.2f, \"humi\": %.2f, \"fan_duty\": [%.3f, %.3f], \"fan_avg_duty\": [%.3f, %.3f], "
+             "\"fan_stalled_ms\": %u}\n",
+          sim_env.bin_temp, sim_env.bin_humi, sim_env.fan_duty[0], sim_env.fan_duty[1],
+          sim_env.fan_steps ? sim_env.fan_duty_sum[0] / (double)sim_env.fan_steps : 0.0,
+          sim_env.fan_steps ? sim_env.fan_duty_sum[1] / (double)sim_env.fan_steps : 0.0,
+          sim_env.fan_stalled_steps * SIM_BIN_STEP_MS);
+  fprintf(f, "  },\n");
+}
@@ -0,0 +1,389 @@
+/**
+ ******************************************************************************
+ * @file    sim_gpio.c
+ * @brief   仿真 GPIO/EXTI
+ ******************************************************************************
+ * @attention
+ *
+ * 输出引脚的电平就是 ODR；输入引脚由外部模型给出电平（PB3 超声波回波、
+ * PB12 DHT11 数据线），没有模型的输入按上下拉决定。
+ * 固件直接写 BSRR/BRR 的情况在轮询时合并进 ODR。
+ *
+ ******************************************************************************
+ */
+#include <string.h>
+#include "sim.h"
+
+#define SIM_GPIO_PORTS   4
+#define GPIO_MODE_MASK   0x0000000FU
+#define GPIO_OUTPUT_TYPE 0x00000010U
+#define EXTI_MODE        0x10000000U
+#define EXTI_IT          0x00010000U
+#define EXTI_EVT         0x00020000U
+#define RISING_EDGE      0x00100000U
+#define FALLING_EDGE     0x00200000U
+
+typedef struct
+{
+  uint32_t mode[16];
+  uint32_t pull[16];
+  uint32_t edges[16];
+} sim_gpio_port_t;
+
+static sim_gpio_port_t sim_gpio[SIM_GPIO_PORTS];
+
+static int sim_gpio_index(GPIO_TypeDef *port)
+{
+  if (port == GPIOA) return 0;
+  if (port == GPIOB) return 1;
+  if (port == GPIOC) return 2;
+  if (port == GPIOD) return 3;
+  return -1;
+}
+
+static GPIO_TypeDef *sim_gpio_port(int idx)
+{
+  static GPIO_TypeDef *const ports[SIM_GPIO_PORTS] = { GPIOA, GPIOB, GPIOC, GPIOD };
+  return ports[idx];
+}
+
+static int sim_gpio_pos(uint16_t pin)
+{
+  return __builtin_ctz(pin);
+}
+
+int sim_gpio_is_output(GPIO_TypeDef *port, uint16_t pin)
+{
+  int idx = sim_gpio_index(port);
+  uint32_t mode;
+
+  if (idx < 0)
+  {
+    return 0;
+  }
+  mode = sim_gpio[idx].mode[sim_gpio_pos(pin)] & GPIO_MODE_MASK;
+  return mode == GPIO_MODE_OUTPUT_PP || mode == GPIO_MODE_AF_PP;
+}
+
+static int sim_gpio_is_open_drain(GPIO_TypeDef *port, uint16_t pin)
+{
+  int idx = sim_gpio_index(port);
+  uint32_t mode = sim_gpio[idx].mode[sim_gpio_pos(pin)];
+
+  return mode == GPIO_MODE_OUTPUT_OD || mode == GPIO_MODE_AF_OD;
+}
+
+/* 引脚上的实际电平，调用者持锁 */
+static int sim_gpio_level(GPIO_TypeDef *port, uint16_t pin, uint64_t t, int polled)
+{
+  int idx = sim_gpio_index(port);
+  int pos = sim_gpio_pos(pin);
+  int driven = (port->ODR & pin) != 0U;
+  int external = -1;
+
+  if (sim_gpio_is_output(port, pin))
+  {
+    return driven;
+  }
+  if (port == GPIOB && pin == GPIO_PIN_12)
+  {
+    external = sim_env_dht_level(t, polled);
+  }
+  else if (port == GPIOB && pin == GPIO_PIN_3)
+  {
+    external = sim_env_echo_level(t);
+  }
+  if (sim_gpio_is_open_drain(port, pin))
+  {
+    return driven && (external != 0);
+  }
+  if (external >= 0)
+  {
+    return external;
+  }
+  return sim_gpio[idx].pull[pos] == GPIO_PULLUP;
+}
+
+static void sim_gpio_refresh_idr(GPIO_TypeDef *port, uint64_t t)
+{
+  uint32_t idr = 0;
+
+  for (int pos = 0; pos < 16; pos++)
+  {
+    if (sim_gpio_level(port, (uint16_t)(1U << pos), t, 0))
+    {
+      idr |= 1UL << pos;
+    }
+  }
+  port->IDR = idr;
+}
+
+/* 输出电平变化：通知挂在这个引脚上的模型 */
+static void sim_gpio_output_changed(GPIO_TypeDef *port, uint16_t pin, int level, uint64_t t)
+{
+  sim_gpio[sim_gpio_index(port)].edges[sim_gpio_pos(pin)]++;
+  if (port == GPIOA && pin == GPIO_PIN_15)
+  {
+    /* PA15 是 TRIG，同时经部分重映射接到 TIM2_CH1(TI1) */
+    sim_env_trig_edge(level, t);
+    sim_tim_input_edge(TIM2, 1, level, t);
+  }
+  else if (port == GPIOB && pin == GPIO_PIN_12)
+  {
+    /* 开漏：主机拉低/释放时从机不驱动总线，线上电平跟着变，EXTI 也能看到 */
+    sim_env_dht_host_drive(level, t);
+    sim_gpio_input_edge(port, pin, level, t);
+  }
+}
+
+static int sim_gpio_is_af(GPIO_TypeDef *port, uint16_t pin)
+{
+  uint32_t mode = sim_gpio[sim_gpio_index(port)].mode[sim_gpio_pos(pin)];
+
+  return (mode & GPIO_MODE_MASK) == GPIO_MODE_AF_PP;
+}
+
+/* 外设（定时器输出通道）驱动复用功能引脚，调用者持锁 */
+void sim_gpio_af_output(GPIO_TypeDef *port, uint16_t pin, int level, uint64_t t)
+{
+  if (sim_gpio_index(port) >= 0 && sim_gpio_is_af(port, pin))
+  {
+    sim_gpio_output_changed(port, pin, level, t);
+  }
+}
+
+static void sim_gpio_write_odr(GPIO_TypeDef *port, uint32_t set, uint32_t reset, uint64_t t)
+{
+  uint32_t old = port->ODR;
+  uint32_t odr = (old | set) & ~reset;
+  uint32_t changed = old ^ odr;
+
+  port->ODR = odr;
+  while (changed != 0U)
+  {
+    int pos = __builtin_ctz(changed);
+    uint16_t pin = (uint16_t)(1U << pos);
+
+    changed &= changed - 1U;
+    if (!sim_gpio_is_af(port, pin))
+    {
+      sim_gpio_output_changed(port, pin, (odr & pin) != 0U, t);
+    }
+  }
+}
+
+void HAL_GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init)
+{
+  int idx = sim_gpio_index(GPIOx);
+  uint64_t t = sim_now();
+
+  if (idx < 0)
+  {
+    return;
+  }
+  sim_lock();
+  for (int pos = 0; pos < 16; pos++)
+  {
+    uint32_t line = 1UL << pos;
+
+    if ((GPIO_Init->Pin & line) == 0U)
+    {
+      continue;
+    }
+    sim_gpio[idx].mode[pos] = GPIO_Init->Mode & (GPIO_MODE_MASK | GPIO_OUTPUT_TYPE);
+    sim_gpio[idx].pull[pos] = GPIO_Init->Pull;
+    if ((GPIO_Init->Mode & GPIO_MODE_MASK) == GPIO_MODE_INPUT && GPIO_Init->Pull != GPIO_NOPULL)
+    {
+      /* F1 上拉/下拉由 ODR 选择 */
+      sim_gpio_write_odr(GPIOx, GPIO_Init->Pull == GPIO_PULLUP ? line : 0U,
+                         GPIO_Init->Pull == GPIO_PULLUP ? 0U : line, t);
+    }
+    if (GPIO_Init->Mode & EXTI_MODE)
+    {
+      uint32_t shift = 4U * (pos & 0x03U);
+
+      AFIO->EXTICR[pos >> 2U] = (AFIO->EXTICR[pos >> 2U] & ~(0x0FUL << shift)) | ((uint32_t)idx << shift);
+      EXTI->IMR  = (GPIO_Init->Mode & EXTI_IT)      ? (EXTI->IMR | line)  : (EXTI->IMR & ~line);
+      EXTI->EMR  = (GPIO_Init->Mode & EXTI_EVT)     ? (EXTI->EMR | line)  : (EXTI->EMR & ~line);
+      EXTI->RTSR = (GPIO_Init->Mode & RISING_EDGE)  ? (EXTI->RTSR | line) : (EXTI->RTSR & ~line);
+      EXTI->FTSR = (GPIO_Init->Mode & FALLING_EDGE) ? (EXTI->FTSR | line) : (EXTI->FTSR & ~line);
+    }
+  }
+  sim_gpio_refresh_idr(GPIOx, t);
+  sim_unlock();
+}
+
+void HAL_GPIO_DeInit(GPIO_TypeDef *GPIOx, uint32_t GPIO_Pin)
+{
+  int idx = sim_gpio_index(GPIOx);
+
+  if (idx < 0)
+  {
+    return;
+  }
+  sim_lock();
+  for (int pos = 0; pos < 16; pos++)
+  {
+    uint32_t line = 1UL << pos;
+
+    if ((GPIO_Pin & line) == 0U)
+    {
+      continue;
+    }
+    sim_gpio[idx].mode[pos] = GPIO_MODE_INPUT;
+    sim_gpio[idx].pull[pos] = GPIO_NOPULL;
+    if (((AFIO->EXTICR[pos >> 2U] >> (4U * (pos & 0x03U))) & 0x0FU) == (uint32_t)idx)
+    {
+      EXTI->IMR &= ~line;
+      EXTI->EMR &= ~line;
+      EXTI->RTSR &= ~line;
+      EXTI->FTSR &= ~line;
+    }
+  }
+  sim_unlock();
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+  int level;
+
+  sim_advance(SIM_HAL_CYCLES);
+  sim_lock();
+  level = sim_gpio_level(GPIOx, GPIO_Pin, sim_now(), 1);
+  if (level)
+  {
+    GPIOx->IDR |= GPIO_Pin;
+  }
+  else
+  {
+    GPIOx->IDR &= ~(uint32_t)GPIO_Pin;
+  }
+  sim_unlock();
+  return level ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState)
+{
+  sim_advance(SIM_HAL_CYCLES);
+  sim_lock();
+  if (PinState != GPIO_PIN_RESET)
+  {
+    sim_gpio_write_odr(GPIOx, GPIO_Pin, 0U, sim_now());
+  }
+  else
+  {
+    sim_gpio_write_odr(GPIOx, 0U, GPIO_Pin, sim_now());
+  }
+  sim_unlock();
+}
+
+void HAL_GPIO_TogglePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+  sim_advance(SIM_HAL_CYCLES);
+  sim_lock();
+  sim_gpio_write_odr(GPIOx, ~GPIOx->ODR & GPIO_Pin, GPIOx->ODR & GPIO_Pin, sim_now());
+  sim_unlock();
+}
+
+/******************************* EXTI *****************************************/
+void sim_gpio_input_edge(GPIO_TypeDef *port, uint16_t pin, int level, uint64_t t)
+{
+  int pos = sim_gpio_pos(pin);
+  uint32_t line = pin;
+
+  (void)t;
+  if (((AFIO->EXTICR[pos >> 2U] >> (4U * (pos & 0x03U))) & 0x0FU) != (uint32_t)sim_gpio_index(port))
+  {
+    return;
+  }
+  if ((level && (EXTI->RTSR & line)) || (!level && (EXTI->FTSR & line)))
+  {
+    EXTI->PR |= line;
+  }
+}
+
+void sim_exti_clear(uint32_t line)
+{
+  sim_lock();
+  EXTI->PR &= ~line;
+  sim_unlock();
+}
+
+void HAL_GPIO_EXTI_IRQHandler(uint16_t GPIO_Pin)
+{
+  if (EXTI->PR & GPIO_Pin)
+  {
+    sim_exti_clear(GPIO_Pin);
+    HAL_GPIO_EXTI_Callback(GPIO_Pin);
+  }
+}
+
+__weak void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+{
+  UNUSED(GPIO_Pin);
+}
+
+static int sim_exti_level(uint32_t lines)
+{
+  return (EXTI->PR & EXTI->IMR & lines) != 0U;
+}
+
+static int sim_exti0_level(void)     { return sim_exti_level(0x0001U); }
+static int sim_exti1_level(void)     { return sim_exti_level(0x0002U); }
+static int sim_exti2_level(void)     { return sim_exti_level(0x0004U); }
+static int sim_exti3_level(void)     { return sim_exti_level(0x0008U); }
+static int sim_exti4_level(void)     { return sim_exti_level(0x0010U); }
+static int sim_exti9_5_level(void)   { return sim_exti_level(0x03E0U); }
+static int sim_exti15_10_level(void) { return sim_exti_level(0xFC00U); }
+
+void sim_gpio_init(void)
+{
+  memset(sim_gpio, 0, sizeof(sim_gpio));
+  sim_irq_set_level_source(EXTI0_IRQn, sim_exti0_level);
+  sim_irq_set_level_source(EXTI1_IRQn, sim_exti1_level);
+  sim_irq_set_level_source(EXTI2_IRQn, sim_exti2_level);
+  sim_irq_set_level_source(EXTI3_IRQn, sim_exti3_level);
+  sim_irq_set_level_source(EXTI4_IRQn, sim_exti4_level);
+  sim_irq_set_level_source(EXTI9_5_IRQn, sim_exti9_5_level);
+  sim_irq_set_level_source(EXTI15_10_IRQn, sim_exti15_10_level);
+}
+
+void sim_gpio_poll(uint64_t now)
+{
+  for (int idx = 0; idx < SIM_GPIO_PORTS; idx++)
+  {
+    GPIO_TypeDef *port = sim_gpio_port(idx);
+    uint32_t bsrr = __atomic_exchange_n((uint32_t *)&port->BSRR, 0U, __ATOMIC_SEQ_CST);
+    uint32_t brr = __atomic_exchange_n((uint32_t *)&port->BRR, 0U, __ATOMIC_SEQ_CST);
+
+    if (bsrr != 0U || brr != 0U)
+    {
+      sim_gpio_write_odr(port, bsrr & 0xFFFFU, (bsrr >> 16U) | (brr & 0xFFFFU), now);
+    }
+    sim_gpio_refresh_idr(port, now);
+  }
+}
+
+void sim_report_gpio(FILE *f)
+{
+  static const char names[SIM_GPIO_PORTS] = { 'A', 'B', 'C', 'D' };
+  int first = 1;
+
+  fprintf(f, "  \"gpio\": {");
+  for (int idx = 0; idx < SIM_GPIO_PORTS; idx++)
+  {
+    GPIO_TypeDef *port = sim_gpio_port(idx);
+
+    for (int pos = 0; pos < 16; pos++)
+    {
+      if (sim_gpio[idx].edges[pos] == 0U)
+      {
+        continue;
+      }
+      fprintf(f, "%s\n    \"P%c%d\": {\"level\": %u, \"edges\": %u}", first ? "" : ",",
+              names[idx], pos, (unsigned)((port->ODR >> pos) & 1U), sim_gpio[idx].edges[pos]);
+      first = 0;
+    }
+  }
+  fprintf(f, "\n  },\n");
+}
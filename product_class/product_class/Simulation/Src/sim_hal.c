@@ -0,0 +1,223 @@
+/**
+ ******************************************************************************
+ * @file    sim_hal.c
+ * @brief   仿真 HAL：外设实例、HAL 核心、Cortex、RCC
+ ******************************************************************************
+ * @attention
+ *
+ * 时钟树按 SystemClock_Config() 配好后的状态处理：SYSCLK/HCLK 72MHz，
+ * PCLK1 36MHz，PCLK2 72MHz，RCC 配置函数只做参数返回。
+ *
+ ******************************************************************************
+ */
+#include <string.h>
+#include "sim.h"
+
+/******************************* 外设实例 *************************************/
+GPIO_TypeDef        sim_GPIOA, sim_GPIOB, sim_GPIOC, sim_GPIOD;
+TIM_TypeDef         sim_TIM2, sim_TIM3;
+USART_TypeDef       sim_USART1;
+I2C_TypeDef         sim_I2C2;
+DMA_TypeDef         sim_DMA1;
+DMA_Channel_TypeDef sim_DMA1_Channel[7];
+EXTI_TypeDef        sim_EXTI;
+AFIO_TypeDef        sim_AFIO;
+RCC_TypeDef         sim_RCC;
+PWR_TypeDef         sim_PWR;
+RTC_TypeDef         sim_RTC;
+BKP_TypeDef         sim_BKP;
+
+uint32_t SystemCoreClock = SIM_CORE_CLOCK_HZ;
+const uint8_t AHBPrescTable[16U] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 2, 3, 4, 6, 7, 8, 9};
+const uint8_t APBPrescTable[8U] =  {0, 0, 0, 0, 1, 2, 3, 4};
+
+void SystemInit(void)
+{
+}
+
+void SystemCoreClockUpdate(void)
+{
+  SystemCoreClock = SIM_CORE_CLOCK_HZ;
+}
+
+/******************************* HAL 核心 *************************************/
+__IO uint32_t uwTick;
+uint32_t uwTickPrio = (1UL << __NVIC_PRIO_BITS);
+HAL_TickFreqTypeDef uwTickFreq = HAL_TICK_FREQ_DEFAULT;
+
+HAL_StatusTypeDef HAL_Init(void)
+{
+  HAL_NVIC_SetPriorityGrouping(NVIC_PRIORITYGROUP_4);
+  HAL_InitTick(TICK_INT_PRIORITY);
+  HAL_MspInit();
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_DeInit(void)
+{
+  HAL_MspDeInit();
+  return HAL_OK;
+}
+
+__weak void HAL_MspInit(void)
+{
+}
+
+__weak void HAL_MspDeInit(void)
+{
+}
+
+__weak HAL_StatusTypeDef HAL_InitTick(uint32_t TickPriority)
+{
+  if (HAL_SYSTICK_Config(SystemCoreClock / (1000U / uwTickFreq)) > 0U)
+  {
+    return HAL_ERROR;
+  }
+  if (TickPriority < (1UL << __NVIC_PRIO_BITS))
+  {
+    HAL_NVIC_SetPriority(SysTick_IRQn, TickPriority, 0U);
+    uwTickPrio = TickPriority;
+  }
+  else
+  {
+    return HAL_ERROR;
+  }
+  return HAL_OK;
+}
+
+__weak void HAL_IncTick(void)
+{
+  uwTick += uwTickFreq;
+}
+
+__weak uint32_t HAL_GetTick(void)
+{
+  return uwTick;
+}
+
+uint32_t HAL_GetTickPrio(void)
+{
+  return uwTickPrio;
+}
+
+__weak void HAL_Delay(uint32_t Delay)
+{
+  uint32_t tickstart = HAL_GetTick();
+  uint32_t wait = Delay;
+
+  if (wait < HAL_MAX_DELAY)
+  {
+    wait += (uint32_t)(uwTickFreq);
+  }
+  while ((HAL_GetTick() - tickstart) < wait)
+  {
+  }
+}
+
+__weak void HAL_SuspendTick(void)
+{
+  SysTick->CTRL &= ~SysTick_CTRL_TICKINT_Msk;
+}
+
+__weak void HAL_ResumeTick(void)
+{
+  SysTick->CTRL |= SysTick_CTRL_TICKINT_Msk;
+}
+
+uint32_t HAL_GetUIDw0(void)
+{
+  return 0x0032FF39U;
+}
+
+uint32_t HAL_GetUIDw1(void)
+{
+  return 0x3830500BU;
+}
+
+uint32_t HAL_GetUIDw2(void)
+{
+  return 0x51631452U;
+}
+
+/******************************* SysTick **************************************/
+uint32_t HAL_SYSTICK_Config(uint32_t TicksNumb)
+{
+  if ((TicksNumb - 1UL) > SysTick_LOAD_RELOAD_Msk)
+  {
+    return 1UL;
+  }
+  SysTick->LOAD = (uint32_t)(TicksNumb - 1UL);
+  HAL_NVIC_SetPriority(SysTick_IRQn, (1UL << __NVIC_PRIO_BITS) - 1UL, 0U);
+  SysTick->VAL = 0UL;
+  SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_TICKINT_Msk | SysTick_CTRL_ENABLE_Msk;
+  return 0UL;
+}
+
+void HAL_SYSTICK_CLKSourceConfig(uint32_t CLKSource)
+{
+  if (CLKSource == SYSTICK_CLKSOURCE_HCLK)
+  {
+    SysTick->CTRL |= SYSTICK_CLKSOURCE_HCLK;
+  }
+  else
+  {
+    SysTick->CTRL &= ~SYSTICK_CLKSOURCE_HCLK;
+  }
+}
+
+void HAL_SYSTICK_IRQHandler(void)
+{
+  HAL_SYSTICK_Callback();
+}
+
+__weak void HAL_SYSTICK_Callback(void)
+{
+}
+
+/******************************* RCC ******************************************/
+HAL_StatusTypeDef HAL_RCC_OscConfig(RCC_OscInitTypeDef *RCC_OscInitStruct)
+{
+  if (RCC_OscInitStruct == NULL)
+  {
+    return HAL_ERROR;
+  }
+  sim_pwr_osc_config(RCC_OscInitStruct);
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_RCC_ClockConfig(RCC_ClkInitTypeDef *RCC_ClkInitStruct, uint32_t FLatency)
+{
+  (void)FLatency;
+  if (RCC_ClkInitStruct == NULL)
+  {
+    return HAL_ERROR;
+  }
+  SystemCoreClock = SIM_CORE_CLOCK_HZ;
+  sim_pwr_clock_restored();
+  return HAL_InitTick(uwTickPrio);
+}
+
+HAL_StatusTypeDef HAL_RCCEx_PeriphCLKConfig(RCC_PeriphCLKInitTypeDef *PeriphClkInit)
+{
+  return (PeriphClkInit == NULL) ? HAL_ERROR : HAL_OK;
+}
+
+uint32_t HAL_RCC_GetSysClockFreq(void)
+{
+  return SIM_CORE_CLOCK_HZ;
+}
+
+uint32_t HAL_RCC_GetHCLKFreq(void)
+{
+  return SystemCoreClock;
+}
+
+uint32_t HAL_RCC_GetPCLK1Freq(void)
+{
+  return SystemCoreClock / 2U;
+}
+
+uint32_t HAL_RCC_GetPCLK2Freq(void)
+{
+  return SystemCoreClock;
+}
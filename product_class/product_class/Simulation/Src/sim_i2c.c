@@ -0,0 +1,664 @@
+/**
+ ******************************************************************************
+ * @file    sim_i2c.c
+ * @brief   仿真 I2C2 与 SSD1306 OLED
+ ******************************************************************************
+ * @attention
+ *
+ * 阻塞式 HAL_I2C_Mem_Write() 按总线时间忙等：每字节 9 个 SCL 周期，
+ * 外加起始/停止条件，期间照常响应中断。总线上只挂了一个 SSD1306
+ * （地址 0x78），其他地址返回 NACK；--i2c-nack-every 可以注入 NACK。
+ *
+ * HAL_I2C_Mem_Write_DMA() 发完地址和存储器地址后置 CR2 DMAEN，
+ * 轮询时按字节时间从 DMA1 通道4 取数据，取空后置 BTF 产生事件中断，
+ * 事件中断里发停止信号并调用 HAL_I2C_MemTxCpltCallback()；
+ * 地址不应答时置 AF 产生错误中断，调用 HAL_I2C_ErrorCallback()。
+ *
+ * SSD1306 模型实现页/水平/垂直三种寻址模式和常用的多字节命令，
+ * 退出时可以把显存导出成字符画（--oled-dump）。
+ *
+ ******************************************************************************
+ */
+#include <string.h>
+#include "sim.h"
+
+#define SSD1306_ADDR      0x78U
+#define SSD1306_PAGES     8
+#define SSD1306_COLS      128
+#define SIM_I2C_TX_DMA    3   /* DMA1_Channel4 */
+
+typedef struct
+{
+  uint8_t  ram[SSD1306_PAGES][SSD1306_COLS];
+  uint8_t  page;
+  uint8_t  col;
+  uint8_t  mode;            /* 0 水平，1 垂直，2 页寻址 */
+  uint8_t  col_start, col_end;
+  uint8_t  page_start, page_end;
+  uint8_t  on;
+  uint8_t  invert;
+  uint8_t  cmd[8];          /* 正在接收的多字节命令 */
+  uint8_t  cmd_len;
+  uint8_t  cmd_need;
+  uint32_t cmds;
+  uint32_t data_bytes;
+} sim_ssd1306_t;
+
+typedef struct
+{
+  uint64_t transfers;
+  uint64_t bytes;
+  uint64_t nacks;
+  uint64_t dma_transfers;
+  uint64_t bus_cycles;
+  uint64_t max_transfer_cycles;
+} sim_i2c_stats_t;
+
+/* 正在进行的 DMA 传输 */
+typedef struct
+{
+  I2C_HandleTypeDef *hi2c;      /* NULL 表示空闲 */
+  uint8_t  control;             /* 存储器地址，即 SSD1306 的控制字节 */
+  int      nack;
+  int      done;                /* 已置 BTF/AF，等中断处理 */
+  uint32_t nbytes;              /* 总线上的字节数（含地址） */
+  uint64_t start;
+  uint64_t next_t;              /* 下一个字节开始发送的时刻 */
+  uint64_t byte_cycles;
+} sim_i2c_xfer_t;
+
+static sim_ssd1306_t sim_oled;
+static sim_i2c_stats_t sim_i2c_stats;
+static sim_i2c_xfer_t sim_i2c_xfer;
+static uint32_t sim_i2c_count;   /* 地址阶段计数，用于故障注入 */
+
+/* 命令需要的参数字节数 */
+static uint8_t sim_ssd1306_args(uint8_t c)
+{
+  switch (c)
+  {
+  case 0x20: case 0x81: case 0x8D: case 0xA8: case 0xD3:
+  case 0xD5: case 0xD9: case 0xDA: case 0xDB:
+    return 1;
+  case 0x21: case 0x22: case 0xA3:
+    return 2;
+  case 0x29: case 0x2A:
+    return 5;
+  case 0x26: case 0x27:
+    return 6;
+  default:
+    return 0;
+  }
+}
+
+static void sim_ssd1306_exec(sim_ssd1306_t *d)
+{
+  uint8_t c = d->cmd[0];
+
+  d->cmds++;
+  if (c <= 0x0F)
+  {
+    d->col = (uint8_t)((d->col & 0xF0U) | c);
+  }
+  else if (c <= 0x1F)
+  {
+    d->col = (uint8_t)((d->col & 0x0FU) | ((c & 0x0FU) << 4));
+  }
+  else if (c == 0x20)
+  {
+    d->mode = d->cmd[1] & 0x03U;
+  }
+  else if (c == 0x21)
+  {
+    d->col_start = d->cmd[1] & 0x7FU;
+    d->col_end = d->cmd[2] & 0x7FU;
+    d->col = d->col_start;
+  }
+  else if (c == 0x22)
+  {
+    d->page_start = d->cmd[1] & 0x07U;
+    d->page_end = d->cmd[2] & 0x07U;
+    d->page = d->page_start;
+  }
+  else if (c >= 0xB0 && c <= 0xB7)
+  {
+    d->page = c & 0x07U;
+  }
+  else if (c == 0xAE || c == 0xAF)
+  {
+    d->on = c & 0x01U;
+  }
+  else if (c == 0xA6 || c == 0xA7)
+  {
+    d->invert = c & 0x01U;
+  }
+}
+
+static void sim_ssd1306_command(sim_ssd1306_t *d, uint8_t b)
+{
+  if (d->cmd_len == 0U)
+  {
+    d->cmd_need = sim_ssd1306_args(b);
+  }
+  d->cmd[d->cmd_len++] = b;
+  if (d->cmd_len > d->cmd_need)
+  {
+    sim_ssd1306_exec(d);
+    d->cmd_len = 0;
+  }
+}
+
+static void sim_ssd1306_data(sim_ssd1306_t *d, uint8_t b)
+{
+  d->ram[d->page & 0x07U][d->col & 0x7FU] = b;
+  d->data_bytes++;
+  if (d->mode == 2U)
+  {
+    d->col = (uint8_t)((d->col + 1U) & 0x7FU);
+  }
+  else if (d->mode == 0U)
+  {
+    if (d->col >= d->col_end)
+    {
+      d->col = d->col_start;
+      d->page = (d->page >= d->page_end) ? d->page_start : (uint8_t)(d->page + 1U);
+    }
+    else
+    {
+      d->col++;
+    }
+  }
+  else
+  {
+    if (d->page >= d->page_end)
+    {
+      d->page = d->page_start;
+      d->col = (d->col >= d->col_end) ? d->col_start : (uint8_t)(d->col + 1U);
+    }
+    else
+    {
+      d->page++;
+    }
+  }
+}
+
+/* 控制字节 Co=0 时后面全是同一类数据，这里按 Mem_Write 的用法处理 */
+static void sim_ssd1306_write(uint8_t control, const uint8_t *data, uint16_t size)
+{
+  for (uint16_t i = 0; i < size; i++)
+  {
+    if (control & 0x40U)
+    {
+      sim_ssd1306_data(&sim_oled, data[i]);
+    }
+    else
+    {
+      sim_ssd1306_command(&sim_oled, data[i]);
+    }
+  }
+}
+
+/* 传输 nbytes 个字节（含地址）的总线时间 */
+static uint64_t sim_i2c_bus_cycles(I2C_HandleTypeDef *hi2c, uint32_t nbytes)
+{
+  uint32_t speed = hi2c->Init.ClockSpeed ? hi2c->Init.ClockSpeed : 100000U;
+
+  return ((uint64_t)nbytes * 9U + 2U) * SIM_CORE_CLOCK_HZ / speed;
+}
+
+/* 调用者持锁 */
+static void sim_i2c_account_locked(uint64_t cycles, uint32_t nbytes, int nack)
+{
+  sim_i2c_stats.transfers++;
+  sim_i2c_stats.bytes += nbytes;
+  sim_i2c_stats.nacks += nack ? 1U : 0U;
+  sim_i2c_stats.bus_cycles += cycles;
+  if (cycles > sim_i2c_stats.max_transfer_cycles)
+  {
+    sim_i2c_stats.max_transfer_cycles = cycles;
+  }
+}
+
+static void sim_i2c_account(uint64_t cycles, uint32_t nbytes, int nack)
+{
+  sim_lock();
+  sim_i2c_account_locked(cycles, nbytes, nack);
+  sim_unlock();
+}
+
+/* 地址阶段从机是否应答 */
+static int sim_i2c_acked(uint16_t DevAddress)
+{
+  sim_i2c_count++;
+  if (sim_opt.i2c_nack_every != 0U && sim_i2c_count % sim_opt.i2c_nack_every == 0U)
+  {
+    return 0;
+  }
+  return (DevAddress & 0xFEU) == SSD1306_ADDR;
+}
+
+/* 发地址并等应答，NACK 时返回非零 */
+static int sim_i2c_address(I2C_HandleTypeDef *hi2c, uint16_t DevAddress)
+{
+  if (sim_i2c_acked(DevAddress))
+  {
+    return 0;
+  }
+  sim_spin_until(sim_now() + sim_i2c_bus_cycles(hi2c, 1U));
+  sim_i2c_account(sim_i2c_bus_cycles(hi2c, 1U), 1U, 1);
+  hi2c->ErrorCode |= HAL_I2C_ERROR_AF;
+  hi2c->State = HAL_I2C_STATE_READY;
+  hi2c->Mode = HAL_I2C_MODE_NONE;
+  __HAL_UNLOCK(hi2c);
+  return 1;
+}
+
+/******************************* HAL_I2C **************************************/
+HAL_StatusTypeDef HAL_I2C_Init(I2C_HandleTypeDef *hi2c)
+{
+  if (hi2c == NULL)
+  {
+    return HAL_ERROR;
+  }
+  if (hi2c->State == HAL_I2C_STATE_RESET)
+  {
+    hi2c->Lock = HAL_UNLOCKED;
+    HAL_I2C_MspInit(hi2c);
+  }
+  hi2c->State = HAL_I2C_STATE_BUSY;
+  __HAL_I2C_DISABLE(hi2c);
+  hi2c->Instance->CCR = HAL_RCC_GetPCLK1Freq() / (hi2c->Init.ClockSpeed * 2U);
+  hi2c->Instance->OAR1 = hi2c->Init.AddressingMode | hi2c->Init.OwnAddress1;
+  __HAL_I2C_ENABLE(hi2c);
+  hi2c->ErrorCode = HAL_I2C_ERROR_NONE;
+  hi2c->State = HAL_I2C_STATE_READY;
+  hi2c->PreviousState = 0U;
+  hi2c->Mode = HAL_I2C_MODE_NONE;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_DeInit(I2C_HandleTypeDef *hi2c)
+{
+  if (hi2c == NULL)
+  {
+    return HAL_ERROR;
+  }
+  hi2c->State = HAL_I2C_STATE_BUSY;
+  sim_lock();
+  if (sim_i2c_xfer.hi2c == hi2c)
+  {
+    sim_i2c_xfer.hi2c = NULL;
+  }
+  hi2c->Instance->CR2 = 0U;
+  hi2c->Instance->SR1 = 0U;
+  sim_unlock();
+  __HAL_I2C_DISABLE(hi2c);
+  HAL_I2C_MspDeInit(hi2c);
+  hi2c->ErrorCode = HAL_I2C_ERROR_NONE;
+  hi2c->State = HAL_I2C_STATE_RESET;
+  hi2c->Mode = HAL_I2C_MODE_NONE;
+  __HAL_UNLOCK(hi2c);
+  return HAL_OK;
+}
+
+__weak void HAL_I2C_MspInit(I2C_HandleTypeDef *hi2c)
+{
+  UNUSED(hi2c);
+}
+
+__weak void HAL_I2C_MspDeInit(I2C_HandleTypeDef *hi2c)
+{
+  UNUSED(hi2c);
+}
+
+HAL_StatusTypeDef HAL_I2C_Master_Transmit(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint8_t *pData, uint16_t Size, uint32_t Timeout)
+{
+  uint64_t cycles;
+
+  UNUSED(Timeout);
+  if (hi2c->State != HAL_I2C_STATE_READY)
+  {
+    return HAL_BUSY;
+  }
+  __HAL_LOCK(hi2c);
+  hi2c->State = HAL_I2C_STATE_BUSY_TX;
+  hi2c->Mode = HAL_I2C_MODE_MASTER;
+  hi2c->ErrorCode = HAL_I2C_ERROR_NONE;
+  if (sim_i2c_address(hi2c, DevAddress))
+  {
+    return HAL_ERROR;
+  }
+  cycles = sim_i2c_bus_cycles(hi2c, 1U + Size);
+  sim_spin_until(sim_now() + cycles);
+  sim_lock();
+  if (Size > 0U)
+  {
+    sim_ssd1306_write(pData[0], pData + 1, (uint16_t)(Size - 1U));
+  }
+  sim_unlock();
+  sim_i2c_account(cycles, 1U + Size, 0);
+  hi2c->State = HAL_I2C_STATE_READY;
+  hi2c->Mode = HAL_I2C_MODE_NONE;
+  __HAL_UNLOCK(hi2c);
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Write(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t *pData, uint16_t Size, uint32_t Timeout)
+{
+  uint32_t nbytes = 1U + (MemAddSize == I2C_MEMADD_SIZE_8BIT ? 1U : 2U) + Size;
+  uint64_t cycles;
+
+  UNUSED(Timeout);
+  if (hi2c->State != HAL_I2C_STATE_READY)
+  {
+    return HAL_BUSY;
+  }
+  if (pData == NULL || Size == 0U)
+  {
+    return HAL_ERROR;
+  }
+  __HAL_LOCK(hi2c);
+  hi2c->State = HAL_I2C_STATE_BUSY_TX;
+  hi2c->Mode = HAL_I2C_MODE_MEM;
+  hi2c->ErrorCode = HAL_I2C_ERROR_NONE;
+  hi2c->pBuffPtr = pData;
+  hi2c->XferCount = Size;
+  hi2c->XferSize = Size;
+  if (sim_i2c_address(hi2c, DevAddress))
+  {
+    return HAL_ERROR;
+  }
+  cycles = sim_i2c_bus_cycles(hi2c, nbytes);
+  sim_spin_until(sim_now() + cycles);
+  sim_lock();
+  sim_ssd1306_write((uint8_t)MemAddress, pData, Size);
+  sim_unlock();
+  sim_i2c_account(cycles, nbytes, 0);
+  hi2c->XferCount = 0U;
+  hi2c->State = HAL_I2C_STATE_READY;
+  hi2c->Mode = HAL_I2C_MODE_NONE;
+  __HAL_UNLOCK(hi2c);
+  return HAL_OK;
+}
+
+static void I2C_DMAXferCplt(DMA_HandleTypeDef *hdma)
+{
+  I2C_HandleTypeDef *hi2c = (I2C_HandleTypeDef *)hdma->Parent;
+
+  /* 数据都交给 I2C 了，关 DMA 请求，等 BTF */
+  sim_lock();
+  hi2c->Instance->CR2 &= ~I2C_CR2_DMAEN;
+  sim_unlock();
+}
+
+static void I2C_DMAError(DMA_HandleTypeDef *hdma)
+{
+  I2C_HandleTypeDef *hi2c = (I2C_HandleTypeDef *)hdma->Parent;
+
+  sim_lock();
+  hi2c->Instance->CR2 &= ~(I2C_CR2_DMAEN | I2C_CR2_ITEVTEN | I2C_CR2_ITERREN);
+  sim_i2c_xfer.hi2c = NULL;
+  sim_unlock();
+  hi2c->ErrorCode |= HAL_I2C_ERROR_DMA;
+  hi2c->State = HAL_I2C_STATE_READY;
+  hi2c->Mode = HAL_I2C_MODE_NONE;
+  HAL_I2C_ErrorCallback(hi2c);
+}
+
+HAL_StatusTypeDef HAL_I2C_Mem_Write_DMA(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint16_t MemAddress, uint16_t MemAddSize, uint8_t *pData, uint16_t Size)
+{
+  uint32_t speed = hi2c->Init.ClockSpeed ? hi2c->Init.ClockSpeed : 100000U;
+  uint32_t addr_bytes = 1U + (MemAddSize == I2C_MEMADD_SIZE_8BIT ? 1U : 2U);
+  sim_i2c_xfer_t *x = &sim_i2c_xfer;
+
+  if (hi2c->State != HAL_I2C_STATE_READY)
+  {
+    return HAL_BUSY;
+  }
+  if (pData == NULL || Size == 0U || hi2c->hdmatx == NULL)
+  {
+    return HAL_ERROR;
+  }
+  __HAL_LOCK(hi2c);
+  hi2c->State = HAL_I2C_STATE_BUSY_TX;
+  hi2c->Mode = HAL_I2C_MODE_MEM;
+  hi2c->ErrorCode = HAL_I2C_ERROR_NONE;
+  hi2c->pBuffPtr = pData;
+  hi2c->XferCount = Size;
+  hi2c->XferSize = Size;
+  hi2c->Devaddress = DevAddress;
+  hi2c->Memaddress = MemAddress;
+  hi2c->MemaddSize = MemAddSize;
+
+  hi2c->hdmatx->XferCpltCallback = I2C_DMAXferCplt;
+  hi2c->hdmatx->XferHalfCpltCallback = NULL;
+  hi2c->hdmatx->XferErrorCallback = I2C_DMAError;
+  hi2c->hdmatx->XferAbortCallback = NULL;
+  sim_dma_start(hi2c->hdmatx, pData, Size);
+
+  sim_lock();
+  x->hi2c = hi2c;
+  x->control = (uint8_t)MemAddress;
+  x->nack = !sim_i2c_acked(DevAddress);
+  x->done = 0;
+  x->start = sim_now();
+  x->byte_cycles = 9ULL * SIM_CORE_CLOCK_HZ / speed;
+  /* 起始条件 + 从机地址（+ 存储器地址） */
+  x->nbytes = x->nack ? 1U : addr_bytes;
+  x->next_t = x->start + (1ULL + 9ULL * x->nbytes) * SIM_CORE_CLOCK_HZ / speed;
+  hi2c->Instance->SR1 = 0U;
+  hi2c->Instance->CR2 |= I2C_CR2_ITEVTEN | I2C_CR2_ITERREN | (x->nack ? 0U : I2C_CR2_DMAEN);
+  sim_i2c_stats.dma_transfers++;
+  sim_unlock();
+  __HAL_UNLOCK(hi2c);
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2C_IsDeviceReady(I2C_HandleTypeDef *hi2c, uint16_t DevAddress, uint32_t Trials, uint32_t Timeout)
+{
+  UNUSED(Timeout);
+  if (hi2c->State != HAL_I2C_STATE_READY)
+  {
+    return HAL_BUSY;
+  }
+  for (uint32_t i = 0; i < (Trials ? Trials : 1U); i++)
+  {
+    sim_spin_until(sim_now() + sim_i2c_bus_cycles(hi2c, 1U));
+    if (sim_i2c_acked(DevAddress))
+    {
+      sim_i2c_account(sim_i2c_bus_cycles(hi2c, 1U), 1U, 0);
+      return HAL_OK;
+    }
+    sim_i2c_account(sim_i2c_bus_cycles(hi2c, 1U), 1U, 1);
+  }
+  hi2c->ErrorCode |= HAL_I2C_ERROR_AF;
+  return HAL_ERROR;
+}
+
+HAL_I2C_StateTypeDef HAL_I2C_GetState(I2C_HandleTypeDef *hi2c)
+{
+  return hi2c->State;
+}
+
+uint32_t HAL_I2C_GetError(I2C_HandleTypeDef *hi2c)
+{
+  return hi2c->ErrorCode;
+}
+
+/* 只处理 DMA 存储器写的结束：BTF 后发停止信号 */
+void HAL_I2C_EV_IRQHandler(I2C_HandleTypeDef *hi2c)
+{
+  uint32_t speed = hi2c->Init.ClockSpeed ? hi2c->Init.ClockSpeed : 100000U;
+
+  if ((hi2c->Instance->SR1 & I2C_SR1_BTF) == 0U || hi2c->State != HAL_I2C_STATE_BUSY_TX)
+  {
+    return;
+  }
+  sim_lock();
+  hi2c->Instance->SR1 &= ~(I2C_SR1_BTF | I2C_SR1_TXE);
+  hi2c->Instance->CR2 &= ~(I2C_CR2_ITEVTEN | I2C_CR2_ITERREN | I2C_CR2_ITBUFEN | I2C_CR2_DMAEN);
+  sim_i2c_account_locked(sim_now() - sim_i2c_xfer.start + SIM_CORE_CLOCK_HZ / speed, sim_i2c_xfer.nbytes, 0);
+  sim_i2c_xfer.hi2c = NULL;
+  sim_unlock();
+  hi2c->XferCount = 0U;
+  hi2c->State = HAL_I2C_STATE_READY;
+  hi2c->Mode = HAL_I2C_MODE_NONE;
+  HAL_I2C_MemTxCpltCallback(hi2c);
+}
+
+void HAL_I2C_ER_IRQHandler(I2C_HandleTypeDef *hi2c)
+{
+  uint32_t sr1 = hi2c->Instance->SR1 & (I2C_SR1_AF | I2C_SR1_BERR | I2C_SR1_ARLO);
+
+  if (sr1 == 0U)
+  {
+    return;
+  }
+  sim_lock();
+  hi2c->Instance->SR1 &= ~sr1;
+  hi2c->Instance->CR2 &= ~(I2C_CR2_ITEVTEN | I2C_CR2_ITERREN | I2C_CR2_ITBUFEN | I2C_CR2_DMAEN);
+  sim_i2c_account_locked(sim_now() - sim_i2c_xfer.start, sim_i2c_xfer.nbytes, (sr1 & I2C_SR1_AF) != 0U);
+  sim_i2c_xfer.hi2c = NULL;
+  sim_unlock();
+  hi2c->ErrorCode |= ((sr1 & I2C_SR1_AF) ? HAL_I2C_ERROR_AF : 0U) |
+                     ((sr1 & I2C_SR1_BERR) ? HAL_I2C_ERROR_BERR : 0U) |
+                     ((sr1 & I2C_SR1_ARLO) ? HAL_I2C_ERROR_ARLO : 0U);
+  if (hi2c->hdmatx != NULL && hi2c->hdmatx->State == HAL_DMA_STATE_BUSY)
+  {
+    HAL_DMA_Abort(hi2c->hdmatx);
+  }
+  hi2c->State = HAL_I2C_STATE_READY;
+  hi2c->Mode = HAL_I2C_MODE_NONE;
+  HAL_I2C_ErrorCallback(hi2c);
+}
+
+__weak void HAL_I2C_MemTxCpltCallback(I2C_HandleTypeDef *hi2c)
+{
+  UNUSED(hi2c);
+}
+
+__weak void HAL_I2C_ErrorCallback(I2C_HandleTypeDef *hi2c)
+{
+  UNUSED(hi2c);
+}
+
+/******************************* 仿真内核 *************************************/
+static int sim_i2c2_ev_level(void)
+{
+  return (I2C2->CR2 & I2C_CR2_ITEVTEN) && (I2C2->SR1 & I2C_SR1_BTF);
+}
+
+static int sim_i2c2_er_level(void)
+{
+  return (I2C2->CR2 & I2C_CR2_ITERREN) && (I2C2->SR1 & (I2C_SR1_AF | I2C_SR1_BERR | I2C_SR1_ARLO));
+}
+
+/* 推进 DMA 传输到 now，调用者持锁 */
+void sim_i2c_poll(uint64_t now)
+{
+  sim_i2c_xfer_t *x = &sim_i2c_xfer;
+  I2C_TypeDef *i2c;
+  uint8_t b;
+
+  if (x->hi2c == NULL || x->done)
+  {
+    return;
+  }
+  i2c = x->hi2c->Instance;
+  if ((i2c->CR1 & I2C_CR1_PE) == 0U)
+  {
+    /* 外设被关掉，传输中止 */
+    x->hi2c = NULL;
+    return;
+  }
+  while (now >= x->next_t)
+  {
+    if (x->nack)
+    {
+      i2c->SR1 |= I2C_SR1_AF;
+      x->done = 1;
+      break;
+    }
+    if ((i2c->CR2 & I2C_CR2_DMAEN) == 0U || !sim_dma_request_read(SIM_I2C_TX_DMA, &b))
+    {
+      /* 数据寄存器和移位寄存器都空了 */
+      i2c->SR1 |= I2C_SR1_BTF | I2C_SR1_TXE;
+      x->done = 1;
+      break;
+    }
+    sim_ssd1306_write(x->control, &b, 1U);
+    x->nbytes++;
+    x->next_t += x->byte_cycles;
+  }
+}
+
+void sim_i2c_init(void)
+{
+  sim_irq_set_level_source(I2C2_EV_IRQn, sim_i2c2_ev_level);
+  sim_irq_set_level_source(I2C2_ER_IRQn, sim_i2c2_er_level);
+  memset(&sim_oled, 0, sizeof(sim_oled));
+  sim_oled.mode = 2;
+  sim_oled.col_end = SSD1306_COLS - 1;
+  sim_oled.page_end = SSD1306_PAGES - 1;
+}
+
+static int sim_oled_pixel(int x, int y)
+{
+  return ((sim_oled.ram[y / 8][x] >> (y % 8)) & 1U) ^ sim_oled.invert;
+}
+
+void sim_i2c_dump_oled(const char *path)
+{
+  FILE *f = fopen(path, "w");
+
+  if (f == NULL)
+  {
+    fprintf(stderr, "sim: cannot write %s\n", path);
+    return;
+  }
+  fprintf(f, "+");
+  for (int x = 0; x < SSD1306_COLS; x++)
+  {
+    fputc('-', f);
+  }
+  fprintf(f, "+ display %s\n", sim_oled.on ? "on" : "off");
+  for (int y = 0; y < SSD1306_PAGES * 8; y++)
+  {
+    fputc('|', f);
+    for (int x = 0; x < SSD1306_COLS; x++)
+    {
+      fputc(sim_oled.on && sim_oled_pixel(x, y) ? '#' : ' ', f);
+    }
+    fprintf(f, "|\n");
+  }
+  fprintf(f, "+");
+  for (int x = 0; x < SSD1306_COLS; x++)
+  {
+    fputc('-', f);
+  }
+  fprintf(f, "+\n");
+  fclose(f);
+}
+
+void sim_report_i2c(FILE *f)
+{
+  uint32_t lit = 0;
+
+  for (int y = 0; y < SSD1306_PAGES * 8; y++)
+  {
+    for (int x = 0; x < SSD1306_COLS; x++)
+    {
+      lit += (uint32_t)sim_oled_pixel(x, y);
+    }
+  }
+  fprintf(f, "  \"i2c\": {\n");
+  fprintf(f, "    \"transfers\": %llu,\n", (unsigned long long)sim_i2c_stats.transfers);
+  fprintf(f, "    \"bytes\": %llu,\n", (unsigned long long)sim_i2c_stats.bytes);
+  fprintf(f, "    \"nacks\": %llu,\n", (unsigned long long)sim_i2c_stats.nacks);
+  fprintf(f, "    \"dma_transfers\": %llu,\n", (unsigned long long)sim_i2c_stats.dma_transfers);
+  fprintf(f, "    \"bus_cycles\": %llu,\n", (unsigned long long)sim_i2c_stats.bus_cycles);
+  fprintf(f, "    \"max_transfer_cycles\": %llu,\n", (unsigned long long)sim_i2c_stats.max_transfer_cycles);
+  fprintf(f, "    \"oled\": {\"on\": %u, \"commands\": %u, \"data_bytes\": %u, \"lit_pixels\": %u}\n",
+          sim_oled.on, sim_oled.cmds, sim_oled.data_bytes, lit);
+  fprintf(f, "  },\n");
+}
@@ -0,0 +1,136 @@
+/**
+ ******************************************************************************
+ * @file    sim_main.c
+ * @brief   主机仿真入口
+ ******************************************************************************
+ * @attention
+ *
+ * Core/Src/main.c 编译时 main 被重命名为 firmware_main，这里解析命令行、
+ * 初始化各个外设模型，然后在主线程上跑固件。
+ *
+ ******************************************************************************
+ */
+#include <getopt.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim.h"
+
+int firmware_main(void);
+
+static void sim_usage(const char *prog)
+{
+  fprintf(stderr,
+          "usage: %s [options]\n"
+          "  --realtime           pace virtual time to host time (implied by the pty links)\n"
+          "  --time-scale X       with --realtime, virtual time runs X times host time (default 1)\n"
+          "  --tick-us N          peripheral poll interval in virtual us (default 10)\n"
+          "  --duration-ms N      stop after N ms of virtual time\n"
+          "  --pty-link PATH      symlink the USART1 pty to PATH\n"
+          "  --usb-pty-link PATH  symlink the USB CDC pty to PATH\n"
+          "  --report PATH        write a JSON report on exit\n"
+          "  --oled-dump PATH     dump the OLED frame buffer on exit\n"
+          "  --distance M         ultrasonic target distance in metres (default 0.5)\n"
+          "  --distance-noise M   ultrasonic distance noise, std dev in metres\n"
+          "  --temp C             DHT11 temperature (default 24)\n"
+          "  --humi P             DHT11 humidity (default 55)\n"
+          "  --heat C             bin temperature rise over --temp with the fans off\n"
+          "  --humi-rise P        bin humidity rise over --humi with the fans off\n"
+          "  --i2c-nack-every N   NACK the address of every Nth I2C transfer\n"
+          "  --lsi-hz N           actual LSI frequency clocking the RTC (default 40000)\n"
+          "  --no-usb             leave the USB cable unplugged (device never enumerates)\n"
+          "  --seed N             random seed\n"
+          "  --quiet              no summary on stderr\n",
+          prog);
+}
+
+static void sim_parse_options(int argc, char **argv)
+{
+  static const struct option longopts[] =
+  {
+    { "realtime",       no_argument,       NULL, 'P' },
+    { "time-scale",     required_argument, NULL, 's' },
+    { "tick-us",        required_argument, NULL, 't' },
+    { "duration-ms",    required_argument, NULL, 'd' },
+    { "pty-link",       required_argument, NULL, 'p' },
+    { "usb-pty-link",   required_argument, NULL, 'u' },
+    { "report",         required_argument, NULL, 'r' },
+    { "oled-dump",      required_argument, NULL, 'o' },
+    { "distance",       required_argument, NULL, 'D' },
+    { "distance-noise", required_argument, NULL, 'N' },
+    { "temp",           required_argument, NULL, 'T' },
+    { "humi",           required_argument, NULL, 'H' },
+    { "heat",           required_argument, NULL, 'A' },
+    { "humi-rise",      required_argument, NULL, 'R' },
+    { "i2c-nack-every", required_argument, NULL, 'I' },
+    { "lsi-hz",         required_argument, NULL, 'L' },
+    { "no-usb",         no_argument,       NULL, 'U' },
+    { "seed",           required_argument, NULL, 'S' },
+    { "quiet",          no_argument,       NULL, 'q' },
+    { "help",           no_argument,       NULL, 'h' },
+    { NULL, 0, NULL, 0 }
+  };
+  int c;
+
+  while ((c = getopt_long(argc, argv, "qh", longopts, NULL)) != -1)
+  {
+    switch (c)
+    {
+      case 'P': sim_opt.realtime = 1; break;
+      case 's': sim_opt.time_scale = strtod(optarg, NULL); break;
+      case 't': sim_opt.tick_us = (uint32_t)strtoul(optarg, NULL, 0); break;
+      case 'd': sim_opt.duration_ms = (uint32_t)strtoul(optarg, NULL, 0); break;
+      case 'p': sim_opt.pty_link = optarg; break;
+      case 'u': sim_opt.usb_pty_link = optarg; break;
+      case 'r': sim_opt.report_path = optarg; break;
+      case 'o': sim_opt.oled_dump_path = optarg; break;
+      case 'D': sim_opt.distance_m = strtod(optarg, NULL); break;
+      case 'N': sim_opt.distance_noise_m = strtod(optarg, NULL); break;
+      case 'T': sim_opt.temp_c = atoi(optarg); break;
+      case 'H': sim_opt.humi_pct = atoi(optarg); break;
+      case 'A': sim_opt.heat_c = strtod(optarg, NULL); break;
+      case 'R': sim_opt.humi_rise_pct = strtod(optarg, NULL); break;
+      case 'I': sim_opt.i2c_nack_every = (uint32_t)strtoul(optarg, NULL, 0); break;
+      case 'L': sim_opt.lsi_hz = (uint32_t)strtoul(optarg, NULL, 0); break;
+      case 'U': sim_opt.no_usb = 1; break;
+      case 'S': sim_opt.seed = (uint32_t)strtoul(optarg, NULL, 0); break;
+      case 'q': sim_opt.quiet = 1; break;
+      case 'h': sim_usage(argv[0]); exit(0);
+      default:  sim_usage(argv[0]); exit(1);
+    }
+  }
+  if (sim_opt.time_scale <= 0.0 || sim_opt.tick_us == 0U || sim_opt.tick_us >= 1000000U)
+  {
+    fprintf(stderr, "sim: bad --time-scale or --tick-us\n");
+    exit(1);
+  }
+  if (sim_opt.lsi_hz == 0U)
+  {
+    fprintf(stderr, "sim: bad --lsi-hz\n");
+    exit(1);
+  }
+  /* 接了 PTY 就有主机上的对端，虚拟时间不能跑在它前面 */
+  if (sim_opt.pty_link != NULL || sim_opt.usb_pty_link != NULL)
+  {
+    sim_opt.realtime = 1;
+  }
+}
+
+int main(int argc, char **argv)
+{
+  sim_parse_options(argc, argv);
+
+  sim_core_init();
+  sim_gpio_init();
+  sim_tim_init();
+  sim_dma_init();
+  sim_uart_init();
+  sim_i2c_init();
+  sim_usb_init();
+  sim_env_init();
+  sim_pwr_init();
+  sim_core_start();
+
+  firmware_main();
+  sim_exit(0);
+  return 0;
+}
@@ -0,0 +1,216 @@
+/**
+ ******************************************************************************
+ * @file    sim_pwr.c
+ * @brief   仿真 PWR/RCC 时钟恢复/RTC：Stop 模式、LSI、RTC 计数器和闹钟
+ ******************************************************************************
+ * @attention
+ *
+ * RTC：RCC_BDCR 选 LSI 并使能、CSR 里 LSI 打开后按 --lsi-hz 计数，
+ * 预分频取 PRLH/PRLL。计数器越过 ALR 时置 ALRF，EXTI17 配了上升沿就挂起
+ * （RTC_Alarm_IRQn 电平源）。RTOFF 一直为 1，RSF 每次轮询置位。
+ * 固件改写 CNTH/CNTL 时以写入值为新起点继续计数。
+ *
+ * Stop：HAL_PWR_EnterSTOPMode 挂起到 EXTI 有 IMR 使能的线挂起为止，
+ * 期间 SysTick 不走（固件先 HAL_SuspendTick）、USART1 收到的字节丢掉，
+ * 时钟一直停到固件重新调用 HAL_RCC_ClockConfig；这之前的 HAL_RCC_OscConfig
+ * 按 HSE 起振和 PLL 锁定时间忙等。USB 唤醒（EXTI18）不模拟，USB 默认
+ * 一直是已枚举状态，--no-usb 时当作没插线。
+ *
+ ******************************************************************************
+ */
+#define _GNU_SOURCE
+#include <time.h>
+#include "sim.h"
+
+#define SIM_HSE_STARTUP_US   1500U     /* 8MHz 晶振起振 */
+#define SIM_PLL_LOCK_US      200U
+#define SIM_HSI_HZ           8000000U
+#define SIM_EXTI_RTC_ALARM   (1UL << 17U)
+#define SIM_EXTI_USB_WAKEUP  (1UL << 18U)
+
+typedef struct
+{
+  /* RTC */
+  int       running;
+  uint64_t  last_t;
+  double    frac;            /* 不足一个计数的周期数 */
+  uint32_t  cnt;
+  uint32_t  cnt_written;     /* 上一次写进 CNTH/CNTL 的值 */
+  uint64_t  alarms;
+
+  /* Stop */
+  volatile int clock_stopped;
+  uint64_t  stop_t;
+  uint64_t  stops;
+  uint64_t  stop_cycles;
+} sim_pwr_t;
+
+static sim_pwr_t sim_pwr;
+
+static uint32_t sim_rtc_read_cnt(void)
+{
+  return (RTC->CNTH & 0xFFFFU) << 16 | (RTC->CNTL & 0xFFFFU);
+}
+
+static void sim_rtc_write_cnt(uint32_t cnt)
+{
+  RTC->CNTH = cnt >> 16;
+  RTC->CNTL = cnt & 0xFFFFU;
+  sim_pwr.cnt_written = cnt;
+}
+
+/* 推进 RTC 到 now，调用者持锁 */
+static void sim_rtc_step(uint64_t now)
+{
+  sim_pwr_t *p = &sim_pwr;
+  uint32_t prl;
+  uint32_t alr;
+  uint32_t ticks;
+  double period;
+  int running;
+
+  RCC->CSR = (RCC->CSR & RCC_CSR_LSION) ? (RCC->CSR | RCC_CSR_LSIRDY) : (RCC->CSR & ~RCC_CSR_LSIRDY);
+  RTC->CRL |= RTC_CRL_RTOFF | RTC_CRL_RSF;
+
+  if (sim_rtc_read_cnt() != p->cnt_written)
+  {
+    /* 固件在配置模式下写了计数器 */
+    p->cnt = sim_rtc_read_cnt();
+    p->cnt_written = p->cnt;
+  }
+  running = (RCC->BDCR & RCC_BDCR_RTCEN) && (RCC->BDCR & RCC_BDCR_RTCSEL) == RCC_BDCR_RTCSEL_LSI &&
+            (RCC->CSR & RCC_CSR_LSIRDY) && !(RTC->CRL & RTC_CRL_CNF);
+  if (!running || !p->running)
+  {
+    p->running = running;
+    p->last_t = now;
+    p->frac = 0.0;
+    return;
+  }
+
+  prl = ((RTC->PRLH & 0x0FU) << 16 | (RTC->PRLL & 0xFFFFU)) + 1U;
+  period = (double)SIM_CORE_CLOCK_HZ * (double)prl / (double)sim_opt.lsi_hz;
+  p->frac += (double)(now - p->last_t);
+  p->last_t = now;
+  if (p->frac < period)
+  {
+    return;
+  }
+  ticks = (uint32_t)(p->frac / period);
+  p->frac -= (double)ticks * period;
+
+  alr = (RTC->ALRH & 0xFFFFU) << 16 | (RTC->ALRL & 0xFFFFU);
+  if ((uint32_t)(alr - p->cnt - 1U) < ticks)
+  {
+    RTC->CRL |= RTC_CRL_ALRF;
+    if (EXTI->RTSR & SIM_EXTI_RTC_ALARM)
+    {
+      EXTI->PR |= SIM_EXTI_RTC_ALARM;
+    }
+    p->alarms++;
+  }
+  p->cnt += ticks;
+  sim_rtc_write_cnt(p->cnt);
+}
+
+static int sim_rtc_alarm_level(void)
+{
+  return (EXTI->PR & EXTI->IMR & SIM_EXTI_RTC_ALARM) != 0U;
+}
+
+static int sim_usb_wakeup_level(void)
+{
+  return (EXTI->PR & EXTI->IMR & SIM_EXTI_USB_WAKEUP) != 0U;
+}
+
+void sim_pwr_init(void)
+{
+  sim_irq_set_level_source(RTC_Alarm_IRQn, sim_rtc_alarm_level);
+  sim_irq_set_level_source(USBWakeUp_IRQn, sim_usb_wakeup_level);
+}
+
+void sim_pwr_poll(uint64_t now)
+{
+  sim_rtc_step(now);
+}
+
+int sim_pwr_clock_stopped(void)
+{
+  return sim_pwr.clock_stopped;
+}
+
+/* HAL_RCC_OscConfig：Stop 醒来后 HSE 重新起振、PLL 重新锁定 */
+void sim_pwr_osc_config(const RCC_OscInitTypeDef *osc)
+{
+  uint64_t us = 0;
+
+  if (!sim_pwr.clock_stopped)
+  {
+    return;
+  }
+  if ((osc->OscillatorType & RCC_OSCILLATORTYPE_HSE) && osc->HSEState == RCC_HSE_ON)
+  {
+    us += SIM_HSE_STARTUP_US;
+  }
+  if (osc->PLL.PLLState == RCC_PLL_ON)
+  {
+    us += SIM_PLL_LOCK_US;
+  }
+  sim_spin_until(sim_now() + SIM_US(us));
+}
+
+/* HAL_RCC_ClockConfig：切回 PLL，时钟恢复 */
+void sim_pwr_clock_restored(void)
+{
+  sim_lock();
+  sim_pwr.clock_stopped = 0;
+  sim_unlock();
+}
+
+void HAL_PWR_EnableBkUpAccess(void)
+{
+  PWR->CR |= PWR_CR_DBP;
+}
+
+void HAL_PWR_DisableBkUpAccess(void)
+{
+  PWR->CR &= ~PWR_CR_DBP;
+}
+
+void HAL_PWR_EnterSTOPMode(uint32_t Regulator, uint8_t STOPEntry)
+{
+  int wake;
+
+  (void)Regulator;
+  (void)STOPEntry;
+  sim_lock();
+  sim_pwr.clock_stopped = 1;
+  sim_pwr.stop_t = sim_now();
+  sim_pwr.stops++;
+  SystemCoreClock = SIM_HSI_HZ;
+  sim_unlock();
+  for (;;)
+  {
+    sim_lock();
+    wake = (EXTI->PR & EXTI->IMR) != 0U;
+    sim_unlock();
+    if (wake)
+    {
+      break;
+    }
+    sim_spin_until(sim_now() + SIM_US(sim_opt.tick_us));
+  }
+  sim_lock();
+  sim_pwr.stop_cycles += sim_now() - sim_pwr.stop_t;
+  sim_unlock();
+}
+
+void sim_report_pwr(FILE *f)
+{
+  sim_pwr_t *p = &sim_pwr;
+
+  fprintf(f, "  \"pwr\": {\"lsi_hz\": %u, \"rtc_count\": %u, \"rtc_alarms\": %llu, \"stops\": %llu, "
+             "\"stop_ms\": %.1f, \"usb\": \"%s\"},\n",
+          sim_opt.lsi_hz, p->cnt, (unsigned long long)p->alarms, (unsigned long long)p->stops,
+          (double)p->stop_cycles / (SIM_CORE_CLOCK_HZ / 1000U), sim_opt.no_usb ? "unplugged" : "configured");
+}
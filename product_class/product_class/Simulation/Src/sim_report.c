@@ -0,0 +1,722 @@
+/**
+ ******************************************************************************
+ * @file    sim_report.c
+ * @brief   仿真统计：函数耗时、中断耗时与 JSON 报告
+ ******************************************************************************
+ * @attention
+ *
+ * 固件源文件用 -finstrument-functions 编译，每次函数进出都会调用
+ * __cyg_profile_func_enter/exit。这里维护一个影子调用栈，按虚拟周期
+ * 统计每个函数的调用次数、包含子函数的耗时、扣除中断后的耗时和两次
+ * 调用之间的间隔（主循环里第一个函数的调用间隔就是循环周期）。
+ *
+ * 中断在固件线程的信号处理函数里执行，和线程模式共用一个影子栈；
+ * 入栈先占位再填写，中途被中断打断也不会踩到对方的栈帧。
+ *
+ ******************************************************************************
+ */
+#define _GNU_SOURCE
+#include <elf.h>
+#include <link.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim.h"
+#include "schedule.h"
+#include "bsp_dht11.h"
+#include "bsp_oled_debug.h"
+#include "usbd_cdc_if.h"
+#include "servo_motion.h"
+#include "fan_ctrl.h"
+#include "power.h"
+#include "cpu_prof.h"
+#include "timebase.h"
+#include "fill_level.h"
+
+#define SIM_PROF_NOINSTR      __attribute__((no_instrument_function))
+#define SIM_PROF_STACK_DEPTH  256
+#define SIM_PROF_FUNCS        1024     /* 2 的幂 */
+#define SIM_LOOP_FUNCTION     "Ultra_Sound_Start"
+
+typedef struct
+{
+  void     *fn;
+  uint64_t  calls;
+  uint64_t  total;          /* 包含子函数 */
+  uint64_t  total_irq;      /* 其间被中断占用的周期 */
+  uint64_t  max;
+  uint64_t  last_enter;
+  uint64_t  interval_sum;
+  uint64_t  interval_min;
+  uint64_t  interval_max;
+} sim_prof_func_t;
+
+typedef struct
+{
+  sim_prof_func_t *func;
+  uint64_t         enter;
+  uint64_t         irq;
+} sim_prof_frame_t;
+
+typedef struct
+{
+  uint64_t count;
+  uint64_t total;
+  uint64_t max;
+} sim_prof_irq_t;
+
+typedef struct
+{
+  uintptr_t   addr;
+  const char *name;
+} sim_symbol_t;
+
+static sim_prof_func_t  sim_prof_funcs[SIM_PROF_FUNCS];
+static sim_prof_frame_t sim_prof_stack[SIM_PROF_STACK_DEPTH];
+static volatile sig_atomic_t sim_prof_sp;
+static uint64_t         sim_prof_overflow;
+static sim_prof_irq_t   sim_prof_irqs[SIM_IRQ_COUNT];
+static volatile uint64_t sim_prof_irq_total;
+static int              sim_prof_irq_depth;
+
+static sim_symbol_t    *sim_symbols;
+static size_t           sim_symbol_count;
+
+/******************************* 函数插桩 *************************************/
+SIM_PROF_NOINSTR static sim_prof_func_t *sim_prof_func(void *fn)
+{
+  uint32_t h = (uint32_t)(((uintptr_t)fn >> 2) * 2654435761U) & (SIM_PROF_FUNCS - 1U);
+
+  for (uint32_t i = 0; i < SIM_PROF_FUNCS; i++)
+  {
+    sim_prof_func_t *p = &sim_prof_funcs[(h + i) & (SIM_PROF_FUNCS - 1U)];
+
+    if (p->fn == fn)
+    {
+      return p;
+    }
+    if (p->fn == NULL)
+    {
+      p->fn = fn;
+      p->interval_min = UINT64_MAX;
+      return p;
+    }
+  }
+  return NULL;
+}
+
+SIM_PROF_NOINSTR void __cyg_profile_func_enter(void *fn, void *call_site)
+{
+  int sp;
+  uint64_t now;
+  sim_prof_func_t *p;
+
+  (void)call_site;
+  /* 先记调用开销，期间到期的中断在入栈前执行完 */
+  sim_advance(SIM_CALL_CYCLES);
+  sp = sim_prof_sp;
+  now = sim_now();
+  sim_prof_sp = sp + 1;
+  __atomic_signal_fence(__ATOMIC_SEQ_CST);
+  if (sp >= SIM_PROF_STACK_DEPTH)
+  {
+    sim_prof_overflow++;
+    return;
+  }
+  p = sim_prof_func(fn);
+  if (p != NULL && p->calls != 0U)
+  {
+    uint64_t interval = now - p->last_enter;
+
+    p->interval_sum += interval;
+    p->interval_min = interval < p->interval_min ? interval : p->interval_min;
+    p->interval_max = interval > p->interval_max ? interval : p->interval_max;
+  }
+  if (p != NULL)
+  {
+    p->calls++;
+    p->last_enter = now;
+  }
+  sim_prof_stack[sp].func = p;
+  sim_prof_stack[sp].irq = sim_prof_irq_total;
+  sim_prof_stack[sp].enter = now;
+}
+
+SIM_PROF_NOINSTR void __cyg_profile_func_exit(void *fn, void *call_site)
+{
+  int sp = sim_prof_sp - 1;
+
+  (void)fn;
+  (void)call_site;
+  if (sp < 0)
+  {
+    return;
+  }
+  if (sp < SIM_PROF_STACK_DEPTH && sim_prof_stack[sp].func != NULL)
+  {
+    sim_prof_frame_t *f = &sim_prof_stack[sp];
+    uint64_t cycles = sim_now() - f->enter;
+
+    f->func->total += cycles;
+    f->func->total_irq += sim_prof_irq_total - f->irq;
+    f->func->max = cycles > f->func->max ? cycles : f->func->max;
+  }
+  __atomic_signal_fence(__ATOMIC_SEQ_CST);
+  sim_prof_sp = sp;
+}
+
+void sim_prof_irq_enter(int idx)
+{
+  (void)idx;
+  sim_prof_irq_depth++;
+}
+
+void sim_prof_irq_exit(int idx, uint64_t cycles)
+{
+  sim_prof_irq_t *q = &sim_prof_irqs[idx];
+
+  q->count++;
+  q->total += cycles;
+  q->max = cycles > q->max ? cycles : q->max;
+  /* 嵌套中断的时间已经算在外层里 */
+  if (--sim_prof_irq_depth == 0)
+  {
+    sim_prof_irq_total += cycles;
+  }
+}
+
+uint64_t sim_prof_irq_cycles(void)
+{
+  return sim_prof_irq_total;
+}
+
+/******************************* 符号表 ***************************************/
+static int sim_symbol_cmp(const void *a, const void *b)
+{
+  uintptr_t x = ((const sim_symbol_t *)a)->addr;
+  uintptr_t y = ((const sim_symbol_t *)b)->addr;
+
+  return x < y ? -1 : x > y;
+}
+
+static int sim_load_base_cb(struct dl_phdr_info *info, size_t size, void *data)
+{
+  (void)size;
+  *(uintptr_t *)data = (uintptr_t)info->dlpi_addr;
+  return 1;   /* 第一个对象就是可执行文件本身 */
+}
+
+/* 读取 /proc/self/exe 的 .symtab，只在生成报告时调用一次 */
+static void sim_symbols_load(void)
+{
+  FILE *f = fopen("/proc/self/exe", "rb");
+  Elf64_Ehdr eh;
+  Elf64_Shdr *sh = NULL;
+  char *strtab = NULL;
+  Elf64_Sym *syms = NULL;
+  uintptr_t base = 0;
+  size_t nsyms = 0;
+
+  if (f == NULL)
+  {
+    return;
+  }
+  dl_iterate_phdr(sim_load_base_cb, &base);
+  if (fread(&eh, sizeof(eh), 1, f) != 1 || memcmp(eh.e_ident, ELFMAG, SELFMAG) != 0 || eh.e_ident[EI_CLASS] != ELFCLASS64)
+  {
+    goto out;
+  }
+  sh = calloc(eh.e_shnum, sizeof(*sh));
+  if (sh == NULL || fseek(f, (long)eh.e_shoff, SEEK_SET) != 0 || fread(sh, sizeof(*sh), eh.e_shnum, f) != eh.e_shnum)
+  {
+    goto out;
+  }
+  for (int i = 0; i < eh.e_shnum; i++)
+  {
+    Elf64_Shdr *str;
+
+    if (sh[i].sh_type != SHT_SYMTAB || sh[i].sh_link >= eh.e_shnum)
+    {
+      continue;
+    }
+    str = &sh[sh[i].sh_link];
+    nsyms = sh[i].sh_size / sizeof(Elf64_Sym);
+    syms = malloc(sh[i].sh_size);
+    strtab = malloc(str->sh_size);
+    sim_symbols = calloc(nsyms, sizeof(*sim_symbols));
+    if (syms == NULL || strtab == NULL || sim_symbols == NULL
+        || fseek(f, (long)sh[i].sh_offset, SEEK_SET) != 0 || fread(syms, sizeof(Elf64_Sym), nsyms, f) != nsyms
+        || fseek(f, (long)str->sh_offset, SEEK_SET) != 0 || fread(strtab, 1, str->sh_size, f) != str->sh_size)
+    {
+      free(sim_symbols);
+      sim_symbols = NULL;
+      goto out;
+    }
+    for (size_t k = 0; k < nsyms; k++)
+    {
+      if (ELF64_ST_TYPE(syms[k].st_info) != STT_FUNC || syms[k].st_value == 0U || syms[k].st_name >= str->sh_size)
+      {
+        continue;
+      }
+      sim_symbols[sim_symbol_count].addr = base + (uintptr_t)syms[k].st_value;
+      sim_symbols[sim_symbol_count].name = strtab + syms[k].st_name;
+      sim_symbol_count++;
+    }
+    qsort(sim_symbols, sim_symbol_count, sizeof(*sim_symbols), sim_symbol_cmp);
+    strtab = NULL;    /* 名字指向 strtab，常驻 */
+    break;
+  }
+out:
+  free(syms);
+  free(strtab);
+  free(sh);
+  fclose(f);
+}
+
+static const char *sim_symbol_name(void *fn)
+{
+  size_t lo = 0;
+  size_t hi = sim_symbol_count;
+
+  while (lo < hi)
+  {
+    size_t mid = (lo + hi) / 2U;
+
+    if (sim_symbols[mid].addr < (uintptr_t)fn)
+    {
+      lo = mid + 1U;
+    }
+    else
+    {
+      hi = mid;
+    }
+  }
+  if (lo < sim_symbol_count && sim_symbols[lo].addr == (uintptr_t)fn)
+  {
+    return sim_symbols[lo].name;
+  }
+  return "?";
+}
+
+const char *sim_prof_current_function(void)
+{
+  int sp = sim_prof_sp - 1;
+
+  if (sim_symbols == NULL)
+  {
+    sim_symbols_load();
+  }
+  if (sp < 0 || sp >= SIM_PROF_STACK_DEPTH || sim_prof_stack[sp].func == NULL)
+  {
+    return "";
+  }
+  return sim_symbol_name(sim_prof_stack[sp].func->fn);
+}
+
+/******************************* 报告 *****************************************/
+static const char *sim_irq_name(int idx)
+{
+  switch (idx - 16)
+  {
+    case SysTick_IRQn:          return "SysTick";
+    case PendSV_IRQn:           return "PendSV";
+    case EXTI0_IRQn:            return "EXTI0";
+    case EXTI1_IRQn:            return "EXTI1";
+    case EXTI2_IRQn:            return "EXTI2";
+    case EXTI3_IRQn:            return "EXTI3";
+    case EXTI4_IRQn:            return "EXTI4";
+    case DMA1_Channel1_IRQn:    return "DMA1_Channel1";
+    case DMA1_Channel2_IRQn:    return "DMA1_Channel2";
+    case DMA1_Channel3_IRQn:    return "DMA1_Channel3";
+    case DMA1_Channel4_IRQn:    return "DMA1_Channel4";
+    case DMA1_Channel5_IRQn:    return "DMA1_Channel5";
+    case DMA1_Channel6_IRQn:    return "DMA1_Channel6";
+    case DMA1_Channel7_IRQn:    return "DMA1_Channel7";
+    case USB_LP_CAN1_RX0_IRQn:  return "USB_LP_CAN1_RX0";
+    case EXTI9_5_IRQn:          return "EXTI9_5";
+    case TIM2_IRQn:             return "TIM2";
+    case TIM3_IRQn:             return "TIM3";
+    case I2C2_EV_IRQn:          return "I2C2_EV";
+    case I2C2_ER_IRQn:          return "I2C2_ER";
+    case USART1_IRQn:           return "USART1";
+    case EXTI15_10_IRQn:        return "EXTI15_10";
+    default:                    return "?";
+  }
+}
+
+static double sim_us(uint64_t cycles)
+{
+  return (double)cycles / SIM_CYCLES_PER_US;
+}
+
+void sim_report_irq(FILE *f)
+{
+  int first = 1;
+
+  fprintf(f, "  \"irq\": {");
+  for (int idx = 0; idx < SIM_IRQ_COUNT; idx++)
+  {
+    sim_prof_irq_t *q = &sim_prof_irqs[idx];
+
+    if (q->count == 0U)
+    {
+      continue;
+    }
+    fprintf(f, "%s\n    \"%s\": {\"count\": %llu, \"total_cycles\": %llu, \"avg_cycles\": %.1f, \"max_cycles\": %llu}",
+            first ? "" : ",", sim_irq_name(idx), (unsigned long long)q->count, (unsigned long long)q->total,
+            (double)q->total / (double)q->count, (unsigned long long)q->max);
+    first = 0;
+  }
+  fprintf(f, "\n  },\n");
+}
+
+/* 固件调度器的任务表（schedule.c），没有链接进来时不输出 */
+extern struct TaskStruct TaskST[] __attribute__((weak));
+extern uint8_t TaskCount __attribute__((weak));
+
+static void sim_report_tasks(FILE *f)
+{
+  if (TaskST == NULL || &TaskCount == NULL)
+  {
+    return;
+  }
+  fprintf(f, "  \"tasks\": [");
+  for (int i = 0; i < TaskCount; i++)
+  {
+    struct TaskStruct *t = &TaskST[i];
+
+    fprintf(f, "%s\n    {\"name\": \"%s\", \"period_ms\": %u, \"phase_ms\": %u, \"runs\": %u, "
+               "\"misses\": %u, \"max_latency_ms\": %u}",
+            i ? "," : "", sim_symbol_name((void *)t->FC), t->TaskTickMax, t->TaskPhase,
+            t->RunCount, t->MissCount, t->MaxLatency);
+  }
+  fprintf(f, "\n  ],\n");
+}
+
+/* 固件 DHT11 驱动的统计（bsp_dht11.c），没有链接进来时不输出 */
+extern DHT11_Ctrl_TypeDef dht11 __attribute__((weak));
+
+static void sim_report_dht11(FILE *f)
+{
+  if (&dht11 == NULL)
+  {
+    return;
+  }
+  fprintf(f, "  \"dht11\": {\"frames\": %u, \"checksum_errors\": %u, \"no_response\": %u, \"timeouts\": %u, "
+             "\"bit_errors\": %u, \"too_soon\": %u, \"busy\": %u, \"temp\": %u, \"humi\": %u},\n",
+          dht11.seq, dht11.checksum_errors, dht11.no_response, dht11.timeouts, dht11.bit_errors,
+          dht11.too_soon, dht11.busy, dht11.data.temp_int, dht11.data.humi_int);
+}
+
+/* 固件 OLED 驱动的统计（bsp_oled_debug.c），没有链接进来时不输出 */
+extern OLED_Stat_TypeDef oled_stat __attribute__((weak));
+
+static void sim_report_oled(FILE *f)
+{
+  if (&oled_stat == NULL)
+  {
+    return;
+  }
+  fprintf(f, "  \"oled\": {\"transfers\": %u, \"bytes\": %u, \"pages\": %u, \"flushes\": %u, \"errors\": %u, "
+             "\"timeouts\": %u, \"recoveries\": %u, \"fallbacks\": %u, \"dma_waits\": %u},\n",
+          oled_stat.transfers, oled_stat.bytes, oled_stat.pages, oled_stat.flushes, oled_stat.errors,
+          oled_stat.timeouts, oled_stat.recoveries, oled_stat.fallbacks, oled_stat.dma_waits);
+}
+
+/* 固件每条通信链路的吞吐统计（Connectivity_Protocal.c / usbd_cdc_if.c），没有链接进来时不输出 */
+extern Link_Stat link_stat[LINK_NUM] __attribute__((weak));
+extern volatile uint8_t active_link __attribute__((weak));
+extern Usb_Tx_Pool usb_tx __attribute__((weak));
+extern Usb_Rx_Ring usb_rx __attribute__((weak));
+
+static void sim_report_links(FILE *f)
+{
+  static const char *const names[LINK_NUM] = { "uart", "usb" };
+
+  if (link_stat == NULL)
+  {
+    return;
+  }
+  fprintf(f, "  \"links\": {\n");
+  for (int i = 0; i < LINK_NUM; i++)
+  {
+    fprintf(f, "    \"%s\": {\"rx_bytes\": %u, \"rx_frames\": %u, \"rx_dups\": %u, \"rx_nacks\": %u, "
+               "\"tx_bytes\": %u, \"tx_frames\": %u, \"tx_drops\": %u, \"tx_resends\": %u},\n",
+            names[i], link_stat[i].rx_bytes, link_stat[i].rx_frames, link_stat[i].rx_dups, link_stat[i].rx_nacks,
+            link_stat[i].tx_bytes, link_stat[i].tx_frames, link_stat[i].tx_drops, link_stat[i].tx_resends);
+  }
+  if (&usb_tx != NULL && &usb_rx != NULL)
+  {
+    fprintf(f, "    \"usb_tx_transfers\": %u, \"usb_tx_max_len\": %u, \"usb_tx_overflow\": %u, \"usb_rx_pauses\": %u,\n",
+            usb_tx.transfers, usb_tx.max_len, usb_tx.overflow, usb_rx.pauses);
+  }
+  fprintf(f, "    \"active\": \"%s\"\n  },\n", active_link < LINK_NUM ? names[active_link] : "?");
+}
+
+/* 固件舵机运动规划的统计（servo_motion.c），没有链接进来时不输出 */
+extern Servo_Motion servo __attribute__((weak));
+
+static void sim_report_servo(FILE *f)
+{
+  if (&servo == NULL)
+  {
+    return;
+  }
+  fprintf(f, "  \"servo\": {\"state\": %u, \"class\": %u, \"pos\": %d, \"moves\": %u, \"retargets\": %u, "
+             "\"releases\": %u, \"done\": %u, \"last_move_ms\": %u},\n",
+          servo.state, servo.cls, (int)servo.pos, servo.moves, servo.retargets, servo.releases,
+          servo.done_seq, servo.done.move_ms);
+}
+
+/* 固件风扇闭环的状态（fan_ctrl.c），没有链接进来时不输出 */
+extern Fan_Ctrl fan __attribute__((weak));
+
+static void sim_report_fan(FILE *f)
+{
+  if (&fan == NULL)
+  {
+    return;
+  }
+  fprintf(f, "  \"fan\": {\"state\": %u, \"temp\": %d, \"humi\": %d, \"demand\": %u, \"updates\": %u, "
+             "\"failsafes\": %u, \"channels\": [",
+          fan.state, fan.pv[FAN_TEMP], fan.pv[FAN_HUMI], fan.demand, fan.updates, fan.failsafes);
+  for (int i = 0; i < FAN_NUM; i++)
+  {
+    fprintf(f, "%s{\"duty\": %u, \"target\": %u, \"starts\": %u, \"avg_duty\": %.2f}", i ? ", " : "",
+            fan.ch[i].duty, fan.ch[i].target, fan.ch[i].starts,
+            fan.ticks ? (double)fan.ch[i].duty_sum / (double)fan.ticks : 0.0);
+  }
+  fprintf(f, "]},\n");
+}
+
+/* 固件低功耗管理的统计（power.c），没有链接进来时不输出 */
+extern Power_Ctrl power __attribute__((weak));
+
+static void sim_report_power(FILE *f)
+{
+  static const char *const blocks[POWER_BLOCK_NUM] = { "mode", "cal", "due", "usb", "busy" };
+  double total_ms;
+  double sleep_ms;
+  double stop_ms;
+
+  if (&power == NULL)
+  {
+    return;
+  }
+  total_ms = (double)(uwTick - power.start_tick);
+  sleep_ms = (double)power.sleep_cycles / (SIM_CORE_CLOCK_HZ / 1000U);
+  stop_ms = power.rtc_hz ? (double)power.stop_ticks * 1000.0 / (double)power.rtc_hz : 0.0;
+  fprintf(f, "  \"power\": {\"mode\": %u, \"stop_enable\": %u, \"saves\": %u, \"sleeps\": %u, \"stops\": %u, "
+             "\"run_ms\": %.1f, \"sleep_ms\": %.1f, \"stop_ms\": %.1f, \"rtc_hz\": %u, "
+             "\"wakes\": {\"rtc\": %u, \"uart\": %u, \"usb\": %u, \"other\": %u}, "
+             "\"wake_us_avg\": %.1f, \"wake_us_max\": %u, \"blocked\": {",
+          power.mode, power.stop_enable, power.saves, power.sleeps, power.stops,
+          total_ms > sleep_ms + stop_ms ? total_ms - sleep_ms - stop_ms : 0.0, sleep_ms, stop_ms, power.rtc_hz,
+          power.wakes[POWER_WAKE_RTC], power.wakes[POWER_WAKE_UART], power.wakes[POWER_WAKE_USB],
+          power.wakes[POWER_WAKE_OTHER],
+          power.stops ? (double)power.wake_us_sum / (double)power.stops : 0.0, power.wake_us_max);
+  for (int i = 0; i < POWER_BLOCK_NUM; i++)
+  {
+    fprintf(f, "%s\"%s\": %u", i ? ", " : "", blocks[i], power.blocked[i]);
+  }
+  fprintf(f, "}},\n");
+}
+
+/* 固件 DWT 剖析表（cpu_prof.c），没有链接进来时不输出 */
+extern Prof_Table prof __attribute__((weak));
+
+static void sim_report_prof(FILE *f)
+{
+  static const char *const names[PROF_NUM] =
+  {
+    "task_command", "task_ultrasound", "task_dht11", "task_fan", "task_telemetry", "task_oled",
+    "idle", "systick", "usart1_irq", "tim2_irq", "usb_irq", "exti15_10_irq", "oled_flush", "dht11_decode",
+  };
+
+  if (&prof == NULL)
+  {
+    return;
+  }
+  fprintf(f, "  \"prof\": {\"idle_pct\": %.2f, \"idle_min_pct\": %.2f, \"probes\": [",
+          prof.idle_x100 / 100.0, prof.idle_min_x100 / 100.0);
+  for (int i = 0; i < PROF_NUM; i++)
+  {
+    const Prof_Probe *p = &prof.probe[i];
+
+    fprintf(f, "%s\n    {\"name\": \"%s\", \"count\": %u, \"min\": %u, \"max\": %u, \"mean\": %.1f, \"hist\": [",
+            i ? "," : "", names[i], p->count, p->count ? p->min : 0U, p->max,
+            p->count ? (double)p->sum / (double)p->count : 0.0);
+    for (int b = 0; b < PROF_HIST_BINS; b++)
+    {
+      fprintf(f, "%s%u", b ? ", " : "", p->hist[b]);
+    }
+    fprintf(f, "]}");
+  }
+  fprintf(f, "\n  ]},\n");
+}
+
+/* 固件时基和软件定时器（timebase.c），没有链接进来时不输出 */
+extern Timebase_Ctrl timebase __attribute__((weak));
+
+static void sim_report_timebase(FILE *f)
+{
+  int armed = 0;
+
+  if (&timebase == NULL)
+  {
+    return;
+  }
+  for (int i = 0; i < TIMEBASE_WHEEL_SLOTS; i++)
+  {
+    for (const Timebase_Timer *t = timebase.wheel[i]; t != NULL; t = t->next)
+    {
+      armed++;
+    }
+  }
+  fprintf(f, "  \"timebase\": {\"epoch\": %u, \"ms\": %u, \"last_us\": %llu, \"fired\": %u, \"late\": %u, "
+             "\"armed\": %d},\n",
+          timebase.epoch, uwTick, (unsigned long long)timebase.last_us, timebase.fired, timebase.late, armed);
+}
+
+/* 固件满溢检测（fill_level.c），没有链接进来时不输出 */
+extern Fill_Ctrl fill __attribute__((weak));
+
+static void sim_report_fill(FILE *f)
+{
+  if (&fill == NULL)
+  {
+    return;
+  }
+  fprintf(f, "  \"fill\": {\"state\": %u, \"pct\": %u, \"distance_mm\": %u, \"empty_mm\": %u, \"full_mm\": %u, "
+             "\"speed_dm\": %u, \"temp\": %d, \"outliers\": %u, \"events\": %u},\n",
+          fill.state, fill.pct, fill.distance_mm, fill.empty_mm, fill.full_mm, fill.speed_dm, fill.temp,
+          fill.outliers, fill.event_seq);
+}
+
+static int sim_func_cmp(const void *a, const void *b)
+{
+  const sim_prof_func_t *x = *(const sim_prof_func_t * const *)a;
+  const sim_prof_func_t *y = *(const sim_prof_func_t * const *)b;
+
+  return x->total < y->total ? 1 : x->total > y->total ? -1 : 0;
+}
+
+static void sim_report_functions(FILE *f)
+{
+  sim_prof_func_t *list[SIM_PROF_FUNCS];
+  size_t n = 0;
+
+  for (int i = 0; i < SIM_PROF_FUNCS; i++)
+  {
+    if (sim_prof_funcs[i].fn != NULL && sim_prof_funcs[i].calls != 0U)
+    {
+      list[n++] = &sim_prof_funcs[i];
+    }
+  }
+  qsort(list, n, sizeof(list[0]), sim_func_cmp);
+  fprintf(f, "  \"functions\": [");
+  for (size_t i = 0; i < n; i++)
+  {
+    sim_prof_func_t *p = list[i];
+    uint64_t intervals = p->calls - 1U;
+
+    fprintf(f, "%s\n    {\"name\": \"%s\", \"calls\": %llu, \"total_cycles\": %llu, \"avg_cycles\": %.1f, "
+               "\"avg_cycles_excl_irq\": %.1f, \"max_cycles\": %llu, \"interval_avg_us\": %.1f, "
+               "\"interval_min_us\": %.1f, \"interval_max_us\": %.1f}",
+            i ? "," : "", sim_symbol_name(p->fn), (unsigned long long)p->calls, (unsigned long long)p->total,
+            (double)p->total / (double)p->calls, (double)(p->total - p->total_irq) / (double)p->calls,
+            (unsigned long long)p->max,
+            intervals ? sim_us(p->interval_sum) / (double)intervals : 0.0,
+            intervals ? sim_us(p->interval_min) : 0.0, sim_us(p->interval_max));
+  }
+  fprintf(f, "\n  ]\n");
+}
+
+static sim_prof_func_t *sim_prof_find(const char *name)
+{
+  for (int i = 0; i < SIM_PROF_FUNCS; i++)
+  {
+    if (sim_prof_funcs[i].fn != NULL && strcmp(sim_symbol_name(sim_prof_funcs[i].fn), name) == 0)
+    {
+      return &sim_prof_funcs[i];
+    }
+  }
+  return NULL;
+}
+
+void sim_report_summary(FILE *f)
+{
+  sim_prof_func_t *loop = sim_prof_find(SIM_LOOP_FUNCTION);
+  uint64_t now = sim_now();
+
+  fprintf(f, "sim: %.1f ms virtual in %.1f ms host, irq load %.2f%%, sleep %.2f%%\n",
+          sim_us(now) / 1000.0, (double)sim_host_ns() / 1e6,
+          now ? 100.0 * (double)sim_prof_irq_total / (double)now : 0.0,
+          now ? 100.0 * (double)sim_wfi_cycles() / (double)now : 0.0);
+  if (loop != NULL && loop->calls > 1U)
+  {
+    fprintf(f, "sim: %s %llu calls, period avg %.1f us, min %.1f us, max %.1f us\n",
+            SIM_LOOP_FUNCTION, (unsigned long long)loop->calls, sim_us(loop->interval_sum) / (double)(loop->calls - 1U),
+            sim_us(loop->interval_min), sim_us(loop->interval_max));
+  }
+  if (sim_prof_overflow)
+  {
+    fprintf(f, "sim: profiler stack overflowed %llu times\n", (unsigned long long)sim_prof_overflow);
+  }
+}
+
+/* 退出时调用，调用者持锁 */
+void sim_report_write(void)
+{
+  if (sim_symbols == NULL)
+  {
+    sim_symbols_load();
+  }
+  if (sim_opt.report_path != NULL)
+  {
+    FILE *f = fopen(sim_opt.report_path, "w");
+
+    if (f == NULL)
+    {
+      fprintf(stderr, "sim: cannot write %s\n", sim_opt.report_path);
+    }
+    else
+    {
+      fprintf(f, "{\n");
+      fprintf(f, "  \"sim\": {\"time_scale\": %g, \"tick_us\": %u, \"virtual_ms\": %.3f, \"host_ms\": %.3f, "
+                 "\"realtime\": %d, \"irq_cycles\": %llu, \"wfi_calls\": %llu, \"wfi_cycles\": %llu, \"stall_steps\": %llu},\n",
+              sim_opt.time_scale, sim_opt.tick_us, sim_us(sim_now()) / 1000.0, (double)sim_host_ns() / 1e6,
+              sim_opt.realtime, (unsigned long long)sim_prof_irq_total, (unsigned long long)sim_wfi_count(),
+              (unsigned long long)sim_wfi_cycles(), (unsigned long long)sim_core_stall_steps());
+      sim_report_gpio(f);
+      sim_report_tim(f);
+      sim_report_uart(f);
+      sim_report_i2c(f);
+      sim_report_usb(f);
+      sim_report_env(f);
+      sim_report_pwr(f);
+      sim_report_irq(f);
+      sim_report_tasks(f);
+      sim_report_dht11(f);
+      sim_report_oled(f);
+      sim_report_links(f);
+      sim_report_servo(f);
+      sim_report_fan(f);
+      sim_report_power(f);
+      sim_report_prof(f);
+      sim_report_timebase(f);
+      sim_report_fill(f);
+      sim_report_functions(f);
+      fprintf(f, "}\n");
+      fclose(f);
+    }
+  }
+  if (sim_opt.oled_dump_path != NULL)
+  {
+    sim_i2c_dump_oled(sim_opt.oled_dump_path);
+  }
+  if (!sim_opt.quiet)
+  {
+    sim_report_summary(stderr);
+  }
+}
@@ -0,0 +1,824 @@
+/**
+ ******************************************************************************
+ * @file    sim_tim.c
+ * @brief   仿真 TIM2/TIM3 与 HAL_TIM 接口
+ ******************************************************************************
+ * @attention
+ *
+ * 计数器按需推进：每次访问时根据虚拟时间算出 CNT，并补上期间发生的
+ * 更新事件（UIF）和输出比较匹配（CCxIF）。输入捕获由外部模型按边沿
+ * 发生的时刻调用 sim_tim_input_edge()，捕获值是那个时刻的 CNT。
+ * 接了引脚的输出通道（TIM2_CH1 经部分重映射到 PA15/TRIG）按 PWM1/PWM2/
+ * 强制电平模式算出输出电平，边沿按发生时刻送给 GPIO。
+ * TIM2/TIM3 挂在 APB1（36MHz，x2），计数时钟为 72MHz/(PSC+1)。
+ *
+ * HAL 部分照搬官方库的通道状态处理，例如同一通道先 HAL_TIM_IC_Start()
+ * 再 HAL_TIM_IC_Start_IT() 时第二次调用返回 HAL_ERROR，和板子上一致。
+ *
+ ******************************************************************************
+ */
+#include <string.h>
+#include "sim.h"
+
+#define SIM_TIM_COUNT      2
+#define TIM_CCMR_CCS_MASK  0x03U
+#define TIM_CCMR_OCPE      0x08U
+#define TIM_CCMR_OCM_MASK  0x70U
+#define TIM_CR2_MMS_MASK   0x70U
+#define TIM_SMCR_MSM       0x80U
+#define TIM_CCER_CCxNP     0x08U
+
+typedef struct
+{
+  TIM_TypeDef *tim;
+  uint64_t     base_t;        /* CNT == base_cnt 时的虚拟时刻 */
+  uint32_t     base_cnt;
+  uint32_t     updates;
+  uint32_t     captures[4];
+  uint32_t     overcaptures[4];
+  uint32_t     compare_writes[4];
+  uint32_t     last_ccr[4];
+  int          out_level[4];
+  uint32_t     out_edges[4];
+} sim_tim_t;
+
+static sim_tim_t sim_tim[SIM_TIM_COUNT] = {
+  { .tim = TIM2 },
+  { .tim = TIM3 },
+};
+
+static sim_tim_t *sim_tim_get(TIM_TypeDef *tim)
+{
+  for (int i = 0; i < SIM_TIM_COUNT; i++)
+  {
+    if (sim_tim[i].tim == tim)
+    {
+      return &sim_tim[i];
+    }
+  }
+  return NULL;
+}
+
+static uint32_t sim_tim_ccs(TIM_TypeDef *tim, int ch)
+{
+  uint32_t ccmr = (ch < 2) ? tim->CCMR1 : tim->CCMR2;
+
+  return (ccmr >> ((ch & 1) * 8U)) & TIM_CCMR_CCS_MASK;
+}
+
+static volatile uint32_t *sim_tim_ccr(TIM_TypeDef *tim, int ch)
+{
+  return &tim->CCR1 + ch;
+}
+
+/* 输出通道接的引脚，没有接引脚的通道不计算输出电平 */
+static int sim_tim_output_pin(sim_tim_t *st, int ch, GPIO_TypeDef **port, uint16_t *pin)
+{
+  if (st->tim == TIM2 && ch == 0)
+  {
+    *port = GPIOA;
+    *pin = GPIO_PIN_15;
+    return 1;
+  }
+  return 0;
+}
+
+/* 计数值为 cnt 时 OCx 的电平，不建模的模式保持原电平 */
+static int sim_tim_oc_level(sim_tim_t *st, int ch, uint64_t cnt)
+{
+  TIM_TypeDef *tim = st->tim;
+  uint32_t ccmr = (ch < 2) ? tim->CCMR1 : tim->CCMR2;
+  uint32_t ocm = (ccmr >> ((ch & 1) * 8U)) & TIM_CCMR_OCM_MASK;
+  uint32_t ccer = tim->CCER >> (ch * 4);
+  uint64_t ccr = *sim_tim_ccr(tim, ch);
+  int ref;
+
+  if ((ccer & TIM_CCER_CC1E) == 0U)
+  {
+    return 0;
+  }
+  switch (ocm)
+  {
+    case TIM_OCMODE_PWM1:            ref = cnt < ccr; break;
+    case TIM_OCMODE_PWM2:            ref = cnt >= ccr; break;
+    case TIM_OCMODE_FORCED_ACTIVE:   ref = 1; break;
+    case TIM_OCMODE_FORCED_INACTIVE: ref = 0; break;
+    default:                         return st->out_level[ch];
+  }
+  return (ccer & TIM_CCER_CC1P) ? !ref : ref;
+}
+
+static void sim_tim_output_at(sim_tim_t *st, int ch, uint64_t cnt, uint64_t t)
+{
+  GPIO_TypeDef *port;
+  uint16_t pin;
+  int level;
+
+  if (sim_tim_ccs(st->tim, ch) != 0U || !sim_tim_output_pin(st, ch, &port, &pin))
+  {
+    return;
+  }
+  level = sim_tim_oc_level(st, ch, cnt);
+  if (level != st->out_level[ch])
+  {
+    st->out_level[ch] = level;
+    st->out_edges[ch]++;
+    sim_gpio_af_output(port, pin, level, t);
+  }
+}
+
+/* 计数从 p0 走 ticks 步期间的输出边沿：CNT 到达 CCR 和回到 0 的时刻。
+ * 一次跨过多个周期时只补第一个周期的边沿 */
+static void sim_tim_output_edges(sim_tim_t *st, uint64_t p0, uint64_t ticks, uint64_t period, uint64_t div)
+{
+  uint64_t p1 = p0 + ticks;
+  uint64_t end = (p1 < period) ? p1 : period - 1U;
+  uint64_t wrap_t = st->base_t + (period - p0) * div;
+
+  for (int ch = 0; ch < 4; ch++)
+  {
+    uint64_t ccr = *sim_tim_ccr(st->tim, ch);
+
+    if (ccr > p0 && ccr <= end)
+    {
+      sim_tim_output_at(st, ch, ccr, st->base_t + (ccr - p0) * div);
+    }
+    if (p1 >= period)
+    {
+      sim_tim_output_at(st, ch, 0, wrap_t);
+      if ((st->tim->CR1 & TIM_CR1_OPM) == 0U && ccr > 0U && ccr < period && ccr <= p1 - period)
+      {
+        sim_tim_output_at(st, ch, ccr, wrap_t + ccr * div);
+      }
+    }
+  }
+}
+
+/* 把计数器推进到时刻 t，调用者持锁 */
+static void sim_tim_advance(sim_tim_t *st, uint64_t t)
+{
+  TIM_TypeDef *tim = st->tim;
+  uint64_t div = (uint64_t)tim->PSC + 1U;
+  uint64_t period = (uint64_t)tim->ARR + 1U;
+  uint64_t ticks, p0, p1;
+
+  if (t <= st->base_t)
+  {
+    return;
+  }
+  if ((tim->CR1 & TIM_CR1_CEN) == 0U)
+  {
+    st->base_t = t;
+    return;
+  }
+  ticks = (t - st->base_t) / div;
+  if (ticks == 0U)
+  {
+    return;
+  }
+  p0 = st->base_cnt;
+  p1 = p0 + ticks;
+  sim_tim_output_edges(st, p0, ticks, period, div);
+
+  /* 输出比较：CCR 落在 (p0, p1] 内即匹配 */
+  for (int ch = 0; ch < 4; ch++)
+  {
+    uint64_t ccr = *sim_tim_ccr(tim, ch);
+    int match;
+
+    if (sim_tim_ccs(tim, ch) != 0U || ccr >= period)
+    {
+      continue;
+    }
+    if (ticks >= period)
+    {
+      match = 1;
+    }
+    else if (p1 < period)
+    {
+      match = (ccr > p0) && (ccr <= p1);
+    }
+    else
+    {
+      match = (ccr > p0) || (ccr <= p1 - period);
+    }
+    if (match)
+    {
+      tim->SR |= TIM_SR_CC1IF << ch;
+    }
+  }
+  if (p1 >= period)
+  {
+    st->updates += (uint32_t)(p1 / period);
+    if ((tim->CR1 & TIM_CR1_UDIS) == 0U)
+    {
+      tim->SR |= TIM_SR_UIF;
+    }
+    if (tim->CR1 & TIM_CR1_OPM)
+    {
+      tim->CR1 &= ~TIM_CR1_CEN;
+      p1 = 0;
+    }
+  }
+  st->base_cnt = (uint32_t)(p1 % period);
+  st->base_t += ticks * div;
+  tim->CNT = st->base_cnt;
+}
+
+/* 时刻 t 的计数值，t 可以略早于当前推进到的时刻 */
+static uint32_t sim_tim_count_at(sim_tim_t *st, uint64_t t)
+{
+  TIM_TypeDef *tim = st->tim;
+  uint64_t div = (uint64_t)tim->PSC + 1U;
+  uint64_t period = (uint64_t)tim->ARR + 1U;
+  uint64_t back;
+
+  sim_tim_advance(st, t);
+  if (t >= st->base_t || (tim->CR1 & TIM_CR1_CEN) == 0U)
+  {
+    return st->base_cnt;
+  }
+  back = ((st->base_t - t) + div - 1U) / div;
+  return (uint32_t)((st->base_cnt + period - (back % period)) % period);
+}
+
+static void sim_tim_sync(sim_tim_t *st)
+{
+  uint64_t now = sim_now();
+
+  sim_env_poll(now);
+  sim_tim_advance(st, now);
+}
+
+void sim_tim_input_edge(TIM_TypeDef *tim, int ti, int level, uint64_t t)
+{
+  sim_tim_t *st = sim_tim_get(tim);
+
+  if (st == NULL)
+  {
+    return;
+  }
+  for (int ch = 0; ch < 4; ch++)
+  {
+    uint32_t ccs = sim_tim_ccs(tim, ch);
+    uint32_t ccer = tim->CCER >> (ch * 4);
+    int src;
+
+    if (ccs == 0U || (ccer & TIM_CCER_CC1E) == 0U)
+    {
+      continue;
+    }
+    /* 直接映射 ICx<-TIx，间接映射 IC1<-TI2、IC2<-TI1、IC3<-TI4、IC4<-TI3 */
+    src = (ccs == TIM_ICSELECTION_DIRECTTI) ? ch + 1 : ((ch ^ 1) + 1);
+    if (src != ti)
+    {
+      continue;
+    }
+    if ((ccer & TIM_CCER_CCxNP) == 0U && ((ccer & TIM_CCER_CC1P) ? level : !level))
+    {
+      continue;
+    }
+    if (tim->SR & (TIM_SR_CC1IF << ch))
+    {
+      tim->SR |= TIM_SR_CC1OF << ch;
+      st->overcaptures[ch]++;
+    }
+    *sim_tim_ccr(tim, ch) = sim_tim_count_at(st, t);
+    tim->SR |= TIM_SR_CC1IF << ch;
+    st->captures[ch]++;
+  }
+}
+
+uint32_t sim_tim_get_counter(TIM_TypeDef *TIMx)
+{
+  sim_tim_t *st = sim_tim_get(TIMx);
+  uint32_t cnt;
+
+  sim_advance(SIM_HAL_CYCLES);
+  sim_lock();
+  sim_tim_sync(st);
+  cnt = st->base_cnt;
+  sim_unlock();
+  return cnt;
+}
+
+void sim_tim_set_counter(TIM_TypeDef *TIMx, uint32_t value)
+{
+  sim_tim_t *st = sim_tim_get(TIMx);
+
+  sim_lock();
+  sim_tim_sync(st);
+  st->base_cnt = value;
+  st->base_t = sim_now();
+  TIMx->CNT = value;
+  sim_unlock();
+}
+
+uint32_t sim_tim_get_flag(TIM_TypeDef *TIMx, uint32_t flag)
+{
+  uint32_t sr;
+
+  sim_advance(SIM_HAL_CYCLES);
+  sim_lock();
+  sim_tim_sync(sim_tim_get(TIMx));
+  sr = TIMx->SR & flag;
+  sim_unlock();
+  return sr;
+}
+
+void sim_tim_clear_flag(TIM_TypeDef *TIMx, uint32_t flag)
+{
+  sim_lock();
+  TIMx->SR &= ~flag;
+  sim_unlock();
+}
+
+static void sim_tim_generate_update(TIM_HandleTypeDef *htim)
+{
+  sim_tim_t *st = sim_tim_get(htim->Instance);
+
+  sim_lock();
+  st->base_cnt = 0;
+  st->base_t = sim_now();
+  htim->Instance->CNT = 0;
+  sim_unlock();
+}
+
+static int sim_tim_count_enable_all(TIM_TypeDef *tim)
+{
+  return (tim->CCER & (TIM_CCER_CC1E | TIM_CCER_CC2E | TIM_CCER_CC3E | TIM_CCER_CC4E)) != 0U;
+}
+
+static void sim_tim_enable(TIM_HandleTypeDef *htim)
+{
+  sim_tim_t *st = sim_tim_get(htim->Instance);
+
+  sim_lock();
+  if ((htim->Instance->CR1 & TIM_CR1_CEN) == 0U)
+  {
+    st->base_t = sim_now();
+    htim->Instance->CR1 |= TIM_CR1_CEN;
+  }
+  sim_unlock();
+}
+
+static void sim_tim_disable(TIM_HandleTypeDef *htim)
+{
+  sim_tim_t *st = sim_tim_get(htim->Instance);
+
+  sim_lock();
+  if (!sim_tim_count_enable_all(htim->Instance))
+  {
+    sim_tim_advance(st, sim_now());
+    htim->Instance->CR1 &= ~TIM_CR1_CEN;
+  }
+  sim_unlock();
+}
+
+static void sim_tim_ccx(TIM_TypeDef *tim, uint32_t Channel, int enable)
+{
+  uint32_t mask = TIM_CCER_CC1E << Channel;
+
+  sim_lock();
+  tim->CCER = enable ? (tim->CCER | mask) : (tim->CCER & ~mask);
+  sim_unlock();
+}
+
+#define TIM_CHANNEL_STATE_GET(__HANDLE__, __CHANNEL__)          ((__HANDLE__)->ChannelState[(__CHANNEL__) >> 2U])
+#define TIM_CHANNEL_STATE_SET(__HANDLE__, __CHANNEL__, __STATE__) ((__HANDLE__)->ChannelState[(__CHANNEL__) >> 2U] = (__STATE__))
+
+static void sim_tim_channel_state_set_all(TIM_HandleTypeDef *htim, HAL_TIM_ChannelStateTypeDef state)
+{
+  for (int i = 0; i < 4; i++)
+  {
+    htim->ChannelState[i] = state;
+    htim->ChannelNState[i] = state;
+  }
+}
+
+/******************************* Base *****************************************/
+static void TIM_Base_SetConfig(TIM_HandleTypeDef *htim)
+{
+  TIM_TypeDef *tim = htim->Instance;
+
+  tim->CR1 = (tim->CR1 & ~TIM_CR1_ARPE) | htim->Init.AutoReloadPreload;
+  tim->ARR = htim->Init.Period;
+  tim->PSC = htim->Init.Prescaler;
+  sim_tim_generate_update(htim);
+}
+
+static HAL_StatusTypeDef sim_tim_handle_init(TIM_HandleTypeDef *htim, void (*msp)(TIM_HandleTypeDef *))
+{
+  if (htim == NULL || sim_tim_get(htim->Instance) == NULL)
+  {
+    return HAL_ERROR;
+  }
+  if (htim->State == HAL_TIM_STATE_RESET)
+  {
+    htim->Lock = HAL_UNLOCKED;
+    msp(htim);
+  }
+  htim->State = HAL_TIM_STATE_BUSY;
+  TIM_Base_SetConfig(htim);
+  sim_tim_channel_state_set_all(htim, HAL_TIM_CHANNEL_STATE_READY);
+  htim->State = HAL_TIM_STATE_READY;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Init(TIM_HandleTypeDef *htim)
+{
+  return sim_tim_handle_init(htim, HAL_TIM_Base_MspInit);
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_DeInit(TIM_HandleTypeDef *htim)
+{
+  htim->State = HAL_TIM_STATE_BUSY;
+  htim->Instance->CR1 &= ~TIM_CR1_CEN;
+  HAL_TIM_Base_MspDeInit(htim);
+  sim_tim_channel_state_set_all(htim, HAL_TIM_CHANNEL_STATE_RESET);
+  htim->State = HAL_TIM_STATE_RESET;
+  return HAL_OK;
+}
+
+__weak void HAL_TIM_Base_MspInit(TIM_HandleTypeDef *htim)
+{
+  UNUSED(htim);
+}
+
+__weak void HAL_TIM_Base_MspDeInit(TIM_HandleTypeDef *htim)
+{
+  UNUSED(htim);
+}
+
+__weak void HAL_TIM_IC_MspInit(TIM_HandleTypeDef *htim)
+{
+  UNUSED(htim);
+}
+
+__weak void HAL_TIM_OC_MspInit(TIM_HandleTypeDef *htim)
+{
+  UNUSED(htim);
+}
+
+__weak void HAL_TIM_PWM_MspInit(TIM_HandleTypeDef *htim)
+{
+  UNUSED(htim);
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Start(TIM_HandleTypeDef *htim)
+{
+  if (htim->State != HAL_TIM_STATE_READY)
+  {
+    return HAL_ERROR;
+  }
+  htim->State = HAL_TIM_STATE_BUSY;
+  sim_tim_enable(htim);
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Stop(TIM_HandleTypeDef *htim)
+{
+  sim_tim_disable(htim);
+  htim->State = HAL_TIM_STATE_READY;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Start_IT(TIM_HandleTypeDef *htim)
+{
+  if (htim->State != HAL_TIM_STATE_READY)
+  {
+    return HAL_ERROR;
+  }
+  htim->State = HAL_TIM_STATE_BUSY;
+  __HAL_TIM_ENABLE_IT(htim, TIM_IT_UPDATE);
+  sim_tim_enable(htim);
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Stop_IT(TIM_HandleTypeDef *htim)
+{
+  __HAL_TIM_DISABLE_IT(htim, TIM_IT_UPDATE);
+  sim_tim_disable(htim);
+  htim->State = HAL_TIM_STATE_READY;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_ConfigClockSource(TIM_HandleTypeDef *htim, TIM_ClockConfigTypeDef *sClockSourceConfig)
+{
+  if (sClockSourceConfig->ClockSource != TIM_CLOCKSOURCE_INTERNAL)
+  {
+    return HAL_ERROR;
+  }
+  htim->State = HAL_TIM_STATE_READY;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIMEx_MasterConfigSynchronization(TIM_HandleTypeDef *htim, TIM_MasterConfigTypeDef *sMasterConfig)
+{
+  htim->Instance->CR2 = (htim->Instance->CR2 & ~TIM_CR2_MMS_MASK) | sMasterConfig->MasterOutputTrigger;
+  htim->Instance->SMCR = (htim->Instance->SMCR & ~TIM_SMCR_MSM) | sMasterConfig->MasterSlaveMode;
+  return HAL_OK;
+}
+
+/******************************* 输入捕获 *************************************/
+HAL_StatusTypeDef HAL_TIM_IC_Init(TIM_HandleTypeDef *htim)
+{
+  return sim_tim_handle_init(htim, HAL_TIM_IC_MspInit);
+}
+
+HAL_StatusTypeDef HAL_TIM_IC_ConfigChannel(TIM_HandleTypeDef *htim, TIM_IC_InitTypeDef *sConfig, uint32_t Channel)
+{
+  TIM_TypeDef *tim = htim->Instance;
+  int ch = (int)(Channel >> 2U);
+  volatile uint32_t *ccmr = (ch < 2) ? &tim->CCMR1 : &tim->CCMR2;
+  uint32_t shift = (ch & 1) * 8U;
+
+  sim_lock();
+  tim->CCER &= ~(0x0FUL << (ch * 4));
+  *ccmr = (*ccmr & ~(0xFFUL << shift)) |
+          ((sConfig->ICSelection | sConfig->ICPrescaler | (sConfig->ICFilter << 4U)) << shift);
+  tim->CCER |= (sConfig->ICPolarity & (TIM_CCER_CC1P | TIM_CCER_CCxNP)) << (ch * 4);
+  sim_unlock();
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_IC_Start(TIM_HandleTypeDef *htim, uint32_t Channel)
+{
+  if (TIM_CHANNEL_STATE_GET(htim, Channel) != HAL_TIM_CHANNEL_STATE_READY)
+  {
+    return HAL_ERROR;
+  }
+  TIM_CHANNEL_STATE_SET(htim, Channel, HAL_TIM_CHANNEL_STATE_BUSY);
+  sim_tim_ccx(htim->Instance, Channel, 1);
+  sim_tim_enable(htim);
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_IC_Stop(TIM_HandleTypeDef *htim, uint32_t Channel)
+{
+  sim_tim_ccx(htim->Instance, Channel, 0);
+  sim_tim_disable(htim);
+  TIM_CHANNEL_STATE_SET(htim, Channel, HAL_TIM_CHANNEL_STATE_READY);
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_IC_Start_IT(TIM_HandleTypeDef *htim, uint32_t Channel)
+{
+  if (TIM_CHANNEL_STATE_GET(htim, Channel) != HAL_TIM_CHANNEL_STATE_READY)
+  {
+    return HAL_ERROR;
+  }
+  TIM_CHANNEL_STATE_SET(htim, Channel, HAL_TIM_CHANNEL_STATE_BUSY);
+  __HAL_TIM_ENABLE_IT(htim, TIM_IT_CC1 << (Channel >> 2U));
+  sim_tim_ccx(htim->Instance, Channel, 1);
+  sim_tim_enable(htim);
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_IC_Stop_IT(TIM_HandleTypeDef *htim, uint32_t Channel)
+{
+  __HAL_TIM_DISABLE_IT(htim, TIM_IT_CC1 << (Channel >> 2U));
+  return HAL_TIM_IC_Stop(htim, Channel);
+}
+
+uint32_t HAL_TIM_ReadCapturedValue(TIM_HandleTypeDef *htim, uint32_t Channel)
+{
+  return *sim_tim_ccr(htim->Instance, (int)(Channel >> 2U));
+}
+
+/******************************* 输出比较 / PWM *******************************/
+HAL_StatusTypeDef HAL_TIM_OC_Init(TIM_HandleTypeDef *htim)
+{
+  return sim_tim_handle_init(htim, HAL_TIM_OC_MspInit);
+}
+
+HAL_StatusTypeDef HAL_TIM_PWM_Init(TIM_HandleTypeDef *htim)
+{
+  return sim_tim_handle_init(htim, HAL_TIM_PWM_MspInit);
+}
+
+HAL_StatusTypeDef HAL_TIM_OC_ConfigChannel(TIM_HandleTypeDef *htim, TIM_OC_InitTypeDef *sConfig, uint32_t Channel)
+{
+  TIM_TypeDef *tim = htim->Instance;
+  int ch = (int)(Channel >> 2U);
+  volatile uint32_t *ccmr = (ch < 2) ? &tim->CCMR1 : &tim->CCMR2;
+  uint32_t shift = (ch & 1) * 8U;
+
+  sim_lock();
+  tim->CCER &= ~(TIM_CCER_CC1E << (ch * 4));
+  *ccmr = (*ccmr & ~(0xFFUL << shift)) | (sConfig->OCMode << shift);
+  tim->CCER = (tim->CCER & ~(TIM_CCER_CC1P << (ch * 4))) | (sConfig->OCPolarity << (ch * 4));
+  *sim_tim_ccr(tim, ch) = sConfig->Pulse;
+  sim_unlock();
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_PWM_ConfigChannel(TIM_HandleTypeDef *htim, TIM_OC_InitTypeDef *sConfig, uint32_t Channel)
+{
+  TIM_TypeDef *tim = htim->Instance;
+  int ch = (int)(Channel >> 2U);
+  volatile uint32_t *ccmr = (ch < 2) ? &tim->CCMR1 : &tim->CCMR2;
+  uint32_t shift = (ch & 1) * 8U;
+
+  HAL_TIM_OC_ConfigChannel(htim, sConfig, Channel);
+  sim_lock();
+  *ccmr |= (TIM_CCMR_OCPE | (sConfig->OCFastMode & 0x04U)) << shift;
+  sim_unlock();
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_OC_Start_IT(TIM_HandleTypeDef *htim, uint32_t Channel)
+{
+  if (TIM_CHANNEL_STATE_GET(htim, Channel) != HAL_TIM_CHANNEL_STATE_READY)
+  {
+    return HAL_ERROR;
+  }
+  TIM_CHANNEL_STATE_SET(htim, Channel, HAL_TIM_CHANNEL_STATE_BUSY);
+  __HAL_TIM_ENABLE_IT(htim, TIM_IT_CC1 << (Channel >> 2U));
+  sim_tim_ccx(htim->Instance, Channel, 1);
+  sim_tim_enable(htim);
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_OC_Stop_IT(TIM_HandleTypeDef *htim, uint32_t Channel)
+{
+  __HAL_TIM_DISABLE_IT(htim, TIM_IT_CC1 << (Channel >> 2U));
+  sim_tim_ccx(htim->Instance, Channel, 0);
+  sim_tim_disable(htim);
+  TIM_CHANNEL_STATE_SET(htim, Channel, HAL_TIM_CHANNEL_STATE_READY);
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_PWM_Start(TIM_HandleTypeDef *htim, uint32_t Channel)
+{
+  if (TIM_CHANNEL_STATE_GET(htim, Channel) != HAL_TIM_CHANNEL_STATE_READY)
+  {
+    return HAL_ERROR;
+  }
+  TIM_CHANNEL_STATE_SET(htim, Channel, HAL_TIM_CHANNEL_STATE_BUSY);
+  sim_tim_ccx(htim->Instance, Channel, 1);
+  sim_tim_enable(htim);
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_PWM_Stop(TIM_HandleTypeDef *htim, uint32_t Channel)
+{
+  sim_tim_ccx(htim->Instance, Channel, 0);
+  sim_tim_disable(htim);
+  TIM_CHANNEL_STATE_SET(htim, Channel, HAL_TIM_CHANNEL_STATE_READY);
+  return HAL_OK;
+}
+
+/******************************* 单脉冲 ***************************************/
+__weak void HAL_TIM_OnePulse_MspInit(TIM_HandleTypeDef *htim)
+{
+  UNUSED(htim);
+}
+
+/* 官方库在这里还会配置两个通道，CubeMX 生成的代码只用它设置 OPM，通道另外配置 */
+HAL_StatusTypeDef HAL_TIM_OnePulse_Init(TIM_HandleTypeDef *htim, uint32_t OnePulseMode)
+{
+  HAL_StatusTypeDef status = sim_tim_handle_init(htim, HAL_TIM_OnePulse_MspInit);
+
+  if (status == HAL_OK)
+  {
+    htim->Instance->CR1 = (htim->Instance->CR1 & ~TIM_CR1_OPM) | OnePulseMode;
+  }
+  return status;
+}
+
+/******************************* 中断 *****************************************/
+HAL_TIM_ActiveChannel HAL_TIM_GetActiveChannel(TIM_HandleTypeDef *htim)
+{
+  return htim->Channel;
+}
+
+static void sim_tim_cc_irq(TIM_HandleTypeDef *htim, uint32_t flag, uint32_t it, int ch)
+{
+  if ((htim->Instance->SR & flag) && (htim->Instance->DIER & it))
+  {
+    sim_tim_clear_flag(htim->Instance, flag);
+    htim->Channel = (HAL_TIM_ActiveChannel)(1U << ch);
+    if (sim_tim_ccs(htim->Instance, ch) != 0U)
+    {
+      HAL_TIM_IC_CaptureCallback(htim);
+    }
+    else
+    {
+      HAL_TIM_OC_DelayElapsedCallback(htim);
+      HAL_TIM_PWM_PulseFinishedCallback(htim);
+    }
+    htim->Channel = HAL_TIM_ACTIVE_CHANNEL_CLEARED;
+  }
+}
+
+void HAL_TIM_IRQHandler(TIM_HandleTypeDef *htim)
+{
+  sim_tim_cc_irq(htim, TIM_FLAG_CC1, TIM_IT_CC1, 0);
+  sim_tim_cc_irq(htim, TIM_FLAG_CC2, TIM_IT_CC2, 1);
+  sim_tim_cc_irq(htim, TIM_FLAG_CC3, TIM_IT_CC3, 2);
+  sim_tim_cc_irq(htim, TIM_FLAG_CC4, TIM_IT_CC4, 3);
+  if ((htim->Instance->SR & TIM_FLAG_UPDATE) && (htim->Instance->DIER & TIM_IT_UPDATE))
+  {
+    sim_tim_clear_flag(htim->Instance, TIM_FLAG_UPDATE);
+    HAL_TIM_PeriodElapsedCallback(htim);
+  }
+}
+
+__weak void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
+{
+  UNUSED(htim);
+}
+
+__weak void HAL_TIM_IC_CaptureCallback(TIM_HandleTypeDef *htim)
+{
+  UNUSED(htim);
+}
+
+__weak void HAL_TIM_OC_DelayElapsedCallback(TIM_HandleTypeDef *htim)
+{
+  UNUSED(htim);
+}
+
+__weak void HAL_TIM_PWM_PulseFinishedCallback(TIM_HandleTypeDef *htim)
+{
+  UNUSED(htim);
+}
+
+static int sim_tim_level(TIM_TypeDef *tim)
+{
+  return (tim->SR & tim->DIER & (TIM_SR_UIF | TIM_SR_CC1IF | TIM_SR_CC2IF | TIM_SR_CC3IF | TIM_SR_CC4IF)) != 0U;
+}
+
+static int sim_tim2_level(void)
+{
+  return sim_tim_level(TIM2);
+}
+
+static int sim_tim3_level(void)
+{
+  return sim_tim_level(TIM3);
+}
+
+void sim_tim_init(void)
+{
+  sim_irq_set_level_source(TIM2_IRQn, sim_tim2_level);
+  sim_irq_set_level_source(TIM3_IRQn, sim_tim3_level);
+}
+
+void sim_tim_poll(uint64_t now)
+{
+  for (int i = 0; i < SIM_TIM_COUNT; i++)
+  {
+    sim_tim_t *st = &sim_tim[i];
+
+    sim_tim_advance(st, now);
+    for (int ch = 0; ch < 4; ch++)
+    {
+      uint32_t ccr = *sim_tim_ccr(st->tim, ch);
+
+      /* 固件直接改 CCMR/CCER 的情况在这里补上 */
+      sim_tim_output_at(st, ch, st->base_cnt, now);
+
+      if (sim_tim_ccs(st->tim, ch) == 0U && ccr != st->last_ccr[ch])
+      {
+        st->last_ccr[ch] = ccr;
+        st->compare_writes[ch]++;
+      }
+    }
+  }
+}
+
+void sim_report_tim(FILE *f)
+{
+  static const char *names[SIM_TIM_COUNT] = { "TIM2", "TIM3" };
+
+  fprintf(f, "  \"tim\": {\n");
+  for (int i = 0; i < SIM_TIM_COUNT; i++)
+  {
+    sim_tim_t *st = &sim_tim[i];
+    TIM_TypeDef *tim = st->tim;
+
+    fprintf(f, "    \"%s\": {\"psc\": %u, \"arr\": %u, \"updates\": %u, \"channels\": [",
+            names[i], (unsigned)tim->PSC, (unsigned)tim->ARR, st->updates);
+    for (int ch = 0; ch < 4; ch++)
+    {
+      uint32_t ccr = *sim_tim_ccr(tim, ch);
+
+      if (sim_tim_ccs(tim, ch) != 0U)
+      {
+        fprintf(f, "%s{\"mode\": \"ic\", \"ccr\": %u, \"captures\": %u, \"overcaptures\": %u}",
+                ch ? ", " : "", (unsigned)ccr, st->captures[ch], st->overcaptures[ch]);
+      }
+      else
+      {
+        fprintf(f, "%s{\"mode\": \"oc\", \"enabled\": %d, \"ccr\": %u, \"duty\": %.4f, \"changes\": %u, "
+                   "\"output_edges\": %u}",
+                ch ? ", " : "", (tim->CCER >> (ch * 4)) & 1U ? 1 : 0, (unsigned)ccr,
+                (double)ccr / ((double)tim->ARR + 1.0), st->compare_writes[ch], st->out_edges[ch]);
+      }
+    }
+    fprintf(f, "]}%s\n", i + 1 < SIM_TIM_COUNT ? "," : "");
+  }
+  fprintf(f, "  },\n");
+}
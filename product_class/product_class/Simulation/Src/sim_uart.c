@@ -0,0 +1,992 @@
+/**
+ ******************************************************************************
+ * @file    sim_uart.c
+ * @brief   仿真 USART1（PTY 对接上位机）与 HAL_UART 接口
+ ******************************************************************************
+ * @attention
+ *
+ * USART1 的 TX/RX 线接到一个伪终端，上位机程序（upper_computer）直接打开
+ * 打印出来的 /dev/pts/N 即可通信。
+ *
+ * 发送：TDR + 移位寄存器两级，按波特率逐字节输出；TX DMA 在 TXE 时
+ * 取下一个字节，所以 CNDTR 比线上已发出的字节数提前两个字节。
+ * 接收：从 PTY 读到的字节按字符时间逐个落到 DR，有 DMA 请求时搬进
+ * 内存，否则置 RXNE，RXNE 未清又来数据则置 ORE；最后一个字节之后
+ * 空闲一个字符时间置 IDLE。每个字节的起始位在 PA10 上产生下降沿，
+ * 配了 EXTI10 就能把固件从 Stop 唤醒；时钟停着时落下的字节丢掉。
+ *
+ * HAL 部分保持官方库的状态机行为（例如 HAL_UART_DMAStop() 会同时终止
+ * 正在进行的 DMA 发送），方便在主机上复现板子上的问题。
+ *
+ ******************************************************************************
+ */
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+/* termios.h 里的输出延时宏和外设寄存器名冲突 */
+#undef CR0
+#undef CR1
+#undef CR2
+#undef CR3
+#include "sim.h"
+
+#define SIM_UART_TX_DMA   3   /* DMA1_Channel4 */
+#define SIM_UART_RX_DMA   4   /* DMA1_Channel5 */
+#define SIM_UART_RXQ      4096U
+
+typedef struct
+{
+  int       master;
+  int       slave;
+  char      path[64];
+  uint64_t  char_cycles;
+
+  /* 接收 */
+  uint8_t   rxq[SIM_UART_RXQ];
+  uint64_t  rxq_t[SIM_UART_RXQ];      /* 字节落到 DR 的时刻 */
+  uint32_t  rxq_head;
+  uint32_t  rxq_tail;
+  uint64_t  rx_line_free;
+  uint64_t  rx_last_t;
+  int       idle_armed;
+
+  /* 发送 */
+  int       tdr_full;
+  uint8_t   tdr;
+  uint64_t  tdr_t;
+  uint64_t  txe_t;
+  uint64_t  dmat_t;
+  int       shifting;
+  uint8_t   shift;
+  uint64_t  shift_end;
+  uint64_t  shift_free;
+
+  /* 统计 */
+  uint64_t  tx_bytes;
+  uint64_t  rx_bytes;
+  uint64_t  tx_dma_starts;
+  uint64_t  tx_busy;
+  uint64_t  tx_aborts;
+  uint64_t  tx_abort_bytes;
+  uint64_t  rx_overruns;
+  uint64_t  rx_idle_events;
+  uint64_t  rx_dropped;
+  uint64_t  rx_lost_stop;    /* Stop 模式下时钟停着，字节丢失 */
+  uint64_t  pty_drops;
+  uint64_t  errors;
+  uint64_t  tx_first_t;
+  uint64_t  tx_last_t;
+} sim_uart_t;
+
+static sim_uart_t sim_uart = { .master = -1, .slave = -1 };
+
+static uint64_t sim_max_u64(uint64_t a, uint64_t b)
+{
+  return a > b ? a : b;
+}
+
+/* 推进发送通路到 now，调用者持锁 */
+static void sim_uart_tx_step(uint64_t now)
+{
+  USART_TypeDef *u = USART1;
+  sim_uart_t *s = &sim_uart;
+  uint8_t out[256];
+  size_t n = 0;
+
+  for (;;)
+  {
+    int progressed = 0;
+
+    if (s->shifting && s->shift_end <= now)
+    {
+      out[n++] = s->shift;
+      s->shifting = 0;
+      s->shift_free = s->shift_end;
+      if (s->tx_bytes == 0U)
+      {
+        s->tx_first_t = s->shift_end;
+      }
+      s->tx_last_t = s->shift_end;
+      s->tx_bytes++;
+      if (!s->tdr_full)
+      {
+        u->SR |= USART_SR_TC;
+      }
+      progressed = 1;
+    }
+    if (!s->shifting && s->tdr_full)
+    {
+      uint64_t start = sim_max_u64(s->tdr_t, s->shift_free);
+
+      s->shift = s->tdr;
+      s->shifting = 1;
+      s->shift_end = start + s->char_cycles;
+      s->tdr_full = 0;
+      s->txe_t = start;
+      u->SR |= USART_SR_TXE;
+      progressed = 1;
+    }
+    if (!s->tdr_full && (u->CR3 & USART_CR3_DMAT) && (u->CR1 & USART_CR1_TE))
+    {
+      uint8_t b;
+
+      if (sim_dma_request_read(SIM_UART_TX_DMA, &b))
+      {
+        s->tdr = b;
+        s->tdr_full = 1;
+        s->tdr_t = sim_max_u64(s->txe_t, s->dmat_t);
+        u->SR &= ~(USART_SR_TXE | USART_SR_TC);
+        progressed = 1;
+      }
+    }
+    if (n == sizeof(out) || (!progressed && n != 0U))
+    {
+      if (s->master >= 0 && write(s->master, out, n) != (ssize_t)n)
+      {
+        s->pty_drops += n;
+      }
+      n = 0;
+    }
+    if (!progressed)
+    {
+      break;
+    }
+  }
+}
+
+/* 推进接收通路到 now，调用者持锁 */
+static void sim_uart_rx_step(uint64_t now)
+{
+  USART_TypeDef *u = USART1;
+  sim_uart_t *s = &sim_uart;
+  uint32_t space = SIM_UART_RXQ - (s->rxq_head - s->rxq_tail);
+
+  if (s->master >= 0 && space != 0U)
+  {
+    uint8_t buf[SIM_UART_RXQ];
+    ssize_t n = read(s->master, buf, space);
+
+    for (ssize_t i = 0; i < n; i++)
+    {
+      uint32_t slot = s->rxq_head++ % SIM_UART_RXQ;
+
+      /* 起始位的下降沿 */
+      sim_gpio_input_edge(GPIOA, GPIO_PIN_10, 0, sim_max_u64(s->rx_line_free, now));
+      s->rx_line_free = sim_max_u64(s->rx_line_free, now) + s->char_cycles;
+      s->rxq[slot] = buf[i];
+      s->rxq_t[slot] = s->rx_line_free;
+    }
+  }
+
+  while (s->rxq_tail != s->rxq_head)
+  {
+    uint32_t slot = s->rxq_tail % SIM_UART_RXQ;
+    uint64_t t = s->rxq_t[slot];
+    uint8_t b = s->rxq[slot];
+
+    if (t > now)
+    {
+      break;
+    }
+    /* 两批数据之间线路空闲超过一个字符：先报 IDLE，让固件处理完再收后面的 */
+    if (s->idle_armed && t > s->rx_last_t + s->char_cycles)
+    {
+      u->SR |= USART_SR_IDLE;
+      s->idle_armed = 0;
+      s->rx_idle_events++;
+      if (u->CR1 & USART_CR1_IDLEIE)
+      {
+        return;
+      }
+    }
+    s->rxq_tail++;
+    s->rx_last_t = t;
+    if ((u->CR1 & (USART_CR1_UE | USART_CR1_RE)) != (USART_CR1_UE | USART_CR1_RE))
+    {
+      s->rx_dropped++;
+      continue;
+    }
+    if (sim_pwr_clock_stopped())
+    {
+      s->rx_lost_stop++;
+      continue;
+    }
+    s->rx_bytes++;
+    s->idle_armed = 1;
+    if ((u->CR3 & USART_CR3_DMAR) && sim_dma_request_write(SIM_UART_RX_DMA, b))
+    {
+      continue;
+    }
+    if (u->SR & USART_SR_RXNE)
+    {
+      u->SR |= USART_SR_ORE;
+      s->rx_overruns++;
+    }
+    else
+    {
+      u->DR = b;
+      u->SR |= USART_SR_RXNE;
+    }
+  }
+
+  if (s->idle_armed && now >= s->rx_last_t + s->char_cycles)
+  {
+    u->SR |= USART_SR_IDLE;
+    s->idle_armed = 0;
+    s->rx_idle_events++;
+  }
+}
+
+static void sim_uart_sync(void)
+{
+  uint64_t now = sim_now();
+
+  sim_lock();
+  sim_uart_tx_step(now);
+  sim_uart_rx_step(now);
+  sim_unlock();
+}
+
+void sim_uart_clear_flag(USART_TypeDef *USARTx, uint32_t flag)
+{
+  /* 写 SR 只对 rc_w0 位有效 */
+  sim_lock();
+  USARTx->SR &= ~(flag & (USART_SR_RXNE | USART_SR_TC));
+  sim_unlock();
+}
+
+void sim_uart_clear_peflag(USART_TypeDef *USARTx)
+{
+  sim_lock();
+  USARTx->SR &= ~(USART_SR_PE | USART_SR_FE | USART_SR_NE | USART_SR_ORE | USART_SR_IDLE | USART_SR_RXNE);
+  sim_unlock();
+}
+
+static uint8_t sim_uart_read_dr(USART_TypeDef *USARTx)
+{
+  uint8_t b;
+
+  sim_lock();
+  b = (uint8_t)USARTx->DR;
+  USARTx->SR &= ~USART_SR_RXNE;
+  sim_unlock();
+  return b;
+}
+
+static void sim_uart_write_dr(USART_TypeDef *USARTx, uint8_t b)
+{
+  uint64_t now = sim_now();
+
+  sim_lock();
+  sim_uart_tx_step(now);
+  if (!sim_uart.tdr_full)
+  {
+    sim_uart.tdr = b;
+    sim_uart.tdr_full = 1;
+    sim_uart.tdr_t = now;
+    USARTx->SR &= ~(USART_SR_TXE | USART_SR_TC);
+    sim_uart_tx_step(now);
+  }
+  sim_unlock();
+}
+
+static void sim_uart_cr(volatile uint32_t *reg, uint32_t set, uint32_t clear)
+{
+  sim_lock();
+  *reg = (*reg & ~clear) | set;
+  if ((set & USART_CR3_DMAT) && reg == &USART1->CR3)
+  {
+    sim_uart.dmat_t = sim_now();
+  }
+  sim_unlock();
+}
+
+/******************************* HAL_UART 内部 *********************************/
+static void UART_EndTxTransfer(UART_HandleTypeDef *huart)
+{
+  sim_uart_cr(&huart->Instance->CR1, 0U, USART_CR1_TXEIE | USART_CR1_TCIE);
+  huart->gState = HAL_UART_STATE_READY;
+}
+
+static void UART_EndRxTransfer(UART_HandleTypeDef *huart)
+{
+  sim_uart_cr(&huart->Instance->CR1, 0U, USART_CR1_RXNEIE | USART_CR1_PEIE);
+  sim_uart_cr(&huart->Instance->CR3, 0U, USART_CR3_EIE);
+  if (huart->ReceptionType == HAL_UART_RECEPTION_TOIDLE)
+  {
+    sim_uart_cr(&huart->Instance->CR1, 0U, USART_CR1_IDLEIE);
+  }
+  huart->RxState = HAL_UART_STATE_READY;
+  huart->ReceptionType = HAL_UART_RECEPTION_STANDARD;
+}
+
+static void sim_uart_error_callback(UART_HandleTypeDef *huart)
+{
+  sim_uart.errors++;
+  HAL_UART_ErrorCallback(huart);
+}
+
+static void UART_DMATransmitCplt(DMA_HandleTypeDef *hdma)
+{
+  UART_HandleTypeDef *huart = (UART_HandleTypeDef *)hdma->Parent;
+
+  if ((hdma->Instance->CCR & DMA_CCR_CIRC) == 0U)
+  {
+    huart->TxXferCount = 0x00U;
+    sim_uart_cr(&huart->Instance->CR3, 0U, USART_CR3_DMAT);
+    sim_uart_cr(&huart->Instance->CR1, USART_CR1_TCIE, 0U);
+  }
+  else
+  {
+    HAL_UART_TxCpltCallback(huart);
+  }
+}
+
+static void UART_DMATxHalfCplt(DMA_HandleTypeDef *hdma)
+{
+  HAL_UART_TxHalfCpltCallback((UART_HandleTypeDef *)hdma->Parent);
+}
+
+static void UART_DMAReceiveCplt(DMA_HandleTypeDef *hdma)
+{
+  UART_HandleTypeDef *huart = (UART_HandleTypeDef *)hdma->Parent;
+
+  if ((hdma->Instance->CCR & DMA_CCR_CIRC) == 0U)
+  {
+    huart->RxXferCount = 0U;
+    sim_uart_cr(&huart->Instance->CR1, 0U, USART_CR1_PEIE);
+    sim_uart_cr(&huart->Instance->CR3, 0U, USART_CR3_EIE | USART_CR3_DMAR);
+    huart->RxState = HAL_UART_STATE_READY;
+    if (huart->ReceptionType == HAL_UART_RECEPTION_TOIDLE)
+    {
+      sim_uart_cr(&huart->Instance->CR1, 0U, USART_CR1_IDLEIE);
+    }
+  }
+  huart->RxEventType = HAL_UART_RXEVENT_TC;
+  if (huart->ReceptionType == HAL_UART_RECEPTION_TOIDLE)
+  {
+    HAL_UARTEx_RxEventCallback(huart, huart->RxXferSize);
+  }
+  else
+  {
+    HAL_UART_RxCpltCallback(huart);
+  }
+}
+
+static void UART_DMARxHalfCplt(DMA_HandleTypeDef *hdma)
+{
+  UART_HandleTypeDef *huart = (UART_HandleTypeDef *)hdma->Parent;
+
+  huart->RxEventType = HAL_UART_RXEVENT_HT;
+  if (huart->ReceptionType == HAL_UART_RECEPTION_TOIDLE)
+  {
+    HAL_UARTEx_RxEventCallback(huart, huart->RxXferSize / 2U);
+  }
+  else
+  {
+    HAL_UART_RxHalfCpltCallback(huart);
+  }
+}
+
+static void UART_DMAError(DMA_HandleTypeDef *hdma)
+{
+  UART_HandleTypeDef *huart = (UART_HandleTypeDef *)hdma->Parent;
+
+  if ((huart->Instance->CR3 & USART_CR3_DMAT) && huart->gState == HAL_UART_STATE_BUSY_TX)
+  {
+    huart->TxXferCount = 0x00U;
+    UART_EndTxTransfer(huart);
+  }
+  if ((huart->Instance->CR3 & USART_CR3_DMAR) && huart->RxState == HAL_UART_STATE_BUSY_RX)
+  {
+    huart->RxXferCount = 0x00U;
+    UART_EndRxTransfer(huart);
+  }
+  huart->ErrorCode |= HAL_UART_ERROR_DMA;
+  sim_uart_error_callback(huart);
+}
+
+static void UART_DMAAbortOnError(DMA_HandleTypeDef *hdma)
+{
+  UART_HandleTypeDef *huart = (UART_HandleTypeDef *)hdma->Parent;
+
+  huart->RxXferCount = 0x00U;
+  huart->TxXferCount = 0x00U;
+  sim_uart_error_callback(huart);
+}
+
+static HAL_StatusTypeDef UART_Start_Receive_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size)
+{
+  huart->pRxBuffPtr = pData;
+  huart->RxXferSize = Size;
+  huart->ErrorCode = HAL_UART_ERROR_NONE;
+  huart->RxState = HAL_UART_STATE_BUSY_RX;
+
+  huart->hdmarx->XferCpltCallback = UART_DMAReceiveCplt;
+  huart->hdmarx->XferHalfCpltCallback = UART_DMARxHalfCplt;
+  huart->hdmarx->XferErrorCallback = UART_DMAError;
+  huart->hdmarx->XferAbortCallback = NULL;
+  sim_dma_start(huart->hdmarx, pData, Size);
+
+  __HAL_UART_CLEAR_OREFLAG(huart);
+  __HAL_UNLOCK(huart);
+  if (huart->Init.Parity != UART_PARITY_NONE)
+  {
+    sim_uart_cr(&huart->Instance->CR1, USART_CR1_PEIE, 0U);
+  }
+  sim_uart_cr(&huart->Instance->CR3, USART_CR3_EIE | USART_CR3_DMAR, 0U);
+  return HAL_OK;
+}
+
+static HAL_StatusTypeDef UART_WaitOnFlagUntilTimeout(UART_HandleTypeDef *huart, uint32_t Flag, FlagStatus Status,
+                                                     uint32_t Tickstart, uint32_t Timeout)
+{
+  for (;;)
+  {
+    sim_uart_sync();
+    if ((__HAL_UART_GET_FLAG(huart, Flag) ? SET : RESET) != Status)
+    {
+      return HAL_OK;
+    }
+    if (Timeout != HAL_MAX_DELAY && ((Timeout == 0U) || ((HAL_GetTick() - Tickstart) > Timeout)))
+    {
+      sim_uart_cr(&huart->Instance->CR1, 0U, USART_CR1_RXNEIE | USART_CR1_PEIE | USART_CR1_TXEIE);
+      sim_uart_cr(&huart->Instance->CR3, 0U, USART_CR3_EIE);
+      huart->gState = HAL_UART_STATE_READY;
+      huart->RxState = HAL_UART_STATE_READY;
+      __HAL_UNLOCK(huart);
+      return HAL_TIMEOUT;
+    }
+  }
+}
+
+/******************************* HAL_UART *************************************/
+HAL_StatusTypeDef HAL_UART_Init(UART_HandleTypeDef *huart)
+{
+  uint32_t pclk;
+
+  if (huart == NULL || huart->Instance != USART1)
+  {
+    return HAL_ERROR;
+  }
+  if (huart->gState == HAL_UART_STATE_RESET)
+  {
+    huart->Lock = HAL_UNLOCKED;
+    HAL_UART_MspInit(huart);
+  }
+  huart->gState = HAL_UART_STATE_BUSY;
+  pclk = HAL_RCC_GetPCLK2Freq();
+  sim_lock();
+  huart->Instance->CR1 &= ~USART_CR1_UE;
+  huart->Instance->BRR = (pclk + huart->Init.BaudRate / 2U) / huart->Init.BaudRate;
+  huart->Instance->CR1 = (huart->Instance->CR1 & ~(USART_CR1_TE | USART_CR1_RE)) | huart->Init.Mode;
+  huart->Instance->CR1 |= USART_CR1_UE;
+  sim_uart.char_cycles = (uint64_t)huart->Instance->BRR * 10U * (SIM_CORE_CLOCK_HZ / pclk);
+  sim_unlock();
+  huart->ErrorCode = HAL_UART_ERROR_NONE;
+  huart->gState = HAL_UART_STATE_READY;
+  huart->RxState = HAL_UART_STATE_READY;
+  huart->ReceptionType = HAL_UART_RECEPTION_STANDARD;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_DeInit(UART_HandleTypeDef *huart)
+{
+  if (huart == NULL)
+  {
+    return HAL_ERROR;
+  }
+  huart->gState = HAL_UART_STATE_BUSY;
+  sim_uart_cr(&huart->Instance->CR1, 0U, USART_CR1_UE);
+  HAL_UART_MspDeInit(huart);
+  huart->ErrorCode = HAL_UART_ERROR_NONE;
+  huart->gState = HAL_UART_STATE_RESET;
+  huart->RxState = HAL_UART_STATE_RESET;
+  huart->ReceptionType = HAL_UART_RECEPTION_STANDARD;
+  __HAL_UNLOCK(huart);
+  return HAL_OK;
+}
+
+__weak void HAL_UART_MspInit(UART_HandleTypeDef *huart)
+{
+  UNUSED(huart);
+}
+
+__weak void HAL_UART_MspDeInit(UART_HandleTypeDef *huart)
+{
+  UNUSED(huart);
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size, uint32_t Timeout)
+{
+  uint32_t tickstart;
+
+  if (huart->gState != HAL_UART_STATE_READY)
+  {
+    return HAL_BUSY;
+  }
+  if (pData == NULL || Size == 0U)
+  {
+    return HAL_ERROR;
+  }
+  __HAL_LOCK(huart);
+  huart->ErrorCode = HAL_UART_ERROR_NONE;
+  huart->gState = HAL_UART_STATE_BUSY_TX;
+  tickstart = HAL_GetTick();
+  huart->TxXferSize = Size;
+  huart->TxXferCount = Size;
+  __HAL_UNLOCK(huart);
+
+  while (huart->TxXferCount > 0U)
+  {
+    if (UART_WaitOnFlagUntilTimeout(huart, UART_FLAG_TXE, RESET, tickstart, Timeout) != HAL_OK)
+    {
+      return HAL_TIMEOUT;
+    }
+    sim_uart_write_dr(huart->Instance, *pData++);
+    huart->TxXferCount--;
+  }
+  if (UART_WaitOnFlagUntilTimeout(huart, UART_FLAG_TC, RESET, tickstart, Timeout) != HAL_OK)
+  {
+    return HAL_TIMEOUT;
+  }
+  huart->gState = HAL_UART_STATE_READY;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Transmit_DMA(UART_HandleTypeDef *huart, const uint8_t *pData, uint16_t Size)
+{
+  if (huart->gState != HAL_UART_STATE_READY)
+  {
+    sim_uart.tx_busy++;
+    return HAL_BUSY;
+  }
+  if (pData == NULL || Size == 0U)
+  {
+    return HAL_ERROR;
+  }
+  __HAL_LOCK(huart);
+  huart->pTxBuffPtr = pData;
+  huart->TxXferSize = Size;
+  huart->TxXferCount = Size;
+  huart->ErrorCode = HAL_UART_ERROR_NONE;
+  huart->gState = HAL_UART_STATE_BUSY_TX;
+
+  huart->hdmatx->XferCpltCallback = UART_DMATransmitCplt;
+  huart->hdmatx->XferHalfCpltCallback = UART_DMATxHalfCplt;
+  huart->hdmatx->XferErrorCallback = UART_DMAError;
+  huart->hdmatx->XferAbortCallback = NULL;
+  sim_dma_start(huart->hdmatx, (uint8_t *)pData, Size);
+
+  __HAL_UART_CLEAR_FLAG(huart, UART_FLAG_TC);
+  __HAL_UNLOCK(huart);
+  sim_uart_cr(&huart->Instance->CR3, USART_CR3_DMAT, 0U);
+  sim_uart.tx_dma_starts++;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_Receive_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size)
+{
+  if (huart->RxState != HAL_UART_STATE_READY)
+  {
+    return HAL_BUSY;
+  }
+  if (pData == NULL || Size == 0U)
+  {
+    return HAL_ERROR;
+  }
+  __HAL_LOCK(huart);
+  huart->ReceptionType = HAL_UART_RECEPTION_STANDARD;
+  return UART_Start_Receive_DMA(huart, pData, Size);
+}
+
+HAL_StatusTypeDef HAL_UARTEx_ReceiveToIdle_DMA(UART_HandleTypeDef *huart, uint8_t *pData, uint16_t Size)
+{
+  HAL_StatusTypeDef status;
+
+  if (huart->RxState != HAL_UART_STATE_READY)
+  {
+    return HAL_BUSY;
+  }
+  if (pData == NULL || Size == 0U)
+  {
+    return HAL_ERROR;
+  }
+  __HAL_LOCK(huart);
+  huart->ReceptionType = HAL_UART_RECEPTION_TOIDLE;
+  status = UART_Start_Receive_DMA(huart, pData, Size);
+  if (status == HAL_OK && huart->ReceptionType == HAL_UART_RECEPTION_TOIDLE)
+  {
+    __HAL_UART_CLEAR_IDLEFLAG(huart);
+    sim_uart_cr(&huart->Instance->CR1, USART_CR1_IDLEIE, 0U);
+  }
+  else
+  {
+    status = HAL_ERROR;
+  }
+  return status;
+}
+
+HAL_UART_RxEventTypeTypeDef HAL_UARTEx_GetRxEventType(UART_HandleTypeDef *huart)
+{
+  return huart->RxEventType;
+}
+
+static void sim_uart_count_tx_abort(UART_HandleTypeDef *huart)
+{
+  sim_uart.tx_aborts++;
+  sim_uart.tx_abort_bytes += huart->hdmatx->Instance->CNDTR;
+}
+
+HAL_StatusTypeDef HAL_UART_DMAStop(UART_HandleTypeDef *huart)
+{
+  if ((huart->Instance->CR3 & USART_CR3_DMAT) && huart->gState == HAL_UART_STATE_BUSY_TX)
+  {
+    sim_uart_cr(&huart->Instance->CR3, 0U, USART_CR3_DMAT);
+    if (huart->hdmatx != NULL)
+    {
+      sim_uart_count_tx_abort(huart);
+      HAL_DMA_Abort(huart->hdmatx);
+    }
+    UART_EndTxTransfer(huart);
+  }
+  if ((huart->Instance->CR3 & USART_CR3_DMAR) && huart->RxState == HAL_UART_STATE_BUSY_RX)
+  {
+    sim_uart_cr(&huart->Instance->CR3, 0U, USART_CR3_DMAR);
+    if (huart->hdmarx != NULL)
+    {
+      HAL_DMA_Abort(huart->hdmarx);
+    }
+    UART_EndRxTransfer(huart);
+  }
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_AbortTransmit(UART_HandleTypeDef *huart)
+{
+  sim_uart_cr(&huart->Instance->CR1, 0U, USART_CR1_TXEIE | USART_CR1_TCIE);
+  if (huart->Instance->CR3 & USART_CR3_DMAT)
+  {
+    sim_uart_cr(&huart->Instance->CR3, 0U, USART_CR3_DMAT);
+    if (huart->hdmatx != NULL)
+    {
+      huart->hdmatx->XferAbortCallback = NULL;
+      sim_uart_count_tx_abort(huart);
+      HAL_DMA_Abort(huart->hdmatx);
+    }
+  }
+  huart->TxXferCount = 0x00U;
+  huart->gState = HAL_UART_STATE_READY;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_UART_AbortReceive(UART_HandleTypeDef *huart)
+{
+  sim_uart_cr(&huart->Instance->CR1, 0U, USART_CR1_RXNEIE | USART_CR1_PEIE);
+  sim_uart_cr(&huart->Instance->CR3, 0U, USART_CR3_EIE);
+  if (huart->ReceptionType == HAL_UART_RECEPTION_TOIDLE)
+  {
+    sim_uart_cr(&huart->Instance->CR1, 0U, USART_CR1_IDLEIE);
+  }
+  if (huart->Instance->CR3 & USART_CR3_DMAR)
+  {
+    sim_uart_cr(&huart->Instance->CR3, 0U, USART_CR3_DMAR);
+    if (huart->hdmarx != NULL)
+    {
+      huart->hdmarx->XferAbortCallback = NULL;
+      HAL_DMA_Abort(huart->hdmarx);
+    }
+  }
+  huart->RxXferCount = 0x00U;
+  __HAL_UART_CLEAR_OREFLAG(huart);
+  huart->RxState = HAL_UART_STATE_READY;
+  huart->ReceptionType = HAL_UART_RECEPTION_STANDARD;
+  return HAL_OK;
+}
+
+HAL_UART_StateTypeDef HAL_UART_GetState(UART_HandleTypeDef *huart)
+{
+  return (HAL_UART_StateTypeDef)(huart->gState | huart->RxState);
+}
+
+uint32_t HAL_UART_GetError(UART_HandleTypeDef *huart)
+{
+  return huart->ErrorCode;
+}
+
+static HAL_StatusTypeDef UART_Receive_IT(UART_HandleTypeDef *huart)
+{
+  if (huart->RxState != HAL_UART_STATE_BUSY_RX)
+  {
+    return HAL_BUSY;
+  }
+  *huart->pRxBuffPtr++ = sim_uart_read_dr(huart->Instance);
+  if (--huart->RxXferCount == 0U)
+  {
+    sim_uart_cr(&huart->Instance->CR1, 0U, USART_CR1_RXNEIE | USART_CR1_PEIE);
+    sim_uart_cr(&huart->Instance->CR3, 0U, USART_CR3_EIE);
+    huart->RxState = HAL_UART_STATE_READY;
+    huart->RxEventType = HAL_UART_RXEVENT_TC;
+    if (huart->ReceptionType == HAL_UART_RECEPTION_TOIDLE)
+    {
+      huart->ReceptionType = HAL_UART_RECEPTION_STANDARD;
+      sim_uart_cr(&huart->Instance->CR1, 0U, USART_CR1_IDLEIE);
+      HAL_UARTEx_RxEventCallback(huart, huart->RxXferSize);
+    }
+    else
+    {
+      HAL_UART_RxCpltCallback(huart);
+    }
+  }
+  return HAL_OK;
+}
+
+void HAL_UART_IRQHandler(UART_HandleTypeDef *huart)
+{
+  uint32_t isrflags = huart->Instance->SR;
+  uint32_t cr1its = huart->Instance->CR1;
+  uint32_t cr3its = huart->Instance->CR3;
+  uint32_t errorflags = isrflags & (USART_SR_PE | USART_SR_FE | USART_SR_ORE | USART_SR_NE);
+
+  if (errorflags == 0U)
+  {
+    if ((isrflags & USART_SR_RXNE) && (cr1its & USART_CR1_RXNEIE))
+    {
+      UART_Receive_IT(huart);
+      return;
+    }
+  }
+
+  if (errorflags != 0U && ((cr3its & USART_CR3_EIE) || (cr1its & (USART_CR1_RXNEIE | USART_CR1_PEIE))))
+  {
+    if ((isrflags & USART_SR_PE) && (cr1its & USART_CR1_PEIE))
+    {
+      huart->ErrorCode |= HAL_UART_ERROR_PE;
+    }
+    if ((isrflags & USART_SR_NE) && (cr3its & USART_CR3_EIE))
+    {
+      huart->ErrorCode |= HAL_UART_ERROR_NE;
+    }
+    if ((isrflags & USART_SR_FE) && (cr3its & USART_CR3_EIE))
+    {
+      huart->ErrorCode |= HAL_UART_ERROR_FE;
+    }
+    if ((isrflags & USART_SR_ORE) && ((cr1its & USART_CR1_RXNEIE) || (cr3its & USART_CR3_EIE)))
+    {
+      huart->ErrorCode |= HAL_UART_ERROR_ORE;
+    }
+    if (huart->ErrorCode != HAL_UART_ERROR_NONE)
+    {
+      uint32_t dmarequest;
+
+      if ((isrflags & USART_SR_RXNE) && (cr1its & USART_CR1_RXNEIE))
+      {
+        UART_Receive_IT(huart);
+      }
+      dmarequest = huart->Instance->CR3 & USART_CR3_DMAR;
+      if ((huart->ErrorCode & HAL_UART_ERROR_ORE) || dmarequest)
+      {
+        UART_EndRxTransfer(huart);
+        if (huart->Instance->CR3 & USART_CR3_DMAR)
+        {
+          sim_uart_cr(&huart->Instance->CR3, 0U, USART_CR3_DMAR);
+          if (huart->hdmarx != NULL)
+          {
+            huart->hdmarx->XferAbortCallback = UART_DMAAbortOnError;
+            if (HAL_DMA_Abort_IT(huart->hdmarx) != HAL_OK)
+            {
+              huart->hdmarx->XferAbortCallback(huart->hdmarx);
+            }
+          }
+          else
+          {
+            sim_uart_error_callback(huart);
+          }
+        }
+        else
+        {
+          sim_uart_error_callback(huart);
+        }
+      }
+      else
+      {
+        sim_uart_error_callback(huart);
+        huart->ErrorCode = HAL_UART_ERROR_NONE;
+      }
+    }
+    return;
+  }
+
+  if (huart->ReceptionType == HAL_UART_RECEPTION_TOIDLE &&
+      (isrflags & USART_SR_IDLE) && (cr1its & USART_CR1_IDLEIE))
+  {
+    __HAL_UART_CLEAR_IDLEFLAG(huart);
+    if (huart->Instance->CR3 & USART_CR3_DMAR)
+    {
+      uint16_t nb_remaining_rx_data = (uint16_t)__HAL_DMA_GET_COUNTER(huart->hdmarx);
+
+      if (nb_remaining_rx_data > 0U && nb_remaining_rx_data < huart->RxXferSize)
+      {
+        huart->RxXferCount = nb_remaining_rx_data;
+        if ((huart->hdmarx->Instance->CCR & DMA_CCR_CIRC) == 0U)
+        {
+          sim_uart_cr(&huart->Instance->CR1, 0U, USART_CR1_PEIE);
+          sim_uart_cr(&huart->Instance->CR3, 0U, USART_CR3_EIE | USART_CR3_DMAR);
+          huart->RxState = HAL_UART_STATE_READY;
+          huart->ReceptionType = HAL_UART_RECEPTION_STANDARD;
+          sim_uart_cr(&huart->Instance->CR1, 0U, USART_CR1_IDLEIE);
+          HAL_DMA_Abort(huart->hdmarx);
+        }
+        huart->RxEventType = HAL_UART_RXEVENT_IDLE;
+        HAL_UARTEx_RxEventCallback(huart, (uint16_t)(huart->RxXferSize - huart->RxXferCount));
+      }
+      return;
+    }
+    else
+    {
+      uint16_t nb_rx_data = (uint16_t)(huart->RxXferSize - huart->RxXferCount);
+
+      if (huart->RxXferCount > 0U && nb_rx_data > 0U)
+      {
+        sim_uart_cr(&huart->Instance->CR1, 0U, USART_CR1_RXNEIE | USART_CR1_PEIE | USART_CR1_IDLEIE);
+        sim_uart_cr(&huart->Instance->CR3, 0U, USART_CR3_EIE);
+        huart->RxState = HAL_UART_STATE_READY;
+        huart->ReceptionType = HAL_UART_RECEPTION_STANDARD;
+        huart->RxEventType = HAL_UART_RXEVENT_IDLE;
+        HAL_UARTEx_RxEventCallback(huart, nb_rx_data);
+      }
+      return;
+    }
+  }
+
+  if ((isrflags & USART_SR_TC) && (cr1its & USART_CR1_TCIE))
+  {
+    /* UART_EndTransmit_IT */
+    sim_uart_cr(&huart->Instance->CR1, 0U, USART_CR1_TCIE);
+    huart->gState = HAL_UART_STATE_READY;
+    HAL_UART_TxCpltCallback(huart);
+    return;
+  }
+}
+
+__weak void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+  UNUSED(huart);
+}
+
+__weak void HAL_UART_TxHalfCpltCallback(UART_HandleTypeDef *huart)
+{
+  UNUSED(huart);
+}
+
+__weak void HAL_UART_RxCpltCallback(UART_HandleTypeDef *huart)
+{
+  UNUSED(huart);
+}
+
+__weak void HAL_UART_RxHalfCpltCallback(UART_HandleTypeDef *huart)
+{
+  UNUSED(huart);
+}
+
+__weak void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+  UNUSED(huart);
+}
+
+__weak void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
+{
+  UNUSED(huart);
+  UNUSED(Size);
+}
+
+/******************************* 仿真内核 *************************************/
+static int sim_usart1_level(void)
+{
+  uint32_t sr = USART1->SR;
+  uint32_t cr1 = USART1->CR1;
+  uint32_t cr3 = USART1->CR3;
+
+  return ((sr & USART_SR_RXNE) && (cr1 & USART_CR1_RXNEIE)) ||
+         ((sr & USART_SR_ORE) && (cr1 & USART_CR1_RXNEIE)) ||
+         ((sr & USART_SR_TC) && (cr1 & USART_CR1_TCIE)) ||
+         ((sr & USART_SR_TXE) && (cr1 & USART_CR1_TXEIE)) ||
+         ((sr & USART_SR_IDLE) && (cr1 & USART_CR1_IDLEIE)) ||
+         ((sr & USART_SR_PE) && (cr1 & USART_CR1_PEIE)) ||
+         ((sr & (USART_SR_FE | USART_SR_NE | USART_SR_ORE)) && (cr3 & USART_CR3_EIE));
+}
+
+void sim_uart_init(void)
+{
+  struct termios tio;
+  const char *name;
+
+  USART1->SR = USART_SR_TXE | USART_SR_TC;
+  sim_uart.char_cycles = SIM_CORE_CLOCK_HZ / 11520U;
+  sim_irq_set_level_source(USART1_IRQn, sim_usart1_level);
+
+  sim_uart.master = posix_openpt(O_RDWR | O_NOCTTY);
+  if (sim_uart.master < 0 || grantpt(sim_uart.master) != 0 || unlockpt(sim_uart.master) != 0 ||
+      (name = ptsname(sim_uart.master)) == NULL)
+  {
+    fprintf(stderr, "sim: cannot create pty for USART1: %s\n", strerror(errno));
+    exit(1);
+  }
+  snprintf(sim_uart.path, sizeof(sim_uart.path), "%s", name);
+
+  /* 自己保留一个从端，上位机没连上时主端读写也不会报 EIO */
+  sim_uart.slave = open(sim_uart.path, O_RDWR | O_NOCTTY);
+  if (sim_uart.slave >= 0 && tcgetattr(sim_uart.slave, &tio) == 0)
+  {
+    cfmakeraw(&tio);
+    cfsetspeed(&tio, B115200);
+    tcsetattr(sim_uart.slave, TCSANOW, &tio);
+  }
+  fcntl(sim_uart.master, F_SETFL, fcntl(sim_uart.master, F_GETFL) | O_NONBLOCK);
+
+  if (sim_opt.pty_link != NULL)
+  {
+    unlink(sim_opt.pty_link);
+    if (symlink(sim_uart.path, sim_opt.pty_link) != 0)
+    {
+      fprintf(stderr, "sim: cannot link %s -> %s: %s\n", sim_opt.pty_link, sim_uart.path, strerror(errno));
+    }
+  }
+  fprintf(stderr, "sim: USART1 on %s%s%s\n", sim_uart.path,
+          sim_opt.pty_link ? " -> " : "", sim_opt.pty_link ? sim_opt.pty_link : "");
+}
+
+void sim_uart_poll(uint64_t now)
+{
+  sim_uart_tx_step(now);
+  sim_uart_rx_step(now);
+}
+
+void sim_report_uart(FILE *f)
+{
+  sim_uart_t *s = &sim_uart;
+  double span = (s->tx_last_t > s->tx_first_t) ? (double)(s->tx_last_t - s->tx_first_t) / SIM_CORE_CLOCK_HZ : 0.0;
+
+  fprintf(f, "  \"uart\": {\n");
+  fprintf(f, "    \"pty\": \"%s\",\n", s->path);
+  fprintf(f, "    \"char_cycles\": %llu,\n", (unsigned long long)s->char_cycles);
+  fprintf(f, "    \"tx_bytes\": %llu,\n", (unsigned long long)s->tx_bytes);
+  fprintf(f, "    \"tx_bytes_per_s\": %.1f,\n", span > 0.0 ? (double)s->tx_bytes / span : 0.0);
+  fprintf(f, "    \"tx_dma_starts\": %llu,\n", (unsigned long long)s->tx_dma_starts);
+  fprintf(f, "    \"tx_busy\": %llu,\n", (unsigned long long)s->tx_busy);
+  fprintf(f, "    \"tx_aborts\": %llu,\n", (unsigned long long)s->tx_aborts);
+  fprintf(f, "    \"tx_abort_bytes\": %llu,\n", (unsigned long long)s->tx_abort_bytes);
+  fprintf(f, "    \"rx_bytes\": %llu,\n", (unsigned long long)s->rx_bytes);
+  fprintf(f, "    \"rx_dma_bytes\": %u,\n", sim_dma_chan[SIM_UART_RX_DMA].bytes);
+  fprintf(f, "    \"rx_idle_events\": %llu,\n", (unsigned long long)s->rx_idle_events);
+  fprintf(f, "    \"rx_overruns\": %llu,\n", (unsigned long long)s->rx_overruns);
+  fprintf(f, "    \"rx_dropped\": %llu,\n", (unsigned long long)s->rx_dropped);
+  fprintf(f, "    \"rx_lost_stop\": %llu,\n", (unsigned long long)s->rx_lost_stop);
+  fprintf(f, "    \"error_callbacks\": %llu,\n", (unsigned long long)s->errors);
+  fprintf(f, "    \"pty_drops\": %llu\n", (unsigned long long)s->pty_drops);
+  fprintf(f, "  },\n");
+}
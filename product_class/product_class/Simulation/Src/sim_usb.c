@@ -0,0 +1,333 @@
+/**
+ ******************************************************************************
+ * @file    sim_usb.c
+ * @brief   仿真 USB 全速 CDC 数据端点（第二个 PTY 对接上位机）
+ ******************************************************************************
+ * @attention
+ *
+ * 只模拟 CDC 类提供给 usbd_cdc_if.c 的接口（usbd_cdc.h 里的几个函数和
+ * fops 回调），枚举和控制端点不模拟：MX_USB_DEVICE_Init 直接当作已经
+ * 枚举完成、主机已经打开串口（DTR 置位）。--no-usb 时当作没插线，
+ * 设备一直停在默认状态，PTY 上的数据不收也不发。
+ *
+ * 总线：批量端点每包 64 字节，一帧（1ms）最多 19 包，OUT 和 IN 共用。
+ * OUT：固件 ReceivePacket 之后才从 PTY 取下一包，没准备好就一直 NAK
+ *      （数据留在 PTY 里）；一包到达后在 USB 中断里交给 fops->Receive。
+ * IN： TransmitPacket 的数据按包时间逐包写到 PTY，长度是 64 的整数倍时
+ *      再补一个零长度包，全部发完在 USB 中断里清 TxState（对应 DataIn）。
+ *
+ ******************************************************************************
+ */
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+/* termios.h 里的输出延时宏和外设寄存器名冲突 */
+#undef CR0
+#undef CR1
+#undef CR2
+#undef CR3
+#include "sim.h"
+#include "usbd_cdc_if.h"
+
+#define SIM_USB_PACKET_SIZE    CDC_DATA_FS_MAX_PACKET_SIZE
+#define SIM_USB_PACKET_CYCLES  (SIM_MS(1) / 19U)
+
+typedef struct
+{
+  int       master;
+  int       slave;
+  char      path[64];
+  uint64_t  bus_free;        /* 总线下一个空闲时刻 */
+
+  /* OUT 端点 */
+  int       out_armed;       /* 固件准备好了接收缓冲区 */
+  int       out_ready;       /* 一包已经到达，等 USB 中断交给固件 */
+  uint8_t   out_buf[SIM_USB_PACKET_SIZE];
+  uint32_t  out_len;
+
+  /* IN 端点 */
+  const uint8_t *in_buf;
+  uint32_t  in_len;
+  uint32_t  in_off;
+  int       in_active;
+  int       in_zlp;          /* 还要补一个零长度包 */
+  int       in_done;         /* 发完了，等 USB 中断清 TxState */
+
+  /* 统计 */
+  uint64_t  out_packets;
+  uint64_t  in_packets;
+  uint64_t  zlps;
+  uint64_t  rx_bytes;
+  uint64_t  tx_bytes;
+  uint64_t  transfers;
+  uint64_t  tx_busy;
+  uint64_t  pty_drops;
+  uint64_t  tx_first_t;
+  uint64_t  tx_last_t;
+} sim_usb_t;
+
+static sim_usb_t sim_usb = { .master = -1, .slave = -1 };
+static USBD_CDC_HandleTypeDef sim_cdc;
+
+USBD_HandleTypeDef hUsbDeviceFS;
+PCD_HandleTypeDef hpcd_USB_FS;
+
+static uint64_t sim_usb_packet(uint64_t now)
+{
+  sim_usb.bus_free = (sim_usb.bus_free > now ? sim_usb.bus_free : now) + SIM_USB_PACKET_CYCLES;
+  return sim_usb.bus_free;
+}
+
+/******************************* CDC 类接口 ***********************************/
+uint8_t USBD_CDC_SetTxBuffer(USBD_HandleTypeDef *pdev, uint8_t *pbuff, uint16_t length)
+{
+  USBD_CDC_HandleTypeDef *hcdc = (USBD_CDC_HandleTypeDef *)pdev->pClassData;
+
+  hcdc->TxBuffer = pbuff;
+  hcdc->TxLength = length;
+  return USBD_OK;
+}
+
+uint8_t USBD_CDC_SetRxBuffer(USBD_HandleTypeDef *pdev, uint8_t *pbuff)
+{
+  USBD_CDC_HandleTypeDef *hcdc = (USBD_CDC_HandleTypeDef *)pdev->pClassData;
+
+  hcdc->RxBuffer = pbuff;
+  return USBD_OK;
+}
+
+uint8_t USBD_CDC_ReceivePacket(USBD_HandleTypeDef *pdev)
+{
+  if (pdev->pClassData == NULL)
+  {
+    return USBD_FAIL;
+  }
+  sim_lock();
+  sim_usb.out_armed = 1;
+  sim_unlock();
+  return USBD_OK;
+}
+
+uint8_t USBD_CDC_TransmitPacket(USBD_HandleTypeDef *pdev)
+{
+  USBD_CDC_HandleTypeDef *hcdc = (USBD_CDC_HandleTypeDef *)pdev->pClassData;
+  uint8_t ret = USBD_OK;
+
+  if (hcdc == NULL)
+  {
+    return USBD_FAIL;
+  }
+  sim_lock();
+  if (hcdc->TxState != 0U)
+  {
+    sim_usb.tx_busy++;
+    ret = USBD_BUSY;
+  }
+  else
+  {
+    hcdc->TxState = 1U;
+    sim_usb.in_buf = hcdc->TxBuffer;
+    sim_usb.in_len = hcdc->TxLength;
+    sim_usb.in_off = 0U;
+    sim_usb.in_zlp = hcdc->TxLength != 0U && (hcdc->TxLength % SIM_USB_PACKET_SIZE) == 0U;
+    sim_usb.in_active = 1;
+    sim_usb.transfers++;
+  }
+  sim_unlock();
+  return ret;
+}
+
+/* 对应 USB 设备库初始化加上枚举完成：SET_CONFIGURATION 里调用 fops->Init
+ * 并准备 OUT 端点，随后主机打开串口发 SET_CONTROL_LINE_STATE */
+void MX_USB_DEVICE_Init(void)
+{
+  USBD_SetupReqTypedef req = { 0x21U, CDC_SET_CONTROL_LINE_STATE, 0x0003U, 0U, 0U };
+
+  hpcd_USB_FS.pData = &hUsbDeviceFS;
+  hUsbDeviceFS.pData = &hpcd_USB_FS;
+  hUsbDeviceFS.pUserData = &USBD_Interface_fops_FS;
+  HAL_NVIC_SetPriority(USB_LP_CAN1_RX0_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(USB_LP_CAN1_RX0_IRQn);
+
+  memset(&sim_cdc, 0, sizeof(sim_cdc));
+  hUsbDeviceFS.pClassData = &sim_cdc;
+  if (sim_opt.no_usb)
+  {
+    hUsbDeviceFS.dev_state = USBD_STATE_DEFAULT;
+    return;
+  }
+  hUsbDeviceFS.dev_config = 1U;
+  hUsbDeviceFS.dev_state = USBD_STATE_CONFIGURED;
+  USBD_Interface_fops_FS.Init();
+  USBD_CDC_ReceivePacket(&hUsbDeviceFS);
+  USBD_Interface_fops_FS.Control(CDC_SET_CONTROL_LINE_STATE, (uint8_t *)&req, 0U);
+}
+
+/* 只处理 CDC 数据端点：先清 TxState（DataIn），再交付收到的一包（DataOut） */
+void HAL_PCD_IRQHandler(PCD_HandleTypeDef *hpcd)
+{
+  USBD_HandleTypeDef *pdev = (USBD_HandleTypeDef *)hpcd->pData;
+  USBD_CDC_HandleTypeDef *hcdc = (USBD_CDC_HandleTypeDef *)pdev->pClassData;
+  int in_done;
+  int out_ready = 0;
+
+  sim_lock();
+  in_done = sim_usb.in_done;
+  sim_usb.in_done = 0;
+  if (sim_usb.out_ready && hcdc != NULL && hcdc->RxBuffer != NULL)
+  {
+    memcpy(hcdc->RxBuffer, sim_usb.out_buf, sim_usb.out_len);
+    hcdc->RxLength = sim_usb.out_len;
+    sim_usb.out_ready = 0;
+    out_ready = 1;
+  }
+  sim_unlock();
+
+  if (in_done && hcdc != NULL)
+  {
+    hcdc->TxState = 0U;
+  }
+  if (out_ready)
+  {
+    ((USBD_CDC_ItfTypeDef *)pdev->pUserData)->Receive(hcdc->RxBuffer, &hcdc->RxLength);
+  }
+}
+
+/******************************* 仿真内核 *************************************/
+static int sim_usb_level(void)
+{
+  return sim_usb.out_ready || sim_usb.in_done;
+}
+
+/* 推进 IN 端点到 now，调用者持锁 */
+static void sim_usb_in_step(uint64_t now)
+{
+  sim_usb_t *s = &sim_usb;
+
+  while (s->in_active && s->bus_free <= now)
+  {
+    uint32_t n = s->in_len - s->in_off;
+
+    if (n > SIM_USB_PACKET_SIZE)
+    {
+      n = SIM_USB_PACKET_SIZE;
+    }
+    if (n != 0U)
+    {
+      if (write(s->master, s->in_buf + s->in_off, n) != (ssize_t)n)
+      {
+        s->pty_drops += n;
+      }
+      if (s->tx_bytes == 0U)
+      {
+        s->tx_first_t = now;
+      }
+      s->in_off += n;
+      s->tx_bytes += n;
+      s->tx_last_t = now;
+      s->in_packets++;
+    }
+    else if (s->in_zlp)
+    {
+      s->in_zlp = 0;
+      s->zlps++;
+    }
+    else
+    {
+      s->in_active = 0;
+      s->in_done = 1;
+      break;
+    }
+    sim_usb_packet(now);
+  }
+}
+
+/* 推进 OUT 端点到 now，调用者持锁 */
+static void sim_usb_out_step(uint64_t now)
+{
+  sim_usb_t *s = &sim_usb;
+  ssize_t n;
+
+  if (!s->out_armed || s->out_ready || s->bus_free > now)
+  {
+    return;
+  }
+  n = read(s->master, s->out_buf, sizeof(s->out_buf));
+  if (n <= 0)
+  {
+    return;
+  }
+  s->out_len = (uint32_t)n;
+  s->out_armed = 0;
+  s->out_ready = 1;
+  s->out_packets++;
+  s->rx_bytes += (uint64_t)n;
+  sim_usb_packet(now);
+}
+
+void sim_usb_init(void)
+{
+  struct termios tio;
+  const char *name;
+
+  sim_irq_set_level_source(USB_LP_CAN1_RX0_IRQn, sim_usb_level);
+
+  sim_usb.master = posix_openpt(O_RDWR | O_NOCTTY);
+  if (sim_usb.master < 0 || grantpt(sim_usb.master) != 0 || unlockpt(sim_usb.master) != 0 ||
+      (name = ptsname(sim_usb.master)) == NULL)
+  {
+    fprintf(stderr, "sim: cannot create pty for USB CDC: %s\n", strerror(errno));
+    exit(1);
+  }
+  snprintf(sim_usb.path, sizeof(sim_usb.path), "%s", name);
+
+  /* 自己保留一个从端，上位机没连上时主端读写也不会报 EIO */
+  sim_usb.slave = open(sim_usb.path, O_RDWR | O_NOCTTY);
+  if (sim_usb.slave >= 0 && tcgetattr(sim_usb.slave, &tio) == 0)
+  {
+    cfmakeraw(&tio);
+    tcsetattr(sim_usb.slave, TCSANOW, &tio);
+  }
+  fcntl(sim_usb.master, F_SETFL, fcntl(sim_usb.master, F_GETFL) | O_NONBLOCK);
+
+  if (sim_opt.usb_pty_link != NULL)
+  {
+    unlink(sim_opt.usb_pty_link);
+    if (symlink(sim_usb.path, sim_opt.usb_pty_link) != 0)
+    {
+      fprintf(stderr, "sim: cannot link %s -> %s: %s\n", sim_opt.usb_pty_link, sim_usb.path, strerror(errno));
+    }
+  }
+  fprintf(stderr, "sim: USB CDC on %s%s%s\n", sim_usb.path,
+          sim_opt.usb_pty_link ? " -> " : "", sim_opt.usb_pty_link ? sim_opt.usb_pty_link : "");
+}
+
+void sim_usb_poll(uint64_t now)
+{
+  sim_usb_in_step(now);
+  sim_usb_out_step(now);
+}
+
+void sim_report_usb(FILE *f)
+{
+  sim_usb_t *s = &sim_usb;
+  double span = (s->tx_last_t > s->tx_first_t) ? (double)(s->tx_last_t - s->tx_first_t) / SIM_CORE_CLOCK_HZ : 0.0;
+
+  fprintf(f, "  \"usb\": {\n");
+  fprintf(f, "    \"pty\": \"%s\",\n", s->path);
+  fprintf(f, "    \"packet_cycles\": %llu,\n", (unsigned long long)SIM_USB_PACKET_CYCLES);
+  fprintf(f, "    \"tx_bytes\": %llu,\n", (unsigned long long)s->tx_bytes);
+  fprintf(f, "    \"tx_bytes_per_s\": %.1f,\n", span > 0.0 ? (double)s->tx_bytes / span : 0.0);
+  fprintf(f, "    \"tx_transfers\": %llu,\n", (unsigned long long)s->transfers);
+  fprintf(f, "    \"tx_packets\": %llu,\n", (unsigned long long)s->in_packets);
+  fprintf(f, "    \"tx_zlps\": %llu,\n", (unsigned long long)s->zlps);
+  fprintf(f, "    \"tx_busy\": %llu,\n", (unsigned long long)s->tx_busy);
+  fprintf(f, "    \"rx_bytes\": %llu,\n", (unsigned long long)s->rx_bytes);
+  fprintf(f, "    \"rx_packets\": %llu,\n", (unsigned long long)s->out_packets);
+  fprintf(f, "    \"pty_drops\": %llu\n", (unsigned long long)s->pty_drops);
+  fprintf(f, "  },\n");
+}
@@ -22,6 +22,7 @@
 #include "usbd_cdc_if.h"
 
 /* USER CODE BEGIN INCLUDE */
+#include "schedule.h"
 
 /* USER CODE END INCLUDE */
 
@@ -90,10 +91,11 @@
 /** Received data over USB are stored in this buffer      */
 uint8_t UserRxBufferFS[APP_RX_DATA_SIZE];
 
-/** Data to send over USB CDC are stored in this buffer   */
-uint8_t UserTxBufferFS[APP_TX_DATA_SIZE];
-
 /* USER CODE BEGIN PRIVATE_VARIABLES */
+Frame_Parser usb_parser;
+Frame_Queue usb_rx_queue;
+Usb_Rx_Ring usb_rx;
+Usb_Tx_Pool usb_tx;
 
 /* USER CODE END PRIVATE_VARIABLES */
 
@@ -151,8 +153,10 @@ static int8_t CDC_Init_FS(void)
 {
   /* USER CODE BEGIN 3 */
   /* Set Application Buffers */
-  USBD_CDC_SetTxBuffer(&hUsbDeviceFS, UserTxBufferFS, 0);
+  USBD_CDC_SetTxBuffer(&hUsbDeviceFS, usb_tx.buf[0], 0);
   USBD_CDC_SetRxBuffer(&hUsbDeviceFS, UserRxBufferFS);
+  // öٺЭջķ״̬Ѿλڷһ
+  usb_tx.busy = 0;
   return (USBD_OK);
   /* USER CODE END 3 */
 }
@@ -164,6 +168,7 @@ static int8_t CDC_Init_FS(void)
 static int8_t CDC_DeInit_FS(void)
 {
   /* USER CODE BEGIN 4 */
+  if(active_link == LINK_USB) active_link = LINK_UART;
   return (USBD_OK);
   /* USER CODE END 4 */
 }
@@ -226,7 +231,8 @@ static int8_t CDC_Control_FS(uint8_t cmd, uint8_t* pbuf, uint16_t length)
     break;
 
     case CDC_SET_CONTROL_LINE_STATE:
-
+      // wValue  bit0  DTRλصںңص USART1
+      if(!(((USBD_SetupReqTypedef *)pbuf)->wValue & 0x01) && active_link == LINK_USB) active_link = LINK_UART;
     break;
 
     case CDC_SEND_BREAK:
@@ -259,13 +265,27 @@ static int8_t CDC_Control_FS(uint8_t cmd, uint8_t* pbuf, uint16_t length)
 static int8_t CDC_Receive_FS(uint8_t* Buf, uint32_t *Len)
 {
   /* USER CODE BEGIN 6 */
-	memset(myUsbRxData, 0, 64);                     // 0 
-  memcpy(myUsbRxData, Buf, *Len);                 // ѽյݣƵԼĻ
-  myUsbRxNum = *Len;                              // ֽ    
-  memset(Buf, 0, 64);
-	
-  USBD_CDC_SetRxBuffer(&hUsbDeviceFS, &Buf[0]);
-  USBD_CDC_ReceivePacket(&hUsbDeviceFS);
+  uint16_t head = usb_rx.head;
+  uint32_t i;
+
+  // ֻλ֡ŵ Task_Command 
+  for(i = 0; i < *Len; i++)
+  {
+    usb_rx.buf[(head + i) & (USB_RX_RING_SIZE - 1)] = Buf[i];
+  }
+  usb_rx.head = head + *Len;
+  link_stat[LINK_USB].rx_bytes += *Len;
+  // ŵһͽգ CDC_Rx_Poll ڳռ
+  if(USB_RX_RING_SIZE - (uint16_t)(usb_rx.head - usb_rx.tail) >= CDC_DATA_FS_MAX_PACKET_SIZE)
+  {
+    USBD_CDC_ReceivePacket(&hUsbDeviceFS);
+  }
+  else
+  {
+    usb_rx.paused = 1;
+    usb_rx.pauses++;
+  }
+  OS_Task_Trigger(TASK_COMMAND);
   return (USBD_OK);
   /* USER CODE END 6 */
 }
@@ -296,6 +316,95 @@ uint8_t CDC_Transmit_FS(uint8_t* Buf, uint16_t Len)
 }
 
 /* USER CODE BEGIN PRIVATE_FUNCTIONS_IMPLEMENTATION */
+// Task_Command ãѻֽڽ֡ӣһ USB_RX_POLL_MAX ֽڣ
+// ûķ 1֮ǰͣ˽գڳռ¿ʼ
+uint8_t CDC_Rx_Poll(void)
+{
+	uint16_t head = usb_rx.head;
+	uint16_t tail = usb_rx.tail;
+	uint16_t budget = USB_RX_POLL_MAX;
+	uint16_t pos, n;
+	uint32_t primask;
+
+	while(tail != head && budget)
+	{
+		pos = tail & (USB_RX_RING_SIZE - 1);
+		n = head - tail;
+		if(n > USB_RX_RING_SIZE - pos) n = USB_RX_RING_SIZE - pos;
+		if(n > budget) n = budget;
+		Frame_Parser_Input(&usb_parser, &usb_rx_queue, usb_rx.buf + pos, n);
+		tail += n;
+		budget -= n;
+	}
+	usb_rx.tail = tail;
+	primask = __get_PRIMASK();
+	__disable_irq();
+	if(usb_rx.paused && USB_RX_RING_SIZE - (uint16_t)(usb_rx.head - tail) >= CDC_DATA_FS_MAX_PACKET_SIZE)
+	{
+		usb_rx.paused = 0;
+		USBD_CDC_ReceivePacket(&hUsbDeviceFS);
+	}
+	__set_PRIMASK(primask);
+	return tail != usb_rx.head;
+}
+
+// һ鷢˾Ͱܵһ齻Эջ汾 CDC ûзɻص
+//  SysTick ÿ 1ms  CDC_Tx_Submit  TxStateUSB жȼߣж
+void CDC_Tx_Kick(void)
+{
+	USBD_CDC_HandleTypeDef *hcdc;
+	uint32_t primask = __get_PRIMASK();
+	uint8_t fill;
+
+	__disable_irq();
+	hcdc = (USBD_CDC_HandleTypeDef*)hUsbDeviceFS.pClassData;
+	fill = usb_tx.fill;
+	if(hcdc != NULL && usb_tx.busy && hcdc->TxState == 0)
+	{
+		usb_tx.busy = 0;
+		link_stat[LINK_USB].tx_bytes += usb_tx.len[fill ^ 1];
+	}
+	if(hcdc != NULL && !usb_tx.busy && !usb_tx.composing && usb_tx.len[fill] != 0 &&
+	   CDC_Transmit_FS(usb_tx.buf[fill], usb_tx.len[fill]) == USBD_OK)
+	{
+		usb_tx.busy = 1;
+		usb_tx.transfers++;
+		if(usb_tx.len[fill] > usb_tx.max_len) usb_tx.max_len = usb_tx.len[fill];
+		usb_tx.fill = fill ^ 1;
+		usb_tx.len[fill ^ 1] = 0;
+	}
+	__set_PRIMASK(primask);
+}
+
+// ֡Ļĩβһ֡Ŀռ䣬ûöٻŲ· NULLȴ
+uint8_t *CDC_Tx_Alloc(void)
+{
+	uint8_t fill;
+
+	usb_tx.composing = 1;   // λSysTick Ͳ֡л
+	fill = usb_tx.fill;
+	if(hUsbDeviceFS.dev_state != USBD_STATE_CONFIGURED || usb_tx.len[fill] + FRAME_V1_SIZE > USB_TX_BUF_SIZE)
+	{
+		usb_tx.composing = 0;
+		usb_tx.overflow++;
+		link_stat[LINK_USB].tx_drops++;
+		return NULL;
+	}
+	return usb_tx.buf[fill] + usb_tx.len[fill];
+}
+
+// ύ CDC_Tx_Alloc() õĿռ䣬USB оϷ
+void CDC_Tx_Submit(uint16_t len)
+{
+	uint32_t primask = __get_PRIMASK();
+
+	__disable_irq();
+	usb_tx.len[usb_tx.fill] += len;
+	usb_tx.composing = 0;
+	link_stat[LINK_USB].tx_frames++;
+	__set_PRIMASK(primask);
+	CDC_Tx_Kick();
+}
 
 /* USER CODE END PRIVATE_FUNCTIONS_IMPLEMENTATION */
 
@@ -30,6 +30,7 @@
 #include "usbd_cdc.h"
 
 /* USER CODE BEGIN INCLUDE */
+#include "Connectivity_Protocal.h"
 
 /* USER CODE END INCLUDE */
 
@@ -48,16 +49,21 @@
   * @{
   */
 /* Define size for the receive and transmit buffer over CDC */
-#define APP_RX_DATA_SIZE  1000
-#define APP_TX_DATA_SIZE  1000
+// Эջÿֻջһֱ usb_tx 黺ûеķͻ
+#define APP_RX_DATA_SIZE  CDC_DATA_FS_MAX_PACKET_SIZE
 /* USER CODE BEGIN EXPORTED_DEFINES */
 extern unsigned char RX_USART_1[64];
 extern uint16_t RX_USART_1_LEN;
 extern uint16_t RX_FLAG;
 
-
-extern uint8_t  myUsbRxData[64];   // յ
-extern uint16_t myUsbRxNum ;
+// USB ջλUSB жյİTask_Command ֡
+// ʣռ䲻һʱȲգǱ߱ NAK֡ڳռټ
+// ֡Ҫ usb_rx_queueֻǸ Task_Command ܼ̫
+#define USB_RX_RING_SIZE  256     // 2 
+#define USB_RX_POLL_MAX   256     // ÿôֽڣ֤֡зŵ
+// USB ͣ黺ãһ齻 USB ʱһ֡
+// ܵļ֡һνЭջ 64 ֽһ
+#define USB_TX_BUF_SIZE   512
 /* USER CODE END EXPORTED_DEFINES */
 
 /**
@@ -70,6 +76,26 @@ extern uint16_t myUsbRxNum ;
   */
 
 /* USER CODE BEGIN EXPORTED_TYPES */
+typedef struct
+{
+	uint8_t buf[USB_RX_RING_SIZE];
+	volatile uint16_t head;     // USB жд
+	volatile uint16_t tail;     // Task_Command 
+	volatile uint8_t paused;    // ռ䲻һͣ
+	uint32_t pauses;            // ͣյĴ
+}Usb_Rx_Ring;
+
+typedef struct
+{
+	uint8_t buf[2][USB_TX_BUF_SIZE];
+	uint16_t len[2];
+	volatile uint8_t fill;      // ֡Ļ
+	volatile uint8_t busy;      // һڷ
+	volatile uint8_t composing; // ˿ռ仹ûύʱ
+	uint32_t transfers;         // Эջ͵Ĵ
+	uint32_t overflow;          // 벻ռĴ
+	uint16_t max_len;           // һη͵ֽ
+}Usb_Tx_Pool;
 
 /* USER CODE END EXPORTED_TYPES */
 
@@ -99,6 +125,10 @@ extern uint16_t myUsbRxNum ;
 extern USBD_CDC_ItfTypeDef USBD_Interface_fops_FS;
 
 /* USER CODE BEGIN EXPORTED_VARIABLES */
+extern Frame_Parser usb_parser;
+extern Frame_Queue usb_rx_queue;
+extern Usb_Rx_Ring usb_rx;
+extern Usb_Tx_Pool usb_tx;
 
 /* USER CODE END EXPORTED_VARIABLES */
 
@@ -114,6 +144,10 @@ extern USBD_CDC_ItfTypeDef USBD_Interface_fops_FS;
 uint8_t CDC_Transmit_FS(uint8_t* Buf, uint16_t Len);
 
 /* USER CODE BEGIN EXPORTED_FUNCTIONS */
+uint8_t CDC_Rx_Poll(void);
+uint8_t *CDC_Tx_Alloc(void);
+void CDC_Tx_Submit(uint16_t len);
+void CDC_Tx_Kick(void);
 
 /* USER CODE END EXPORTED_FUNCTIONS */
 
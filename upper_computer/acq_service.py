@@ -0,0 +1,517 @@
+"""
+串口采集服务：独占串口，一直读、一直解帧，结果放进共享内存里的环形缓冲，
+Streamlit 每次刷新（可以开好几个页面）只读共享内存，不再抢串口，刷新之间的帧也不会丢
+
+    python acq_service.py --port COM12        # 先起服务
+    client = AcqClient()                      # 页面里
+    client.latest()                           # 最新一帧遥测
+    client.telemetry(600)                     # 最近 600 帧，按列返回
+    send_packet(client, build_packet(...))    # 发命令走服务转发
+
+遥测同时追加到 ts_store 的时间序列存储里（--store），界面画长时间的曲线从那里查。
+
+共享内存：头 + 传感器表 + 遥测环 + 样本环，写的时候用 seqlock（gen 奇数表示正在写），
+读的一方拷完再看一次 gen，变了就重读，不用加锁也不会读到写了一半的数据。
+命令通道：127.0.0.1 上的 TCP，客户端发 [长度(2) | 原始帧]，服务排进发送队列，由读串口的线程在两次读之间原样写出去；
+服务把遥测、样本、TLV 之外的帧（ACK、FILL、PROF 等）转给所有客户端：
+[数据长度(2) | 命令 | 序号 | 版本 | 主机时间 double(8) | 数据]，客户端从 frames() 取，
+可以直接交给 my_serial.CommandLink.on_frame。
+"""
+import argparse
+import collections
+import errno
+import os
+import selectors
+import signal
+import socket
+import struct
+import sys
+import threading
+import time
+from multiprocessing import shared_memory
+
+import trash_link
+from ts_store import STORE_ROOT, TSStore
+
+SHM_NAME = os.environ.get('SMART_TRASH_SHM', 'smart_trash_acq')
+CMD_PORT = int(os.environ.get('SMART_TRASH_ACQ_PORT', '47811'))
+
+SHM_MAGIC = b'STAQ'
+SHM_LAYOUT = 1
+SENSOR_MAX = 32                 # TLV 传感器编号 < 32
+TEL_CAP = 1 << 16               # 遥测 10Hz 时约 1.8 小时
+SMP_CAP = 1 << 18
+
+# 头：magic | 布局版本 | gen | 遥测环容量 | 样本环容量 | 遥测总行数 | 样本总行数 | 更新时间 | 服务 pid | 串口在线
+#     | 字节 | 帧 | CRC 错 | 重新同步 | 格式错
+_HEADER = struct.Struct('<4sHxxQIIQQdII5Q')
+_GEN = struct.Struct('<Q')
+_GEN_OFFSET = 8
+_SENSOR = struct.Struct('<di')                  # 主机时间 | 值，时间为 0 表示没收到过
+# 遥测一行：主机时间 | 距离 mm | 温度 0.1℃ | 湿度 0.1%RH | 满溢 %（255 没有）| 序号 | 帧版本
+_TEL = struct.Struct('<dHhHBBB')
+_TEL_COLUMNS = ('host_time', 'distance_mm', 'temp', 'humi', 'fill', 'seq', 'version')
+# 样本一行：tick ms | 序号 | 值 | 通道 | 是否补发的历史
+_SMP = struct.Struct('<IIhBB')
+_SMP_COLUMNS = ('tick', 'seq', 'value', 'channel', 'history')
+_SENSOR_OFFSET = _HEADER.size
+_STATS = ('bytes', 'frames', 'crc_errors', 'resync', 'malformed')
+
+# 命令通道的消息头
+_CMD_HEAD = struct.Struct('>H')
+_FRAME_HEAD = struct.Struct('>HBBBd')
+CLIENT_BUF_MAX = 1 << 16        # 客户端收得太慢，积压超过这个就断开它
+POLL_MS = 20                    # 读串口最多等这么久就回来看一眼发送队列
+
+
+def _layout(tel_cap, smp_cap):
+    tel_offset = _SENSOR_OFFSET + SENSOR_MAX * _SENSOR.size
+    smp_offset = tel_offset + tel_cap * _TEL.size
+    return tel_offset, smp_offset, smp_offset + smp_cap * _SMP.size
+
+
+def _pid_alive(pid):
+    if sys.platform == 'win32':
+        return True             # Windows 上共享内存随最后一个句柄消失，还在就说明服务还在
+    try:
+        os.kill(pid, 0)
+    except ProcessLookupError:
+        return False
+    except PermissionError:
+        pass
+    return True
+
+
+def _untrack(shm):
+    """3.13 之前打开已有的段也会被 resource_tracker 登记，退出时把段删掉；不是自己建的段要注销"""
+    if sys.platform != 'win32':
+        from multiprocessing import resource_tracker
+        resource_tracker.unregister(shm._name, 'shared_memory')
+
+
+class _Ring:
+    """共享内存里的一个环，只由服务写"""
+
+    def __init__(self, buf, offset, cap, rec):
+        self.buf, self.offset, self.cap, self.rec = buf, offset, cap, rec
+        self.head = 0
+
+    def append_rows(self, rows):
+        for row in rows:
+            self.rec.pack_into(self.buf, self.offset + (self.head % self.cap) * self.rec.size, *row)
+            self.head += 1
+
+    def read(self, head, n):
+        """拷出最后 n 行的原始字节"""
+        n = min(n, head, self.cap)
+        start = (head - n) % self.cap
+        first = min(n, self.cap - start)
+        a = self.offset + start * self.rec.size
+        data = bytes(self.buf[a:a + first * self.rec.size])
+        if first < n:
+            data += bytes(self.buf[self.offset:self.offset + (n - first) * self.rec.size])
+        return data
+
+
+class AcqService:
+    def __init__(self, port, baud=115200, shm_name=SHM_NAME, cmd_port=CMD_PORT,
+                 tel_cap=TEL_CAP, smp_cap=SMP_CAP, quiet=False, store=STORE_ROOT, store_days=90):
+        self.port_path, self.baud = port, baud
+        self.cmd_port = cmd_port
+        self.quiet = quiet
+        self.tel_cap, self.smp_cap = tel_cap, smp_cap
+        tel_offset, smp_offset, size = _layout(tel_cap, smp_cap)
+        self.shm = self._create_shm(shm_name, size)
+        # 确认没有别的服务在跑再打开存储，打开时会截断段文件末尾写了一半的记录
+        self.store = TSStore(store, writable=True, keep_days=store_days) if store else None
+        self.buf = self.shm.buf
+        self.buf[:size] = bytes(size)
+        self.tel = _Ring(self.buf, tel_offset, tel_cap, _TEL)
+        self.smp = _Ring(self.buf, smp_offset, smp_cap, _SMP)
+        self.gen = 0
+        self.online = 0
+        self.stats = dict.fromkeys(_STATS, 0)
+        self._publish(lambda: None)
+
+        self.decoder = trash_link.Decoder()
+        self.port = None
+        self.tx = collections.deque()   # 待写串口的帧，客户端线程放、串口线程取，只有串口线程碰串口
+        self.clients = {}       # socket -> [收到一半的数据, 待发数据]
+        self.clients_lock = threading.Lock()
+        self.running = True
+        self.wake_r, self.wake_w = socket.socketpair()
+        self.listener = socket.create_server(('127.0.0.1', cmd_port))
+
+    @staticmethod
+    def _create_shm(name, size):
+        try:
+            return shared_memory.SharedMemory(name, create=True, size=size)
+        except FileExistsError:
+            pass
+        old = shared_memory.SharedMemory(name)
+        magic, _, _, _, _, _, _, _, pid = _HEADER.unpack_from(old.buf)[:9]
+        if magic == SHM_MAGIC and pid and _pid_alive(pid):
+            _untrack(old)
+            old.close()
+            raise RuntimeError(f'acquisition service already running (pid {pid})')
+        old.close()
+        old.unlink()            # 上次异常退出留下的
+        return shared_memory.SharedMemory(name, create=True, size=size)
+
+    def _log(self, msg):
+        if not self.quiet:
+            print(f'acq: {msg}', flush=True)
+
+    def _publish(self, write):
+        """seqlock：gen 先变奇数再写，写完变偶数"""
+        self.gen += 1
+        _GEN.pack_into(self.buf, _GEN_OFFSET, self.gen)
+        write()
+        _HEADER.pack_into(self.buf, 0, SHM_MAGIC, SHM_LAYOUT, self.gen, self.tel_cap, self.smp_cap,
+                          self.tel.head, self.smp.head, time.time(), os.getpid(), self.online,
+                          *(self.stats[k] for k in _STATS))
+        self.gen += 1
+        _GEN.pack_into(self.buf, _GEN_OFFSET, self.gen)
+
+    def _store(self, batch):
+        t, s, sen = batch['telemetry'], batch['samples'], batch['sensors']
+
+        def write():
+            self.tel.append_rows(zip(t['host_time'], t['distance_mm'], t['temp'], t['humi'],
+                                     t['fill'], t['seq'], t['version']))
+            self.smp.append_rows(zip(s['tick'], s['seq'], s['value'], s['channel'], s['history']))
+            for host_time, sid, value in zip(sen['host_time'], sen['id'], sen['value']):
+                if sid < SENSOR_MAX:
+                    _SENSOR.pack_into(self.buf, _SENSOR_OFFSET + sid * _SENSOR.size, host_time, value)
+
+        stats = self.decoder.stats()
+        for k in _STATS:
+            self.stats[k] = stats.get(k, 0)
+        self._publish(write)
+        if self.store is not None and len(t['host_time']):
+            self.store.append_columns(t)
+            self.store.flush()
+        if batch['frames']:
+            self._broadcast(batch['frames'])
+
+    def _broadcast(self, frames):
+        msg = b''.join(_FRAME_HEAD.pack(len(data), cmd, seq, version, host_time) + data
+                       for cmd, seq, data, version, host_time in frames)
+        with self.clients_lock:
+            for entry in self.clients.values():
+                if entry[1] is not None:
+                    entry[1] += msg
+        self.wake_w.send(b'\x00')
+
+    def _open(self):
+        port = trash_link.open_port(self.port_path, self.baud)
+        if not hasattr(port, 'poll'):
+            port.timeout = 0.05
+        return port
+
+    def _set_online(self, online):
+        self.online = online
+        self._publish(lambda: None)
+
+    def serve_serial(self):
+        while self.running:
+            try:
+                self.port = self._open()
+            except OSError as e:
+                self._log(f'open {self.port_path} failed: {e}')
+                time.sleep(1.0)
+                continue
+            self._log(f'{self.port_path} open')
+            self._set_online(1)
+            try:
+                while self.running:
+                    self._flush_tx()
+                    if hasattr(self.port, 'poll'):
+                        if self.port.poll(self.decoder, POLL_MS) == 0:
+                            continue
+                    else:
+                        data = self.port.read(max(1, self.port.in_waiting))
+                        if not data:
+                            continue
+                        self.decoder.feed(data)
+                    self._store(self.decoder.take())
+            except OSError as e:
+                self._log(f'{self.port_path} lost: {e}')
+            self.port.close()
+            self.port = None
+            self.tx.clear()     # 串口不在线，命令丢掉，客户端等不到 ACK 自己会重发 / 报失败
+            self._set_online(0)
+            time.sleep(1.0)
+
+    def _write_serial(self, frame):
+        """客户端线程调用，只排队"""
+        if self.port is not None:
+            self.tx.append(frame)
+
+    def _flush_tx(self):
+        """串口线程调用；没写完（设备不收、发送缓冲区一直满）当成串口坏了，关掉重开，半帧设备会按 CRC 丢掉"""
+        while self.tx:
+            frame = self.tx.popleft()
+            n = self.port.write(frame)
+            if n is not None and n < len(frame):
+                raise OSError(errno.ETIMEDOUT, f'write timed out after {n}/{len(frame)} bytes')
+
+    def _drop(self, sel, sock):
+        sel.unregister(sock)
+        with self.clients_lock:
+            self.clients.pop(sock, None)
+        sock.close()
+
+    def serve_clients(self):
+        sel = selectors.DefaultSelector()
+        sel.register(self.listener, selectors.EVENT_READ)
+        sel.register(self.wake_r, selectors.EVENT_READ)
+        while self.running:
+            # 有待发数据的客户端关心可写
+            with self.clients_lock:
+                for sock, entry in self.clients.items():
+                    if len(entry[1]) > CLIENT_BUF_MAX:
+                        entry[1] = None
+                    events = selectors.EVENT_READ | (selectors.EVENT_WRITE if entry[1] else 0)
+                    sel.modify(sock, events)
+                dead = [s for s, e in self.clients.items() if e[1] is None]
+            for sock in dead:
+                self._log('client too slow, dropped')
+                self._drop(sel, sock)
+            for key, events in sel.select(0.5):
+                sock = key.fileobj
+                if sock is self.listener:
+                    conn, _ = sock.accept()
+                    conn.setblocking(False)
+                    with self.clients_lock:
+                        self.clients[conn] = [b'', b'']
+                    sel.register(conn, selectors.EVENT_READ)
+                    continue
+                if sock is self.wake_r:
+                    sock.recv(4096)
+                    continue
+                entry = self.clients.get(sock)
+                if entry is None:
+                    continue
+                try:
+                    if events & selectors.EVENT_READ:
+                        data = sock.recv(4096)
+                        if not data:
+                            self._drop(sel, sock)
+                            continue
+                        entry[0] += data
+                        while len(entry[0]) >= 2:
+                            n = _CMD_HEAD.unpack_from(entry[0])[0]
+                            if len(entry[0]) < 2 + n:
+                                break
+                            self._write_serial(entry[0][2:2 + n])
+                            entry[0] = entry[0][2 + n:]
+                    if events & selectors.EVENT_WRITE:
+                        with self.clients_lock:
+                            sent = sock.send(entry[1])
+                            entry[1] = entry[1][sent:]
+                except (BlockingIOError, InterruptedError):
+                    pass
+                except OSError:
+                    self._drop(sel, sock)
+
+    def run(self):
+        self._log(f'shared memory {self.shm.name}, commands on 127.0.0.1:{self.cmd_port}')
+        threading.Thread(target=self.serve_clients, daemon=True).start()
+        try:
+            self.serve_serial()
+        except KeyboardInterrupt:
+            pass
+        finally:
+            self.close()
+
+    def close(self):
+        self.running = False
+        self.listener.close()
+        self.wake_w.send(b'\x00')
+        self.online = 0
+        _HEADER.pack_into(self.buf, 0, SHM_MAGIC, SHM_LAYOUT, self.gen, self.tel_cap, self.smp_cap,
+                          self.tel.head, self.smp.head, time.time(), 0, 0, *(self.stats[k] for k in _STATS))
+        del self.buf, self.tel.buf, self.smp.buf
+        self.shm.close()
+        self.shm.unlink()
+        if self.store is not None:
+            self.store.close()
+
+
+class AcqClient:
+    """
+    读服务的共享内存，服务没起来时各个读函数返回 None，下次调用再试着连
+    write() 和串口一样用，可以交给 send_packet / CommandLink
+    """
+
+    def __init__(self, shm_name=SHM_NAME, cmd_port=CMD_PORT):
+        self.shm_name, self.cmd_port = shm_name, cmd_port
+        self.shm = None
+        self.sock = None
+        self.rx = b''
+
+    def _attach(self):
+        if self.shm is not None:
+            return True
+        try:
+            try:
+                shm = shared_memory.SharedMemory(self.shm_name, track=False)
+            except TypeError:
+                shm = shared_memory.SharedMemory(self.shm_name)     # 3.13 之前没有 track
+                _untrack(shm)
+        except FileNotFoundError:
+            return False
+        if bytes(shm.buf[:4]) != SHM_MAGIC:
+            shm.close()
+            return False
+        self.shm = shm
+        return True
+
+    def _snapshot(self, read):
+        """seqlock 读：gen 是奇数或者读完变了就重读"""
+        if not self._attach():
+            return None
+        buf = self.shm.buf
+        for _ in range(10000):
+            gen = _GEN.unpack_from(buf, _GEN_OFFSET)[0]
+            if gen & 1:
+                time.sleep(0)
+                continue
+            header = _HEADER.unpack_from(buf)
+            result = read(buf, header)
+            if _GEN.unpack_from(buf, _GEN_OFFSET)[0] == gen:
+                if header[8] == 0 or not _pid_alive(header[8]):
+                    # 服务退出了，这次返回最后的数据，下次重新连（服务重启后是新的段）
+                    self.shm.close()
+                    self.shm = None
+                return result
+        return None
+
+    def _rows(self, ring_index, rec, columns, n):
+        def read(buf, header):
+            tel_cap, smp_cap, tel_head, smp_head = header[3:7]
+            tel_offset, smp_offset, _ = _layout(tel_cap, smp_cap)
+            ring = (_Ring(buf, tel_offset, tel_cap, rec) if ring_index == 0
+                    else _Ring(buf, smp_offset, smp_cap, rec))
+            head = tel_head if ring_index == 0 else smp_head
+            return head, ring.read(head, n)
+
+        snap = self._snapshot(read)
+        if snap is None:
+            return None
+        head, data = snap
+        rows = list(rec.iter_unpack(data))
+        result = {k: list(v) for k, v in zip(columns, zip(*rows))} if rows else {k: [] for k in columns}
+        result['index'] = head - len(rows)      # 第一行的全局序号，跟 latest()['index'] 对得上
+        return result
+
+    def telemetry(self, n=TEL_CAP):
+        """最近 n 帧遥测，按列：host_time distance_mm temp humi fill seq version"""
+        return self._rows(0, _TEL, _TEL_COLUMNS, n)
+
+    def samples(self, n=SMP_CAP):
+        """最近 n 个批量样本，按列：tick seq value channel history"""
+        return self._rows(1, _SMP, _SMP_COLUMNS, n)
+
+    def latest(self):
+        """最新一帧遥测，index 是它的全局序号（服务重启后从 0 开始），还没有数据返回 None"""
+        rows = self.telemetry(1)
+        if not rows or not rows['host_time']:
+            return None
+        row = {k: rows[k][0] for k in _TEL_COLUMNS}
+        row['index'] = rows['index']
+        if row['fill'] == 0xff:
+            row['fill'] = None
+        return row
+
+    def sensors(self):
+        """TLV 传感器最新值 {编号: (主机时间, 值)}"""
+        def read(buf, header):
+            return [_SENSOR.unpack_from(buf, _SENSOR_OFFSET + i * _SENSOR.size) for i in range(SENSOR_MAX)]
+
+        table = self._snapshot(read)
+        if table is None:
+            return None
+        return {i: entry for i, entry in enumerate(table) if entry[0]}
+
+    def status(self):
+        """服务状态：串口是否在线、更新时间、行数和解帧统计"""
+        header = self._snapshot(lambda buf, header: header)
+        if header is None:
+            return None
+        status = dict(zip(('tel_cap', 'smp_cap', 'tel_rows', 'smp_rows', 'updated', 'pid', 'online'), header[3:10]))
+        status.update(zip(_STATS, header[10:]))
+        status['online'] = bool(status['online']) and status['pid'] != 0
+        return status
+
+    def _connect(self):
+        if self.sock is None:
+            self.sock = socket.create_connection(('127.0.0.1', self.cmd_port), timeout=1.0)
+            self.sock.setblocking(False)
+        return self.sock
+
+    def write(self, data):
+        """发给服务写串口；服务没起来抛 ConnectionError"""
+        data = bytes(data)
+        sock = self._connect()
+        sock.setblocking(True)
+        try:
+            sock.sendall(_CMD_HEAD.pack(len(data)) + data)
+        except OSError:
+            self.close()
+            raise
+        finally:
+            if self.sock is not None:
+                sock.setblocking(False)
+        return len(data)
+
+    def flush(self):
+        pass
+
+    def frames(self):
+        """服务转发过来的其他命令的帧 [(命令, 序号, 数据, 版本, 主机时间)]，写过命令之后才会收到"""
+        if self.sock is None:
+            return []
+        try:
+            while True:
+                data = self.sock.recv(65536)
+                if not data:
+                    self.close()
+                    break
+                self.rx += data
+        except (BlockingIOError, InterruptedError):
+            pass
+        except OSError:
+            self.close()
+        frames = []
+        while len(self.rx) >= _FRAME_HEAD.size:
+            n, cmd, seq, version, host_time = _FRAME_HEAD.unpack_from(self.rx)
+            if len(self.rx) < _FRAME_HEAD.size + n:
+                break
+            frames.append((cmd, seq, self.rx[_FRAME_HEAD.size:_FRAME_HEAD.size + n], version, host_time))
+            self.rx = self.rx[_FRAME_HEAD.size + n:]
+        return frames
+
+    def close(self):
+        if self.sock is not None:
+            self.sock.close()
+            self.sock = None
+        self.rx = b''
+
+
+if __name__ == '__main__':
+    parser = argparse.ArgumentParser(description='smart_trash 串口采集服务')
+    parser.add_argument('--port', default=os.environ.get('SMART_TRASH_PORT', 'COM12'))
+    parser.add_argument('--baud', type=int, default=115200)
+    parser.add_argument('--shm', default=SHM_NAME)
+    parser.add_argument('--cmd-port', type=int, default=CMD_PORT)
+    parser.add_argument('--tel-cap', type=int, default=TEL_CAP)
+    parser.add_argument('--smp-cap', type=int, default=SMP_CAP)
+    parser.add_argument('--store', default=STORE_ROOT, help='时间序列存储目录，空字符串不存')
+    parser.add_argument('--store-days', type=int, default=90, help='存储保留天数')
+    parser.add_argument('--quiet', action='store_true')
+    args = parser.parse_args()
+    signal.signal(signal.SIGTERM, lambda *_: sys.exit(0))     # 被 kill 也要删掉共享内存
+    AcqService(args.port, args.baud, args.shm, args.cmd_port, args.tel_cap, args.smp_cap, args.quiet,
+               args.store, args.store_days).run()
@@ -0,0 +1,378 @@
+"""
+多桶网关：一个进程、一个 asyncio 事件循环管很多个串口 / USB CDC 设备（只在 Linux 上跑）
+
+    python gateway.py                                   # 默认扫 /dev/serial/by-id/*
+    python gateway.py --ports '/tmp/bin*' --stats-interval 5
+    python virtual_bin.py --count 200 --link /tmp/bin   # 没有板子时用虚拟桶
+
+设备 ID 是设备路径的文件名：/dev/serial/by-id 下的名字带 USB 序列号（STM32 的 CDC 序列号由芯片 UID 算出），
+拔了再插还是同一个 ID。定时重新扫描路径，新设备自动打开；读写出错或者设备消失就标成离线，
+按 1s、2s、4s……最多 30s 的退避重连。每个设备一个原生解帧器，只保留最新状态和计数，内存不随运行时间增长。
+
+控制接口：127.0.0.1 上的 TCP，一行一个 JSON 请求，一行一个 JSON 回复
+    {"op": "list"}                                      所有设备的状态和链路统计
+    {"op": "get", "device": ID}                         一个设备
+    {"op": "send", "device": ID, "frame": "a502..."}    原样写一帧
+    {"op": "command", "device": ID, "cmd": 1, "data": "0102", "timeout": 0.5}
+                                                        发 v2 请求并等 ACK，回 {"status": "ok", "rtt_ms": ..}
+    {"op": "stats"}                                     网关汇总
+"""
+import argparse
+import asyncio
+import errno
+import glob
+import json
+import os
+import random
+import resource
+import termios
+import time
+import tty
+
+import trash_link
+
+CONTROL_PORT = int(os.environ.get('SMART_TRASH_GATEWAY_PORT', '47820'))
+DEFAULT_PORTS = ('/dev/serial/by-id/*',)
+BACKOFF_MIN_S = 1.0
+BACKOFF_MAX_S = 30.0
+READ_SIZE = 4096
+OUT_BUF_MAX = 4096              # 设备写不动时最多积压这么多，再多就丢
+CMD_ACK, CMD_FILL_EVENT, CMD_SORT_DONE = 9, 13, 6
+ACK_STATUS = ('ok', 'bad_len', 'bad_arg', 'unknown', 'gone', 'busy')
+RATE_WINDOW_S = 5.0
+FILL_NONE = 0xff
+REPLY_LIMIT = 1 << 24           # list 几百个设备的回复是一行几百 KB
+
+_BAUD = {9600: termios.B9600, 57600: termios.B57600, 115200: termios.B115200,
+         230400: termios.B230400, 460800: termios.B460800, 921600: termios.B921600}
+
+
+def _open_tty(path, baud):
+    fd = os.open(path, os.O_RDWR | os.O_NOCTTY | os.O_NONBLOCK)
+    try:
+        tty.setraw(fd)
+        attr = termios.tcgetattr(fd)
+        attr[4] = attr[5] = _BAUD.get(baud, termios.B115200)
+        termios.tcsetattr(fd, termios.TCSANOW, attr)
+    except termios.error:
+        pass                    # 不是真的串口（比如普通管道），照样读写
+    return fd
+
+
+class Device:
+    """一个设备的连接、解帧和最新状态"""
+
+    def __init__(self, gw, dev_id, path):
+        self.gw = gw
+        self.id = dev_id
+        self.path = path
+        self.fd = None
+        self.decoder = None
+        self.out = b''
+        self.seq = 0
+        self.pending = {}       # 请求序号 -> (命令, future, 发出时刻)
+        self.backoff = BACKOFF_MIN_S
+        self.retry_at = 0.0
+        self.online = False
+        self.connects = 0
+        self.last_error = None
+        self.last_rx = None
+        self.latest = None      # 最新一帧遥测
+        self.fill_event = None
+        self.sort_done = None
+        self.rate_t = time.time()
+        self.rate_frames = 0
+        self.rate_hz = 0.0
+        self.stats = dict.fromkeys(('bytes', 'frames', 'telemetry', 'crc_errors', 'resync', 'skipped', 'malformed',
+                                    'tx_bytes', 'tx_dropped', 'disconnects'), 0)
+        self.base = {}          # 本次连接之前累计的解帧统计
+
+    def open(self):
+        loop = self.gw.loop
+        try:
+            self.fd = _open_tty(self.path, self.gw.baud)
+        except OSError as e:
+            self._failed(e)
+            return False
+        self.decoder = trash_link.Decoder()
+        self.online = True
+        self.connects += 1
+        self.backoff = BACKOFF_MIN_S
+        self.last_error = None
+        loop.add_reader(self.fd, self._on_readable)
+        return True
+
+    def _failed(self, e):
+        self.last_error = str(e)
+        self.retry_at = time.time() + self.backoff * random.uniform(0.8, 1.2)
+        self.backoff = min(self.backoff * 2, BACKOFF_MAX_S)
+
+    def close(self, error=None):
+        if self.fd is None:
+            return
+        loop = self.gw.loop
+        loop.remove_reader(self.fd)
+        if self.out:
+            loop.remove_writer(self.fd)
+        os.close(self.fd)
+        self.fd = None
+        self.out = b''
+        for k, v in self.decoder.stats().items():
+            if k in self.stats:
+                self.base[k] = self.base.get(k, 0) + v
+        self.decoder = None
+        self.online = False
+        for _, fut, _ in self.pending.values():
+            if not fut.done():
+                fut.set_result(('offline', None))
+        self.pending.clear()
+        if error is not None:
+            self.stats['disconnects'] += 1
+            self._failed(error)
+
+    def _on_readable(self):
+        try:
+            data = os.read(self.fd, READ_SIZE)
+        except BlockingIOError:
+            return
+        except OSError as e:
+            self.close(e)
+            return
+        if not data:
+            self.close(OSError(errno.EIO, 'end of file'))
+            return
+        now = time.time()
+        self.last_rx = now
+        self.decoder.feed(data, now)
+        batch = self.decoder.take()
+        t = batch['telemetry']
+        n = len(t['seq'])
+        if n:
+            fill = t['fill'][-1]
+            self.latest = {'time': t['host_time'][-1], 'distance_mm': t['distance_mm'][-1], 'temp': t['temp'][-1],
+                           'humi': t['humi'][-1], 'fill': None if fill == FILL_NONE else fill,
+                           'version': t['version'][-1]}
+            self.rate_frames += n
+        for cmd, seq, payload, version, host_time in batch['frames']:
+            if cmd == CMD_ACK and len(payload) >= 3:
+                entry = self.pending.get(payload[0])
+                if entry is not None and entry[0] == payload[1]:
+                    del self.pending[payload[0]]
+                    status = payload[2] & 0x7f
+                    name = ACK_STATUS[status] if status < len(ACK_STATUS) else f'status{status}'
+                    if not entry[1].done():
+                        entry[1].set_result((name, now - entry[2]))
+            elif cmd == CMD_FILL_EVENT:
+                self.fill_event = {'time': host_time, 'data': payload.hex()}
+            elif cmd == CMD_SORT_DONE:
+                self.sort_done = {'time': host_time, 'data': payload.hex()}
+
+    def _on_writable(self):
+        try:
+            n = os.write(self.fd, self.out)
+        except BlockingIOError:
+            return
+        except OSError as e:
+            self.close(e)
+            return
+        self.stats['tx_bytes'] += n
+        self.out = self.out[n:]
+        if not self.out:
+            self.gw.loop.remove_writer(self.fd)
+
+    def write(self, frame):
+        if self.fd is None:
+            raise ConnectionError(f'{self.id} offline')
+        if len(self.out) + len(frame) > OUT_BUF_MAX:
+            self.stats['tx_dropped'] += 1
+            raise BufferError(f'{self.id} write buffer full')
+        if not self.out:
+            try:
+                n = os.write(self.fd, frame)
+            except BlockingIOError:
+                n = 0
+            except OSError as e:
+                self.close(e)
+                raise ConnectionError(f'{self.id} write failed: {e}')
+            self.stats['tx_bytes'] += n
+            frame = frame[n:]
+            if frame:
+                self.gw.loop.add_writer(self.fd, self._on_writable)
+        self.out += frame
+
+    async def command(self, cmd, data=b'', timeout=0.5):
+        """
+        发 v2 请求等 ACK，返回 (状态名, 往返秒数)；超时返回 ('timeout', None)
+        'busy' 是设备这次没执行也没记下这个序号，调用者过一会儿再发一次就行
+        """
+        seq = self.seq
+        self.seq = (self.seq + 1) & 0xff
+        fut = self.gw.loop.create_future()
+        old = self.pending.pop(seq, None)
+        if old is not None and not old[1].done():
+            old[1].set_result(('timeout', None))
+        self.write(trash_link.encode_v2(cmd, data, seq))     # 写不出去直接抛，不留 pending
+        self.pending[seq] = (cmd, fut, time.time())
+        try:
+            return await asyncio.wait_for(fut, timeout)
+        except asyncio.TimeoutError:
+            self.pending.pop(seq, None)
+            return 'timeout', None
+
+    def tick(self, now):
+        """每秒一次：算帧率"""
+        dt = now - self.rate_t
+        if dt >= RATE_WINDOW_S:
+            self.rate_hz = self.rate_frames / dt
+            self.rate_t = now
+            self.rate_frames = 0
+
+    def link_stats(self):
+        stats = dict(self.stats)
+        for k, v in self.base.items():
+            stats[k] += v
+        if self.decoder is not None:
+            for k, v in self.decoder.stats().items():
+                if k in stats:
+                    stats[k] += v
+        return stats
+
+    def describe(self):
+        return {'id': self.id, 'path': self.path, 'online': self.online, 'connects': self.connects,
+                'last_error': self.last_error, 'last_rx': self.last_rx, 'rate_hz': round(self.rate_hz, 2),
+                'retry_in': None if self.online else max(0.0, round(self.retry_at - time.time(), 2)),
+                'latest': self.latest, 'fill_event': self.fill_event, 'sort_done': self.sort_done,
+                'stats': self.link_stats()}
+
+
+class Gateway:
+    def __init__(self, patterns=DEFAULT_PORTS, baud=115200, control_port=CONTROL_PORT,
+                 scan_interval=2.0, stats_interval=0.0):
+        self.patterns = patterns
+        self.baud = baud
+        self.control_port = control_port
+        self.scan_interval = scan_interval
+        self.stats_interval = stats_interval
+        self.devices = {}
+        self.loop = None
+        self.started = time.time()
+
+    def scan(self):
+        """按路径找设备：新的加进来，在的按退避时间重连；路径消失的留着显示离线"""
+        now = time.time()
+        paths = set()
+        for pattern in self.patterns:
+            paths.update(glob.glob(pattern))
+        for path in sorted(paths):
+            dev_id = os.path.basename(path)
+            dev = self.devices.get(dev_id)
+            if dev is None:
+                dev = self.devices[dev_id] = Device(self, dev_id, path)
+            if dev.fd is None and now >= dev.retry_at and os.path.exists(path):
+                dev.open()
+
+    async def _maintain(self):
+        """每秒一次算帧率，每 scan_interval 秒找一次设备"""
+        last_stats = time.time()
+        next_scan = 0.0
+        while True:
+            now = time.time()
+            if now >= next_scan:
+                next_scan = now + self.scan_interval
+                self.scan()
+            for dev in self.devices.values():
+                dev.tick(now)
+            if self.stats_interval and now - last_stats >= self.stats_interval:
+                last_stats = now
+                s = self.summary()
+                print(f"gateway: {s['online']}/{s['devices']} online, {s['telemetry_hz']:.0f} frames/s, "
+                      f"crc {s['crc_errors']}, cpu {s['cpu_pct']:.1f}%, rss {s['rss_mb']:.1f}MB", flush=True)
+            await asyncio.sleep(max(0.0, min(1.0, next_scan - time.time())))
+
+    def summary(self):
+        usage = resource.getrusage(resource.RUSAGE_SELF)
+        elapsed = time.time() - self.started
+        totals = {}
+        for dev in self.devices.values():
+            for k, v in dev.link_stats().items():
+                totals[k] = totals.get(k, 0) + v
+        return {'devices': len(self.devices), 'online': sum(d.online for d in self.devices.values()),
+                'telemetry_hz': sum(d.rate_hz for d in self.devices.values()),
+                'cpu_pct': (usage.ru_utime + usage.ru_stime) / max(elapsed, 1e-3) * 100,
+                'rss_mb': usage.ru_maxrss / 1024, 'uptime_s': round(elapsed, 1), **totals}
+
+    def _device(self, req):
+        dev = self.devices.get(req.get('device'))
+        if dev is None:
+            raise KeyError(f"unknown device {req.get('device')}")
+        return dev
+
+    async def handle(self, req):
+        op = req.get('op')
+        if op == 'list':
+            return {'devices': [d.describe() for d in self.devices.values()]}
+        if op == 'get':
+            return self._device(req).describe()
+        if op == 'stats':
+            return self.summary()
+        if op == 'send':
+            self._device(req).write(bytes.fromhex(req['frame']))
+            return {'status': 'sent'}
+        if op == 'command':
+            status, rtt = await self._device(req).command(int(req['cmd']), bytes.fromhex(req.get('data', '')),
+                                                          float(req.get('timeout', 0.5)))
+            return {'status': status, 'rtt_ms': None if rtt is None else round(rtt * 1000, 3)}
+        raise ValueError(f'unknown op {op}')
+
+    async def _client(self, reader, writer):
+        try:
+            while True:
+                line = await reader.readline()
+                if not line:
+                    break
+                try:
+                    reply = await self.handle(json.loads(line))
+                except Exception as e:      # 请求有错回错误，不断开
+                    reply = {'error': f'{type(e).__name__}: {e}'}
+                writer.write(json.dumps(reply).encode() + b'\n')
+                await writer.drain()
+        except ConnectionError:
+            pass
+        finally:
+            writer.close()
+
+    async def run(self):
+        self.loop = asyncio.get_running_loop()
+        server = await asyncio.start_server(self._client, '127.0.0.1', self.control_port)
+        async with server:
+            await self._maintain()
+
+
+async def request(op, port=CONTROL_PORT, **kw):
+    """给网关发一个请求，返回回复（脚本和界面用）"""
+    reader, writer = await asyncio.open_connection('127.0.0.1', port, limit=REPLY_LIMIT)
+    writer.write(json.dumps(dict(op=op, **kw)).encode() + b'\n')
+    reply = json.loads(await reader.readline())
+    writer.close()
+    return reply
+
+
+def main():
+    parser = argparse.ArgumentParser(description='smart_trash 多桶网关')
+    parser.add_argument('--ports', nargs='+', default=list(DEFAULT_PORTS), help='设备路径的通配符')
+    parser.add_argument('--baud', type=int, default=115200)
+    parser.add_argument('--control-port', type=int, default=CONTROL_PORT)
+    parser.add_argument('--scan-interval', type=float, default=2.0)
+    parser.add_argument('--stats-interval', type=float, default=0.0, help='每隔几秒打印一次汇总，0 不打印')
+    args = parser.parse_args()
+    soft, hard = resource.getrlimit(resource.RLIMIT_NOFILE)
+    resource.setrlimit(resource.RLIMIT_NOFILE, (hard, hard))       # 几百个设备要几百个 fd
+    gw = Gateway(args.ports, args.baud, args.control_port, args.scan_interval, args.stats_interval)
+    try:
+        asyncio.run(gw.run())
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == '__main__':
+    main()
@@ -8,6 +8,8 @@ from ultralytics import YOLOWorld
 from utils import Serial
 import struct
 from my_serial import *
+from acq_service import AcqClient
+from ts_store import TSStore
 import random
 
 from enum import Enum
@@ -48,55 +50,51 @@ with sidebar:
 
     print(rubbish_class)
 
+    # 曲线的时间范围，数据来自采集服务写的时间序列存储
+    chart_range = st.selectbox(
+    label = '曲线时间范围',
+    options = ('1分钟', '10分钟', '1小时', '1天', '1周', '1个月'),
+    index = 1,
+    )
+
 
 st.set_page_config(layout="wide")
 
 # 初始化多个变量（仅在会话首次运行时执行）
-if 'rubbish_distance' not in st.session_state:
-    st.session_state.rubbish_distance = [0,0,0,0,0,0,0,0,0,0]
-if 'temperature_data' not in st.session_state: 
-    st.session_state.temperature_data = [0,0,0,0,0,0,0,0,0,0]
-if 'humidity_data' not in st.session_state:
-    st.session_state.humidity_data = [0,0,0,0,0,0,0,0,0,0]
 if 'rubbish_flag' not in st.session_state:
     st.session_state.rubbish_flag = Rubbish.idle
 
+CHART_SPAN = {'1分钟': 60, '10分钟': 600, '1小时': 3600, '1天': 86400, '1周': 7 * 86400, '1个月': 30 * 86400}
+CHART_POINTS = 300
+
+@st.cache_resource
+def ts_store():
+    return TSStore()
 
-# 通用队列
-def enqueue(origin_data, value, max_length=10):
-    queue = origin_data.copy()
-    queue.append(value)
-    if len(queue) > max_length:
-        queue.pop(0)
-    origin_data = queue
-    return origin_data
+# 查一次，三张图共用：每个点是一段时间的 最小 / 平均 / 最大
+def chart_history(span):
+    now = time.time()
+    return ts_store().query(now - span, now, CHART_POINTS)
+
+def chart_frame(history, column, scale):
+    index = pd.to_datetime(history['t'], unit='s', utc=True).tz_convert('Asia/Shanghai')
+    return pd.DataFrame({
+        '最小': [v / scale for v in history[column + '_min']],
+        '平均': [v / scale for v in history[column + '_mean']],
+        '最大': [v / scale for v in history[column + '_max']],
+    }, index=index)
+
+# 串口归采集服务（python acq_service.py --port COM12），这里只读它的共享内存，几个页面一起开也不抢串口
+@st.cache_resource
+def acq_client():
+    return AcqClient()
 
 #串口数据更新(接收)
-received_data = ser.read_all()  # 读取一秒内收到的所有串口数据
-buffer = b''  # 初始化缓冲区
-buffer += received_data
-sof_index = buffer.find(b'\xa5')
-serial_distance = None
-serial_humi_int = None
-serial_temp_int = None
-if sof_index != -1:
-    packet_data = buffer[sof_index:]
-    next_sof_index = packet_data.find(b'\xa5', 1)
-    if next_sof_index != -1:
-        packet_data = packet_data[:next_sof_index]
-    else:
-        pass
-    print(packet_data)
-    # print(len(packet_data))
-    try:
-        # 距离
-        serial_distance = u8array_to_float(packet_data[5], packet_data[6], packet_data[7], packet_data[8])
-        # 湿度
-        serial_humi_int = packet_data[9]
-        # 温度
-        serial_temp_int = packet_data[10]
-    except:
-        pass
+client = acq_client()
+latest = client.latest()
+if latest is None:
+    st.sidebar.warning('采集服务没有运行')
+history = chart_history(CHART_SPAN[chart_range])
 
 
 for row in range(2):
@@ -109,27 +107,21 @@ for row in range(2):
                 # 根据行列索引分配不同组件
                 if row == 0 and col_index == 0:
                     st.header(f"垃圾满载情况")
-                    if serial_distance != None: # 更新数据
-                        value = serial_distance
-                        st.session_state.rubbish_distance = enqueue(st.session_state.rubbish_distance,value)
-                    chart_data = pd.DataFrame(st.session_state.rubbish_distance, columns=["数据"])
-                    st.area_chart(chart_data)
+                    if latest is not None:
+                        st.caption(f"当前距离 {latest['distance_mm'] / 1000:.3f} m")
+                    st.line_chart(chart_frame(history, 'distance_mm', 1000))
 
                 elif row == 0 and col_index == 1:
                     st.header(f"温度检测")
-                    if serial_temp_int != None:
-                        value = serial_temp_int
-                        st.session_state.temperature_data = enqueue(st.session_state.temperature_data,value)
-                    chart_data = pd.DataFrame(st.session_state.temperature_data, columns=["数据"])
-                    st.area_chart(chart_data)
+                    if latest is not None:
+                        st.caption(f"当前温度 {latest['temp'] / 10:.1f} ℃")
+                    st.line_chart(chart_frame(history, 'temp', 10))
 
                 elif row == 0 and col_index == 2:  # humidity_data
                     st.header(f"湿度检测")
-                    if serial_humi_int != None:
-                        value = serial_humi_int
-                        st.session_state.humidity_data = enqueue(st.session_state.humidity_data,value)
-                    chart_data = pd.DataFrame(st.session_state.humidity_data, columns=["数据"])
-                    st.area_chart(chart_data)
+                    if latest is not None:
+                        st.caption(f"当前湿度 {latest['humi'] / 10:.1f} %")
+                    st.line_chart(chart_frame(history, 'humi', 10))
 
 
                 # oled显示
@@ -219,5 +211,6 @@ elif rubbish_class == "厨余垃圾":
 elif rubbish_class == "其他垃圾":
     motor_send_data = b'\x04'
 packet_data_send =  build_packet(oled_send_data, motor_send_data)
-send_packet(ser,packet_data_send)
+if latest is not None:
+    send_packet(client,packet_data_send)
 
@@ -1,7 +1,19 @@
-from utils import Serial
+import os
+import sys
 import struct
+import time
+
+
+def open_serial(port=None):
+    """直接开串口；界面不用这个，串口归 acq_service.py 的采集服务，界面用 AcqClient"""
+    # 用到才导入，只编解帧的时候（比如连 virtual_bin.py）不需要装 pyserial
+    if sys.platform == 'win32':
+        from utils import Serial
+    else:
+        # Linux 下用 pyserial，可以直接连仿真固件的 PTY（见 product_class/product_class/Simulation）
+        from serial import Serial
+    return Serial(port or os.environ.get('SMART_TRASH_PORT', 'COM12'), 115200, timeout=1)
 
-ser = Serial('COM12', 115200, timeout=1)
 def u8array_to_float(u8_array_0, u8_array_1, u8_array_2, u8_array_3):
     """
     将C函数float2u8Arry生成的字节数组还原为浮点数
@@ -16,27 +28,379 @@ def u8array_to_float(u8_array_0, u8_array_1, u8_array_2, u8_array_3):
 
 # 构建发送帧
 def build_packet(oled, motor_send_data):
-    SOF = b'\xa5'
-    packet = SOF
-    for i in range (4):
-        packet += b'\x00'
+    # 帧头 a5 + 4 字节 0 | oled屏幕是否显示，1显示，0关闭 | 识别的垃圾种类，0无，1-4对应四种垃圾 | 56 字节 0 | 帧尾 ff
+    return b'\xa5' + bytes(4) + oled + motor_send_data + bytes(56) + b'\xff'
+
+# v2 帧：帧头 a5 | 版本 02 | 长度 | 序号 | 命令 | 数据 | CRC16（高字节在前）| 帧尾 ff
+# 下位机用收到的帧版本回复，发 v2 帧之后遥测也变成 20 字节的 v2 帧
+FRAME_V2 = 0x02
+
+
+def crc16_ccitt(data, crc=0xffff):
+    for b in data:
+        crc ^= b << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+        crc &= 0xffff
+    return crc
+
+
+def build_frame_v2(cmd, data, seq=0):
+    body = bytes([FRAME_V2, len(data), seq & 0xff, cmd]) + data
+    crc = crc16_ccitt(body)
+    return b'\xa5' + body + bytes([crc >> 8, crc & 0xff]) + b'\xff'
+
+
+def build_packet_v2(oled, motor_send_data, seq=0, cmd=1):
+    return build_frame_v2(cmd, oled + motor_send_data, seq)
+
+
+# v2 遥测帧（命令 1）：距离 m(float) | 湿度 % | 温度 ℃ | 距离 mm(2) | 温度 0.1℃(2) | 湿度 0.1%RH(2)
+# 前 6 字节和 v1 一样，后面是同样的量的整数单位，只发前 6 字节的旧固件返回 None
+CMD_TELEMETRY = 1
+
+
+def decode_telemetry(data):
+    """:return: (距离 mm, 温度 0.1℃, 湿度 0.1%RH)"""
+    if len(data) < 12:
+        return None
+    return struct.unpack('>Hhh', data[6:12])
+
+
+def parse_packet_v2(buffer):
+    """
+    从缓冲区开头解析一个 v2 帧
+    :return: (cmd, seq, data, 帧长度)，数据不完整或校验失败返回 None
+    """
+    if len(buffer) < 8 or buffer[0] != 0xa5 or buffer[1] != FRAME_V2:
+        return None
+    length = buffer[2]
+    if length > 56 or len(buffer) < 8 + length or buffer[7 + length] != 0xff:
+        return None
+    if crc16_ccitt(buffer[1:5 + length]) != (buffer[5 + length] << 8 | buffer[6 + length]):
+        return None
+    return buffer[4], buffer[3], buffer[5:5 + length], 8 + length
+
+
+# 批量样本帧（命令 4）：通道（bit7 为历史回放）| 样本数 | 第一个样本的序号(4) | 时间 ms(4) | 数值(2)
+# 后面每个样本是和上一个的时间差、数值差（zigzag），都是 varint；格式见固件 sample_ring.h
+CMD_SAMPLES = 4
+CMD_HISTORY = 5
+SAMPLE_CHANNELS = ('distance_mm', 'temp_0.1C', 'humi_0.1%')
+
+
+def build_history_request(mask=0, seconds=0, seq=0):
+    """请求最近 seconds 秒的历史样本（0 为下位机缓存的全部），mask 按位选通道，0 为全部"""
+    return build_frame_v2(CMD_HISTORY, bytes([mask & 0xff, (seconds >> 8) & 0xff, seconds & 0xff]), seq)
+
+
+def decode_samples(data):
+    """
+    解批量样本帧的数据部分
+    :return: (通道, 是否历史回放, [(序号, 时间ms, 数值), ...])
+    """
+    def varint(pos):
+        v = shift = 0
+        while True:
+            b = data[pos]
+            v |= (b & 0x7f) << shift
+            pos += 1
+            shift += 7
+            if not b & 0x80:
+                return v, pos
+
+    seq, tick = struct.unpack('>II', data[2:10])
+    value = struct.unpack('>h', data[10:12])[0]
+    samples = [(seq, tick, value)]
+    pos = 12
+    for _ in range(data[1] - 1):
+        dt, pos = varint(pos)
+        dv, pos = varint(pos)
+        seq += 1
+        tick = (tick + dt) & 0xffffffff
+        value += (dv >> 1) ^ -(dv & 1)
+        samples.append((seq, tick, value))
+    return data[0] & 0x7f, bool(data[0] & 0x80), samples
+
+
+# 分拣完成帧（命令 6）：舵机到位并松开后下位机主动发，分类 | 角度 | 序号 | 到位用时 ms(2)
+CMD_SORT_DONE = 6
+
+
+def decode_sort_done(data):
+    """:return: (分类, 角度, 序号, 到位用时 ms)，序号不连续说明中间有通知丢了"""
+    return data[0], data[1], data[2], data[3] << 8 | data[4]
+
+
+# 低功耗帧（命令 7）：请求带 3 字节（允许 Stop | 进入省电的空闲秒数(2)）会改配置，空请求只查询；
+# 回复：模式 | 允许 Stop | 空闲秒数(2) | 运行/Sleep/Stop ms(各 4) | Stop 次数(4)
+#      | RTC/串口/USB 唤醒次数(各 2) | 唤醒平均/最大 us(各 2) | LSI Hz(2)
+# 省电模式下串口唤醒的第一个字节会丢，先 send_wake_preamble 再发命令
+CMD_POWER = 7
+POWER_MODES = ('run', 'save')
+
+
+def build_power_request(stop_enable=None, save_delay_s=30, seq=0):
+    """stop_enable 为 None 时只查询；save_delay_s 为 0 时一直不进省电"""
+    if stop_enable is None:
+        return build_frame_v2(CMD_POWER, b'', seq)
+    return build_frame_v2(CMD_POWER, bytes([1 if stop_enable else 0]) + struct.pack('>H', save_delay_s), seq)
+
+
+def decode_power(data):
+    names = ('mode', 'stop_enable', 'save_delay_s', 'run_ms', 'sleep_ms', 'stop_ms', 'stops',
+             'wake_rtc', 'wake_uart', 'wake_usb', 'wake_us_avg', 'wake_us_max', 'rtc_hz')
+    stats = dict(zip(names, struct.unpack('>BBHIIIIHHHHHH', data[:32])))
+    stats['mode'] = POWER_MODES[stats['mode']] if stats['mode'] < len(POWER_MODES) else stats['mode']
+    return stats
+
+
+# CPU 剖析帧（命令 8）：请求带 1 字节（1 为读完清零）或空；下位机先回一帧汇总，再每个探针一帧
+# 汇总：0xff | 探针数 | 上个窗口空闲率 0.01%(2) | 最低窗口空闲率(2) | 统计时长 ms(4) | CPU MHz | 直方图起点
+# 探针：编号 | 次数(4) | 最小/最大/平均周期(各 4) | 占 CPU 0.01%(2) | log2 直方图 16 格(各 2)
+# 直方图第 0 格 < 2^(起点+1) 周期，第 i 格 [2^(i+起点), 2^(i+起点+1))，最后一格不封顶；格式见固件 cpu_prof.h
+CMD_PROF = 8
+PROF_SUMMARY_ID = 0xff
+PROF_PROBES = ('task_command', 'task_ultrasound', 'task_dht11', 'task_fan', 'task_telemetry', 'task_oled',
+               'idle', 'systick', 'usart1_irq', 'tim2_irq', 'usb_irq', 'exti15_10_irq', 'oled_flush', 'dht11_decode')
+
+
+def build_prof_request(reset=False, seq=0):
+    return build_frame_v2(CMD_PROF, bytes([1 if reset else 0]), seq)
+
+
+def decode_prof(data):
+    """
+    :return: 汇总帧 ('summary', {...})，探针帧 (探针名, {...})，周期数按 CPU 时钟换算成 us 要除以 MHz
+    """
+    if data[0] == PROF_SUMMARY_ID:
+        idle, idle_min, ms = struct.unpack('>HHI', data[2:10])
+        return 'summary', {'probes': data[1], 'idle_pct': idle / 100, 'idle_min_pct': idle_min / 100,
+                           'span_ms': ms, 'mhz': data[10], 'hist_shift': data[11]}
+    count, cmin, cmax, mean, load = struct.unpack('>IIIIH', data[1:19])
+    hist = struct.unpack('>16H', data[19:51])
+    name = PROF_PROBES[data[0]] if data[0] < len(PROF_PROBES) else 'probe%d' % data[0]
+    return name, {'count': count, 'min': cmin, 'max': cmax, 'mean': mean, 'cpu_pct': load / 100, 'hist': hist}
+
+
+# 请求 / 应答：下位机对每个 v2 请求回 ACK（命令 9）：请求序号 | 请求命令 | 状态，状态非 0 为 NACK，
+# bit7 表示是重复的请求（下位机 2s 内见过同序号同命令的帧，只回第一次的结果，不再执行）
+CMD_RESEND = 2
+CMD_REQUIRE = 3
+CMD_ACK = 9
+ACK_STATUS = ('ok', 'bad_len', 'bad_arg', 'unknown', 'gone', 'busy')
+ACK_DUP = 0x80
+REQUIRE_DISTANCE = 0x01
+REQUIRE_DHT11 = 0x02
+TX_HISTORY_NUM = 16     # 下位机发送历史的帧数，RESEND 最多要这么多帧
+
+
+def decode_ack(data):
+    """:return: (请求序号, 请求命令, 状态名, 是否重复请求)"""
+    status = data[2] & 0x7f
+    name = ACK_STATUS[status] if status < len(ACK_STATUS) else 'status%d' % status
+    return data[0], data[1], name, bool(data[2] & ACK_DUP)
+
+
+def build_require_request(mask=0, seq=0):
+    """按需读取传感器，mask 按位选（REQUIRE_DISTANCE / REQUIRE_DHT11），0 为全部"""
+    return build_frame_v2(CMD_REQUIRE, bytes([mask & 0xff]), seq)
+
+
+def decode_require(data):
+    """:return: 各传感器最近一次的结果和数据龄 ms，没有请求或还没有数据的为 None"""
+    mask = data[0]
+    dist, dist_age, temp, humi, dht_age = struct.unpack('>HHhhH', data[1:11])
+    result = {'distance_mm': None, 'distance_age_ms': None, 'temp_0.1C': None, 'humi_0.1%': None, 'dht11_age_ms': None}
+    if mask & REQUIRE_DISTANCE and dist_age != 0xffff:
+        result.update({'distance_mm': dist, 'distance_age_ms': dist_age})
+    if mask & REQUIRE_DHT11 and dht_age != 0xffff:
+        result.update({'temp_0.1C': temp, 'humi_0.1%': humi, 'dht11_age_ms': dht_age})
+    return result
+
+
+def build_resend_request(count, from_seq=None, seq=0):
+    """要求下位机按原序号重发 count 帧，from_seq 省略时为最近的 count 帧"""
+    data = bytes([count]) if from_seq is None else bytes([count, from_seq & 0xff])
+    return build_frame_v2(CMD_RESEND, data, seq)
+
+
+# 传感器 TLV 遥测（命令 10）：每个有数据的传感器一条 编号 | 类型 | 数值（高位在前），
+# 类型高 4 位是数据类型、低 4 位是数值字节数，不认识的编号按长度跳过；格式见固件 sensor_tlv.h
+# 描述符（命令 11）：请求带 1 字节选遥测格式（1 为 TLV，0 为改回命令 1）或空（TLV）；
+# 回复 传感器总数 | 本帧第一个的下标 | 每个传感器 14 字节：编号 | 类型 | 单位 | scale(有符号) | 周期 ms(2) | 名字(8)
+CMD_SENSORS = 10
+CMD_DESCRIBE = 11
+SENSOR_DTYPES = ('u8', 'i8', 'u16', 'i16', 'u32', 'i32')
+SENSOR_UNITS = ('', 'ms', 'mm', 'C', '%RH', 'deg', '%')
+SENSOR_DESC_SIZE = 14
+
+
+def build_describe_request(tlv=True, seq=0):
+    return build_frame_v2(CMD_DESCRIBE, bytes([1 if tlv else 0]), seq)
+
+
+def decode_descriptors(data, descriptors=None):
+    """
+    :param descriptors: 前面几帧解出来的，按编号累加进去
+    :return: (描述符 {编号: {...}}, 是否已经收齐)
+    """
+    descriptors = {} if descriptors is None else descriptors
+    total = data[0]
+    for off in range(2, len(data) - SENSOR_DESC_SIZE + 1, SENSOR_DESC_SIZE):
+        sid, dtype, unit, scale, period = struct.unpack('>BBBbH', data[off:off + 6])
+        descriptors[sid] = {'name': data[off + 6:off + 14].decode('ascii', 'replace').rstrip(),
+                            'dtype': SENSOR_DTYPES[dtype >> 4] if dtype >> 4 < len(SENSOR_DTYPES) else dtype >> 4,
+                            'unit': SENSOR_UNITS[unit] if unit < len(SENSOR_UNITS) else unit,
+                            'scale': scale, 'period_ms': period}
+    return descriptors, len(descriptors) >= total
+
+
+def decode_tlv(data, descriptors=None):
+    """
+    :param descriptors: decode_descriptors 的结果，有的话按 scale 换算并用名字做键
+    :return: {名字或编号: 数值}
+    """
+    result = {}
+    off = 0
+    while off + 2 <= len(data):
+        sid, dtype = data[off], data[off + 1]
+        n = dtype & 0x0f
+        raw = data[off + 2:off + 2 + n]
+        off += 2 + n
+        if len(raw) < n:
+            break
+        value = int.from_bytes(raw, 'big', signed=bool((dtype >> 4) & 1))
+        desc = descriptors.get(sid) if descriptors else None
+        if desc is None:
+            result[sid] = value
+        else:
+            result[desc['name']] = value * 10 ** desc['scale'] if desc['scale'] else value
+    return result
+
+
+# 满溢检测（命令 12）：请求 操作 [| 空桶 mm(2) | 满桶 mm(2)]，空请求只查询；
+# 回复 状态 | 满溢 % | 距离 mm(2) | 空桶 mm(2) | 满桶 mm(2) | 声速 0.1m/s(2) | 野值数(2)
+# 满溢状态变化（命令 13）下位机主动发：状态 | 满溢 % | 距离 mm(2) | 事件序号；遥测帧（命令 1）第 12 字节也带满溢 %
+CMD_FILL = 12
+CMD_FILL_EVENT = 13
+FILL_STATES = ('init', 'normal', 'full', 'fault')
+FILL_QUERY, FILL_SET_EMPTY, FILL_SET_FULL, FILL_SET = range(4)
+
+
+def build_fill_request(op=FILL_QUERY, empty_mm=0, full_mm=0, seq=0):
+    """FILL_SET_EMPTY / FILL_SET_FULL 用下位机当前的距离标定，FILL_SET 直接给两个距离"""
+    if op == FILL_SET:
+        return build_frame_v2(CMD_FILL, bytes([op]) + struct.pack('>HH', empty_mm, full_mm), seq)
+    return build_frame_v2(CMD_FILL, bytes([op]), seq)
+
+
+def _fill_state(state):
+    return FILL_STATES[state] if state < len(FILL_STATES) else state
+
+
+def decode_fill(data):
+    names = ('state', 'pct', 'distance_mm', 'empty_mm', 'full_mm', 'speed_dm', 'outliers')
+    result = dict(zip(names, struct.unpack('>BBHHHHH', data[:12])))
+    result['state'] = _fill_state(result['state'])
+    return result
+
+
+def decode_fill_event(data):
+    """:return: (状态, 满溢 %, 距离 mm, 事件序号)，序号不连续说明中间有事件丢了"""
+    return _fill_state(data[0]), data[1], data[2] << 8 | data[3], data[4]
+
+
+def decode_fill_pct(data):
+    """从遥测帧（命令 1）里取满溢 %，老固件没有这个字节返回 None"""
+    return data[12] if len(data) > 12 else None
+
+
+class CommandLink:
+    """
+    请求 / 应答层：请求带递增序号，可以连发不等应答；超时没等到 ACK 用原序号重发，
+    下位机去重，重发不会执行两次（重试总时长要小于下位机的 2s 去重窗口）。
+    收到的帧按下位机序号找缺口，缺了就发 RESEND。
+    """
+
+    def __init__(self, ser, timeout_s=0.2, retries=3):
+        self.ser = ser
+        self.timeout_s = timeout_s
+        self.retries = retries
+        self.seq = 0
+        self.pending = {}       # 请求序号 -> [帧, 命令, 重发时刻, 已发次数]
+        self.rx_expect = None   # 下一个应该收到的下位机序号
+        self.gaps = 0           # 发现缺的帧数
+
+    def send(self, cmd, data=b''):
+        """发一个请求，返回它的序号"""
+        seq = self.seq
+        self.seq = (self.seq + 1) & 0xff
+        frame = build_frame_v2(cmd, data, seq)
+        self.pending[seq] = [frame, cmd, time.time() + self.timeout_s, 1]
+        self.ser.write(frame)
+        return seq
+
+    def on_frame(self, cmd, seq, data):
+        """
+        把 parse_packet_v2 解出的每一帧交给这里
+        :return: 请求有了结果时返回 (请求序号, 状态名)，否则 None；busy 留着等 poll 重发
+        """
+        self._check_gap(seq)
+        if cmd != CMD_ACK or len(data) < 3:
+            return None
+        req_seq, req_cmd, status, _ = decode_ack(data)
+        entry = self.pending.get(req_seq)
+        if entry is None or entry[1] != req_cmd or status == 'busy':
+            return None
+        del self.pending[req_seq]
+        return req_seq, status
+
+    def poll(self):
+        """重发超时的请求，返回重试用完的 [(请求序号, 命令)]"""
+        now = time.time()
+        failed = []
+        for seq, entry in list(self.pending.items()):
+            if now < entry[2]:
+                continue
+            if entry[3] >= self.retries:
+                del self.pending[seq]
+                failed.append((seq, entry[1]))
+                continue
+            entry[2] = now + self.timeout_s
+            entry[3] += 1
+            self.ser.write(entry[0])
+        return failed
+
+    def _check_gap(self, seq):
+        if self.rx_expect is None:
+            self.rx_expect = (seq + 1) & 0xff
+            return
+        ahead = (seq - self.rx_expect) & 0xff
+        if ahead >= 0x80:
+            return              # 重发回来的旧帧
+        if ahead:
+            # 下位机只留最近 TX_HISTORY_NUM 帧，更早的要了也没有
+            self.gaps += ahead
+            count = min(ahead, TX_HISTORY_NUM)
+            self.send(CMD_RESEND, bytes([count, (seq - count) & 0xff]))
+        self.rx_expect = (seq + 1) & 0xff
 
-    # oled屏幕是否显示，1显示，0关闭
-    tmp1 = oled
-    packet += tmp1
 
-    # 识别的垃圾种类，0无，1-4对应四种垃圾
-    # tmp1 = b'\x04'
-    tmp1 = motor_send_data
-    packet += tmp1
+def send_wake_preamble(ser, settle_s=0.005):
+    """下位机在 Stop 里时，这个字节的起始位把它叫醒（字节本身会丢），等时钟恢复"""
+    ser.write(b'\x00')
+    ser.flush()
+    time.sleep(settle_s)
 
-    for i in range(56):
-        packet += b'\x00'
 
-    EOF = b'\xff'
-    packet += EOF
+def estimate_current_ma(stats, run_ma=36.0, sleep_ma=14.0, stop_ma=0.024):
+    """按 decode_power 的驻留时间估算 MCU 平均电流（默认值是 F103 72MHz 外设全开的手册典型值）"""
+    total = stats['run_ms'] + stats['sleep_ms'] + stats['stop_ms']
+    if total == 0:
+        return 0.0
+    return (stats['run_ms'] * run_ma + stats['sleep_ms'] * sleep_ma + stats['stop_ms'] * stop_ma) / total
 
-    return packet
 
 def send_packet(ser, packet):
     # 发送数据
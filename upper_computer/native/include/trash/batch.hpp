@@ -0,0 +1,120 @@
+// 批量解码：字节流直接解成按列存放的数组，Python 那边用 numpy.frombuffer 零拷贝拿走
+// 每一列的格式字符和 Python struct / 缓冲区协议一致（B H h I i d），本机字节序
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <vector>
+
+#include "trash/frame.hpp"
+
+namespace trash {
+
+class Column {
+public:
+    Column(const char *name, char format, size_t item) : name_(name), format_(format), item_(item) {}
+
+    template <class T>
+    void push(T v)
+    {
+        static_assert(sizeof(T) <= 8, "column item too large");
+        size_t n = data_.size();
+        data_.resize(n + sizeof(T));
+        memcpy(data_.data() + n, &v, sizeof(T));
+    }
+
+    const char *name() const { return name_; }
+    char format() const { return format_; }
+    size_t rows() const { return data_.size() / item_; }
+    const std::vector<uint8_t> &data() const { return data_; }
+    void clear() { data_.clear(); }
+    void truncate(size_t rows) { data_.resize(rows * item_); }
+
+private:
+    const char *name_;
+    char format_;
+    size_t item_;
+    std::vector<uint8_t> data_;
+};
+
+// 几列同样行数的数据
+class Table {
+public:
+    Table(std::initializer_list<Column> columns) : columns_(columns) {}
+
+    Column &operator[](size_t i) { return columns_[i]; }
+    const std::vector<Column> &columns() const { return columns_; }
+    size_t rows() const { return columns_.empty() ? 0 : columns_[0].rows(); }
+    void clear()
+    {
+        for (auto &c : columns_) {
+            c.clear();
+        }
+    }
+    // 一帧解到一半坏了，退回到这一帧之前
+    void truncate(size_t rows)
+    {
+        for (auto &c : columns_) {
+            c.truncate(rows);
+        }
+    }
+
+private:
+    std::vector<Column> columns_;
+};
+
+// 遥测帧（命令 1，v1 和 v2）每帧一行；满溢 % 为 255 表示帧里没有
+enum TelemetryColumn { kTelHostTime, kTelVersion, kTelSeq, kTelDistance, kTelTemp, kTelHumi, kTelFill };
+// 批量样本帧（命令 4）展开成每个样本一行
+enum SampleColumn { kSmpChannel, kSmpHistory, kSmpSeq, kSmpTick, kSmpValue };
+// TLV 传感器帧（命令 10）每条记录一行，frame 是这一批里的帧号，同一帧的记录同一时刻
+enum SensorColumn { kSenHostTime, kSenFrame, kSenId, kSenValue };
+
+// 其他命令的帧原样留给调用者（ACK、分拣完成、满溢事件等，频率低）
+struct RawFrame {
+    double host_time;
+    uint8_t version;
+    uint8_t cmd;
+    uint8_t seq;
+    std::vector<uint8_t> data;
+};
+
+struct BatchStats {
+    uint64_t telemetry = 0;
+    uint64_t samples = 0;        // 展开后的样本数
+    uint64_t sensors = 0;        // TLV 记录数
+    uint64_t malformed = 0;      // CRC 对但数据部分解不了的帧
+};
+
+class BatchDecoder {
+public:
+    // raw 为 true 时不按命令分表，所有帧都放进 frames（下位机一侧收命令用，命令 1 是 COMMOND 不是遥测）
+    explicit BatchDecoder(bool accept_host_v1 = false, bool raw = false);
+
+    // host_time 记在这一批解出来的每一行上（一般是读到这批字节的时刻）
+    size_t feed(const uint8_t *data, size_t len, double host_time);
+    void clear();
+
+    Table telemetry;
+    Table samples;
+    Table sensors;
+    std::vector<RawFrame> frames;
+
+    const DecoderStats &decoder_stats() const { return decoder_.stats(); }
+    const BatchStats &stats() const { return stats_; }
+
+private:
+    void on_frame(const Frame &f, double host_time);
+    void on_telemetry(const Frame &f, double host_time);
+    bool on_samples(const Frame &f);
+    bool on_sensors(const Frame &f, double host_time);
+
+    FrameDecoder decoder_;
+    BatchStats stats_;
+    uint32_t sensor_frames_ = 0;
+    bool raw_;
+};
+
+}  // namespace trash
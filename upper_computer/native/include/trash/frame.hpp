@@ -0,0 +1,137 @@
+// 帧协议：和固件 Connectivity_Protocal.h 一致
+// v1：a5 | 00 | 长度(2，不用) | 命令 | 数据(56) | CRC16(2) | 帧尾，共 64 字节
+//     下位机发的 v1 帧 CRC16 覆盖前 61 字节、帧尾是 'o'；上位机发的不算 CRC、帧尾是 0xff
+// v2：a5 | 02 | 数据长度 | 序号 | 命令 | 数据(0~56) | CRC16(2，高字节在前) | ff
+//     CRC16 为 CCITT（多项式 0x1021，初值 0xffff），范围从版本号到数据最后一个字节
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace trash {
+
+constexpr uint8_t kHead = 0xa5;
+constexpr uint8_t kTail = 0xff;
+constexpr uint8_t kTailV1Mcu = 'o';
+constexpr uint8_t kV1 = 0x00;
+constexpr uint8_t kV2 = 0x02;
+constexpr size_t kV1Size = 64;
+constexpr size_t kV2HeadSize = 5;
+constexpr size_t kV2Overhead = 8;
+constexpr size_t kDataMax = 56;
+
+// 命令号，见固件 Connectivity_Protocal.h
+enum Cmd : uint8_t {
+    kCmdTelemetry = 1,
+    kCmdResend = 2,
+    kCmdRequire = 3,
+    kCmdSamples = 4,
+    kCmdHistory = 5,
+    kCmdSortDone = 6,
+    kCmdPower = 7,
+    kCmdProf = 8,
+    kCmdAck = 9,
+    kCmdSensors = 10,
+    kCmdDescribe = 11,
+    kCmdFill = 12,
+    kCmdFillEvent = 13,
+};
+
+uint16_t crc16_ccitt(const uint8_t *data, size_t len, uint16_t crc = 0xffff);
+
+// 解出来的一帧，data 指向解码器内部缓冲区，只在回调里有效
+struct Frame {
+    uint8_t version;
+    uint8_t cmd;
+    uint8_t seq;
+    uint8_t length;
+    const uint8_t *data;
+};
+
+struct DecoderStats {
+    uint64_t bytes = 0;
+    uint64_t frames = 0;
+    uint64_t crc_errors = 0;     // 帧长、帧尾对但 CRC 不对
+    uint64_t resync = 0;         // 帧头后内容不对、从下一个 0xa5 重新找的次数
+    uint64_t skipped = 0;        // 重新同步时丢掉的字节
+};
+
+// 流式解帧：找 0xa5 帧头，按版本确定帧长，校验失败就从这个帧头后面的下一个 0xa5 重新找
+// （数据里出现的 0xa5 不会把后面的真帧吃掉）。不完整的帧留到下次 feed
+class FrameDecoder {
+public:
+    // accept_host_v1：也收上位机发的 v1 帧（不带 CRC、帧尾 0xff），仿真下位机用
+    explicit FrameDecoder(bool accept_host_v1 = false) : accept_host_v1_(accept_host_v1) {}
+
+    // on_frame(const Frame &)，返回处理了多少帧
+    template <class F>
+    size_t feed(const uint8_t *data, size_t len, F &&on_frame);
+
+    const DecoderStats &stats() const { return stats_; }
+    void reset() { buf_.clear(); }
+
+private:
+    // 判断 p 开头是不是一帧：>0 为帧长，0 为字节不够，<0 为不是帧
+    long check(const uint8_t *p, size_t avail, Frame *frame);
+
+    std::vector<uint8_t> buf_;
+    DecoderStats stats_;
+    bool accept_host_v1_;
+};
+
+// 编一个 v2 帧，out 至少 kV2Overhead + len 字节，返回帧长；len 超过 kDataMax 返回 0
+size_t encode_v2(uint8_t *out, uint8_t cmd, uint8_t seq, const uint8_t *data, size_t len);
+// 编一个旧上位机的 v1 分拣命令帧（64 字节）：oled 开关 | 分类
+size_t encode_v1(uint8_t *out, uint8_t oled, uint8_t cls);
+
+template <class F>
+size_t FrameDecoder::feed(const uint8_t *data, size_t len, F &&on_frame)
+{
+    size_t count = 0;
+    size_t pos = 0;
+
+    stats_.bytes += len;
+    // 缓冲区是空的时候直接在输入上解，只把最后不完整的一帧拷进来
+    const uint8_t *p = data;
+    size_t avail = len;
+    if (!buf_.empty()) {
+        buf_.insert(buf_.end(), data, data + len);
+        p = buf_.data();
+        avail = buf_.size();
+    }
+    while (pos < avail) {
+        const uint8_t *head = static_cast<const uint8_t *>(memchr(p + pos, kHead, avail - pos));
+        if (head == nullptr) {
+            stats_.skipped += avail - pos;
+            pos = avail;
+            break;
+        }
+        stats_.skipped += head - (p + pos);
+        pos = head - p;
+        Frame frame;
+        long n = check(p + pos, avail - pos, &frame);
+        if (n == 0) {
+            break;
+        }
+        if (n < 0) {
+            stats_.resync++;
+            stats_.skipped++;
+            pos++;
+            continue;
+        }
+        stats_.frames++;
+        count++;
+        on_frame(frame);
+        pos += n;
+    }
+    if (p == data) {
+        buf_.assign(data + pos, data + avail);
+    } else {
+        buf_.erase(buf_.begin(), buf_.begin() + pos);
+    }
+    return count;
+}
+
+}  // namespace trash
@@ -0,0 +1,40 @@
+// Linux 串口：termios 原始模式、非阻塞，用 epoll 等数据，真串口、USB CDC（ttyACM）和仿真的 PTY 都能用
+// 出错抛 std::system_error；对端挂断（拔线、仿真退出）读的时候抛 EIO，调用者关掉重开
+// 一个线程读、另一个线程写可以同时进行（读等 epoll，写等 poll，各等各的）；两个线程同时读或同时写、
+// 或者读写的时候 close() 都不行
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace trash {
+
+class SerialPort {
+public:
+    SerialPort(const std::string &path, unsigned baud = 115200);
+    ~SerialPort();
+    SerialPort(const SerialPort &) = delete;
+    SerialPort &operator=(const SerialPort &) = delete;
+
+    int fd() const { return fd_; }
+    const std::string &path() const { return path_; }
+    bool is_open() const { return fd_ >= 0; }
+
+    // 最多等 timeout_ms（-1 一直等）有数据，然后读到没有为止，追加到 out 后面；返回读到的字节数，0 为超时
+    size_t read(std::vector<uint8_t> &out, int timeout_ms);
+    // 写完为止，发送缓冲区满了每次最多等 timeout_ms；返回写出去的字节数，等超时了会比 len 少，调用者要检查
+    size_t write(const uint8_t *data, size_t len, int timeout_ms);
+    void close();
+
+private:
+    bool wait_readable(int timeout_ms);
+    bool wait_writable(int timeout_ms);
+
+    std::string path_;
+    int fd_ = -1;
+    int epfd_ = -1;
+};
+
+}  // namespace trash
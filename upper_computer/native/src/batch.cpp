@@ -0,0 +1,189 @@
+#include "trash/batch.hpp"
+
+namespace trash {
+
+namespace {
+
+uint16_t be16(const uint8_t *p)
+{
+    return static_cast<uint16_t>(p[0] << 8 | p[1]);
+}
+
+uint32_t be32(const uint8_t *p)
+{
+    return static_cast<uint32_t>(p[0]) << 24 | static_cast<uint32_t>(p[1]) << 16 | static_cast<uint32_t>(p[2]) << 8 | p[3];
+}
+
+// varint：每字节低 7 位，bit7 表示后面还有；越界返回 false
+bool varint(const uint8_t *&p, const uint8_t *end, uint32_t *v)
+{
+    uint32_t x = 0;
+    for (int shift = 0; shift < 35 && p < end; shift += 7) {
+        uint8_t b = *p++;
+        x |= static_cast<uint32_t>(b & 0x7f) << shift;
+        if (!(b & 0x80)) {
+            *v = x;
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace
+
+BatchDecoder::BatchDecoder(bool accept_host_v1, bool raw)
+    : telemetry{{"host_time", 'd', 8}, {"version", 'B', 1}, {"seq", 'B', 1}, {"distance_mm", 'H', 2},
+                {"temp", 'h', 2}, {"humi", 'H', 2}, {"fill", 'B', 1}},
+      samples{{"channel", 'B', 1}, {"history", 'B', 1}, {"seq", 'I', 4}, {"tick", 'I', 4}, {"value", 'h', 2}},
+      sensors{{"host_time", 'd', 8}, {"frame", 'I', 4}, {"id", 'B', 1}, {"value", 'i', 4}},
+      decoder_(accept_host_v1),
+      raw_(raw)
+{
+}
+
+size_t BatchDecoder::feed(const uint8_t *data, size_t len, double host_time)
+{
+    return decoder_.feed(data, len, [&](const Frame &f) { on_frame(f, host_time); });
+}
+
+void BatchDecoder::clear()
+{
+    telemetry.clear();
+    samples.clear();
+    sensors.clear();
+    frames.clear();
+}
+
+void BatchDecoder::on_frame(const Frame &f, double host_time)
+{
+    bool ok = true;
+
+    switch (raw_ ? -1 : f.cmd) {
+    case kCmdTelemetry:
+        on_telemetry(f, host_time);
+        return;
+    case kCmdSamples:
+        ok = f.version == kV2 && on_samples(f);
+        break;
+    case kCmdSensors:
+        ok = f.version == kV2 && on_sensors(f, host_time);
+        break;
+    default:
+        frames.push_back(RawFrame{host_time, f.version, f.cmd, f.seq, std::vector<uint8_t>(f.data, f.data + f.length)});
+        return;
+    }
+    if (!ok) {
+        stats_.malformed++;
+    }
+}
+
+// v1 和只有 6 字节的老 v2 帧：距离 m(float 高位在前) | 湿度 % | 温度 ℃
+// v2：后面还有 距离 mm(2) | 温度 0.1℃(2) | 湿度 0.1%RH(2) [| 满溢 %]
+void BatchDecoder::on_telemetry(const Frame &f, double host_time)
+{
+    uint16_t distance;
+    int16_t temp;
+    uint16_t humi;
+    uint8_t fill = 0xff;
+
+    if (f.length < 6) {
+        stats_.malformed++;
+        return;
+    }
+    if (f.version == kV2 && f.length >= 12) {
+        distance = be16(f.data + 6);
+        temp = static_cast<int16_t>(be16(f.data + 8));
+        humi = be16(f.data + 10);
+        if (f.length >= 13) {
+            fill = f.data[12];
+        }
+    } else {
+        uint32_t bits = be32(f.data);
+        float m;
+        memcpy(&m, &bits, sizeof(m));
+        distance = (m > 0.0f && m < 65.0f) ? static_cast<uint16_t>(m * 1000.0f + 0.5f) : 0;
+        humi = static_cast<uint16_t>(f.data[4] * 10);
+        temp = static_cast<int16_t>(f.data[5] * 10);
+    }
+    telemetry[kTelHostTime].push(host_time);
+    telemetry[kTelVersion].push(f.version);
+    telemetry[kTelSeq].push(f.seq);
+    telemetry[kTelDistance].push(distance);
+    telemetry[kTelTemp].push(temp);
+    telemetry[kTelHumi].push(humi);
+    telemetry[kTelFill].push(fill);
+    stats_.telemetry++;
+}
+
+// 格式见固件 sample_ring.h：通道 | 样本数 | 序号(4) | 时间 ms(4) | 数值(2)，后面是时间差、数值差（zigzag）的 varint
+bool BatchDecoder::on_samples(const Frame &f)
+{
+    if (f.length < 12 || f.data[1] == 0) {
+        return false;
+    }
+    const uint8_t *p = f.data + 12;
+    const uint8_t *end = f.data + f.length;
+    uint8_t channel = f.data[0] & 0x7f;
+    uint8_t history = (f.data[0] & 0x80) ? 1 : 0;
+    uint32_t seq = be32(f.data + 2);
+    uint32_t tick = be32(f.data + 6);
+    uint32_t value = be16(f.data + 10);     // 无符号累加，溢出按模算，推进表时截成 int16
+    size_t start = samples.rows();
+
+    for (unsigned i = 0; i < f.data[1]; i++) {
+        if (i) {
+            uint32_t dt, dv;
+            if (!varint(p, end, &dt) || !varint(p, end, &dv)) {
+                samples.truncate(start);
+                return false;
+            }
+            seq++;
+            tick += dt;
+            value += (dv >> 1) ^ (0u - (dv & 1));
+        }
+        samples[kSmpChannel].push(channel);
+        samples[kSmpHistory].push(history);
+        samples[kSmpSeq].push(seq);
+        samples[kSmpTick].push(tick);
+        samples[kSmpValue].push(static_cast<int16_t>(static_cast<uint16_t>(value)));
+    }
+    stats_.samples += f.data[1];
+    return true;
+}
+
+// 格式见固件 sensor_tlv.h：编号 | 类型（高 4 位数据类型，低 4 位字节数）| 数值（高位在前）
+// 数据类型 1 / 3 / 5 是有符号的
+bool BatchDecoder::on_sensors(const Frame &f, double host_time)
+{
+    const uint8_t *p = f.data;
+    const uint8_t *end = f.data + f.length;
+    size_t start = sensors.rows();
+
+    while (end - p >= 2) {
+        uint8_t id = p[0];
+        uint8_t type = p[1];
+        size_t n = type & 0x0f;
+        if (n > 4 || static_cast<size_t>(end - p) < 2 + n) {
+            sensors.truncate(start);
+            return false;
+        }
+        uint32_t raw = 0;
+        for (size_t i = 0; i < n; i++) {
+            raw = raw << 8 | p[2 + i];
+        }
+        int32_t value = static_cast<int32_t>(raw);
+        if ((type >> 4) & 1 && n && n < 4 && (raw >> (n * 8 - 1)) & 1) {
+            value = static_cast<int32_t>(raw | (~0u << (n * 8)));
+        }
+        sensors[kSenHostTime].push(host_time);
+        sensors[kSenFrame].push(sensor_frames_);
+        sensors[kSenId].push(id);
+        sensors[kSenValue].push(value);
+        p += 2 + n;
+    }
+    stats_.sensors += sensors.rows() - start;
+    sensor_frames_++;
+    return true;
+}
+
+}  // namespace trash
@@ -0,0 +1,115 @@
+#include "trash/frame.hpp"
+
+#include <array>
+
+namespace trash {
+
+namespace {
+
+// 按字节查表，一个字节一次查表代替 8 次移位
+constexpr std::array<uint16_t, 256> make_crc_table()
+{
+    std::array<uint16_t, 256> table{};
+    for (unsigned i = 0; i < 256; i++) {
+        uint16_t crc = static_cast<uint16_t>(i << 8);
+        for (int k = 0; k < 8; k++) {
+            crc = (crc & 0x8000) ? static_cast<uint16_t>((crc << 1) ^ 0x1021) : static_cast<uint16_t>(crc << 1);
+        }
+        table[i] = crc;
+    }
+    return table;
+}
+
+constexpr std::array<uint16_t, 256> kCrcTable = make_crc_table();
+
+bool crc_ok(const uint8_t *p, size_t len)
+{
+    uint16_t crc = crc16_ccitt(p, len);
+    return p[len] == (crc >> 8) && p[len + 1] == (crc & 0xff);
+}
+
+}  // namespace
+
+uint16_t crc16_ccitt(const uint8_t *data, size_t len, uint16_t crc)
+{
+    for (size_t i = 0; i < len; i++) {
+        crc = static_cast<uint16_t>((crc << 8) ^ kCrcTable[((crc >> 8) ^ data[i]) & 0xff]);
+    }
+    return crc;
+}
+
+long FrameDecoder::check(const uint8_t *p, size_t avail, Frame *frame)
+{
+    if (avail < 2) {
+        return 0;
+    }
+    if (p[1] == kV1) {
+        if (avail < kV1Size) {
+            return 0;
+        }
+        if (p[kV1Size - 1] == kTailV1Mcu) {
+            if (!crc_ok(p, kV1Size - 3)) {
+                stats_.crc_errors++;
+                return -1;
+            }
+        } else if (!(accept_host_v1_ && p[kV1Size - 1] == kTail)) {
+            return -1;
+        }
+        *frame = Frame{kV1, p[4], 0, static_cast<uint8_t>(kDataMax), p + 5};
+        return kV1Size;
+    }
+    if (p[1] != kV2) {
+        return -1;
+    }
+    if (avail < 3) {
+        return 0;
+    }
+    size_t length = p[2];
+    if (length > kDataMax) {
+        return -1;
+    }
+    if (avail < kV2Overhead + length) {
+        return 0;
+    }
+    if (p[kV2HeadSize + length + 2] != kTail) {
+        return -1;
+    }
+    if (!crc_ok(p + 1, kV2HeadSize - 1 + length)) {
+        stats_.crc_errors++;
+        return -1;
+    }
+    *frame = Frame{kV2, p[4], p[3], static_cast<uint8_t>(length), p + kV2HeadSize};
+    return static_cast<long>(kV2Overhead + length);
+}
+
+size_t encode_v2(uint8_t *out, uint8_t cmd, uint8_t seq, const uint8_t *data, size_t len)
+{
+    if (len > kDataMax) {
+        return 0;
+    }
+    out[0] = kHead;
+    out[1] = kV2;
+    out[2] = static_cast<uint8_t>(len);
+    out[3] = seq;
+    out[4] = cmd;
+    if (len) {
+        memcpy(out + kV2HeadSize, data, len);
+    }
+    uint16_t crc = crc16_ccitt(out + 1, kV2HeadSize - 1 + len);
+    out[kV2HeadSize + len] = static_cast<uint8_t>(crc >> 8);
+    out[kV2HeadSize + len + 1] = static_cast<uint8_t>(crc);
+    out[kV2HeadSize + len + 2] = kTail;
+    return kV2Overhead + len;
+}
+
+size_t encode_v1(uint8_t *out, uint8_t oled, uint8_t cls)
+{
+    memset(out, 0, kV1Size);
+    out[0] = kHead;
+    out[5] = oled;
+    out[6] = cls;
+    out[kV1Size - 1] = kTail;
+    return kV1Size;
+}
+
+}  // namespace trash
@@ -0,0 +1,429 @@
+// Python 绑定（CPython C API，不依赖 pybind11 / numpy 头文件）
+// 列数据以带格式的 memoryview 返回，numpy.asarray 直接零拷贝用；包装见 upper_computer/trash_link.py
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <cerrno>
+#include <ctime>
+#include <memory>
+#include <system_error>
+
+#include "trash/batch.hpp"
+#include "trash/frame.hpp"
+#include "trash/serial_port.hpp"
+
+namespace {
+
+double now_s()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<double>(ts.tv_sec) + ts.tv_nsec * 1e-9;
+}
+
+PyObject *set_os_error(const std::system_error &e, const std::string &path)
+{
+    errno = e.code().value();
+    return PyErr_SetFromErrnoWithFilename(PyExc_OSError, path.c_str());
+}
+
+// 一列：bytes 拷一次，再 cast 成对应格式的 memoryview
+PyObject *column_view(const trash::Column &c)
+{
+    PyObject *bytes = PyBytes_FromStringAndSize(reinterpret_cast<const char *>(c.data().data()),
+                                                static_cast<Py_ssize_t>(c.data().size()));
+    if (bytes == nullptr) {
+        return nullptr;
+    }
+    PyObject *mv = PyMemoryView_FromObject(bytes);
+    Py_DECREF(bytes);
+    if (mv == nullptr) {
+        return nullptr;
+    }
+    char fmt[2] = {c.format(), 0};
+    PyObject *cast = PyObject_CallMethod(mv, "cast", "s", fmt);
+    Py_DECREF(mv);
+    return cast;
+}
+
+PyObject *table_dict(const trash::Table &t)
+{
+    PyObject *d = PyDict_New();
+    if (d == nullptr) {
+        return nullptr;
+    }
+    for (const auto &c : t.columns()) {
+        PyObject *v = column_view(c);
+        if (v == nullptr || PyDict_SetItemString(d, c.name(), v) != 0) {
+            Py_XDECREF(v);
+            Py_DECREF(d);
+            return nullptr;
+        }
+        Py_DECREF(v);
+    }
+    return d;
+}
+
+// ---------------------------------------------------------------- Decoder
+
+struct DecoderObject {
+    PyObject_HEAD
+    trash::BatchDecoder *decoder;
+};
+
+int Decoder_init(DecoderObject *self, PyObject *args, PyObject *kwds)
+{
+    static const char *kwlist[] = {"accept_host_v1", "raw", nullptr};
+    int accept_host_v1 = 0;
+    int raw = 0;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|pp", const_cast<char **>(kwlist), &accept_host_v1, &raw)) {
+        return -1;
+    }
+    delete self->decoder;
+    self->decoder = new trash::BatchDecoder(accept_host_v1 != 0, raw != 0);
+    return 0;
+}
+
+void Decoder_dealloc(DecoderObject *self)
+{
+    delete self->decoder;
+    Py_TYPE(self)->tp_free(reinterpret_cast<PyObject *>(self));
+}
+
+// __new__ 出来没调 __init__（子类忘了 super().__init__()）时 decoder 是空的
+bool Decoder_check(DecoderObject *self)
+{
+    if (self->decoder == nullptr) {
+        PyErr_SetString(PyExc_ValueError, "decoder is not initialized");
+        return false;
+    }
+    return true;
+}
+
+PyObject *Decoder_feed(DecoderObject *self, PyObject *args)
+{
+    Py_buffer buf;
+    PyObject *t = Py_None;
+
+    if (!Decoder_check(self) || !PyArg_ParseTuple(args, "y*|O", &buf, &t)) {
+        return nullptr;
+    }
+    double host_time = t == Py_None ? now_s() : PyFloat_AsDouble(t);
+    if (host_time == -1.0 && PyErr_Occurred()) {
+        PyBuffer_Release(&buf);
+        return nullptr;
+    }
+    size_t n = self->decoder->feed(static_cast<const uint8_t *>(buf.buf), static_cast<size_t>(buf.len), host_time);
+    PyBuffer_Release(&buf);
+    return PyLong_FromSize_t(n);
+}
+
+PyObject *Decoder_take(DecoderObject *self, PyObject *)
+{
+    if (!Decoder_check(self)) {
+        return nullptr;
+    }
+    trash::BatchDecoder *d = self->decoder;
+    PyObject *result = Py_BuildValue("{s:N,s:N,s:N}", "telemetry", table_dict(d->telemetry), "samples",
+                                     table_dict(d->samples), "sensors", table_dict(d->sensors));
+    if (result == nullptr) {
+        return nullptr;
+    }
+    PyObject *frames = PyList_New(static_cast<Py_ssize_t>(d->frames.size()));
+    if (frames == nullptr) {
+        Py_DECREF(result);
+        return nullptr;
+    }
+    for (size_t i = 0; i < d->frames.size(); i++) {
+        const trash::RawFrame &f = d->frames[i];
+        // 空 vector 的 data() 可能是空指针，y# 遇到空指针给的是 None 不是 b''
+        const char *data = f.data.empty() ? "" : reinterpret_cast<const char *>(f.data.data());
+        PyObject *item = Py_BuildValue("(BBy#Bd)", f.cmd, f.seq, data,
+                                       static_cast<Py_ssize_t>(f.data.size()), f.version, f.host_time);
+        if (item == nullptr) {
+            Py_DECREF(frames);
+            Py_DECREF(result);
+            return nullptr;
+        }
+        PyList_SET_ITEM(frames, i, item);
+    }
+    PyDict_SetItemString(result, "frames", frames);
+    Py_DECREF(frames);
+    d->clear();
+    return result;
+}
+
+PyObject *Decoder_stats(DecoderObject *self, PyObject *)
+{
+    if (!Decoder_check(self)) {
+        return nullptr;
+    }
+    const trash::DecoderStats &s = self->decoder->decoder_stats();
+    const trash::BatchStats &b = self->decoder->stats();
+    return Py_BuildValue("{s:K,s:K,s:K,s:K,s:K,s:K,s:K,s:K,s:K}", "bytes", s.bytes, "frames", s.frames,
+                         "crc_errors", s.crc_errors, "resync", s.resync, "skipped", s.skipped, "telemetry",
+                         b.telemetry, "samples", b.samples, "sensors", b.sensors, "malformed", b.malformed);
+}
+
+PyMethodDef Decoder_methods[] = {
+    {"feed", reinterpret_cast<PyCFunction>(Decoder_feed), METH_VARARGS,
+     "feed(data, host_time=None) -> 解出的帧数；host_time 默认为当前时间"},
+    {"take", reinterpret_cast<PyCFunction>(Decoder_take), METH_NOARGS,
+     "take() -> {'telemetry': {列: memoryview}, 'samples': ..., 'sensors': ..., "
+     "'frames': [(cmd, seq, data, version, host_time)]}，取走后清空"},
+    {"stats", reinterpret_cast<PyCFunction>(Decoder_stats), METH_NOARGS, "累计统计"},
+    {nullptr, nullptr, 0, nullptr},
+};
+
+PyTypeObject DecoderType = {PyVarObject_HEAD_INIT(nullptr, 0)};
+
+// ---------------------------------------------------------------- Port
+
+struct PortObject {
+    PyObject_HEAD
+    trash::SerialPort *port;
+    std::vector<uint8_t> *rx;
+};
+
+int Port_init(PortObject *self, PyObject *args, PyObject *kwds)
+{
+    static const char *kwlist[] = {"path", "baud", nullptr};
+    const char *path;
+    unsigned baud = 115200;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "s|I", const_cast<char **>(kwlist), &path, &baud)) {
+        return -1;
+    }
+    try {
+        delete self->port;
+        self->port = nullptr;
+        self->port = new trash::SerialPort(path, baud);
+    } catch (const std::system_error &e) {
+        set_os_error(e, path);
+        return -1;
+    }
+    if (self->rx == nullptr) {
+        self->rx = new std::vector<uint8_t>();
+    }
+    return 0;
+}
+
+void Port_dealloc(PortObject *self)
+{
+    delete self->port;
+    delete self->rx;
+    Py_TYPE(self)->tp_free(reinterpret_cast<PyObject *>(self));
+}
+
+bool Port_check(PortObject *self)
+{
+    if (self->port == nullptr || !self->port->is_open()) {
+        PyErr_SetString(PyExc_ValueError, "port is closed");
+        return false;
+    }
+    return true;
+}
+
+// 读的时候放开 GIL，别的线程（Streamlit、HTTP）照常跑
+bool Port_read_raw(PortObject *self, int timeout_ms)
+{
+    bool ok = true;
+    std::system_error err(0, std::generic_category());
+
+    self->rx->clear();
+    Py_BEGIN_ALLOW_THREADS
+    try {
+        self->port->read(*self->rx, timeout_ms);
+    } catch (const std::system_error &e) {
+        err = e;
+        ok = false;
+    }
+    Py_END_ALLOW_THREADS
+    if (!ok) {
+        set_os_error(err, self->port->path());
+    }
+    return ok;
+}
+
+PyObject *Port_read(PortObject *self, PyObject *args)
+{
+    int timeout_ms = -1;
+
+    if (!PyArg_ParseTuple(args, "|i", &timeout_ms) || !Port_check(self) || !Port_read_raw(self, timeout_ms)) {
+        return nullptr;
+    }
+    return PyBytes_FromStringAndSize(reinterpret_cast<const char *>(self->rx->data()),
+                                     static_cast<Py_ssize_t>(self->rx->size()));
+}
+
+PyObject *Port_poll(PortObject *self, PyObject *args)
+{
+    DecoderObject *decoder;
+    int timeout_ms = -1;
+
+    if (!PyArg_ParseTuple(args, "O!|i", &DecoderType, &decoder, &timeout_ms) || !Decoder_check(decoder) ||
+        !Port_check(self) || !Port_read_raw(self, timeout_ms)) {
+        return nullptr;
+    }
+    decoder->decoder->feed(self->rx->data(), self->rx->size(), now_s());
+    return PyLong_FromSize_t(self->rx->size());
+}
+
+PyObject *Port_write(PortObject *self, PyObject *args)
+{
+    Py_buffer buf;
+    int timeout_ms = 1000;
+    size_t n = 0;
+    bool ok = true;
+    std::system_error err(0, std::generic_category());
+
+    if (!PyArg_ParseTuple(args, "y*|i", &buf, &timeout_ms)) {
+        return nullptr;
+    }
+    if (!Port_check(self)) {
+        PyBuffer_Release(&buf);
+        return nullptr;
+    }
+    Py_BEGIN_ALLOW_THREADS
+    try {
+        n = self->port->write(static_cast<const uint8_t *>(buf.buf), static_cast<size_t>(buf.len), timeout_ms);
+    } catch (const std::system_error &e) {
+        err = e;
+        ok = false;
+    }
+    Py_END_ALLOW_THREADS
+    PyBuffer_Release(&buf);
+    if (!ok) {
+        return set_os_error(err, self->port->path());
+    }
+    return PyLong_FromSize_t(n);
+}
+
+PyObject *Port_fileno(PortObject *self, PyObject *)
+{
+    if (!Port_check(self)) {
+        return nullptr;
+    }
+    return PyLong_FromLong(self->port->fd());
+}
+
+PyObject *Port_close(PortObject *self, PyObject *)
+{
+    if (self->port != nullptr) {
+        self->port->close();
+    }
+    Py_RETURN_NONE;
+}
+
+PyMethodDef Port_methods[] = {
+    {"read", reinterpret_cast<PyCFunction>(Port_read), METH_VARARGS,
+     "read(timeout_ms=-1) -> bytes，超时返回 b''，对端挂断抛 OSError(EIO)"},
+    {"poll", reinterpret_cast<PyCFunction>(Port_poll), METH_VARARGS,
+     "poll(decoder, timeout_ms=-1) -> 读到的字节数，读到的直接喂给 decoder，不经过 Python bytes"},
+    {"write", reinterpret_cast<PyCFunction>(Port_write), METH_VARARGS, "write(data, timeout_ms=1000) -> 写出的字节数"},
+    {"fileno", reinterpret_cast<PyCFunction>(Port_fileno), METH_NOARGS, nullptr},
+    {"close", reinterpret_cast<PyCFunction>(Port_close), METH_NOARGS, nullptr},
+    {nullptr, nullptr, 0, nullptr},
+};
+
+PyTypeObject PortType = {PyVarObject_HEAD_INIT(nullptr, 0)};
+
+// ---------------------------------------------------------------- 函数
+
+PyObject *py_crc16(PyObject *, PyObject *args)
+{
+    Py_buffer buf;
+    unsigned int init = 0xffff;
+
+    if (!PyArg_ParseTuple(args, "y*|I", &buf, &init)) {
+        return nullptr;
+    }
+    uint16_t crc = trash::crc16_ccitt(static_cast<const uint8_t *>(buf.buf), static_cast<size_t>(buf.len),
+                                      static_cast<uint16_t>(init));
+    PyBuffer_Release(&buf);
+    return PyLong_FromLong(crc);
+}
+
+PyObject *py_encode_v2(PyObject *, PyObject *args, PyObject *kwds)
+{
+    static const char *kwlist[] = {"cmd", "data", "seq", nullptr};
+    unsigned char cmd, seq = 0;
+    Py_buffer buf = {};
+    uint8_t out[trash::kV2Overhead + trash::kDataMax];
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "b|y*b", const_cast<char **>(kwlist), &cmd, &buf, &seq)) {
+        return nullptr;
+    }
+    size_t n = trash::encode_v2(out, cmd, seq, static_cast<const uint8_t *>(buf.buf), static_cast<size_t>(buf.len));
+    if (buf.obj != nullptr) {
+        PyBuffer_Release(&buf);
+    }
+    if (n == 0) {
+        PyErr_SetString(PyExc_ValueError, "data longer than 56 bytes");
+        return nullptr;
+    }
+    return PyBytes_FromStringAndSize(reinterpret_cast<const char *>(out), static_cast<Py_ssize_t>(n));
+}
+
+PyObject *py_encode_v1(PyObject *, PyObject *args)
+{
+    unsigned char oled, cls;
+    uint8_t out[trash::kV1Size];
+
+    if (!PyArg_ParseTuple(args, "bb", &oled, &cls)) {
+        return nullptr;
+    }
+    trash::encode_v1(out, oled, cls);
+    return PyBytes_FromStringAndSize(reinterpret_cast<const char *>(out), sizeof(out));
+}
+
+PyMethodDef module_methods[] = {
+    {"crc16", py_crc16, METH_VARARGS, "crc16(data, init=0xffff) -> CCITT CRC16"},
+    {"encode_v2", reinterpret_cast<PyCFunction>(py_encode_v2), METH_VARARGS | METH_KEYWORDS,
+     "encode_v2(cmd, data=b'', seq=0) -> v2 帧"},
+    {"encode_v1", py_encode_v1, METH_VARARGS, "encode_v1(oled, cls) -> 64 字节的 v1 分拣命令帧"},
+    {nullptr, nullptr, 0, nullptr},
+};
+
+PyModuleDef module_def = {PyModuleDef_HEAD_INIT, "_trash_native", "智慧垃圾桶上位机：帧协议、批量解码和 Linux 串口",
+                          -1, module_methods};
+
+}  // namespace
+
+PyMODINIT_FUNC PyInit__trash_native(void)
+{
+    DecoderType.tp_name = "_trash_native.Decoder";
+    DecoderType.tp_basicsize = sizeof(DecoderObject);
+    DecoderType.tp_flags = Py_TPFLAGS_DEFAULT;
+    DecoderType.tp_doc = "Decoder(accept_host_v1=False, raw=False)：流式解帧 + 按列批量解码";
+    DecoderType.tp_new = PyType_GenericNew;
+    DecoderType.tp_init = reinterpret_cast<initproc>(Decoder_init);
+    DecoderType.tp_dealloc = reinterpret_cast<destructor>(Decoder_dealloc);
+    DecoderType.tp_methods = Decoder_methods;
+
+    PortType.tp_name = "_trash_native.Port";
+    PortType.tp_basicsize = sizeof(PortObject);
+    PortType.tp_flags = Py_TPFLAGS_DEFAULT;
+    PortType.tp_doc = "Port(path, baud=115200)：termios 原始模式 + epoll 的串口，一个线程读、一个线程写可以同时进行";
+    PortType.tp_new = PyType_GenericNew;
+    PortType.tp_init = reinterpret_cast<initproc>(Port_init);
+    PortType.tp_dealloc = reinterpret_cast<destructor>(Port_dealloc);
+    PortType.tp_methods = Port_methods;
+
+    if (PyType_Ready(&DecoderType) < 0 || PyType_Ready(&PortType) < 0) {
+        return nullptr;
+    }
+    PyObject *m = PyModule_Create(&module_def);
+    if (m == nullptr) {
+        return nullptr;
+    }
+    Py_INCREF(&DecoderType);
+    Py_INCREF(&PortType);
+    if (PyModule_AddObject(m, "Decoder", reinterpret_cast<PyObject *>(&DecoderType)) < 0 ||
+        PyModule_AddObject(m, "Port", reinterpret_cast<PyObject *>(&PortType)) < 0) {
+        Py_DECREF(m);
+        return nullptr;
+    }
+    return m;
+}
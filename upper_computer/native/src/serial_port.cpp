@@ -0,0 +1,185 @@
+#include "trash/serial_port.hpp"
+
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <system_error>
+#include <termios.h>
+#include <unistd.h>
+
+namespace trash {
+
+namespace {
+
+[[noreturn]] void throw_errno(const std::string &what)
+{
+    throw std::system_error(errno, std::generic_category(), what);
+}
+
+speed_t to_speed(unsigned baud)
+{
+    switch (baud) {
+    case 9600: return B9600;
+    case 19200: return B19200;
+    case 38400: return B38400;
+    case 57600: return B57600;
+    case 115200: return B115200;
+    case 230400: return B230400;
+    case 460800: return B460800;
+    case 921600: return B921600;
+    default: return 0;
+    }
+}
+
+}  // namespace
+
+SerialPort::SerialPort(const std::string &path, unsigned baud) : path_(path)
+{
+    speed_t speed = to_speed(baud);
+    struct termios tio;
+    struct epoll_event ev = {};
+
+    if (speed == 0) {
+        throw std::system_error(EINVAL, std::generic_category(), path + ": unsupported baud rate");
+    }
+    fd_ = ::open(path.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (fd_ < 0) {
+        throw_errno(path);
+    }
+    if (tcgetattr(fd_, &tio) == 0) {
+        cfmakeraw(&tio);
+        tio.c_cflag |= CLOCAL | CREAD;
+        tio.c_cflag &= ~(CSTOPB | CRTSCTS);
+        tio.c_cc[VMIN] = 0;
+        tio.c_cc[VTIME] = 0;
+        cfsetispeed(&tio, speed);
+        cfsetospeed(&tio, speed);
+        if (tcsetattr(fd_, TCSANOW, &tio) != 0) {
+            int err = errno;
+            close();
+            throw std::system_error(err, std::generic_category(), path + ": tcsetattr");
+        }
+    }
+    epfd_ = epoll_create1(EPOLL_CLOEXEC);
+    ev.events = EPOLLIN;
+    if (epfd_ < 0 || epoll_ctl(epfd_, EPOLL_CTL_ADD, fd_, &ev) != 0) {
+        int err = errno;
+        close();
+        throw std::system_error(err, std::generic_category(), path + ": epoll");
+    }
+}
+
+SerialPort::~SerialPort()
+{
+    close();
+}
+
+void SerialPort::close()
+{
+    if (epfd_ >= 0) {
+        ::close(epfd_);
+        epfd_ = -1;
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+// 等有数据；EPOLLHUP / EPOLLERR 也返回 true，让后面的 read 报出错误
+// epfd_ 上只挂 EPOLLIN、从不改，写的线程同时在 wait_writable 里等也互不影响
+bool SerialPort::wait_readable(int timeout_ms)
+{
+    struct epoll_event ev = {};
+    int n;
+
+    do {
+        n = epoll_wait(epfd_, &ev, 1, timeout_ms);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0) {
+        throw_errno(path_ + ": epoll_wait");
+    }
+    return n > 0;
+}
+
+// 等发送缓冲区有空；用自己的 poll，不碰读那边的 epoll 注册
+bool SerialPort::wait_writable(int timeout_ms)
+{
+    struct pollfd p = {fd_, POLLOUT, 0};
+    int n;
+
+    do {
+        n = ::poll(&p, 1, timeout_ms);
+    } while (n < 0 && errno == EINTR);
+    if (n < 0) {
+        throw_errno(path_ + ": poll");
+    }
+    return n > 0;
+}
+
+size_t SerialPort::read(std::vector<uint8_t> &out, int timeout_ms)
+{
+    size_t total = 0;
+
+    if (fd_ < 0) {
+        throw std::system_error(EBADF, std::generic_category(), path_);
+    }
+    if (!wait_readable(timeout_ms)) {
+        return 0;
+    }
+    for (;;) {
+        size_t n = out.size();
+        out.resize(n + 4096);
+        ssize_t r = ::read(fd_, out.data() + n, 4096);
+        out.resize(n + (r > 0 ? r : 0));
+        if (r > 0) {
+            total += r;
+            continue;
+        }
+        if (r < 0 && errno == EINTR) {
+            continue;
+        }
+        if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        }
+        // 有事件却读到 0：对端挂断
+        if (r == 0 && total == 0) {
+            errno = EIO;
+        }
+        if (r == 0 && total) {
+            break;
+        }
+        throw_errno(path_ + ": read");
+    }
+    return total;
+}
+
+size_t SerialPort::write(const uint8_t *data, size_t len, int timeout_ms)
+{
+    size_t done = 0;
+
+    if (fd_ < 0) {
+        throw std::system_error(EBADF, std::generic_category(), path_);
+    }
+    while (done < len) {
+        ssize_t w = ::write(fd_, data + done, len - done);
+        if (w > 0) {
+            done += w;
+            continue;
+        }
+        if (w < 0 && errno == EINTR) {
+            continue;
+        }
+        if (w < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            if (!wait_writable(timeout_ms)) {
+                break;
+            }
+            continue;
+        }
+        throw_errno(path_ + ": write");
+    }
+    return done;
+}
+
+}  // namespace trash
@@ -0,0 +1,137 @@
+"""trash_link 的纯 Python 解码器要和原生库逐列一样（没编译原生库时只跑纯 Python 的部分）
+
+    cd upper_computer && python -m unittest discover -s tests
+"""
+import os
+import random
+import struct
+import sys
+import unittest
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), '..'))
+
+import trash_link  # noqa: E402
+
+
+def varint(v):
+    out = bytearray()
+    while True:
+        b = v & 0x7f
+        v >>= 7
+        if not v:
+            out.append(b)
+            return bytes(out)
+        out.append(b | 0x80)
+
+
+def zigzag(v):
+    return (v << 1) ^ (v >> 31) if v < 0 else v << 1
+
+
+def samples_frame(values, seq=1, tick=1000, channel=0):
+    data = bytes((channel, len(values))) + struct.pack('>IIh', seq, tick, values[0])
+    for prev, v in zip(values, values[1:]):
+        data += varint(10) + varint(zigzag(v - prev) & 0xffffffff)
+    return trash_link._encode_v2(trash_link.CMD_SAMPLES, data, seq)
+
+
+def v1_frame(cmd, data):
+    body = b'\xa5\x00' + b'00' + bytes((cmd,)) + data
+    crc = trash_link._crc16(body)
+    return body + bytes((crc >> 8, crc & 0xff)) + b'o'
+
+
+def random_stream(rng, frames=3000):
+    """各种帧混着垃圾字节、改坏的字节，数据部分随机，专门凑边界"""
+    out = bytearray()
+    for i in range(frames):
+        kind = rng.randrange(6)
+        if kind == 0:
+            data = struct.pack('>f', rng.choice((rng.uniform(0, 70), rng.uniform(-1, 1), 0.1235))) + bytes(
+                rng.randrange(256) for _ in range(52))
+            frame = v1_frame(rng.choice((1, 1, 4, 10, 5)), data)
+        elif kind == 1:
+            frame = trash_link._encode_v2(1, bytes(rng.randrange(256) for _ in range(rng.randrange(15))), i)
+        elif kind == 2:
+            values = [rng.randrange(-32768, 32768)]
+            for _ in range(rng.randrange(1, 12)):
+                values.append(values[-1] + rng.choice((1, -1)) * rng.randrange(40000))
+            frame = samples_frame(values, seq=i, channel=rng.randrange(256))
+        elif kind == 3:
+            frame = trash_link._encode_v2(rng.choice((4, 10)), bytes(rng.randrange(256) for _ in range(rng.randrange(57))), i)
+        elif kind == 4:
+            data = b''
+            for _ in range(rng.randrange(8)):
+                n = rng.randrange(6)
+                data += bytes((rng.randrange(256), rng.randrange(2) << 4 | n)) + bytes(rng.randrange(256) for _ in range(n))
+            frame = trash_link._encode_v2(10, data[:56], i)
+        else:
+            frame = trash_link._encode_v2(rng.randrange(2, 14), bytes(rng.randrange(256) for _ in range(rng.randrange(8))), i)
+        frame = bytearray(frame)
+        if rng.random() < 0.05:
+            frame[rng.randrange(len(frame))] = rng.randrange(256)
+        if rng.random() < 0.05:
+            out += bytes(rng.choice((0xa5, rng.randrange(256))) for _ in range(rng.randrange(1, 20)))
+        out += frame
+    return bytes(out)
+
+
+def decode(decoder, stream, rng):
+    pos = 0
+    while pos < len(stream):
+        n = rng.randrange(1, 200)
+        decoder.feed(stream[pos:pos + n], 1.5)
+        pos += n
+    batch = decoder.take()
+    return ({name: {k: list(v) for k, v in batch[name].items()} for name in ('telemetry', 'samples', 'sensors')},
+            [tuple(f) for f in batch['frames']], decoder.stats())
+
+
+class PyDecoderTest(unittest.TestCase):
+    def test_samples_wrap_int16(self):
+        dec = trash_link._PyDecoder()
+        dec.feed(samples_frame([30000, 40000]))
+        self.assertEqual(list(dec.take()['samples']['value']), [30000, -25536])
+        self.assertEqual(dec.stats()['malformed'], 0)
+
+    def test_malformed_keeps_columns_aligned(self):
+        dec = trash_link._PyDecoder()
+        good = samples_frame([1, 2, 3])
+        # 样本数说有 3 个，后面的 varint 不够
+        dec.feed(trash_link._encode_v2(trash_link.CMD_SAMPLES, bytes((0, 3)) + bytes(10) + b'\x02', 2) + good)
+        batch = dec.take()
+        self.assertEqual(dec.stats()['malformed'], 1)
+        self.assertEqual({len(v) for v in batch['samples'].values()}, {3})
+        self.assertEqual(list(batch['samples']['value']), [1, 2, 3])
+
+
+@unittest.skipUnless(trash_link.HAVE_NATIVE, '没有编译原生库')
+class ParityTest(unittest.TestCase):
+    def test_random_stream(self):
+        for seed in range(5):
+            with self.subTest(seed=seed):
+                stream = random_stream(random.Random(seed))
+                native = decode(trash_link._native.Decoder(), stream, random.Random(seed))
+                python = decode(trash_link._PyDecoder(), stream, random.Random(seed))
+                self.assertGreater(native[2]['malformed'], 0)
+                self.assertEqual(native[2], python[2])
+                self.assertEqual(native[0], python[0])
+                self.assertEqual(native[1], python[1])
+
+    def test_host_v1_and_raw(self):
+        stream = random_stream(random.Random(9), 500) + trash_link._encode_v1(1, 2) * 3
+        for kw in ({'accept_host_v1': True}, {'raw': True}):
+            with self.subTest(**kw):
+                native = decode(trash_link._native.Decoder(**kw), stream, random.Random(1))
+                python = decode(trash_link._PyDecoder(**kw), stream, random.Random(1))
+                self.assertEqual(native, python)
+
+    def test_uninitialized(self):
+        d = trash_link._native.Decoder.__new__(trash_link._native.Decoder)
+        for call in (lambda: d.feed(b'abc', 0.0), d.take, d.stats):
+            with self.assertRaises(ValueError):
+                call()
+
+
+if __name__ == '__main__':
+    unittest.main()
@@ -0,0 +1,90 @@
+"""ts_store.query() 每个桶的结果要和直接扫原始行算出来的一样
+
+    cd upper_computer && python -m unittest discover -s tests
+"""
+import bisect
+import math
+import os
+import random
+import sys
+import tempfile
+import unittest
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), '..'))
+
+import ts_store  # noqa: E402
+
+T0 = 1760659200.0    # 2025-10-17 00:00 UTC
+
+
+def brute_force(rows, result, t0, t1):
+    """按 query() 返回的桶起点把 [t0, t1) 里的原始行分桶，桶到下一个桶起点（最后一个到 t1）为止"""
+    starts = result['t']
+    buckets = [[] for _ in starts]
+    for row in rows:
+        if t0 <= row[0] < t1:
+            i = bisect.bisect_right(starts, row[0]) - 1
+            assert i >= 0, f'{row[0]} 在第一个桶 {starts[0]} 之前'
+            buckets[i].append(row)
+    return buckets
+
+
+class QueryTest(unittest.TestCase):
+    @classmethod
+    def setUpClass(cls):
+        cls.tmp = tempfile.TemporaryDirectory()
+        rng = random.Random(1)
+        cls.rows = []
+        t = T0 + 3.3
+        # 两天多的数据，间隔不均匀，中间还有一段断开
+        while t < T0 + 2.2 * ts_store.DAY:
+            fill = ts_store.FILL_NONE if rng.random() < 0.2 else rng.randrange(101)
+            cls.rows.append((t, rng.randrange(20, 2000), rng.randrange(-100, 400), rng.randrange(200, 900), fill))
+            t += rng.uniform(0.5, 12.0) if not T0 + 30000 < t < T0 + 34000 else 5000.0
+        writer = ts_store.TSStore(cls.tmp.name, writable=True)
+        for row in cls.rows:
+            writer.append(*row)
+        # 写的一方不关，最新几级的桶还在内存里，读的一方得从细一级补
+        writer.flush()
+        cls.writer = writer
+        cls.store = ts_store.TSStore(cls.tmp.name)
+
+    @classmethod
+    def tearDownClass(cls):
+        cls.writer.close()
+        cls.tmp.cleanup()
+
+    def check(self, t0, t1, points):
+        result = self.store.query(t0, t1, points)
+        expect = brute_force(self.rows, result, t0, t1)
+        self.assertEqual(sum(result['count']), sum(len(b) for b in expect))
+        self.assertLessEqual(len(result['t']), points + 1)
+        for i, rows in enumerate(expect):
+            where = f'[{t0}, {t1}) points={points} 桶 {i} @ {result["t"][i]}'
+            self.assertTrue(rows, where + ' 没有行却返回了')
+            for c, col in enumerate(ts_store.COLUMNS):
+                values = [r[1 + c] for r in rows if not (col == 'fill' and r[1 + c] == ts_store.FILL_NONE)]
+                if not values:
+                    self.assertIsNone(result[f'{col}_mean'][i], where)
+                    continue
+                self.assertEqual(result[f'{col}_min'][i], min(values), where + ' ' + col)
+                self.assertEqual(result[f'{col}_max'][i], max(values), where + ' ' + col)
+                self.assertTrue(math.isclose(result[f'{col}_mean'][i], sum(values) / len(values), rel_tol=1e-9),
+                                where + ' ' + col)
+            self.assertEqual(result['count'][i], len(rows), where)
+
+    def test_spans(self):
+        end = T0 + 2.2 * ts_store.DAY
+        for span in (60, 600, 3600, 36540, ts_store.DAY, 2 * ts_store.DAY):
+            for points in (7, 300, 600):
+                for t1 in (end - 123.4, end - 0.7 * ts_store.DAY, T0 + ts_store.DAY + 17):
+                    with self.subTest(span=span, points=points, t1=t1):
+                        self.check(t1 - span, t1, points)
+
+    def test_aligned(self):
+        self.check(T0, T0 + ts_store.DAY, 24)
+        self.check(T0 + 600, T0 + 600 + 300 * 120, 300)
+
+
+if __name__ == '__main__':
+    unittest.main()
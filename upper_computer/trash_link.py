@@ -0,0 +1,292 @@
+"""
+上位机帧协议的统一入口：有编译好的原生库（native/，见 native/CMakeLists.txt）就用原生库，
+没有（比如 Windows 上没编译）就用这里的纯 Python 实现，接口一样
+
+    dec = Decoder()
+    dec.feed(ser.read_all())          # 或者 Linux 上 port.poll(dec, timeout_ms)
+    batch = dec.take()                # {'telemetry': {列名: 数组}, 'samples': ..., 'sensors': ..., 'frames': [...]}
+    arrays(batch['telemetry'])        # 转成 numpy 数组（零拷贝）
+
+telemetry 列：host_time(秒) version seq distance_mm temp(0.1℃) humi(0.1%RH) fill(%，255 为没有)
+samples 列：channel history seq tick(ms) value，批量样本帧展开，通道见 my_serial.SAMPLE_CHANNELS
+sensors 列：host_time frame id value，TLV 记录，frame 相同的是同一帧
+frames：其他命令的帧 [(cmd, seq, data, version, host_time)]
+Decoder(raw=True) 不分表，所有帧都在 frames 里（下位机一侧收命令用，命令 1 是 COMMOND）
+"""
+import array
+import os
+import struct
+import sys
+import time
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), 'native'))
+try:
+    import _trash_native as _native
+except ImportError:
+    _native = None
+
+HAVE_NATIVE = _native is not None
+
+FRAME_HEAD = 0xa5
+FRAME_V1, FRAME_V2 = 0x00, 0x02
+FRAME_V1_SIZE = 64
+FRAME_DATA_MAX = 56
+CMD_TELEMETRY, CMD_SAMPLES, CMD_SENSORS = 1, 4, 10
+_VARINT_MAX = 5                 # 和原生库一样最多 5 字节，只取低 32 位
+
+_TELEMETRY_COLUMNS = (('host_time', 'd'), ('version', 'B'), ('seq', 'B'), ('distance_mm', 'H'),
+                      ('temp', 'h'), ('humi', 'H'), ('fill', 'B'))
+_SAMPLE_COLUMNS = (('channel', 'B'), ('history', 'B'), ('seq', 'I'), ('tick', 'I'), ('value', 'h'))
+_SENSOR_COLUMNS = (('host_time', 'd'), ('frame', 'I'), ('id', 'B'), ('value', 'i'))
+
+
+def _crc_table():
+    table = []
+    for i in range(256):
+        crc = i << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+        table.append(crc & 0xffff)
+    return table
+
+
+_CRC_TABLE = _crc_table()
+
+
+def _crc16(data, crc=0xffff):
+    for b in data:
+        crc = ((crc << 8) & 0xffff) ^ _CRC_TABLE[(crc >> 8) ^ b]
+    return crc
+
+
+def _f32(x):
+    """按 float 舍入，和原生库里 float 运算的结果一样"""
+    return struct.unpack('<f', struct.pack('<f', x))[0]
+
+
+def _wrap(v, bits):
+    """按补码截成 bits 位有符号数"""
+    half = 1 << (bits - 1)
+    return ((v + half) & ((half << 1) - 1)) - half
+
+
+def _encode_v2(cmd, data=b'', seq=0):
+    if len(data) > FRAME_DATA_MAX:
+        raise ValueError('data longer than 56 bytes')
+    body = bytes((FRAME_V2, len(data), seq & 0xff, cmd)) + bytes(data)
+    crc = _crc16(body)
+    return b'\xa5' + body + bytes((crc >> 8, crc & 0xff, 0xff))
+
+
+def _encode_v1(oled, cls):
+    return b'\xa5\x00\x00\x00\x00' + bytes((oled, cls)) + bytes(FRAME_DATA_MAX) + b'\xff'
+
+
+class _PyDecoder:
+    """原生库的纯 Python 版本，解帧和重新同步的规则一样（逐帧处理，不逐字节）"""
+
+    def __init__(self, accept_host_v1=False, raw=False):
+        self.accept_host_v1 = accept_host_v1
+        self.raw = raw
+        self.buf = b''
+        self.sensor_frames = 0
+        self._stats = dict.fromkeys(('bytes', 'frames', 'crc_errors', 'resync', 'skipped',
+                                     'telemetry', 'samples', 'sensors', 'malformed'), 0)
+        self._clear()
+
+    def _clear(self):
+        self.telemetry = {k: array.array(f) for k, f in _TELEMETRY_COLUMNS}
+        self.samples = {k: array.array(f) for k, f in _SAMPLE_COLUMNS}
+        self.sensors = {k: array.array(f) for k, f in _SENSOR_COLUMNS}
+        self.frames = []
+
+    def _check(self, buf, pos):
+        """:return: 帧长，0 为字节不够，-1 为不是帧"""
+        avail = len(buf) - pos
+        if avail < 2:
+            return 0
+        ver = buf[pos + 1]
+        if ver == FRAME_V1:
+            if avail < FRAME_V1_SIZE:
+                return 0
+            tail = buf[pos + FRAME_V1_SIZE - 1]
+            if tail == ord('o'):
+                crc = _crc16(buf[pos:pos + 61])
+                if buf[pos + 61] != crc >> 8 or buf[pos + 62] != crc & 0xff:
+                    self._stats['crc_errors'] += 1
+                    return -1
+                return FRAME_V1_SIZE
+            return FRAME_V1_SIZE if self.accept_host_v1 and tail == 0xff else -1
+        if ver != FRAME_V2:
+            return -1
+        if avail < 3:
+            return 0
+        length = buf[pos + 2]
+        if length > FRAME_DATA_MAX:
+            return -1
+        if avail < 8 + length:
+            return 0
+        if buf[pos + 7 + length] != 0xff:
+            return -1
+        crc = _crc16(buf[pos + 1:pos + 5 + length])
+        if buf[pos + 5 + length] != crc >> 8 or buf[pos + 6 + length] != crc & 0xff:
+            self._stats['crc_errors'] += 1
+            return -1
+        return 8 + length
+
+    def feed(self, data, host_time=None):
+        host_time = time.time() if host_time is None else host_time
+        buf = self.buf + bytes(data)
+        pos = count = 0
+        self._stats['bytes'] += len(data)
+        while pos < len(buf):
+            head = buf.find(b'\xa5', pos)
+            if head < 0:
+                self._stats['skipped'] += len(buf) - pos
+                pos = len(buf)
+                break
+            self._stats['skipped'] += head - pos
+            pos = head
+            n = self._check(buf, pos)
+            if n == 0:
+                break
+            if n < 0:
+                self._stats['resync'] += 1
+                self._stats['skipped'] += 1
+                pos += 1
+                continue
+            frame = buf[pos:pos + n]
+            if frame[1] == FRAME_V1:
+                self._on_frame(FRAME_V1, frame[4], 0, frame[5:61], host_time)
+            else:
+                self._on_frame(FRAME_V2, frame[4], frame[3], frame[5:5 + frame[2]], host_time)
+            self._stats['frames'] += 1
+            count += 1
+            pos += n
+        self.buf = buf[pos:]
+        return count
+
+    def _on_frame(self, version, cmd, seq, data, host_time):
+        try:
+            if self.raw:
+                self.frames.append((cmd, seq, bytes(data), version, host_time))
+            elif cmd == CMD_TELEMETRY:
+                self._telemetry(version, seq, data, host_time)
+            elif cmd == CMD_SAMPLES or cmd == CMD_SENSORS:
+                # v1 帧里没有这两种，和原生库一样算格式错
+                if version != FRAME_V2:
+                    raise ValueError
+                if cmd == CMD_SAMPLES:
+                    self._samples(data)
+                else:
+                    self._sensors(data, host_time)
+            else:
+                self.frames.append((cmd, seq, bytes(data), version, host_time))
+        except (IndexError, struct.error, ValueError, OverflowError):
+            self._stats['malformed'] += 1
+
+    @staticmethod
+    def _append(table, columns):
+        """先把每列转成数组再一起接上，转的时候出错各列都不动，不会长短不一"""
+        columns = [(table[k], array.array(table[k].typecode, v)) for k, v in columns]
+        for column, values in columns:
+            column.extend(values)
+
+    def _telemetry(self, version, seq, data, host_time):
+        fill = 0xff
+        if version == FRAME_V2 and len(data) >= 12:
+            distance, temp, humi = struct.unpack_from('>HhH', data, 6)
+            if len(data) >= 13:
+                fill = data[12]
+        else:
+            m = struct.unpack_from('>f', data)[0]
+            distance = int(_f32(_f32(m * 1000) + 0.5)) if 0 < m < 65 else 0
+            humi, temp = data[4] * 10, data[5] * 10
+        row = (host_time, version, seq, distance, temp, humi, fill)
+        self._append(self.telemetry, [(k, (v,)) for (k, _), v in zip(_TELEMETRY_COLUMNS, row)])
+        self._stats['telemetry'] += 1
+
+    def _samples(self, data):
+        def varint(pos):
+            v = 0
+            for shift in range(0, 7 * _VARINT_MAX, 7):
+                b = data[pos]
+                v |= (b & 0x7f) << shift
+                pos += 1
+                if not b & 0x80:
+                    return v & 0xffffffff, pos
+            raise ValueError
+
+        if len(data) < 12 or data[1] == 0:
+            raise ValueError
+        seq, tick, value = struct.unpack_from('>IIh', data, 2)
+        rows = [(seq, tick, value)]
+        pos = 12
+        for _ in range(data[1] - 1):
+            dt, pos = varint(pos)
+            dv, pos = varint(pos)
+            seq = (seq + 1) & 0xffffffff
+            tick = (tick + dt) & 0xffffffff
+            value = _wrap(value + ((dv >> 1) ^ -(dv & 1)), 16)
+            rows.append((seq, tick, value))
+        seqs, ticks, values = zip(*rows)
+        self._append(self.samples, [('channel', [data[0] & 0x7f] * len(rows)),
+                                    ('history', [1 if data[0] & 0x80 else 0] * len(rows)),
+                                    ('seq', seqs), ('tick', ticks), ('value', values)])
+        self._stats['samples'] += len(rows)
+
+    def _sensors(self, data, host_time):
+        rows = []
+        pos = 0
+        while len(data) - pos >= 2:
+            n = data[pos + 1] & 0x0f
+            if n > 4 or len(data) - pos < 2 + n:
+                raise ValueError
+            signed = bool((data[pos + 1] >> 4) & 1)
+            value = int.from_bytes(data[pos + 2:pos + 2 + n], 'big', signed=signed)
+            rows.append((data[pos], _wrap(value, 32)))
+            pos += 2 + n
+        self._append(self.sensors, [('host_time', [host_time] * len(rows)),
+                                    ('frame', [self.sensor_frames] * len(rows)),
+                                    ('id', [sid for sid, _ in rows]), ('value', [v for _, v in rows])])
+        self.sensor_frames += 1
+        self._stats['sensors'] += len(rows)
+
+    def take(self):
+        view = lambda t: {k: memoryview(v) for k, v in t.items()}
+        result = {'telemetry': view(self.telemetry), 'samples': view(self.samples),
+                  'sensors': view(self.sensors), 'frames': self.frames}
+        self._clear()
+        return result
+
+    def stats(self):
+        return dict(self._stats)
+
+
+if HAVE_NATIVE:
+    Decoder = _native.Decoder
+    crc16 = _native.crc16
+    encode_v2 = _native.encode_v2
+    encode_v1 = _native.encode_v1
+else:
+    Decoder = _PyDecoder
+    crc16 = _crc16
+    encode_v2 = _encode_v2
+    encode_v1 = _encode_v1
+
+
+def arrays(table):
+    """一张表（take() 结果里的 telemetry / samples / sensors）转成 numpy 数组，零拷贝"""
+    import numpy as np
+    return {k: np.asarray(v) for k, v in table.items()}
+
+
+def open_port(path, baud=115200):
+    """Linux 上有原生库用 termios + epoll 的 Port（read / poll / write），否则用 pyserial"""
+    if HAVE_NATIVE and sys.platform.startswith('linux'):
+        return _native.Port(path, baud)
+    if sys.platform == 'win32':
+        from utils import Serial
+    else:
+        from serial import Serial
+    return Serial(path, baud, timeout=0)
@@ -0,0 +1,339 @@
+"""
+遥测的时间序列存储：只追加写，按天分段，每段里除了原始数据还有 10s / 1min / 10min / 1h 四级预聚合
+（每个桶记各列的最小 / 最大 / 总和 / 个数），查询时按要的点数挑够用的最粗一级，
+一分钟到一个月的范围都只读几百到几千条记录
+
+    data/ts/20261017/raw.bin      原始一行：主机时间 | 距离 mm | 温度 0.1℃ | 湿度 0.1%RH | 满溢 %
+    data/ts/20261017/r10.bin      预聚合一桶：桶起点 | 每列 (最小, 最大, 总和, 个数)
+    ...
+
+写的一方（采集服务）只在内存里留各级正在累计的桶，跑多久内存都不变；桶满了追加到文件，
+读的一方（界面）用 mmap 二分查找，粗一级还没写出来的部分自动从细一级补，所以最新的数据也查得到。
+天按 UTC 划分，时间只能往前走，主机时间往回跳的行按上一行的时间记。
+"""
+import calendar
+import mmap
+import os
+import shutil
+import struct
+import time
+
+STORE_ROOT = os.environ.get('SMART_TRASH_TS', os.path.join(os.path.dirname(os.path.abspath(__file__)), 'data', 'ts'))
+COLUMNS = ('distance_mm', 'temp', 'humi', 'fill')
+LEVELS = (10, 60, 600, 3600)    # 都能整除一天，桶不会跨段
+DAY = 86400
+FILL_NONE = 0xff                # 遥测里没有满溢字节
+
+_RAW = struct.Struct('<dHhHBx')
+_AGG = struct.Struct('<d' + 'ffdI' * len(COLUMNS))
+
+
+def _day_name(day):
+    return time.strftime('%Y%m%d', time.gmtime(day * DAY))
+
+
+def _day_of(name):
+    return calendar.timegm(time.strptime(name, '%Y%m%d')) // DAY
+
+
+def _raw_values(row):
+    values = list(row[1:])
+    if values[3] == FILL_NONE:
+        values[3] = None
+    return values
+
+
+class _Bucket:
+    """一个正在累计的桶"""
+
+    def __init__(self, start=None):
+        self.start = start
+        self.acc = [[float('inf'), float('-inf'), 0.0, 0] for _ in COLUMNS]
+
+    def add(self, values):
+        for a, v in zip(self.acc, values):
+            if v is None:
+                continue
+            if v < a[0]:
+                a[0] = v
+            if v > a[1]:
+                a[1] = v
+            a[2] += v
+            a[3] += 1
+
+    def merge(self, acc):
+        for a, b in zip(self.acc, acc):
+            if b[3]:
+                if b[0] < a[0]:
+                    a[0] = b[0]
+                if b[1] > a[1]:
+                    a[1] = b[1]
+                a[2] += b[2]
+                a[3] += b[3]
+
+    def empty(self):
+        return all(a[3] == 0 for a in self.acc)
+
+    def pack(self):
+        fields = [self.start]
+        for a in self.acc:
+            fields += a if a[3] else [0.0, 0.0, 0.0, 0]
+        return _AGG.pack(*fields)
+
+
+def _unpack_agg(rec):
+    return rec[0], [rec[1 + i * 4:5 + i * 4] for i in range(len(COLUMNS))]
+
+
+class _Mapped:
+    """只读 mmap 一个定长记录的文件，按第一个字段（时间）二分"""
+
+    def __init__(self, path, rec):
+        self.rec = rec
+        self.mm = None
+        self.n = 0
+        try:
+            with open(path, 'rb') as f:
+                size = os.fstat(f.fileno()).st_size // rec.size * rec.size
+                if size:
+                    self.mm = mmap.mmap(f.fileno(), size, access=mmap.ACCESS_READ)
+                    self.n = size // rec.size
+        except FileNotFoundError:
+            pass
+
+    def time(self, i):
+        return struct.unpack_from('<d', self.mm, i * self.rec.size)[0]
+
+    def bisect(self, t):
+        lo, hi = 0, self.n
+        while lo < hi:
+            mid = (lo + hi) // 2
+            if self.time(mid) < t:
+                lo = mid + 1
+            else:
+                hi = mid
+        return lo
+
+    def rows(self, lo, hi):
+        if lo >= hi:
+            return []
+        return list(self.rec.iter_unpack(self.mm[lo * self.rec.size:hi * self.rec.size]))
+
+    def close(self):
+        if self.mm is not None:
+            self.mm.close()
+
+
+class _Collector:
+    """把扫到的行 / 预聚合记录归到查询的输出桶里"""
+
+    def __init__(self, t0, width, points):
+        """预聚合记录整个算进起点所在的桶，所以用预聚合时 t0 和 width 都得对齐到那一级的格子上"""
+        self.t0, self.width, self.points = t0, width, points
+        self.buckets = {}
+
+    def _bucket(self, t):
+        i = min(int((t - self.t0) / self.width), self.points - 1)
+        b = self.buckets.get(i)
+        if b is None:
+            b = self.buckets[i] = _Bucket(self.t0 + i * self.width)
+        return b
+
+    def add_row(self, row):
+        self._bucket(row[0]).add(_raw_values(row))
+
+    def add_acc(self, start, acc):
+        self._bucket(start).merge(acc)
+
+
+class TSStore:
+    def __init__(self, root=STORE_ROOT, writable=False, keep_days=None):
+        """
+        :param writable: 只能有一个写的进程（采集服务）
+        :param keep_days: 换天时删掉比这更早的段，None 不删
+        """
+        self.root = root
+        self.writable = writable
+        self.keep_days = keep_days
+        self.day = None
+        self.raw = None
+        self.levels = None
+        self.last_t = 0.0
+        if writable:
+            os.makedirs(root, exist_ok=True)
+            self._recover()
+
+    def _days(self):
+        try:
+            return sorted(_day_of(name) for name in os.listdir(self.root) if len(name) == 8 and name.isdigit())
+        except FileNotFoundError:
+            return []
+
+    def _path(self, day, name):
+        return os.path.join(self.root, _day_name(day), name)
+
+    @staticmethod
+    def _level_file(level):
+        return f'r{level}.bin'
+
+    # ---------------------------------------------------------------- 写
+
+    def _recover(self):
+        """接着最后一段写：截掉写了一半的记录，把各级没写出来的桶从原始数据重新累计"""
+        days = self._days()
+        if not days:
+            return
+        day = days[-1]
+        for name in ['raw.bin'] + [self._level_file(l) for l in LEVELS]:
+            path = self._path(day, name)
+            rec = _RAW if name == 'raw.bin' else _AGG
+            if os.path.exists(path):
+                size = os.path.getsize(path)
+                if size % rec.size:
+                    os.truncate(path, size - size % rec.size)
+        self._open_day(day)
+        raw = _Mapped(self._path(day, 'raw.bin'), _RAW)
+        if raw.n:
+            self.last_t = raw.time(raw.n - 1)
+        for level, bucket in zip(LEVELS, self.levels):
+            agg = _Mapped(self._path(day, self._level_file(level)), _AGG)
+            done = agg.time(agg.n - 1) + level if agg.n else 0.0
+            agg.close()
+            for row in raw.rows(raw.bisect(done), raw.n):
+                self._accumulate(level, bucket, row[0], _raw_values(row))
+        raw.close()
+
+    def _open_day(self, day):
+        os.makedirs(os.path.join(self.root, _day_name(day)), exist_ok=True)
+        self.day = day
+        self.raw = open(self._path(day, 'raw.bin'), 'ab')
+        self.levels = [_Bucket() for _ in LEVELS]
+
+    def _close_day(self):
+        for level, bucket in zip(LEVELS, self.levels):
+            self._flush_bucket(level, bucket)
+        self.raw.close()
+        self.raw = None
+
+    def _flush_bucket(self, level, bucket):
+        if bucket.start is None or bucket.empty():
+            return
+        with open(self._path(self.day, self._level_file(level)), 'ab') as f:
+            f.write(bucket.pack())
+
+    def _accumulate(self, level, bucket, t, values):
+        start = t - t % level
+        if bucket.start != start:
+            self._flush_bucket(level, bucket)
+            bucket.__init__(start)
+        bucket.add(values)
+
+    def append(self, t, distance_mm, temp, humi, fill=FILL_NONE):
+        t = max(t, self.last_t)
+        self.last_t = t
+        day = int(t // DAY)
+        if day != self.day:
+            if self.raw is not None:
+                self._close_day()
+            self._open_day(day)
+            if self.keep_days is not None:
+                self.prune(self.keep_days)
+        row = (t, distance_mm, temp, humi, fill)
+        self.raw.write(_RAW.pack(*row))
+        values = _raw_values(row)
+        for level, bucket in zip(LEVELS, self.levels):
+            self._accumulate(level, bucket, t, values)
+
+    def append_columns(self, columns):
+        """按列追加，列名同 AcqClient.telemetry() / trash_link 的 telemetry 表"""
+        for row in zip(columns['host_time'], columns['distance_mm'], columns['temp'], columns['humi'], columns['fill']):
+            self.append(*row)
+
+    def flush(self):
+        if self.raw is not None:
+            self.raw.flush()
+
+    def close(self):
+        if self.raw is not None:
+            self.flush()
+            self.raw.close()
+            self.raw = None
+
+    def prune(self, keep_days):
+        """删掉 keep_days 天以前的段"""
+        for day in self._days():
+            if day < int(time.time() // DAY) - keep_days and day != self.day:
+                shutil.rmtree(os.path.join(self.root, _day_name(day)), ignore_errors=True)
+
+    # ---------------------------------------------------------------- 读
+
+    def _scan(self, day, t0, t1, li, out):
+        """[t0, t1) 在一段之内，用第 li 级（-1 为原始数据）的记录交给 out，粗一级盖不住的两头用细一级补"""
+        if t0 >= t1:
+            return
+        if li < 0:
+            raw = _Mapped(self._path(day, 'raw.bin'), _RAW)
+            for row in raw.rows(raw.bisect(t0), raw.bisect(t1)):
+                out.add_row(row)
+            raw.close()
+            return
+        level = LEVELS[li]
+        first = -(-t0 // level) * level
+        self._scan(day, t0, min(first, t1), li - 1, out)
+        covered = first
+        agg = _Mapped(self._path(day, self._level_file(level)), _AGG)
+        for rec in agg.rows(agg.bisect(first), agg.bisect(t1 - level + 1e-9)):
+            start, acc = _unpack_agg(rec)
+            out.add_acc(start, acc)
+            covered = start + level
+        agg.close()
+        self._scan(day, max(covered, first), t1, li - 1, out)
+
+    def query(self, t0, t1, points=600):
+        """
+        [t0, t1) 均分成 points 个桶，返回各列每桶的 最小 / 最大 / 平均；
+        用到预聚合时桶宽向上取到那一级的整数倍、桶起点对齐到那一级的格子，桶数可能和 points 差一点，
+        首尾两个桶只算 [t0, t1) 里的行
+        :return: {'t': 桶起点, 'count': 行数, 'distance_mm_min': ..., 'distance_mm_max': ..., 'distance_mm_mean': ...}，
+                 没有数据的桶不返回；满溢没有数据时为 None
+        """
+        width = (t1 - t0) / points
+        li = -1
+        while li + 1 < len(LEVELS) and LEVELS[li + 1] <= width:
+            li += 1
+        start = t0
+        if li >= 0:
+            level = LEVELS[li]
+            width = -(-width // level) * level
+            start = t0 - t0 % level
+            points = int(-(-(t1 - start) // width))
+        out = _Collector(start, width, points)
+        for day in range(int(t0 // DAY), int((t1 - 1e-9) // DAY) + 1):
+            if os.path.isdir(os.path.join(self.root, _day_name(day))):
+                self._scan(day, max(t0, day * DAY), min(t1, (day + 1) * DAY), li, out)
+        buckets = out.buckets
+        result = {'t': [], 'count': []}
+        for col in COLUMNS:
+            for k in ('min', 'max', 'mean'):
+                result[f'{col}_{k}'] = []
+        for i in sorted(buckets):
+            b = buckets[i]
+            result['t'].append(b.start)
+            result['count'].append(max(a[3] for a in b.acc))
+            for col, a in zip(COLUMNS, b.acc):
+                n = a[3]
+                result[f'{col}_min'].append(a[0] if n else None)
+                result[f'{col}_max'].append(a[1] if n else None)
+                result[f'{col}_mean'].append(a[2] / n if n else None)
+        return result
+
+    def span(self):
+        """存储里第一行和最后一行的时间，没有数据返回 None"""
+        days = self._days()
+        times = []
+        for day in (days[:1] + days[-1:]) if days else []:
+            raw = _Mapped(self._path(day, 'raw.bin'), _RAW)
+            if raw.n:
+                times += [raw.time(0), raw.time(raw.n - 1)]
+            raw.close()
+        return (min(times), max(times)) if times else None
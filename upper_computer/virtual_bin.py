@@ -0,0 +1,421 @@
+"""
+虚拟垃圾桶：不接板子也能跑上位机。每个桶开一个伪终端，按固件 Struct_To_Data 的 64 字节帧发遥测，
+一个进程里可以开很多个，用来压上位机的吞吐、解帧错误率和命令往返延迟（只在 Linux 上跑）
+
+    python virtual_bin.py --link /tmp/bin                    # 一个桶，/tmp/bin0 -> /dev/pts/N
+    SMART_TRASH_PORT=/tmp/bin0 python acq_service.py --port /tmp/bin0
+    python virtual_bin.py --count 32 --rate 50 --drop 0.01 --corrupt 0.01 --bench 10
+
+波形：const:v | sine:均值,幅度,周期s | ramp:起点,终点,周期s（锯齿，垃圾慢慢装满再清空）| square:低,高,周期s，
+距离单位 m、温度 ℃、湿度 %RH，再叠加 --*-noise 的高斯噪声，每个桶的相位随机错开。
+故障注入：--drop 整帧不发，--corrupt 帧里随机改一个字节，--garbage 帧之间插随机字节（含 a5）。
+
+命令按固件的规则回：收到 build_packet 的 v1 帧只执行不回；收到 v2 帧之后遥测也换成 v2，
+COMMOND 先回 ACK，舵机按 servo_motion.c 的梯形规划走到位、保持 200ms 松开后回 SORT_DONE，
+2s 内同一序号的请求回重复 ACK 不再执行，RESEND 从最近 16 帧里补发。
+"""
+import argparse
+import heapq
+import json
+import math
+import os
+import random
+import selectors
+import struct
+import sys
+import time
+import tty
+
+import trash_link
+
+CMD_TELEMETRY, CMD_RESEND, CMD_REQUIRE, CMD_SORT_DONE, CMD_ACK = 1, 2, 3, 6, 9
+ACK_OK, ACK_BAD_LEN, ACK_BAD_ARG, ACK_UNKNOWN, ACK_GONE = 0, 1, 2, 3, 4
+ACK_DUP = 0x80
+DUP_WINDOW_S = 2.0
+TX_HISTORY_NUM = 16
+OUT_BUF_MAX = 1 << 16           # 上位机不读时积压到这么多就丢帧
+
+# servo_motion.h
+SERVO_TICK_MS = 20
+SERVO_VMAX = 1000
+SERVO_AMAX = 320
+SERVO_SETTLE_TICKS = 10
+SERVO_DEGREE = (0, 45, 90, 135, 180)
+
+# fill_level.h 的默认标定
+FILL_EMPTY_MM, FILL_FULL_MM = 600, 150
+
+
+def servo_ticks(d):
+    """servo_motion.c Servo_Plan 的梯形规划：走 d（0.01°）要几个 20ms 周期"""
+    ta = (SERVO_VMAX + SERVO_AMAX - 1) // SERVO_AMAX
+    n = (d + SERVO_VMAX - 1) // SERVO_VMAX
+    if n > ta:
+        tc = n - ta
+    else:
+        ta = math.isqrt(max(0, (d + SERVO_AMAX - 1) // SERVO_AMAX - 1)) + 1 if d else 1
+        tc = 0
+    return max(1, 2 * ta + tc)
+
+
+def parse_wave(spec):
+    kind, _, args = spec.partition(':')
+    v = [float(x) for x in args.split(',')] if args else []
+    if kind == 'const':
+        return lambda t: v[0]
+    if kind == 'sine':
+        return lambda t: v[0] + v[1] * math.sin(2 * math.pi * t / v[2])
+    if kind == 'ramp':
+        return lambda t: v[0] + (v[1] - v[0]) * ((t / v[2]) % 1.0)
+    if kind == 'square':
+        return lambda t: v[1] if (t / v[2]) % 1.0 >= 0.5 else v[0]
+    raise ValueError(f'unknown waveform {spec}')
+
+
+def mcu_v1(cmd, data):
+    """Struct_To_Data：a5 00 '0' '0' | 命令 | 数据 56 | CRC16（前 61 字节，高字节在前）| 'o'"""
+    body = b'\xa5\x00' + b'00' + bytes((cmd,)) + bytes(data).ljust(56, b'\x00')
+    crc = trash_link.crc16(body)
+    return body + bytes((crc >> 8, crc & 0xff)) + b'o'
+
+
+class Bin:
+    def __init__(self, index, args, rng):
+        self.index = index
+        self.args = args
+        self.rng = rng
+        self.master, slave = os.openpty()
+        tty.setraw(slave)
+        self.slave = slave          # 自己留着从端，上位机关了再开也不会 EIO
+        os.set_blocking(self.master, False)
+        self.path = os.ttyname(slave)
+        self.link = None
+        if args.link:
+            self.link = f'{args.link}{index}'
+            if os.path.lexists(self.link):
+                os.unlink(self.link)
+            os.symlink(self.path, self.link)
+        self.phase = rng.uniform(0, 1e4)
+        self.decoder = trash_link.Decoder(accept_host_v1=True, raw=True)
+        self.out = b''
+        self.version = trash_link.FRAME_V1
+        self.tx_seq = 0
+        self.history = []           # 最近 TX_HISTORY_NUM 帧 (序号, 帧)
+        self.recent = {}            # (请求序号, 命令) -> 收到时刻，去重
+        self.oled = 1
+        self.cls = 0
+        self.degree = 0.0
+        self.move_id = 0
+        self.done_seq = 0
+        self.stats = dict.fromkeys(('frames', 'dropped', 'corrupted', 'garbage', 'overflow', 'bytes',
+                                    'commands', 'sorts', 'acks', 'dups'), 0)
+
+    def close(self):
+        os.close(self.master)
+        os.close(self.slave)
+        if self.link and os.path.islink(self.link):
+            os.unlink(self.link)
+
+    # ------------------------------------------------------------ 发
+
+    def _write(self, data):
+        if len(self.out) > OUT_BUF_MAX:
+            self.stats['overflow'] += 1
+            return
+        self.out += data
+        self.flush()
+
+    def flush(self):
+        while self.out:
+            try:
+                n = os.write(self.master, self.out)
+            except BlockingIOError:
+                return
+            self.out = self.out[n:]
+            self.stats['bytes'] += n
+
+    def send(self, cmd, data, inject=True):
+        """按当前帧版本发一帧，遥测帧才做故障注入"""
+        if self.version == trash_link.FRAME_V2:
+            seq = self.tx_seq
+            self.tx_seq = (self.tx_seq + 1) & 0xff
+            frame = trash_link.encode_v2(cmd, data, seq)
+            self.history = (self.history + [(seq, frame)])[-TX_HISTORY_NUM:]
+        else:
+            frame = mcu_v1(cmd, data)
+        if inject:
+            a, rng = self.args, self.rng
+            if rng.random() < a.drop:
+                self.stats['dropped'] += 1
+                return
+            if rng.random() < a.corrupt:
+                frame = bytearray(frame)
+                frame[rng.randrange(1, len(frame))] ^= 1 << rng.randrange(8)
+                self.stats['corrupted'] += 1
+            if rng.random() < a.garbage:
+                junk = bytes(rng.choice((0xa5, rng.randrange(256))) for _ in range(rng.randint(1, 8)))
+                frame = junk + bytes(frame)
+                self.stats['garbage'] += 1
+        self.stats['frames'] += 1
+        self._write(bytes(frame))
+
+    def telemetry(self, now):
+        a, rng = self.args, self.rng
+        t = now + self.phase
+        dist = max(0.02, a.distance(t) + rng.gauss(0, a.distance_noise))
+        temp = a.temp(t) + rng.gauss(0, a.temp_noise)
+        humi = min(100.0, max(0.0, a.humi(t) + rng.gauss(0, a.humi_noise)))
+        data = struct.pack('>f', dist) + bytes((int(humi) & 0xff, int(temp) & 0xff))
+        if self.version == trash_link.FRAME_V2:
+            mm = int(dist * 1000)
+            pct = (FILL_EMPTY_MM - mm) * 100 // (FILL_EMPTY_MM - FILL_FULL_MM)
+            data += struct.pack('>HhHB', min(mm, 0xffff), int(temp * 10), int(humi * 10), min(100, max(0, pct)))
+        self.send(CMD_TELEMETRY, data)
+
+    # ------------------------------------------------------------ 收
+
+    def receive(self, loop, now):
+        try:
+            data = os.read(self.master, 4096)
+        except (BlockingIOError, OSError):
+            return
+        self.decoder.feed(data, now)
+        for cmd, seq, data, version, _ in self.decoder.take()['frames']:
+            self.stats['commands'] += 1
+            if version == trash_link.FRAME_V1:
+                # build_packet：a5 | 4 字节 0 | oled | 分类 | ...，命令字节是 0
+                self.version = trash_link.FRAME_V1
+                self.oled = data[0]
+                self.sort(loop, now, data[1])
+                continue
+            self.version = trash_link.FRAME_V2
+            self.command(loop, now, cmd, seq, data)
+
+    def ack(self, seq, cmd, status):
+        self.stats['acks'] += 1
+        self.send(CMD_ACK, bytes((seq, cmd, status)), inject=False)
+
+    def command(self, loop, now, cmd, seq, data):
+        for key, t in list(self.recent.items()):
+            if now - t > DUP_WINDOW_S:
+                del self.recent[key]
+        if (seq, cmd) in self.recent:
+            self.stats['dups'] += 1
+            self.ack(seq, cmd, ACK_OK | ACK_DUP)
+            return
+        self.recent[(seq, cmd)] = now
+        if cmd == CMD_TELEMETRY:
+            if len(data) < 2:
+                self.ack(seq, cmd, ACK_BAD_LEN)
+            elif data[1] >= len(SERVO_DEGREE):
+                self.ack(seq, cmd, ACK_BAD_ARG)
+            else:
+                self.ack(seq, cmd, ACK_OK)
+                self.oled = data[0]
+                self.sort(loop, now, data[1])
+        elif cmd == CMD_REQUIRE:
+            self.ack(seq, cmd, ACK_OK)
+            self.telemetry(now)
+        elif cmd == CMD_RESEND and len(data) >= 2:
+            want = [(data[1] + i) & 0xff for i in range(data[0])]
+            frames = [f for s, f in self.history if s in want]
+            self.ack(seq, cmd, ACK_OK if frames else ACK_GONE)
+            for f in frames:
+                self._write(f)
+        else:
+            self.ack(seq, cmd, ACK_UNKNOWN)
+
+    def sort(self, loop, now, cls):
+        """和 Servo_Sort 一样：分类无效或没变不动；在下一个 TIM3 周期开始走，到位保持后发 SORT_DONE"""
+        if cls >= len(SERVO_DEGREE) or cls == self.cls:
+            return
+        self.stats['sorts'] += 1
+        self.cls = cls
+        self.move_id += 1
+        target = SERVO_DEGREE[cls]
+        ticks = servo_ticks(int(abs(target - self.degree) * 100))
+        start = now + self.rng.uniform(0, SERVO_TICK_MS) / 1000
+        self.degree = target        # 途中换目标时从终点重新规划，差别在一个规划以内
+        arrive = start + ticks * SERVO_TICK_MS / 1000
+        loop.at(arrive + SERVO_SETTLE_TICKS * SERVO_TICK_MS / 1000, self.sort_done, self.move_id, cls, ticks)
+
+    def sort_done(self, loop, now, move_id, cls, ticks):
+        if move_id != self.move_id:
+            return                  # 途中换了目标，只报最后一次
+        self.done_seq = (self.done_seq + 1) & 0xff
+        if self.version == trash_link.FRAME_V2:
+            move_ms = ticks * SERVO_TICK_MS
+            self.send(CMD_SORT_DONE, bytes((cls, SERVO_DEGREE[cls], self.done_seq, move_ms >> 8, move_ms & 0xff)),
+                      inject=False)
+
+
+class Loop:
+    """所有桶共用一个 selector 和一个定时器堆"""
+
+    def __init__(self):
+        self.sel = selectors.DefaultSelector()
+        self.timers = []
+        self.n = 0
+
+    def at(self, t, fn, *args):
+        self.n += 1
+        heapq.heappush(self.timers, (t, self.n, fn, args))
+
+    def run(self, until=None):
+        while until is None or time.time() < until:
+            now = time.time()
+            while self.timers and self.timers[0][0] <= now:
+                _, _, fn, args = heapq.heappop(self.timers)
+                fn(self, now, *args)
+            timeout = max(0.0, self.timers[0][0] - time.time()) if self.timers else 0.1
+            for key, events in self.sel.select(min(timeout, 0.1)):
+                b = key.data
+                if events & selectors.EVENT_READ:
+                    b.receive(self, time.time())
+                if events & selectors.EVENT_WRITE:
+                    b.flush()
+            for key in list(self.sel.get_map().values()):
+                want = selectors.EVENT_READ | (selectors.EVENT_WRITE if key.data.out else 0)
+                if key.events != want:
+                    self.sel.modify(key.fileobj, want, key.data)
+
+
+def start_bins(args):
+    rng = random.Random(args.seed)
+    loop = Loop()
+    bins = [Bin(i, args, random.Random(rng.random())) for i in range(args.count)]
+    period = 1.0 / args.rate
+    now = time.time()
+
+    def tick(loop, now, b, due):
+        b.telemetry(now)
+        loop.at(due + period, tick, b, due + period)
+
+    for b in bins:
+        loop.sel.register(b.master, selectors.EVENT_READ, b)
+        first = now + rng.uniform(0, period)
+        loop.at(first, tick, b, first)
+    return loop, bins
+
+
+def serve(args, ready=None):
+    loop, bins = start_bins(args)
+    if not args.quiet:
+        for b in bins:
+            print(f'bin{b.index}: {b.link or b.path}' + (f' -> {b.path}' if b.link else ''), flush=True)
+    if ready is not None:
+        ready.send([b.link or b.path for b in bins])
+    until = time.time() + args.duration if args.duration else None
+    try:
+        loop.run(until)
+    except KeyboardInterrupt:
+        pass
+    stats = {k: sum(b.stats[k] for b in bins) for k in bins[0].stats}
+    for b in bins:
+        b.close()
+    return stats
+
+
+def _percentile(values, p):
+    if not values:
+        return None
+    values = sorted(values)
+    return round(values[min(len(values) - 1, int(len(values) * p))] * 1000, 2)
+
+
+def bench(args):
+    """子进程跑桶，这里当上位机：全部读、解帧，定时给每个桶发分拣命令，量 ACK 和 SORT_DONE 的延迟"""
+    import multiprocessing
+    parent, child = multiprocessing.Pipe()
+    args.quiet = True
+    args.duration = args.bench + 2.0
+    proc = multiprocessing.Process(target=lambda: child.send(serve(args, child)))
+    proc.start()
+    paths = parent.recv()
+    sel = selectors.DefaultSelector()
+    hosts = []
+    for path in paths:
+        fd = os.open(path, os.O_RDWR | os.O_NOCTTY | os.O_NONBLOCK)
+        tty.setraw(fd)
+        host = {'fd': fd, 'dec': trash_link.Decoder(), 'seq': 0, 'cls': 0, 'pending': {}, 'sorting': None}
+        hosts.append(host)
+        sel.register(fd, selectors.EVENT_READ, host)
+    ack_rtt, sort_rtt, failed = [], [], 0
+    start = time.time()
+    end = start + args.bench
+    next_cmd = start + 0.5
+    while time.time() < end:
+        now = time.time()
+        if now >= next_cmd:
+            next_cmd += args.cmd_interval
+            for h in hosts:
+                h['cls'] = (h['cls'] + 1) % len(SERVO_DEGREE)
+                seq = h['seq']
+                h['seq'] = (seq + 1) & 0xff
+                failed += len(h['pending'])
+                h['pending'] = {seq: now}
+                h['sorting'] = now
+                os.write(h['fd'], trash_link.encode_v2(CMD_TELEMETRY, bytes((1, h['cls'])), seq))
+        for key, _ in sel.select(0.01):
+            h = key.data
+            try:
+                data = os.read(h['fd'], 65536)
+            except BlockingIOError:
+                continue
+            t = time.time()
+            h['dec'].feed(data, t)
+            for cmd, seq, payload, version, _ in h['dec'].take()['frames']:
+                if cmd == CMD_ACK and payload[0] in h['pending']:
+                    ack_rtt.append(t - h['pending'].pop(payload[0]))
+                elif cmd == CMD_SORT_DONE and h['sorting'] is not None:
+                    sort_rtt.append(t - h['sorting'])
+                    h['sorting'] = None
+    elapsed = time.time() - start
+    host_stats = {}
+    for h in hosts:
+        for k, v in h['dec'].stats().items():
+            host_stats[k] = host_stats.get(k, 0) + v
+        os.close(h['fd'])
+    sim_stats = parent.recv()
+    proc.join()
+    return {
+        'bins': args.count, 'rate_hz': args.rate, 'seconds': round(elapsed, 2),
+        'frames_per_s': round(host_stats['frames'] / elapsed), 'mbytes_per_s': round(host_stats['bytes'] / elapsed / 1e6, 3),
+        'telemetry': host_stats['telemetry'], 'crc_errors': host_stats['crc_errors'], 'resync': host_stats['resync'],
+        'frame_error_rate': round(host_stats['crc_errors'] / max(1, host_stats['frames'] + host_stats['crc_errors']), 5),
+        'ack_ms_p50': _percentile(ack_rtt, 0.5), 'ack_ms_p99': _percentile(ack_rtt, 0.99),
+        'sort_ms_p50': _percentile(sort_rtt, 0.5), 'sort_ms_p99': _percentile(sort_rtt, 0.99),
+        'commands_unacked': failed, 'sim': sim_stats,
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(description='smart_trash 虚拟垃圾桶（伪终端）')
+    parser.add_argument('--count', type=int, default=1, help='开几个桶')
+    parser.add_argument('--link', default=None, help='给第 i 个桶建符号链接 <link><i>')
+    parser.add_argument('--rate', type=float, default=10.0, help='每个桶的遥测帧率 Hz')
+    parser.add_argument('--distance', type=parse_wave, default=parse_wave('ramp:0.6,0.15,300'))
+    parser.add_argument('--temp', type=parse_wave, default=parse_wave('sine:25,3,3600'))
+    parser.add_argument('--humi', type=parse_wave, default=parse_wave('sine:55,10,1800'))
+    parser.add_argument('--distance-noise', type=float, default=0.003)
+    parser.add_argument('--temp-noise', type=float, default=0.1)
+    parser.add_argument('--humi-noise', type=float, default=0.5)
+    parser.add_argument('--drop', type=float, default=0.0, help='整帧丢掉的概率')
+    parser.add_argument('--corrupt', type=float, default=0.0, help='帧里改一个位的概率')
+    parser.add_argument('--garbage', type=float, default=0.0, help='帧前插垃圾字节的概率')
+    parser.add_argument('--seed', type=int, default=None)
+    parser.add_argument('--duration', type=float, default=None, help='跑多少秒，默认一直跑')
+    parser.add_argument('--bench', type=float, default=None, help='自己当上位机压测多少秒，输出 JSON')
+    parser.add_argument('--cmd-interval', type=float, default=1.0, help='压测时每个桶发分拣命令的间隔 s')
+    parser.add_argument('--quiet', action='store_true')
+    args = parser.parse_args()
+    if args.bench:
+        print(json.dumps(bench(args), indent=2))
+    else:
+        stats = serve(args)
+        if not args.quiet:
+            print(json.dumps(stats), file=sys.stderr)
+
+
+if __name__ == '__main__':
+    main()